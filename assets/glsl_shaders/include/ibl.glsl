@@ -0,0 +1,47 @@
+#ifndef IBL_GLSL
+#define IBL_GLSL
+
+#define PI 3.14159265359
+
+//direction through the center of texel coord.xy of cubemap face coord.z, faces ordered +x -x +y -y +z -z
+vec3 cube_direction(ivec3 coord, int size)
+{
+  vec2 uv = 2.0 * (vec2(coord.xy) + 0.5) / float(size) - 1.0;
+  switch (coord.z) {
+    case 0: return normalize(vec3(1.0, -uv.y, -uv.x));
+    case 1: return normalize(vec3(-1.0, -uv.y, uv.x));
+    case 2: return normalize(vec3(uv.x, 1.0, uv.y));
+    case 3: return normalize(vec3(uv.x, -1.0, -uv.y));
+    case 4: return normalize(vec3(uv.x, -uv.y, 1.0));
+    default: return normalize(vec3(-uv.x, -uv.y, -1.0));
+  }
+}
+
+vec2 hammersley(uint i, uint n)
+{
+  return vec2(float(i) / float(n), float(bitfieldReverse(i)) * 2.3283064365386963e-10);
+}
+
+//half vector around n distributed like the GGX normal distribution
+vec3 importance_sample_ggx(vec2 xi, vec3 n, float roughness)
+{
+  float a = roughness * roughness;
+  float phi = 2.0 * PI * xi.x;
+  float cos_theta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+  float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+
+  vec3 up = abs(n.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+  vec3 tangent = normalize(cross(up, n));
+  vec3 bitangent = cross(n, tangent);
+  return normalize(tangent * (cos(phi) * sin_theta) + bitangent * (sin(phi) * sin_theta) + n * cos_theta);
+}
+
+float distribution_ggx(float n_dot_h, float roughness)
+{
+  float a = roughness * roughness;
+  float a2 = a * a;
+  float d = n_dot_h * n_dot_h * (a2 - 1.0) + 1.0;
+  return a2 / (PI * d * d);
+}
+
+#endif
@@ -34,7 +34,7 @@ void main() {
     if(ubo.intensity_texture_id < 0) {
         intensity = ubo.intensity;
     } else {
-        intensity = texture(nodeTextures[ubo.intensity_texture_id], fragUV).r;
+        intensity = clamp(texture(nodeTextures[ubo.intensity_texture_id], fragUV).r, 0.0, 10.0); // NodeBlur::Info::max_intensity
     }
 
     const vec2 scale = ps * intensity;
@@ -17,9 +17,11 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
   float detail;
   float roughness;
   float distortion;
+  vec4 tile_transform; // uv offset.xy, uv scale.zw of the evaluated tile
 } ubo;
 
-vec3 texcoord = vec3(fragUV.x + ubo.x, fragUV.y + ubo.y, ubo.z);
+vec2 tile_uv = ubo.tile_transform.xy + fragUV * ubo.tile_transform.zw;
+vec3 texcoord = vec3(tile_uv.x + ubo.x, tile_uv.y + ubo.y, ubo.z);
 
 float random_float_offset(float seed) {
   return 100.0 + hash_float_to_float(seed) * 100.0;
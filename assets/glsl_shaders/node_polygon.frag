@@ -5,6 +5,7 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     float angle;
     int sides;
     float gradient;
+    vec4 tile_transform; // uv offset.xy, uv scale.zw of the evaluated tile
 } ubo;
 
 layout(location = 0) in vec2 fragUV;
@@ -24,7 +25,7 @@ float linearstep(float a, float b, float t) {
 }
 
 void main() {
-    vec2 uv = fragUV * 2. - 1.;
+    vec2 uv = (ubo.tile_transform.xy + fragUV * ubo.tile_transform.zw) * 2. - 1.;
     float a = atan(uv.x, uv.y) + radians(ubo.angle);
     float r = TWO_PI / float(ubo.sides);
     float d = cos(floor(.5 + a / r) * r - a) * length(uv) / ubo.radius;
@@ -15,9 +15,11 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
   float randomness;
   float smoothness;
   float exponent;
+  vec4 tile_transform; // uv offset.xy, uv scale.zw of the evaluated tile
 } ubo;
 
-vec3 texcoord = vec3(fragUV.x + ubo.x, fragUV.y + ubo.y, ubo.z);
+vec2 tile_uv = ubo.tile_transform.xy + fragUV * ubo.tile_transform.zw;
+vec3 texcoord = vec3(tile_uv.x + ubo.x, tile_uv.y + ubo.y, ubo.z);
 
 float voronoi_distance(vec2 a, vec2 b, int metric, float exponent) {
   if(metric == 0) {// SHD_VORONOI_EUCLIDEAN
@@ -0,0 +1,293 @@
+#include "cpu_graph_evaluator.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace cpu {
+	namespace {
+		float linear_to_srgb(const float value) {
+			return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		}
+
+		template<typename T>
+		void write_texel_channel(std::vector<std::byte>& pixels, const size_t offset, const T value) {
+			std::memcpy(pixels.data() + offset, &value, sizeof(T));
+		}
+
+		//texel bytes of the node format, sRGB color channels are encoded here since the planes hold linear values
+		std::vector<std::byte> pack_pixels(const Image& image, VkFormat& format) {
+			auto unorm8 = [](const float value) {
+				return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+			};
+			auto unorm16 = [](const float value) {
+				return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+			};
+			const size_t texel_num = static_cast<size_t>(image.width) * image.height;
+			std::vector<std::byte> pixels;
+			format = image.format;
+
+			switch (image.format) {
+			case VK_FORMAT_R8G8B8A8_SRGB:
+			case VK_FORMAT_R8G8B8A8_UNORM: {
+				const bool srgb = image.format == VK_FORMAT_R8G8B8A8_SRGB;
+				pixels.resize(texel_num * 4);
+				for (size_t i = 0; i < texel_num; ++i) {
+					for (size_t c = 0; c < 4; ++c) {
+						const float value = image.channels[c][i];
+						write_texel_channel(pixels, i * 4 + c, unorm8(srgb && c < 3 ? linear_to_srgb(value) : value));
+					}
+				}
+				break;
+			}
+			case VK_FORMAT_R8_UNORM:
+				pixels.resize(texel_num);
+				for (size_t i = 0; i < texel_num; ++i) {
+					write_texel_channel(pixels, i, unorm8(image.channels[0][i]));
+				}
+				break;
+			case VK_FORMAT_R16_UNORM:
+				pixels.resize(texel_num * sizeof(uint16_t));
+				for (size_t i = 0; i < texel_num; ++i) {
+					write_texel_channel(pixels, i * sizeof(uint16_t), unorm16(image.channels[0][i]));
+				}
+				break;
+			case VK_FORMAT_R16G16B16A16_UNORM:
+				pixels.resize(texel_num * 4 * sizeof(uint16_t));
+				for (size_t i = 0; i < texel_num; ++i) {
+					for (size_t c = 0; c < 4; ++c) {
+						write_texel_channel(pixels, (i * 4 + c) * sizeof(uint16_t), unorm16(image.channels[c][i]));
+					}
+				}
+				break;
+			default:
+				format = VK_FORMAT_R32G32B32A32_SFLOAT;
+				pixels.resize(texel_num * 4 * sizeof(float));
+				for (size_t i = 0; i < texel_num; ++i) {
+					for (size_t c = 0; c < 4; ++c) {
+						write_texel_channel(pixels, (i * 4 + c) * sizeof(float), image.channels[c][i]);
+					}
+				}
+				break;
+			}
+			return pixels;
+		}
+	}
+
+	GraphEvaluator::GraphEvaluator(const uint32_t image_size, const size_t thread_count) :
+		image_size(image_size), thread_pool(thread_count) {}
+
+	void GraphEvaluator::load(const std::filesystem::path& file_path) {
+		json json_file;
+		if (graph_file::is_binary(file_path)) {
+			json_file = graph_file::to_json(graph_file::BinaryGraphFile(file_path).view());
+		}
+		else {
+			std::ifstream i_file(file_path);
+			if (!i_file) {
+				throw std::runtime_error("failed to open graph file!");
+			}
+			i_file >> json_file;
+		}
+
+		nodes.clear();
+		for (auto& json_node : json_file["nodes"]) {
+			const auto type_iter = std::ranges::find(NODE_TYPE_HASH_VALUES, json_node["type_hash"].get<uint32_t>());
+			if (type_iter == NODE_TYPE_HASH_VALUES.end()) {
+				throw std::runtime_error("failed to find node type of graph file!");
+			}
+			auto& node = nodes.emplace_back(Node{
+				.type_index = static_cast<size_t>(std::distance(NODE_TYPE_HASH_VALUES.begin(), type_iter)),
+				.pins = json_node["pins"],
+				});
+			node.input_links.resize(node.pins.size());
+		}
+
+		if (json_file.contains("links")) {
+			for (auto& json_link : json_file["links"]) {
+				auto const start_node_index = json_link["start_node_index"].get<size_t>();
+				auto const end_node_index = json_link["end_node_index"].get<size_t>();
+				auto const end_pin_index = json_link["end_pin_index"].get<size_t>();
+				if (start_node_index >= nodes.size() || end_node_index >= nodes.size() || end_pin_index >= nodes[end_node_index].input_links.size()) {
+					throw std::runtime_error("failed to load link of graph file!");
+				}
+				nodes[end_node_index].input_links[end_pin_index] = Link{
+					.node_index = start_node_index,
+					.pin_index = json_link["start_pin_index"].get<size_t>(),
+				};
+			}
+		}
+	}
+
+	std::vector<size_t> GraphEvaluator::sort_nodes() const {
+		std::vector<size_t> in_degrees(nodes.size(), 0);
+		std::vector<std::vector<size_t>> downstream_nodes(nodes.size());
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			for (auto const& link : nodes[i].input_links) {
+				if (link) {
+					++in_degrees[i];
+					downstream_nodes[link->node_index].emplace_back(i);
+				}
+			}
+		}
+
+		std::vector<size_t> sorted_nodes;
+		sorted_nodes.reserve(nodes.size());
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			if (in_degrees[i] == 0) {
+				sorted_nodes.emplace_back(i);
+			}
+		}
+		for (size_t next = 0; next < sorted_nodes.size(); ++next) {
+			for (auto const i : downstream_nodes[sorted_nodes[next]]) {
+				if (--in_degrees[i] == 0) {
+					sorted_nodes.emplace_back(i);
+				}
+			}
+		}
+
+		if (sorted_nodes.size() != nodes.size()) {
+			throw std::runtime_error("failed to sort graph, it contains a cycle!");
+		}
+		return sorted_nodes;
+	}
+
+	void GraphEvaluator::evaluate() {
+		for (auto const i : sort_nodes()) {
+			evaluate_node(i);
+		}
+	}
+
+	template<typename InfoT>
+	InfoT GraphEvaluator::build_info(const Node& node, VkFormat& format, std::vector<ImGradientMark>& color_ramp) const {
+		InfoT info{};
+		format = InfoT::default_format;
+		for (size_t index = 0; index < InfoT::Class::TotalFields; ++index) {
+			InfoT::Class::FieldAt(info, index, [&](auto& field, auto& value) {
+				using PinT = typename std::decay_t<decltype(field)>::Type;
+				if constexpr (std::same_as<PinT, ColorRampData>) {
+					color_ramp = node.pins[index].template get<std::vector<ImGradientMark>>();
+				}
+				else if constexpr (!std::same_as<PinT, TextureIdData>) {
+					value = node.pins[index].template get<PinT>();
+				}
+
+				if (auto const& link = node.input_links[index]) {
+					auto const& start_node = nodes[link->node_index];
+					if (start_node.image) {
+						auto const texture_id = static_cast<int32_t>(link->node_index);
+						if constexpr (std::same_as<PinT, TextureIdData>) {
+							value.value = texture_id;
+						}
+						else if constexpr (std::same_as<PinT, FloatTextureIdData> || std::same_as<PinT, Color4TextureIdData>) {
+							value.value.id = texture_id;
+						}
+						if (field.template getAnnotation<AutoFormat>() == AutoFormat::True) {
+							format = start_node.image->format;
+						}
+					}
+					else {
+						std::visit([&](auto&& start_value) {
+							using StartPinT = std::decay_t<decltype(start_value)>;
+							if constexpr (std::same_as<PinT, StartPinT> && std::is_copy_assignable_v<PinT>) {
+								value = start_value;
+							}
+							else if constexpr (std::same_as<PinT, FloatTextureIdData> && std::same_as<StartPinT, FloatData>) {
+								value.value = { .number = start_value.value, .id = -1 };
+							}
+							}, start_node.output);
+					}
+				}
+
+				if constexpr (std::same_as<PinT, EnumData>) {
+					if (field.template getAnnotation<FormatEnum>() == FormatEnum::True) {
+						format = str_format_map.get_key(value.value);
+					}
+				}
+				});
+		}
+		return info;
+	}
+
+	void GraphEvaluator::evaluate_node(const size_t node_index) {
+		auto& node = nodes[node_index];
+		UNROLL<NodeTypeList::size>([&] <size_t type_index>() {
+			if (node.type_index != type_index) {
+				return;
+			}
+			using NodeType = NodeTypeList::at<type_index>;
+			using NodeDataT = typename NodeType::data_type;
+
+			if constexpr (value_data<NodeDataT>) {
+				using InfoT = typename NodeDataT::InfoT;
+				using FieldTypes = FieldTypeList<InfoT>;
+				auto input_value = [&] <typename PinT> (const size_t index) -> PinT {
+					if (auto const& link = node.input_links[index]) {
+						if (auto const start_value = std::get_if<PinT>(&nodes[link->node_index].output)) {
+							return *start_value;
+						}
+					}
+					return node.pins[index].template get<PinT>();
+				};
+				node.output = [&] <size_t... I> (std::index_sequence<I...>) {
+					return NodeDataT::calculate(input_value.template operator()<typename FieldTypes::template at<I>>(I)...);
+				}(std::make_index_sequence<FieldTypes::size>{});
+			}
+			else if constexpr (image_data<NodeDataT>) {
+				using InfoT = typename ref_t<NodeDataT>::InfoT;
+				if constexpr (KernelInfo<InfoT>) {
+					VkFormat format;
+					std::vector<ImGradientMark> color_ramp;
+					auto const info = build_info<InfoT>(node, format, color_ramp);
+					const KernelContext context{
+						.thread_pool = thread_pool,
+						.input = [this](const int32_t texture_id) -> const Image* {
+							if (texture_id < 0 || static_cast<size_t>(texture_id) >= nodes.size() || !nodes[texture_id].image) {
+								return nullptr;
+							}
+							return &*nodes[texture_id].image;
+						},
+						.color_ramp = std::move(color_ramp),
+					};
+					Image output(image_size, image_size, format);
+					evaluate_kernel(info, context, output);
+					resolve_format(thread_pool, output);
+					node.image = std::move(output);
+				}
+				else {
+					throw std::runtime_error(std::format("failed to evaluate {} node, it has no CPU kernel!", NodeType::name()));
+				}
+			}
+			});
+	}
+
+	size_t GraphEvaluator::node_count() const noexcept {
+		return nodes.size();
+	}
+
+	std::string_view GraphEvaluator::node_name(const size_t node_index) const {
+		std::string_view name;
+		UNROLL<NodeTypeList::size>([&] <size_t type_index>() {
+			if (nodes.at(node_index).type_index == type_index) {
+				name = NodeTypeList::at<type_index>::name();
+			}
+			});
+		return name;
+	}
+
+	const Image* GraphEvaluator::image(const size_t node_index) const {
+		auto const& image = nodes.at(node_index).image;
+		return image ? &*image : nullptr;
+	}
+
+	void GraphEvaluator::save(const size_t node_index, const std::filesystem::path& file_path) const {
+		auto const node_image = image(node_index);
+		if (!node_image) {
+			throw std::runtime_error("failed to save node, it has no image!");
+		}
+		VkFormat format;
+		auto const pixels = pack_pixels(*node_image, format);
+		engine::TextureExporter::encode_pixels(pixels.data(), node_image->width, node_image->height, format,
+			file_path, engine::TextureExporter::file_format_from_extension(file_path));
+	}
+}
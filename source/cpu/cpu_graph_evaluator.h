@@ -0,0 +1,55 @@
+#pragma once
+#include "cpu_kernels.h"
+#include "../gui/gui_node_editor.h"
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace cpu {
+	//Evaluates a .txg or .txgb graph saved by the node editor without a Vulkan device.
+	//Pins are parsed into the same Info structs the GPU nodes upload; texture ids are node indices resolved by KernelContext::input.
+	class GraphEvaluator {
+	public:
+		explicit GraphEvaluator(uint32_t image_size = TEXTURE_IMAGE_SIZE, size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+
+		void load(const std::filesystem::path& file_path);
+
+		void evaluate();
+
+		[[nodiscard]] size_t node_count() const noexcept;
+
+		[[nodiscard]] std::string_view node_name(size_t node_index) const;
+
+		//nullptr for value and shader nodes, or before evaluate()
+		[[nodiscard]] const Image* image(size_t node_index) const;
+
+		//packs the image into the format the GPU node would render to, then encodes it like the texture exporter
+		void save(size_t node_index, const std::filesystem::path& file_path) const;
+
+	private:
+		struct Link {
+			size_t node_index;
+			size_t pin_index;
+		};
+
+		struct Node {
+			size_t type_index;
+			json pins;
+			std::vector<std::optional<Link>> input_links;
+			PinVariant output;
+			std::optional<Image> image;
+		};
+
+		uint32_t image_size;
+		ThreadPool thread_pool;
+		std::vector<Node> nodes;
+
+		[[nodiscard]] std::vector<size_t> sort_nodes() const;
+
+		template<typename InfoT>
+		InfoT build_info(const Node& node, VkFormat& format, std::vector<ImGradientMark>& color_ramp) const;
+
+		void evaluate_node(size_t node_index);
+	};
+}
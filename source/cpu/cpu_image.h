@@ -0,0 +1,143 @@
+#pragma once
+#include "cpu_simd.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace cpu {
+	//Node texture kept as four float planes (structure of arrays) so row loops over a channel stay contiguous and vectorize.
+	//format records the VkFormat the GPU node would render into; values are stored linear, like shader outputs.
+	struct Image {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		std::array<std::vector<float>, 4> channels;
+
+		Image() = default;
+
+		Image(const uint32_t width, const uint32_t height, const VkFormat format) :
+			width(width), height(height), format(format) {
+			for (auto& channel : channels) {
+				channel.resize(static_cast<size_t>(width) * height);
+			}
+		}
+
+		[[nodiscard]] size_t index(const uint32_t x, const uint32_t y) const noexcept {
+			return static_cast<size_t>(y) * width + x;
+		}
+
+		[[nodiscard]] glm::vec4 load(const size_t i) const noexcept {
+			return { channels[0][i], channels[1][i], channels[2][i], channels[3][i] };
+		}
+
+		void store(const size_t i, const glm::vec4& value) noexcept {
+			channels[0][i] = value.r;
+			channels[1][i] = value.g;
+			channels[2][i] = value.b;
+			channels[3][i] = value.a;
+		}
+
+		//the four pixels from i on, one contiguous load per plane; lanes past the end of the image read as 0
+		[[nodiscard]] simd::Vec<4> load4(const size_t i) const noexcept {
+			simd::Vec<4> value;
+			for (size_t c = 0; c < 4; ++c) {
+				if (i + 4 <= channels[c].size()) {
+					value[c] = simd::Float4::load(&channels[c][i]);
+				}
+				else {
+					alignas(16) std::array<float, 4> lanes{};
+					std::copy(channels[c].begin() + static_cast<ptrdiff_t>(i), channels[c].end(), lanes.begin());
+					value[c] = simd::Float4::load(lanes.data());
+				}
+			}
+			return value;
+		}
+
+		//stores the first count lanes of value to the pixels from i on
+		void store4(const size_t i, const simd::Vec<4>& value, const size_t count = 4) noexcept {
+			for (size_t c = 0; c < 4; ++c) {
+				if (count == 4) {
+					value[c].store(&channels[c][i]);
+				}
+				else {
+					alignas(16) std::array<float, 4> lanes;
+					value[c].store(lanes.data());
+					std::copy_n(lanes.begin(), count, &channels[c][i]);
+				}
+			}
+		}
+
+		//sample() at four uvs. Addresses and weights are computed in lanes, the texel reads stay scalar since SSE2 has no
+		//gather; wrapping goes through floats, exact for images below 2^24 texels per side
+		[[nodiscard]] simd::Vec<4> sample4(const simd::Vec<2>& uv) const noexcept {
+			const simd::Float4 float_width = static_cast<float>(width);
+			const simd::Float4 float_height = static_cast<float>(height);
+			const simd::Float4 x = uv[0] * float_width - 0.5f;
+			const simd::Float4 y = uv[1] * float_height - 0.5f;
+			const simd::Float4 x_floor = simd::floor(x);
+			const simd::Float4 y_floor = simd::floor(y);
+			const simd::Float4 fx = x - x_floor;
+			const simd::Float4 fy = y - y_floor;
+
+			auto wrap = [](const simd::Float4 i, const simd::Float4 size) {
+				simd::Float4 wrapped = i - simd::floor(i / size) * size;
+				wrapped -= size & (wrapped >= size);
+				wrapped += size & (wrapped < 0.0f);
+				return wrapped;
+			};
+			const simd::Float4 x0 = wrap(x_floor, float_width);
+			const simd::Float4 y0 = wrap(y_floor, float_height);
+			alignas(16) std::array<uint32_t, 4> x0_lanes, x1_lanes, y0_lanes, y1_lanes;
+			_mm_store_si128(reinterpret_cast<__m128i*>(x0_lanes.data()), simd::to_int(x0).v);
+			_mm_store_si128(reinterpret_cast<__m128i*>(x1_lanes.data()), simd::to_int(simd::select(x0 + 1.0f == float_width, 0.0f, x0 + 1.0f)).v);
+			_mm_store_si128(reinterpret_cast<__m128i*>(y0_lanes.data()), simd::to_int(y0).v);
+			_mm_store_si128(reinterpret_cast<__m128i*>(y1_lanes.data()), simd::to_int(simd::select(y0 + 1.0f == float_height, 0.0f, y0 + 1.0f)).v);
+
+			simd::Vec<4> value;
+			for (size_t c = 0; c < 4; ++c) {
+				alignas(16) std::array<float, 4> t00, t10, t01, t11;
+				for (size_t lane = 0; lane < 4; ++lane) {
+					t00[lane] = channels[c][index(x0_lanes[lane], y0_lanes[lane])];
+					t10[lane] = channels[c][index(x1_lanes[lane], y0_lanes[lane])];
+					t01[lane] = channels[c][index(x0_lanes[lane], y1_lanes[lane])];
+					t11[lane] = channels[c][index(x1_lanes[lane], y1_lanes[lane])];
+				}
+				value[c] = simd::mix(
+					simd::mix(simd::Float4::load(t00.data()), simd::Float4::load(t10.data()), fx),
+					simd::mix(simd::Float4::load(t01.data()), simd::Float4::load(t11.data()), fx),
+					fy);
+			}
+			return value;
+		}
+
+		//bilinear filtering with repeat addressing, matching the sampler bound to the node textures
+		[[nodiscard]] glm::vec4 sample(const glm::vec2 uv) const noexcept {
+			const float x = uv.x * static_cast<float>(width) - 0.5f;
+			const float y = uv.y * static_cast<float>(height) - 0.5f;
+			const float x_floor = std::floor(x);
+			const float y_floor = std::floor(y);
+			const float fx = x - x_floor;
+			const float fy = y - y_floor;
+
+			auto wrap = [](const int64_t i, const uint32_t size) {
+				const auto s = static_cast<int64_t>(size);
+				return static_cast<uint32_t>(((i % s) + s) % s);
+			};
+			const auto x0 = wrap(static_cast<int64_t>(x_floor), width);
+			const auto x1 = wrap(static_cast<int64_t>(x_floor) + 1, width);
+			const auto y0 = wrap(static_cast<int64_t>(y_floor), height);
+			const auto y1 = wrap(static_cast<int64_t>(y_floor) + 1, height);
+
+			return glm::mix(
+				glm::mix(load(index(x0, y0)), load(index(x1, y0)), fx),
+				glm::mix(load(index(x0, y1)), load(index(x1, y1)), fx),
+				fy);
+		}
+	};
+}
@@ -0,0 +1,910 @@
+#include "cpu_kernels.h"
+#include "cpu_noise.h"
+
+#include <algorithm>
+#include <future>
+#include <numbers>
+
+namespace cpu {
+	namespace {
+		constexpr uint32_t tile_size = 64;
+
+		//splits width x height into tiles, runs func(x0, y0, x1, y1) for each on the pool and waits for all of them
+		template<typename Func>
+		void parallel_for_tiles(ThreadPool& thread_pool, const uint32_t width, const uint32_t height, Func&& func) {
+			std::vector<std::future<void>> tiles;
+			tiles.reserve(static_cast<size_t>((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size));
+			for (uint32_t y0 = 0; y0 < height; y0 += tile_size) {
+				for (uint32_t x0 = 0; x0 < width; x0 += tile_size) {
+					const uint32_t x1 = std::min(x0 + tile_size, width);
+					const uint32_t y1 = std::min(y0 + tile_size, height);
+					tiles.emplace_back(thread_pool.submit([&func, x0, y0, x1, y1] {
+						func(x0, y0, x1, y1);
+						}));
+				}
+			}
+			for (auto& tile : tiles) {
+				tile.get();
+			}
+		}
+
+		//func(uv, i) returns the color of the pixel at index i, uv is the pixel center like fragUV
+		template<typename Func>
+		void for_each_pixel(ThreadPool& thread_pool, Image& output, Func&& func) {
+			const float inv_width = 1.0f / static_cast<float>(output.width);
+			const float inv_height = 1.0f / static_cast<float>(output.height);
+			parallel_for_tiles(thread_pool, output.width, output.height, [&](const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1) {
+				for (uint32_t y = y0; y < y1; ++y) {
+					const float v = (static_cast<float>(y) + 0.5f) * inv_height;
+					for (uint32_t x = x0; x < x1; ++x) {
+						const size_t i = output.index(x, y);
+						output.store(i, func(glm::vec2{ (static_cast<float>(x) + 0.5f) * inv_width, v }, i));
+					}
+				}
+				});
+		}
+
+		//for_each_pixel() four pixels of a row at a time: func(uv, i) returns the colors of the pixels from index i on in
+		//lanes, uv holds their pixel centers. Lanes past the end of a tile row are computed and dropped
+		template<typename Func>
+		void for_each_pixel4(ThreadPool& thread_pool, Image& output, Func&& func) {
+			const float inv_width = 1.0f / static_cast<float>(output.width);
+			const float inv_height = 1.0f / static_cast<float>(output.height);
+			const simd::Float4 lane_centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			parallel_for_tiles(thread_pool, output.width, output.height, [&](const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1) {
+				for (uint32_t y = y0; y < y1; ++y) {
+					const simd::Float4 v = (static_cast<float>(y) + 0.5f) * inv_height;
+					for (uint32_t x = x0; x < x1; x += 4) {
+						const size_t i = output.index(x, y);
+						const simd::Float4 u = (static_cast<float>(x) + lane_centers) * inv_width;
+						output.store4(i, func(simd::Vec<2>{ u, v }, i), std::min<size_t>(x1 - x, 4));
+					}
+				}
+				});
+		}
+
+		//the first count floats from p on, a row tail shorter than four leaves the other lanes 0
+		simd::Float4 load_lanes(const float* p, const uint32_t count) {
+			if (count >= 4) {
+				return simd::Float4::load(p);
+			}
+			alignas(16) std::array<float, 4> lanes{};
+			std::copy_n(p, count, lanes.begin());
+			return simd::Float4::load(lanes.data());
+		}
+
+		void store_lanes(float* p, const simd::Float4 value, const uint32_t count) {
+			if (count >= 4) {
+				value.store(p);
+				return;
+			}
+			alignas(16) std::array<float, 4> lanes;
+			value.store(lanes.data());
+			std::copy_n(lanes.begin(), count, p);
+		}
+
+		bool same_size(const Image& a, const Image& b) {
+			return a.width == b.width && a.height == b.height;
+		}
+
+		//texture(input, fragUV) at the pixel center of output, a plain load when the sizes match
+		glm::vec4 fetch(const Image& input, const Image& output, const glm::vec2 uv, const size_t i) {
+			return same_size(input, output) ? input.load(i) : input.sample(uv);
+		}
+
+		simd::Vec<4> fetch4(const Image& input, const Image& output, const simd::Vec<2>& uv, const size_t i) {
+			return same_size(input, output) ? input.load4(i) : input.sample4(uv);
+		}
+
+		simd::Vec<4> grey4(const simd::Float4 value) {
+			return { value, value, value, 1.0f };
+		}
+
+		//row of channel c of image covering [x0, x1) of output row y, filled with constant when image is not connected
+		const float* channel_row(const Image* image, const size_t c, const Image& output, const uint32_t y,
+			const uint32_t x0, const uint32_t x1, const float constant, std::vector<float>& scratch) {
+			if (image && same_size(*image, output)) {
+				return &image->channels[c][image->index(x0, y)];
+			}
+			scratch.resize(x1 - x0);
+			if (image) {
+				const simd::Float4 lane_centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+				const simd::Float4 v = (static_cast<float>(y) + 0.5f) / static_cast<float>(output.height);
+				alignas(16) std::array<float, 4> lanes;
+				for (uint32_t x = x0; x < x1; x += 4) {
+					const simd::Float4 u = (static_cast<float>(x) + lane_centers) / static_cast<float>(output.width);
+					image->sample4({ u, v })[c].store(lanes.data());
+					std::copy_n(lanes.begin(), std::min<uint32_t>(x1 - x, 4), &scratch[x - x0]);
+				}
+			}
+			else {
+				std::ranges::fill(scratch, constant);
+			}
+			return scratch.data();
+		}
+
+		simd::Float4 linearstep(const float a, const float b, const simd::Float4 t) {
+			return simd::select(t <= a, 0.0f, simd::select(t >= b, 1.0f, (t - a) / (b - a)));
+		}
+
+		simd::Vec<3> node_texcoord(const simd::Vec<2>& uv, const float x, const float y, const float z) {
+			return { uv[0] + x, uv[1] + y, z };
+		}
+
+		//the first N components of a vector
+		template<glm::length_t N>
+		simd::Vec<N> truncate(const simd::Vec<3>& value) {
+			simd::Vec<N> result;
+			std::copy_n(value.begin(), N, result.begin());
+			return result;
+		}
+
+		///////////////////////////////////////////// Noise /////////////////////////////////////////////
+
+		template<glm::length_t N>
+		using NoiseVec = std::conditional_t<N == 1, float, glm::vec<N, float>>;
+
+		template<glm::length_t N>
+		NoiseVec<N> random_offset(const float seed) {
+			if constexpr (N == 1) {
+				return 100.0f + hash_float_to_float(seed) * 100.0f;
+			}
+			else {
+				NoiseVec<N> offset;
+				for (glm::length_t c = 0; c < N; ++c) {
+					offset[c] = 100.0f + hash_vec2_to_float({ seed, static_cast<float>(c) }) * 100.0f;
+				}
+				return offset;
+			}
+		}
+
+		//offsets[0, N) distort the coordinate, offsets[N] and offsets[N + 1] decorrelate the green and blue channels
+		template<glm::length_t N>
+		std::array<simd::Vec<N>, N + 2> random_offsets() {
+			std::array<simd::Vec<N>, N + 2> offsets;
+			for (glm::length_t seed = 0; seed < N + 2; ++seed) {
+				if constexpr (N == 1) {
+					offsets[seed] = { random_offset<N>(static_cast<float>(seed)) };
+				}
+				else {
+					offsets[seed] = simd::splat(random_offset<N>(static_cast<float>(seed)));
+				}
+			}
+			return offsets;
+		}
+
+		template<glm::length_t N>
+		simd::Vec<4> noise_texture(simd::Vec<N> p, const NodeNoise::Info& info, const std::array<simd::Vec<N>, N + 2>& offsets, const bool color) {
+			const float detail = info.detail.value;
+			const float roughness = info.roughness.value;
+			const float distortion = info.distortion.value;
+			if (distortion != 0.0f) {
+				simd::Vec<N> displacement;
+				for (glm::length_t c = 0; c < N; ++c) {
+					displacement[c] = simd::snoise(p + offsets[c]) * distortion;
+				}
+				p = p + displacement;
+			}
+			const simd::Float4 value = simd::fractal_noise(p, detail, roughness);
+			if (color) {
+				return { value, simd::fractal_noise(p + offsets[N], detail, roughness), simd::fractal_noise(p + offsets[N + 1], detail, roughness), 1.0f };
+			}
+			return grey4(value);
+		}
+
+		template<glm::length_t N>
+		void evaluate_noise(const NodeNoise::Info& info, const KernelContext& context, Image& output) {
+			const float scale = info.scale.value * 5.0f;
+			const bool color = info.format.value == 0;
+			const auto offsets = random_offsets<N>();
+			for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& uv, size_t) {
+				const simd::Vec<3> texcoord = node_texcoord(uv, info.x.value, info.y.value, info.z.value);
+				return noise_texture<N>(truncate<N>(texcoord) * scale, info, offsets, color);
+				});
+		}
+
+		//////////////////////////////////////////// Voronoi ////////////////////////////////////////////
+
+		//four pixels per call, the cell loops are the same for all lanes and only their results are selected per lane
+
+		template<glm::length_t N>
+		using VoronoiVec = simd::Vec<N>;
+
+		template<glm::length_t N>
+		simd::Float4 voronoi_distance(const VoronoiVec<N>& a, const VoronoiVec<N>& b, const uint32_t metric, const float exponent) {
+			const VoronoiVec<N> difference = a - b;
+			switch (metric) {
+			case 0:  //SHD_VORONOI_EUCLIDEAN
+				return simd::length(difference);
+			case 1: { //SHD_VORONOI_MANHATTAN
+				simd::Float4 sum = 0.0f;
+				for (glm::length_t c = 0; c < N; ++c) {
+					sum += simd::abs(difference[c]);
+				}
+				return sum;
+			}
+			case 2: { //SHD_VORONOI_CHEBYCHEV
+				simd::Float4 max = simd::abs(difference[0]);
+				for (glm::length_t c = 1; c < N; ++c) {
+					max = simd::max(max, simd::abs(difference[c]));
+				}
+				return max;
+			}
+			case 3: { //SHD_VORONOI_MINKOWSKI
+				simd::Float4 sum = 0.0f;
+				for (glm::length_t c = 0; c < N; ++c) {
+					sum += simd::map([exponent](const float x) { return std::pow(x, exponent); }, simd::abs(difference[c]));
+				}
+				return simd::map([exponent](const float x) { return std::pow(x, 1.0f / exponent); }, sum);
+			}
+			default:
+				return 0.0f;
+			}
+		}
+
+		template<glm::length_t N>
+		VoronoiVec<N> voronoi_hash(const VoronoiVec<N>& cell) {
+			if constexpr (N == 2) {
+				return simd::hash_vec2_to_vec2(cell);
+			}
+			else {
+				return simd::hash_vec3_to_vec3(cell);
+			}
+		}
+
+		//visits the cell offsets in [-range, range]^N in the shader's loop order, i fastest
+		template<glm::length_t N, typename Func>
+		void for_each_cell_offset(const int32_t range, Func&& func) {
+			if constexpr (N == 2) {
+				for (int32_t j = -range; j <= range; ++j) {
+					for (int32_t i = -range; i <= range; ++i) {
+						func(glm::vec<N, float>(i, j));
+					}
+				}
+			}
+			else {
+				for (int32_t k = -range; k <= range; ++k) {
+					for (int32_t j = -range; j <= range; ++j) {
+						for (int32_t i = -range; i <= range; ++i) {
+							func(glm::vec<N, float>(i, j, k));
+						}
+					}
+				}
+			}
+		}
+
+		template<glm::length_t N>
+		simd::Float4 voronoi_f1(const VoronoiVec<N>& cell_position, const VoronoiVec<N>& local_position, const float randomness, const uint32_t metric, const float exponent) {
+			simd::Float4 min_distance = 8.0f;
+			for_each_cell_offset<N>(1, [&](const glm::vec<N, float> offset) {
+				const VoronoiVec<N> cell_offset = simd::splat(offset);
+				const VoronoiVec<N> point_position = cell_offset + voronoi_hash<N>(cell_position + cell_offset) * randomness;
+				min_distance = simd::min(min_distance, voronoi_distance<N>(point_position, local_position, metric, exponent));
+				});
+			return min_distance;
+		}
+
+		template<glm::length_t N>
+		simd::Float4 voronoi_smooth_f1(const VoronoiVec<N>& cell_position, const VoronoiVec<N>& local_position, const float randomness, const uint32_t metric, const float exponent, const float smoothness) {
+			simd::Float4 smooth_distance = 8.0f;
+			for_each_cell_offset<N>(2, [&](const glm::vec<N, float> offset) {
+				const VoronoiVec<N> cell_offset = simd::splat(offset);
+				const VoronoiVec<N> point_position = cell_offset + voronoi_hash<N>(cell_position + cell_offset) * randomness;
+				const simd::Float4 distance_to_point = voronoi_distance<N>(point_position, local_position, metric, exponent);
+				//glm::smoothstep(0, 1, x)
+				const simd::Float4 x = simd::clamp(0.5f + 0.5f * (smooth_distance - distance_to_point) / smoothness, 0.0f, 1.0f);
+				const simd::Float4 h = x * x * (3.0f - 2.0f * x);
+				const simd::Float4 correction_factor = smoothness * h * (1.0f - h);
+				smooth_distance = simd::mix(smooth_distance, distance_to_point, h) - correction_factor;
+				});
+			return smooth_distance;
+		}
+
+		template<glm::length_t N>
+		simd::Float4 voronoi_f2(const VoronoiVec<N>& cell_position, const VoronoiVec<N>& local_position, const float randomness, const uint32_t metric, const float exponent) {
+			simd::Float4 distance_f1 = 8.0f;
+			simd::Float4 distance_f2 = 8.0f;
+			for_each_cell_offset<N>(1, [&](const glm::vec<N, float> offset) {
+				const VoronoiVec<N> cell_offset = simd::splat(offset);
+				const VoronoiVec<N> point_position = cell_offset + voronoi_hash<N>(cell_position + cell_offset) * randomness;
+				const simd::Float4 distance_to_point = voronoi_distance<N>(point_position, local_position, metric, exponent);
+				const simd::Float4 below_f1 = distance_to_point < distance_f1;
+				distance_f2 = simd::select(below_f1, distance_f1, simd::select(distance_to_point < distance_f2, distance_to_point, distance_f2));
+				distance_f1 = simd::select(below_f1, distance_to_point, distance_f1);
+				});
+			return distance_f2;
+		}
+
+		template<glm::length_t N>
+		simd::Float4 voronoi_distance_to_edge(const VoronoiVec<N>& cell_position, const VoronoiVec<N>& local_position, const float randomness) {
+			VoronoiVec<N> vector_to_closest;
+			vector_to_closest.fill(0.0f);
+			simd::Float4 min_distance = 8.0f;
+			for_each_cell_offset<N>(1, [&](const glm::vec<N, float> offset) {
+				const VoronoiVec<N> cell_offset = simd::splat(offset);
+				const VoronoiVec<N> vector_to_point = cell_offset + voronoi_hash<N>(cell_position + cell_offset) * randomness - local_position;
+				const simd::Float4 distance_to_point = simd::dot(vector_to_point, vector_to_point);
+				const simd::Float4 closer = distance_to_point < min_distance;
+				min_distance = simd::select(closer, distance_to_point, min_distance);
+				vector_to_closest = simd::select(closer, vector_to_point, vector_to_closest);
+				});
+
+			min_distance = 8.0f;
+			for_each_cell_offset<N>(1, [&](const glm::vec<N, float> offset) {
+				const VoronoiVec<N> cell_offset = simd::splat(offset);
+				const VoronoiVec<N> vector_to_point = cell_offset + voronoi_hash<N>(cell_position + cell_offset) * randomness - local_position;
+				const VoronoiVec<N> perpendicular_to_edge = vector_to_point - vector_to_closest;
+				const simd::Float4 off_edge = simd::dot(perpendicular_to_edge, perpendicular_to_edge) > 0.0001f;
+				if (simd::any(off_edge)) {
+					const simd::Float4 distance_to_edge = simd::dot((vector_to_closest + vector_to_point) / 2.0f, simd::normalize(perpendicular_to_edge));
+					min_distance = simd::select(off_edge, simd::min(min_distance, distance_to_edge), min_distance);
+				}
+				});
+			return min_distance;
+		}
+
+		template<glm::length_t N>
+		simd::Float4 voronoi_n_sphere_radius(const VoronoiVec<N>& cell_position, const VoronoiVec<N>& local_position, const float randomness) {
+			VoronoiVec<N> closest_point;
+			VoronoiVec<N> closest_point_offset;
+			closest_point.fill(0.0f);
+			closest_point_offset.fill(0.0f);
+			simd::Float4 min_distance = 8.0f;
+			for_each_cell_offset<N>(1, [&](const glm::vec<N, float> offset) {
+				const VoronoiVec<N> cell_offset = simd::splat(offset);
+				const VoronoiVec<N> point_position = cell_offset + voronoi_hash<N>(cell_position + cell_offset) * randomness;
+				const simd::Float4 distance_to_point = simd::length(local_position - point_position);  //glm::distance
+				const simd::Float4 closer = distance_to_point < min_distance;
+				min_distance = simd::select(closer, distance_to_point, min_distance);
+				closest_point = simd::select(closer, point_position, closest_point);
+				closest_point_offset = simd::select(closer, cell_offset, closest_point_offset);
+				});
+
+			min_distance = 8.0f;
+			VoronoiVec<N> closest_point_to_closest_point;
+			closest_point_to_closest_point.fill(0.0f);
+			for_each_cell_offset<N>(1, [&](const glm::vec<N, float> offset) {
+				if (offset == glm::vec<N, float>(0.0f)) {
+					return;
+				}
+				const VoronoiVec<N> cell_offset = simd::splat(offset) + closest_point_offset;
+				const VoronoiVec<N> point_position = cell_offset + voronoi_hash<N>(cell_position + cell_offset) * randomness;
+				const simd::Float4 distance_to_point = simd::length(point_position - closest_point);
+				const simd::Float4 closer = distance_to_point < min_distance;
+				min_distance = simd::select(closer, distance_to_point, min_distance);
+				closest_point_to_closest_point = simd::select(closer, point_position, closest_point_to_closest_point);
+				});
+			return simd::length(closest_point - closest_point_to_closest_point) / 2.0f;
+		}
+
+		template<glm::length_t N>
+		void evaluate_voronoi(const NodeVoronoi::Info& info, const KernelContext& context, Image& output) {
+			const float scale = info.scale.value * 8.0f;
+			const float randomness = std::clamp(info.randomness.value, 0.0f, 1.0f);
+			const float smoothness = std::clamp(info.smoothness.value / 2.0f, 0.0f, 0.5f);
+			const uint32_t method = info.method.value;
+			const uint32_t metric = info.metric.value;
+			const float exponent = info.exponent.value;
+			for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& uv, size_t) {
+				const VoronoiVec<N> scaled_coord = truncate<N>(node_texcoord(uv, info.x.value, info.y.value, info.z.value)) * scale;
+				VoronoiVec<N> cell_position;
+				for (glm::length_t c = 0; c < N; ++c) {
+					cell_position[c] = simd::floor(scaled_coord[c]);
+				}
+				const VoronoiVec<N> local_position = scaled_coord - cell_position;
+				simd::Float4 result = 1.0f;
+				switch (method) {
+				case 0:
+					result = voronoi_f1<N>(cell_position, local_position, randomness, metric, exponent);
+					break;
+				case 1:
+					result = voronoi_smooth_f1<N>(cell_position, local_position, randomness, metric, exponent, smoothness);
+					break;
+				case 2:
+					result = voronoi_f2<N>(cell_position, local_position, randomness, metric, exponent);
+					break;
+				case 3:
+					result = voronoi_distance_to_edge<N>(cell_position, local_position, randomness);
+					break;
+				case 4:
+					result = voronoi_n_sphere_radius<N>(cell_position, local_position, randomness);
+					break;
+				default:
+					break;
+				}
+				return grey4(result);
+				});
+		}
+
+		///////////////////////////////////////////// Blend /////////////////////////////////////////////
+
+		simd::Float4 screen(const simd::Float4 fg, const simd::Float4 bg) {
+			return 1.0f - (1.0f - fg) * (1.0f - bg);
+		}
+
+		//hands func the per channel operation of mode, so the switch stays outside the row loops
+		template<typename Func>
+		void visit_blend_mode(const uint32_t mode, Func&& func) {
+			using simd::Float4;
+			switch (mode) {
+			case 1:  //add
+				func([](const Float4 a, const Float4 b) { return a + b; });
+				break;
+			case 2:  //subtract
+				func([](const Float4 a, const Float4 b) { return b - a; });
+				break;
+			case 3:  //multiply
+				func([](const Float4 a, const Float4 b) { return b * a; });
+				break;
+			case 4:  //divide
+				func([](const Float4 a, const Float4 b) { return b / a; });
+				break;
+			case 5:  //max
+				func([](const Float4 a, const Float4 b) { return simd::max(a, b); });
+				break;
+			case 6:  //min
+				func([](const Float4 a, const Float4 b) { return simd::min(a, b); });
+				break;
+			case 7:  //overlay
+				func([](const Float4 a, const Float4 b) { return simd::select(b < 0.5f, b * a, screen(b, a)); });
+				break;
+			case 8:  //screen
+				func([](const Float4 a, const Float4 b) { return screen(a, b); });
+				break;
+			default: //normal
+				func([](const Float4 a, Float4) { return a; });
+				break;
+			}
+		}
+
+		///////////////////////////////////////////// Blur //////////////////////////////////////////////
+
+		//linear interpolation between texels of a row or column with repeat addressing, position in texel units
+		float sample_line(const float* data, const size_t stride, const int64_t size, const float position) {
+			const float position_floor = std::floor(position);
+			const float f = position - position_floor;
+			const int64_t i0 = ((static_cast<int64_t>(position_floor) % size) + size) % size;
+			const int64_t i1 = (i0 + 1) % size;
+			return glm::mix(data[static_cast<size_t>(i0) * stride], data[static_cast<size_t>(i1) * stride], f);
+		}
+
+		std::vector<float> gaussian_weights(const int32_t samples) {
+			const float sigma = static_cast<float>(samples) * 0.25f;
+			std::vector<float> weights;
+			for (int32_t x = -samples / 2; x < samples / 2; ++x) {
+				weights.emplace_back(std::exp(-static_cast<float>(x * x) / (2.0f * sigma * sigma)));
+			}
+			return weights;
+		}
+
+		//the bilinear taps of the shader's square kernel factor into a horizontal and a vertical pass when the step is uniform
+		void blur_separable(ThreadPool& thread_pool, const Image& input, const float step, const int32_t samples, Image& output) {
+			const auto weights = gaussian_weights(samples);
+			float weight_sum = 0.0f;
+			for (const float weight : weights) {
+				weight_sum += weight;
+			}
+			const float first_offset = static_cast<float>(-samples / 2);
+			Image horizontal(input.width, input.height, input.format);
+
+			auto pass = [&](const Image& src, Image& dst, const bool vertical) {
+				const size_t stride = vertical ? src.width : 1;
+				const auto size = static_cast<int64_t>(vertical ? src.height : src.width);
+				parallel_for_tiles(thread_pool, src.width, src.height, [&](const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1) {
+					for (size_t c = 0; c < 3; ++c) {
+						for (uint32_t y = y0; y < y1; ++y) {
+							for (uint32_t x = x0; x < x1; ++x) {
+								const float* line = vertical ? &src.channels[c][x] : &src.channels[c][src.index(0, y)];
+								const float center = static_cast<float>(vertical ? y : x);
+								float sum = 0.0f;
+								for (size_t k = 0; k < weights.size(); ++k) {
+									sum += weights[k] * sample_line(line, stride, size, center + (first_offset + static_cast<float>(k)) * step);
+								}
+								dst.channels[c][dst.index(x, y)] = sum / weight_sum;
+							}
+						}
+					}
+					});
+			};
+			pass(input, horizontal, false);
+			pass(horizontal, output, true);
+			std::ranges::fill(output.channels[3], 1.0f);
+		}
+	}
+
+	void evaluate_kernel(const NodeUniformColor::Info& info, const KernelContext& context, Image& output) {
+		const glm::vec4 color{ info.color.value[0], info.color.value[1], info.color.value[2], info.color.value[3] };
+		parallel_for_tiles(context.thread_pool, output.width, output.height, [&](const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1) {
+			for (size_t c = 0; c < 4; ++c) {
+				for (uint32_t y = y0; y < y1; ++y) {
+					std::fill_n(&output.channels[c][output.index(x0, y)], x1 - x0, color[static_cast<glm::length_t>(c)]);
+				}
+			}
+			});
+	}
+
+	void evaluate_kernel(const NodePolygon::Info& info, const KernelContext& context, Image& output) {
+		const float angle = glm::radians(info.angle.value);
+		const float r = 2.0f * std::numbers::pi_v<float> / static_cast<float>(info.sides.value);
+		for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& uv, size_t) {
+			const simd::Vec<2> p{ uv[0] * 2.0f - 1.0f, uv[1] * 2.0f - 1.0f };
+			const simd::Float4 a = simd::map([](const float y, const float x) { return std::atan2(y, x); }, p[0], p[1]) + angle;
+			const simd::Float4 d = simd::map([](const float x) { return std::cos(x); }, simd::floor(0.5f + a / r) * r - a) * simd::length(p) / info.radius.value;
+			return grey4(1.0f - linearstep(0.8f - info.gradient.value, 0.8f, d));
+			});
+	}
+
+	void evaluate_kernel(const NodeNoise::Info& info, const KernelContext& context, Image& output) {
+		switch (info.dimension.value) {
+		case 0:
+			evaluate_noise<1>(info, context, output);
+			break;
+		case 1:
+			evaluate_noise<2>(info, context, output);
+			break;
+		case 2:
+			evaluate_noise<3>(info, context, output);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void evaluate_kernel(const NodeVoronoi::Info& info, const KernelContext& context, Image& output) {
+		if (info.dimension.value == 0) {
+			evaluate_voronoi<2>(info, context, output);
+		}
+		else {
+			evaluate_voronoi<3>(info, context, output);
+		}
+	}
+
+	void evaluate_kernel(const NodeTransform::Info& info, const KernelContext& context, Image& output) {
+		auto const input = context.input(info.texture.value);
+		auto trans_mat = [](const glm::vec2 t) {
+			return glm::mat3(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(t, 1.0f));
+		};
+		const float rotation = glm::radians(info.rotation.value);
+		const glm::mat3 rot_mat(
+			glm::vec3(std::cos(rotation), -std::sin(rotation), 0.0f),
+			glm::vec3(std::sin(rotation), std::cos(rotation), 0.0f),
+			glm::vec3(0.0f, 0.0f, 1.0f));
+		const glm::mat3 scale_mat(
+			glm::vec3(info.scale_x.value, 0.0f, 0.0f),
+			glm::vec3(0.0f, info.scale_y.value, 0.0f),
+			glm::vec3(0.0f, 0.0f, 1.0f));
+		const glm::mat3 inverse_trans = glm::inverse(
+			trans_mat({ 0.5f, 0.5f }) *
+			trans_mat({ info.shift_x.value, info.shift_y.value }) *
+			rot_mat *
+			scale_mat *
+			trans_mat({ -0.5f, -0.5f }));
+
+		for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& frag_uv, size_t) {
+			if (!input) {
+				return simd::Vec<4>{ 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+			//inverse_trans * vec3(frag_uv, 1) in the order glm multiplies
+			simd::Vec<2> uv;
+			for (glm::length_t c = 0; c < 2; ++c) {
+				uv[c] = inverse_trans[0][c] * frag_uv[0] + inverse_trans[1][c] * frag_uv[1] + inverse_trans[2][c] * 1.0f;
+				if (info.clamp.value) {
+					uv[c] = simd::clamp(uv[c], 0.0f, 1.0f);
+				}
+			}
+			return input->sample4(uv);
+			});
+	}
+
+	void evaluate_kernel(const NodeBlend::Info& info, const KernelContext& context, Image& output) {
+		auto const foreground = context.input(info.texture1.value.id);
+		auto const background = context.input(info.texture2.value.id);
+		auto const opacity = context.input(info.factor.value.id);
+		const auto& foreground_color = info.texture1.value.color;
+		const auto& background_color = info.texture2.value.color;
+
+		parallel_for_tiles(context.thread_pool, output.width, output.height, [&](const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1) {
+			const uint32_t n = x1 - x0;
+			std::array<std::vector<float>, 9> scratch;
+			for (uint32_t y = y0; y < y1; ++y) {
+				std::array<const float*, 4> a, b;
+				for (size_t c = 0; c < 4; ++c) {
+					a[c] = channel_row(foreground, c, output, y, x0, x1, foreground_color[c], scratch[c]);
+					b[c] = channel_row(background, c, output, y, x0, x1, background_color[c], scratch[4 + c]);
+				}
+				const float* o = channel_row(opacity, 0, output, y, x0, x1, info.factor.value.number, scratch[8]);
+				const size_t row = output.index(x0, y);
+				visit_blend_mode(info.mode.value, [&](auto&& compute) {
+					for (uint32_t x = 0; x < n; x += 4) {
+						const uint32_t count = std::min(n - x, 4u);
+						const simd::Float4 alpha_a = load_lanes(&o[x], count) * load_lanes(&a[3][x], count);
+						const simd::Float4 alpha_b = load_lanes(&b[3][x], count);
+						const simd::Float4 alpha_o = alpha_a + alpha_b - alpha_a * alpha_b;
+						const simd::Float4 alpha_ab = alpha_a * alpha_b;
+						store_lanes(&output.channels[3][row + x], alpha_o, count);
+						for (size_t c = 0; c < 3; ++c) {
+							const simd::Float4 col_a = load_lanes(&a[c][x], count);
+							const simd::Float4 col_b = load_lanes(&b[c][x], count);
+							store_lanes(&output.channels[c][row + x], (col_a * alpha_a + col_b * alpha_b - alpha_ab * (col_a + col_b - compute(col_a, col_b))) / alpha_o, count);
+						}
+					}
+					});
+			}
+			});
+	}
+
+	void evaluate_kernel(const NodeColorRamp::Info& info, const KernelContext& context, Image& output) {
+		//same table as ImGradient::refreshCache, read through the clamp-to-edge linear sampler of the ramp texture
+		constexpr size_t ramp_size = 256;
+		std::array<glm::vec4, ramp_size> ramp;
+		for (size_t i = 0; i < ramp_size; ++i) {
+			const float position = static_cast<float>(i) / 255.0f;
+			const ImGradientMark* lower = nullptr;
+			const ImGradientMark* upper = nullptr;
+			for (const auto& mark : context.color_ramp) {
+				if (mark.position < position && (!lower || lower->position < mark.position)) {
+					lower = &mark;
+				}
+				if (mark.position >= position && (!upper || upper->position > mark.position)) {
+					upper = &mark;
+				}
+			}
+			if (!lower) {
+				lower = upper;
+			}
+			if (!upper) {
+				upper = lower;
+			}
+			if (!lower) {
+				ramp[i] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+			else if (upper == lower) {
+				ramp[i] = { upper->color[0], upper->color[1], upper->color[2], 1.0f };
+			}
+			else {
+				const float delta = (position - lower->position) / (upper->position - lower->position);
+				ramp[i] = glm::mix(
+					glm::vec4{ lower->color[0], lower->color[1], lower->color[2], 1.0f },
+					glm::vec4{ upper->color[0], upper->color[1], upper->color[2], 1.0f },
+					delta);
+			}
+		}
+		//the table reads are scalar, the addressing and interpolation run in lanes
+		auto lookup = [&](const simd::Float4 factor) {
+			const simd::Float4 position = simd::clamp(factor * static_cast<float>(ramp_size) - 0.5f, 0.0f, static_cast<float>(ramp_size - 1));
+			const simd::UInt4 i0 = simd::to_int(position);
+			alignas(16) std::array<uint32_t, 4> i0_lanes;
+			_mm_store_si128(reinterpret_cast<__m128i*>(i0_lanes.data()), i0.v);
+			const simd::Float4 f = position - simd::to_float(i0);
+			simd::Vec<4> color;
+			for (glm::length_t c = 0; c < 4; ++c) {
+				alignas(16) std::array<float, 4> c0, c1;
+				for (size_t lane = 0; lane < 4; ++lane) {
+					c0[lane] = ramp[i0_lanes[lane]][c];
+					c1[lane] = ramp[std::min<size_t>(i0_lanes[lane] + 1, ramp_size - 1)][c];
+				}
+				color[c] = simd::mix(simd::Float4::load(c0.data()), simd::Float4::load(c1.data()), f);
+			}
+			return color;
+		};
+
+		auto const input = context.input(info.texture.value);
+		for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& uv, const size_t i) {
+			return lookup(input ? fetch4(*input, output, uv, i)[0] : uv[0]);
+			});
+	}
+
+	void evaluate_kernel(const NodeBlur::Info& info, const KernelContext& context, Image& output) {
+		auto const input = context.input(info.texture.value);
+		auto const intensity_image = context.input(info.intensity.value.id);
+		const int32_t samples = info.samples.value;
+		if (!input) {
+			for_each_pixel4(context.thread_pool, output, [](const simd::Vec<2>&, size_t) {
+				return simd::Vec<4>{ 0.0f, 0.0f, 0.0f, 1.0f };
+				});
+			return;
+		}
+		if (samples / 2 == 0) {
+			for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& uv, const size_t i) {
+				auto color = fetch4(*input, output, uv, i);
+				color[3] = 1.0f;
+				return color;
+				});
+			return;
+		}
+		if (!intensity_image && same_size(*input, output)) {
+			blur_separable(context.thread_pool, *input, info.intensity.value.number, samples, output);
+			return;
+		}
+
+		const float sigma = static_cast<float>(samples) * 0.25f;
+		const glm::vec2 ps = 1.0f / glm::vec2(input->width, input->height);
+		for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& uv, const size_t i) {
+			const simd::Float4 intensity = intensity_image
+				? simd::clamp(fetch4(*intensity_image, output, uv, i)[0], 0.0f, NodeBlur::Info::max_intensity)
+				: simd::Float4(info.intensity.value.number);
+			const simd::Vec<2> scale{ ps.x * intensity, ps.y * intensity };
+			simd::Vec<4> col{ 0.0f, 0.0f, 0.0f, 1.0f };
+			float accum = 0.0f;
+			for (int32_t x = -samples / 2; x < samples / 2; ++x) {
+				for (int32_t y = -samples / 2; y < samples / 2; ++y) {
+					const glm::vec2 offset(x, y);
+					const float weight = std::exp(-glm::dot(offset, offset) / (2.0f * sigma * sigma));
+					const auto color = input->sample4({ uv[0] + scale[0] * offset.x, uv[1] + scale[1] * offset.y });
+					for (size_t c = 0; c < 3; ++c) {
+						col[c] += color[c] * weight;
+					}
+					accum += weight;
+				}
+			}
+			for (size_t c = 0; c < 3; ++c) {
+				col[c] /= accum;
+			}
+			return col;
+			});
+	}
+
+	void evaluate_kernel(const NodeSlopeBlur::Info& info, const KernelContext& context, Image& output) {
+		auto const input = context.input(info.texture.value);
+		auto const slope = context.input(info.slope.value);
+		auto const intensity_image = context.input(info.intensity.value.id);
+
+		auto calc_slope = [&](const glm::vec2 uv) {
+			if (!slope) {
+				return glm::vec2{ 0.0f };
+			}
+			const glm::vec2 texture_size(slope->width, slope->height);
+			const glm::vec3 sl{
+				slope->sample(uv + glm::vec2(0.0f, 1.0f / texture_size.y)).r,
+				slope->sample(uv + glm::vec2(-1.0f / texture_size.x, -0.5f / texture_size.y)).r,
+				slope->sample(uv + glm::vec2(1.0f / texture_size.x, -0.5f / texture_size.y)).r,
+			};
+			return glm::vec2{ sl.z - sl.y, glm::dot(sl, glm::vec3(1.0f, -0.5f, -0.5f)) };
+		};
+
+		for_each_pixel(context.thread_pool, output, [&](const glm::vec2 frag_uv, const size_t i) {
+			if (!input) {
+				return glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+			const float intensity = intensity_image ? fetch(*intensity_image, output, frag_uv, i).r : info.intensity.value.number;
+			const auto iterations = static_cast<int32_t>(std::ceil(info.quality.value * intensity));
+			if (iterations <= 0) {
+				return glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+			const glm::vec2 blur_texture_size(input->width, input->height);
+			glm::vec3 color{ 0.0f };
+			glm::vec2 uv = frag_uv;
+			for (int32_t iteration = 0; iteration < iterations; ++iteration) {
+				const glm::vec2 slope_value = calc_slope(uv) * blur_texture_size;
+				uv += slope_value * (intensity / blur_texture_size.x) * (intensity / static_cast<float>(iterations));
+				color += glm::vec3(input->sample(uv));
+			}
+			return glm::vec4(color / static_cast<float>(iterations), 1.0f);
+			});
+	}
+
+	void evaluate_kernel(const NodeNormal::Info& info, const KernelContext& context, Image& output) {
+		auto const input = context.input(info.texture.value);
+		auto get_height = [&](const simd::Vec<2>& uv) {
+			return input ? input->sample4(uv)[0] : simd::Float4(0.0f);
+		};
+		const glm::vec2 texture_size = input ? glm::vec2(input->width, input->height) : glm::vec2(output.width, output.height);
+		const glm::vec2 sample_step = (1.0f / (info.match_size.value ? texture_size : glm::vec2(1024.0f))) * info.max_range.value;
+		const float strength = -0.1f * info.strength.value;
+
+		for_each_pixel4(context.thread_pool, output, [&](const simd::Vec<2>& uv, size_t) {
+			const simd::Float4 height = get_height(uv);
+			const simd::Vec<2> dxy{
+				height - get_height({ uv[0] + sample_step.x, uv[1] + 0.0f }),
+				height - get_height({ uv[0] + 0.0f, uv[1] + sample_step.y }),
+			};
+			const simd::Vec<3> normal = simd::normalize(simd::Vec<3>{ dxy[0] * strength / sample_step.x, dxy[1] * strength / sample_step.y, 1.0f });
+			return simd::Vec<4>{ normal[0] * 0.5f + 0.5f, normal[1] * 0.5f + 0.5f, normal[2] * 0.5f + 0.5f, 1.0f };
+			});
+	}
+
+	void evaluate_kernel(const NodeNormalCompute::Info& info, const KernelContext& context, Image& output) {
+		NodeNormal::Info normal_info;
+		normal_info.texture = info.texture;
+		normal_info.strength = info.strength;
+		normal_info.max_range = info.max_range;
+		normal_info.match_size = info.match_size;
+		evaluate_kernel(normal_info, context, output);
+	}
+
+	void evaluate_kernel(const NodeUdf::Info& info, const KernelContext& context, Image& output) {
+		//jump flooding with the pass sequence recorded by ComponentUdf, including which ping-pong image the last pass reads
+		constexpr uint16_t invalid_coord = 0xFFFF;
+		const int32_t width = static_cast<int32_t>(output.width);
+		const int32_t height = static_cast<int32_t>(output.height);
+		auto const input = context.input(info.texture.value);
+		std::array<std::vector<glm::u16vec2>, 2> ping_pong;
+		for (auto& image : ping_pong) {
+			image.resize(static_cast<size_t>(width) * height);
+		}
+
+		for_each_pixel(context.thread_pool, output, [&](const glm::vec2 uv, const size_t i) {
+			const float level = input ? fetch(*input, output, uv, i).r : 1.0f;
+			ping_pong[0][i] = level < 0.5f
+				? glm::u16vec2(i % output.width, i / output.width)
+				: glm::u16vec2(invalid_coord, 0);
+			return glm::vec4{ 0.0f };
+			});
+
+		auto process = [&](const int32_t idx) {
+			const bool in0_out1 = idx % 2 == 1;
+			const auto& src = ping_pong[in0_out1 ? 0 : 1];
+			auto& dst = ping_pong[in0_out1 ? 1 : 0];
+			const int32_t stride = idx > 0 ? width >> idx : 1;
+			parallel_for_tiles(context.thread_pool, output.width, output.height, [&](const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1) {
+				for (uint32_t y = y0; y < y1; ++y) {
+					for (uint32_t x = x0; x < x1; ++x) {
+						const glm::ivec2 coord(x, y);
+						const size_t i = output.index(x, y);
+						glm::u16vec2 best_coord = src[i];
+						uint32_t best_dist = 0xFFFFFFFF;
+						for (int32_t di = -1; di <= 1; ++di) {
+							for (int32_t dj = -1; dj <= 1; ++dj) {
+								const glm::ivec2 offset_coord = coord + stride * glm::ivec2(di, dj);
+								if (offset_coord.x < 0 || offset_coord.y < 0 || offset_coord.x >= width || offset_coord.y >= height) {
+									continue;
+								}
+								const glm::u16vec2 offset_stored_coord = src[static_cast<size_t>(offset_coord.y) * width + offset_coord.x];
+								if (offset_stored_coord.x < invalid_coord) {
+									const glm::ivec2 d = glm::ivec2(offset_stored_coord) - coord;
+									const auto dist = static_cast<uint32_t>(d.x * d.x + d.y * d.y);
+									if (dist < best_dist) {
+										best_coord = offset_stored_coord;
+										best_dist = dist;
+									}
+								}
+							}
+						}
+						if (idx < 0) {
+							const float distance = std::sqrt(static_cast<float>(best_dist)) / info.max_distance.value;
+							output.store(i, { distance, distance, distance, distance });
+						}
+						else {
+							dst[i] = best_coord;
+						}
+					}
+				}
+				});
+		};
+
+		int32_t idx = 1;
+		while (width >> idx) {
+			process(idx);
+			++idx;
+		}
+		process(idx - 1);  //the extra dispatch reuses the last pushed constant
+		process(-1);
+	}
+
+	void resolve_format(ThreadPool& thread_pool, Image& image) {
+		const bool single_channel = image.format == VK_FORMAT_R16_UNORM || image.format == VK_FORMAT_R8_UNORM;
+		const bool normalized = single_channel ||
+			image.format == VK_FORMAT_R8G8B8A8_UNORM ||
+			image.format == VK_FORMAT_R8G8B8A8_SRGB ||
+			image.format == VK_FORMAT_R16G16B16A16_UNORM;
+		if (!normalized) {
+			return;
+		}
+		parallel_for_tiles(thread_pool, image.width, image.height, [&](const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1) {
+			for (size_t c = 0; c < 4; ++c) {
+				for (uint32_t y = y0; y < y1; ++y) {
+					float* row = &image.channels[c][image.index(x0, y)];
+					if (single_channel && c > 0) {
+						std::fill_n(row, x1 - x0, c == 3 ? 1.0f : 0.0f);
+					}
+					else {
+						for (uint32_t x = 0; x < x1 - x0; x += 4) {
+							const uint32_t count = std::min(x1 - x0 - x, 4u);
+							store_lanes(&row[x], simd::clamp(load_lanes(&row[x], count), 0.0f, 1.0f), count);
+						}
+					}
+				}
+			}
+			});
+	}
+}
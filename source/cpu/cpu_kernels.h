@@ -0,0 +1,39 @@
+#pragma once
+#include "cpu_image.h"
+#include "../gui/all_node_headers.h"
+#include "../util/thread_pool.h"
+
+#include <functional>
+#include <vector>
+
+namespace cpu {
+	//Everything a kernel reads besides its Info: texture ids in the Info resolve through input(), like the bindless set on the GPU
+	struct KernelContext {
+		ThreadPool& thread_pool;
+		std::function<const Image* (int32_t)> input;
+		std::vector<ImGradientMark> color_ramp;
+	};
+
+	//CPU counterparts of the node shaders in assets/glsl_shaders, evaluated in 64x64 tiles on the thread pool. Generators and
+	//sampling kernels run four pixels of a row per call in SSE2 lanes (cpu_simd.h), row kernels loop over contiguous planes
+	void evaluate_kernel(const NodeUniformColor::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodePolygon::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeNoise::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeVoronoi::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeTransform::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeBlend::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeColorRamp::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeBlur::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeSlopeBlur::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeNormal::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeNormalCompute::Info& info, const KernelContext& context, Image& output);
+	void evaluate_kernel(const NodeUdf::Info& info, const KernelContext& context, Image& output);
+
+	template<typename InfoT>
+	concept KernelInfo = requires(const InfoT& info, const KernelContext& context, Image& output) {
+		evaluate_kernel(info, context, output);
+	};
+
+	//Emulates the render target: single channel formats read back as (r, 0, 0, 1) and normalized formats clamp to [0, 1]
+	void resolve_format(ThreadPool& thread_pool, Image& image);
+}
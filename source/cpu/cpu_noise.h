@@ -0,0 +1,555 @@
+#pragma once
+//C++ ports of assets/glsl_shaders/include/{hash,noise,fractal_noise}.glsl, kept line for line so both backends hash identically
+//From Blender: https://github.com/blender/blender/blob/master/source/blender/gpu/shaders/material/gpu_shader_material_hash.glsl
+
+#include "cpu_simd.h"
+
+#include <glm/glm.hpp>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace cpu {
+	/* ***** Jenkins Lookup3 Hash Functions ***** */
+
+	/* Source: http://burtleburtle.net/bob/c/lookup3.c */
+	constexpr uint32_t hash_rot(const uint32_t x, const uint32_t k) {
+		return (x << k) | (x >> (32 - k));
+	}
+
+	constexpr void hash_mix(uint32_t& a, uint32_t& b, uint32_t& c) {
+		a -= c; a ^= hash_rot(c, 4); c += b;
+		b -= a; b ^= hash_rot(a, 6); a += c;
+		c -= b; c ^= hash_rot(b, 8); b += a;
+		a -= c; a ^= hash_rot(c, 16); c += b;
+		b -= a; b ^= hash_rot(a, 19); a += c;
+		c -= b; c ^= hash_rot(b, 4); b += a;
+	}
+
+	constexpr void hash_final(uint32_t& a, uint32_t& b, uint32_t& c) {
+		c ^= b; c -= hash_rot(b, 14);
+		a ^= c; a -= hash_rot(c, 11);
+		b ^= a; b -= hash_rot(a, 25);
+		c ^= b; c -= hash_rot(b, 16);
+		a ^= c; a -= hash_rot(c, 4);
+		b ^= a; b -= hash_rot(a, 14);
+		c ^= b; c -= hash_rot(b, 24);
+	}
+
+	constexpr uint32_t hash_uint(const uint32_t kx) {
+		uint32_t a, b, c;
+		a = b = c = 0xdeadbeefu + (1u << 2u) + 13u;
+
+		a += kx;
+		hash_final(a, b, c);
+
+		return c;
+	}
+
+	constexpr uint32_t hash_uint2(const uint32_t kx, const uint32_t ky) {
+		uint32_t a, b, c;
+		a = b = c = 0xdeadbeefu + (2u << 2u) + 13u;
+
+		b += ky;
+		a += kx;
+		hash_final(a, b, c);
+
+		return c;
+	}
+
+	constexpr uint32_t hash_uint3(const uint32_t kx, const uint32_t ky, const uint32_t kz) {
+		uint32_t a, b, c;
+		a = b = c = 0xdeadbeefu + (3u << 2u) + 13u;
+
+		c += kz;
+		b += ky;
+		a += kx;
+		hash_final(a, b, c);
+
+		return c;
+	}
+
+	constexpr uint32_t hash_uint4(const uint32_t kx, const uint32_t ky, const uint32_t kz, const uint32_t kw) {
+		uint32_t a, b, c;
+		a = b = c = 0xdeadbeefu + (4u << 2u) + 13u;
+
+		a += kx;
+		b += ky;
+		c += kz;
+		hash_mix(a, b, c);
+
+		a += kw;
+		hash_final(a, b, c);
+
+		return c;
+	}
+
+	constexpr uint32_t hash_int(const int32_t kx) {
+		return hash_uint(static_cast<uint32_t>(kx));
+	}
+
+	constexpr uint32_t hash_int2(const int32_t kx, const int32_t ky) {
+		return hash_uint2(static_cast<uint32_t>(kx), static_cast<uint32_t>(ky));
+	}
+
+	constexpr uint32_t hash_int3(const int32_t kx, const int32_t ky, const int32_t kz) {
+		return hash_uint3(static_cast<uint32_t>(kx), static_cast<uint32_t>(ky), static_cast<uint32_t>(kz));
+	}
+
+	/* Hashing uint or uint[234] into a float in the range [0, 1]. */
+
+	inline float hash_uint_to_float(const uint32_t kx) {
+		return static_cast<float>(hash_uint(kx)) / static_cast<float>(0xFFFFFFFFu);
+	}
+
+	inline float hash_uint2_to_float(const uint32_t kx, const uint32_t ky) {
+		return static_cast<float>(hash_uint2(kx, ky)) / static_cast<float>(0xFFFFFFFFu);
+	}
+
+	inline float hash_uint3_to_float(const uint32_t kx, const uint32_t ky, const uint32_t kz) {
+		return static_cast<float>(hash_uint3(kx, ky, kz)) / static_cast<float>(0xFFFFFFFFu);
+	}
+
+	inline float hash_uint4_to_float(const uint32_t kx, const uint32_t ky, const uint32_t kz, const uint32_t kw) {
+		return static_cast<float>(hash_uint4(kx, ky, kz, kw)) / static_cast<float>(0xFFFFFFFFu);
+	}
+
+	/* Hashing float or vec[234] into a float in the range [0, 1]. */
+
+	inline float hash_float_to_float(const float k) {
+		return hash_uint_to_float(std::bit_cast<uint32_t>(k));
+	}
+
+	inline float hash_vec2_to_float(const glm::vec2 k) {
+		return hash_uint2_to_float(std::bit_cast<uint32_t>(k.x), std::bit_cast<uint32_t>(k.y));
+	}
+
+	inline float hash_vec3_to_float(const glm::vec3 k) {
+		return hash_uint3_to_float(std::bit_cast<uint32_t>(k.x), std::bit_cast<uint32_t>(k.y), std::bit_cast<uint32_t>(k.z));
+	}
+
+	inline float hash_vec4_to_float(const glm::vec4 k) {
+		return hash_uint4_to_float(std::bit_cast<uint32_t>(k.x), std::bit_cast<uint32_t>(k.y), std::bit_cast<uint32_t>(k.z), std::bit_cast<uint32_t>(k.w));
+	}
+
+	/* Hashing vec[234] into vec[234] of components in the range [0, 1]. */
+
+	inline glm::vec2 hash_vec2_to_vec2(const glm::vec2 k) {
+		return { hash_vec2_to_float(k), hash_vec3_to_float(glm::vec3(k, 1.0f)) };
+	}
+
+	inline glm::vec3 hash_vec3_to_vec3(const glm::vec3 k) {
+		return { hash_vec3_to_float(k), hash_vec4_to_float(glm::vec4(k, 1.0f)), hash_vec4_to_float(glm::vec4(k, 2.0f)) };
+	}
+
+	inline glm::vec3 hash_vec2_to_vec3(const glm::vec2 k) {
+		return { hash_vec2_to_float(k), hash_vec3_to_float(glm::vec3(k, 1.0f)), hash_vec3_to_float(glm::vec3(k, 2.0f)) };
+	}
+
+	//From Blender: https://github.com/blender/blender/blob/master/source/blender/gpu/shaders/material/gpu_shader_material_noise.glsl
+	inline void floor_frac(const float x, int32_t& x_int, float& x_fract) {
+		const float x_floor = std::floor(x);
+		x_int = static_cast<int32_t>(x_floor);
+		x_fract = x - x_floor;
+	}
+
+	constexpr float bi_mix(const float v0, const float v1, const float v2, const float v3, const float x, const float y) {
+		const float x1 = 1.0f - x;
+		return (1.0f - y) * (v0 * x1 + v1 * x) + y * (v2 * x1 + v3 * x);
+	}
+
+	constexpr float tri_mix(const float v0, const float v1, const float v2, const float v3,
+		const float v4, const float v5, const float v6, const float v7,
+		const float x, const float y, const float z) {
+		const float x1 = 1.0f - x;
+		const float y1 = 1.0f - y;
+		const float z1 = 1.0f - z;
+		return z1 * (y1 * (v0 * x1 + v1 * x) + y * (v2 * x1 + v3 * x)) +
+			z * (y1 * (v4 * x1 + v5 * x) + y * (v6 * x1 + v7 * x));
+	}
+
+	constexpr float fade(const float t) {
+		return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+	}
+
+	constexpr float negate_if(const float value, const uint32_t condition) {
+		return (condition != 0u) ? -value : value;
+	}
+
+	constexpr float noise_grad(const uint32_t hash, const float x) {
+		const uint32_t h = hash & 15u;
+		const float g = static_cast<float>(1u + (h & 7u));
+		return negate_if(g, h & 8u) * x;
+	}
+
+	constexpr float noise_grad(const uint32_t hash, const float x, const float y) {
+		const uint32_t h = hash & 7u;
+		const float u = h < 4u ? x : y;
+		const float v = 2.0f * (h < 4u ? y : x);
+		return negate_if(u, h & 1u) + negate_if(v, h & 2u);
+	}
+
+	constexpr float noise_grad(const uint32_t hash, const float x, const float y, const float z) {
+		const uint32_t h = hash & 15u;
+		const float u = h < 8u ? x : y;
+		const float vt = ((h == 12u) || (h == 14u)) ? x : z;
+		const float v = h < 4u ? y : vt;
+		return negate_if(u, h & 1u) + negate_if(v, h & 2u);
+	}
+
+	inline float noise_perlin(const float x) {
+		int32_t X;
+		float fx;
+		floor_frac(x, X, fx);
+
+		const float u = fade(fx);
+		return glm::mix(noise_grad(hash_int(X), fx), noise_grad(hash_int(X + 1), fx - 1.0f), u);
+	}
+
+	inline float noise_perlin(const glm::vec2 vec) {
+		int32_t X, Y;
+		float fx, fy;
+		floor_frac(vec.x, X, fx);
+		floor_frac(vec.y, Y, fy);
+
+		const float u = fade(fx);
+		const float v = fade(fy);
+
+		return bi_mix(noise_grad(hash_int2(X, Y), fx, fy),
+			noise_grad(hash_int2(X + 1, Y), fx - 1.0f, fy),
+			noise_grad(hash_int2(X, Y + 1), fx, fy - 1.0f),
+			noise_grad(hash_int2(X + 1, Y + 1), fx - 1.0f, fy - 1.0f),
+			u,
+			v);
+	}
+
+	inline float noise_perlin(const glm::vec3 vec) {
+		int32_t X, Y, Z;
+		float fx, fy, fz;
+		floor_frac(vec.x, X, fx);
+		floor_frac(vec.y, Y, fy);
+		floor_frac(vec.z, Z, fz);
+
+		const float u = fade(fx);
+		const float v = fade(fy);
+		const float w = fade(fz);
+
+		return tri_mix(noise_grad(hash_int3(X, Y, Z), fx, fy, fz),
+			noise_grad(hash_int3(X + 1, Y, Z), fx - 1, fy, fz),
+			noise_grad(hash_int3(X, Y + 1, Z), fx, fy - 1, fz),
+			noise_grad(hash_int3(X + 1, Y + 1, Z), fx - 1, fy - 1, fz),
+			noise_grad(hash_int3(X, Y, Z + 1), fx, fy, fz - 1),
+			noise_grad(hash_int3(X + 1, Y, Z + 1), fx - 1, fy, fz - 1),
+			noise_grad(hash_int3(X, Y + 1, Z + 1), fx, fy - 1, fz - 1),
+			noise_grad(hash_int3(X + 1, Y + 1, Z + 1), fx - 1, fy - 1, fz - 1),
+			u,
+			v,
+			w);
+	}
+
+	/* Remap the output of noise to a predictable range [-1, 1].
+	 * The scale values were computed experimentally by the OSL developers.
+	 */
+	inline float snoise(const float p) {
+		const float r = noise_perlin(p);
+		return std::isinf(r) ? 0.0f : 0.2500f * r;
+	}
+
+	inline float snoise(const glm::vec2 p) {
+		const float r = noise_perlin(p);
+		return std::isinf(r) ? 0.0f : 0.6616f * r;
+	}
+
+	inline float snoise(const glm::vec3 p) {
+		const float r = noise_perlin(p);
+		return std::isinf(r) ? 0.0f : 0.9820f * r;
+	}
+
+	template<typename T>
+	float noise(const T p) {
+		return 0.5f * snoise(p) + 0.5f;
+	}
+
+	//From Blender: https://github.com/blender/blender/blob/master/source/blender/gpu/shaders/material/gpu_shader_material_fractal_noise.glsl
+	template<typename T>
+	float fractal_noise(const T p, float octaves, const float roughness) {
+		float fscale = 1.0f;
+		float amp = 1.0f;
+		float maxamp = 0.0f;
+		float sum = 0.0f;
+		octaves = glm::clamp(octaves, 0.0f, 15.0f);
+		const int n = static_cast<int>(octaves);
+		for (int i = 0; i <= n; i++) {
+			const float t = noise(fscale * p);
+			sum += t * amp;
+			maxamp += amp;
+			amp *= glm::clamp(roughness, 0.0f, 1.0f);
+			fscale *= 2.0f;
+		}
+		const float rmd = octaves - std::floor(octaves);
+		if (rmd != 0.0f) {
+			const float t = noise(fscale * p);
+			float sum2 = sum + t * amp;
+			sum /= maxamp;
+			sum2 /= maxamp + amp;
+			return (1.0f - rmd) * sum + rmd * sum2;
+		}
+		return sum / maxamp;
+	}
+
+	//Four lane versions of the functions above, so the generators evaluate four pixels of a row per call. They do the
+	//same float operations in the same order and hash to the same bits; std::isinf and branches become lane selects
+	namespace simd {
+		template<int K>
+		UInt4 hash_rot(const UInt4 x) {
+			return shift_left<K>(x) | shift_right<32 - K>(x);
+		}
+
+		inline void hash_mix(UInt4& a, UInt4& b, UInt4& c) {
+			a -= c; a ^= hash_rot<4>(c); c += b;
+			b -= a; b ^= hash_rot<6>(a); a += c;
+			c -= b; c ^= hash_rot<8>(b); b += a;
+			a -= c; a ^= hash_rot<16>(c); c += b;
+			b -= a; b ^= hash_rot<19>(a); a += c;
+			c -= b; c ^= hash_rot<4>(b); b += a;
+		}
+
+		inline void hash_final(UInt4& a, UInt4& b, UInt4& c) {
+			c ^= b; c -= hash_rot<14>(b);
+			a ^= c; a -= hash_rot<11>(c);
+			b ^= a; b -= hash_rot<25>(a);
+			c ^= b; c -= hash_rot<16>(b);
+			a ^= c; a -= hash_rot<4>(c);
+			b ^= a; b -= hash_rot<14>(a);
+			c ^= b; c -= hash_rot<24>(b);
+		}
+
+		inline UInt4 hash_uint(const UInt4 kx) {
+			UInt4 a = 0xdeadbeefu + (1u << 2u) + 13u;
+			UInt4 b = a;
+			UInt4 c = a;
+
+			a += kx;
+			hash_final(a, b, c);
+
+			return c;
+		}
+
+		inline UInt4 hash_uint2(const UInt4 kx, const UInt4 ky) {
+			UInt4 a = 0xdeadbeefu + (2u << 2u) + 13u;
+			UInt4 b = a;
+			UInt4 c = a;
+
+			b += ky;
+			a += kx;
+			hash_final(a, b, c);
+
+			return c;
+		}
+
+		inline UInt4 hash_uint3(const UInt4 kx, const UInt4 ky, const UInt4 kz) {
+			UInt4 a = 0xdeadbeefu + (3u << 2u) + 13u;
+			UInt4 b = a;
+			UInt4 c = a;
+
+			c += kz;
+			b += ky;
+			a += kx;
+			hash_final(a, b, c);
+
+			return c;
+		}
+
+		inline UInt4 hash_uint4(const UInt4 kx, const UInt4 ky, const UInt4 kz, const UInt4 kw) {
+			UInt4 a = 0xdeadbeefu + (4u << 2u) + 13u;
+			UInt4 b = a;
+			UInt4 c = a;
+
+			a += kx;
+			b += ky;
+			c += kz;
+			hash_mix(a, b, c);
+
+			a += kw;
+			hash_final(a, b, c);
+
+			return c;
+		}
+
+		inline Float4 hash_to_float(const UInt4 hash) {
+			return to_float(hash) / static_cast<float>(0xFFFFFFFFu);
+		}
+
+		inline Float4 hash_float_to_float(const Float4 k) {
+			return hash_to_float(hash_uint(bit_cast_uint(k)));
+		}
+
+		inline Float4 hash_vec2_to_float(const Float4 x, const Float4 y) {
+			return hash_to_float(hash_uint2(bit_cast_uint(x), bit_cast_uint(y)));
+		}
+
+		inline Float4 hash_vec3_to_float(const Float4 x, const Float4 y, const Float4 z) {
+			return hash_to_float(hash_uint3(bit_cast_uint(x), bit_cast_uint(y), bit_cast_uint(z)));
+		}
+
+		inline Float4 hash_vec4_to_float(const Float4 x, const Float4 y, const Float4 z, const Float4 w) {
+			return hash_to_float(hash_uint4(bit_cast_uint(x), bit_cast_uint(y), bit_cast_uint(z), bit_cast_uint(w)));
+		}
+
+		inline Vec<2> hash_vec2_to_vec2(const Vec<2>& k) {
+			return { hash_vec2_to_float(k[0], k[1]), hash_vec3_to_float(k[0], k[1], 1.0f) };
+		}
+
+		inline Vec<3> hash_vec3_to_vec3(const Vec<3>& k) {
+			return { hash_vec3_to_float(k[0], k[1], k[2]), hash_vec4_to_float(k[0], k[1], k[2], 1.0f), hash_vec4_to_float(k[0], k[1], k[2], 2.0f) };
+		}
+
+		inline void floor_frac(const Float4 x, UInt4& x_int, Float4& x_fract) {
+			const Float4 x_floor = floor(x);
+			x_int = to_int(x_floor);
+			x_fract = x - x_floor;
+		}
+
+		inline Float4 bi_mix(const Float4 v0, const Float4 v1, const Float4 v2, const Float4 v3, const Float4 x, const Float4 y) {
+			const Float4 x1 = 1.0f - x;
+			return (1.0f - y) * (v0 * x1 + v1 * x) + y * (v2 * x1 + v3 * x);
+		}
+
+		inline Float4 tri_mix(const Float4 v0, const Float4 v1, const Float4 v2, const Float4 v3,
+			const Float4 v4, const Float4 v5, const Float4 v6, const Float4 v7,
+			const Float4 x, const Float4 y, const Float4 z) {
+			const Float4 x1 = 1.0f - x;
+			const Float4 y1 = 1.0f - y;
+			const Float4 z1 = 1.0f - z;
+			return z1 * (y1 * (v0 * x1 + v1 * x) + y * (v2 * x1 + v3 * x)) +
+				z * (y1 * (v4 * x1 + v5 * x) + y * (v6 * x1 + v7 * x));
+		}
+
+		inline Float4 fade(const Float4 t) {
+			return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+		}
+
+		inline Float4 negate_if(const Float4 value, const UInt4 condition) {
+			return select(not_zero(condition), -value, value);
+		}
+
+		inline Float4 noise_grad(const UInt4 hash, const Float4 x) {
+			const UInt4 h = hash & 15u;
+			const Float4 g = to_float(1u + (h & 7u));
+			return negate_if(g, h & 8u) * x;
+		}
+
+		inline Float4 noise_grad(const UInt4 hash, const Float4 x, const Float4 y) {
+			const UInt4 h = hash & 7u;
+			const UInt4 h_below_4 = h < 4u;
+			const Float4 u = select(h_below_4, x, y);
+			const Float4 v = 2.0f * select(h_below_4, y, x);
+			return negate_if(u, h & 1u) + negate_if(v, h & 2u);
+		}
+
+		inline Float4 noise_grad(const UInt4 hash, const Float4 x, const Float4 y, const Float4 z) {
+			const UInt4 h = hash & 15u;
+			const Float4 u = select(h < 8u, x, y);
+			const Float4 vt = select((h == 12u) | (h == 14u), x, z);
+			const Float4 v = select(h < 4u, y, vt);
+			return negate_if(u, h & 1u) + negate_if(v, h & 2u);
+		}
+
+		inline Float4 noise_perlin(const Vec<1>& vec) {
+			UInt4 X;
+			Float4 fx;
+			floor_frac(vec[0], X, fx);
+
+			const Float4 u = fade(fx);
+			return mix(noise_grad(hash_uint(X), fx), noise_grad(hash_uint(X + 1u), fx - 1.0f), u);
+		}
+
+		inline Float4 noise_perlin(const Vec<2>& vec) {
+			UInt4 X, Y;
+			Float4 fx, fy;
+			floor_frac(vec[0], X, fx);
+			floor_frac(vec[1], Y, fy);
+
+			const Float4 u = fade(fx);
+			const Float4 v = fade(fy);
+
+			return bi_mix(noise_grad(hash_uint2(X, Y), fx, fy),
+				noise_grad(hash_uint2(X + 1u, Y), fx - 1.0f, fy),
+				noise_grad(hash_uint2(X, Y + 1u), fx, fy - 1.0f),
+				noise_grad(hash_uint2(X + 1u, Y + 1u), fx - 1.0f, fy - 1.0f),
+				u,
+				v);
+		}
+
+		inline Float4 noise_perlin(const Vec<3>& vec) {
+			UInt4 X, Y, Z;
+			Float4 fx, fy, fz;
+			floor_frac(vec[0], X, fx);
+			floor_frac(vec[1], Y, fy);
+			floor_frac(vec[2], Z, fz);
+
+			const Float4 u = fade(fx);
+			const Float4 v = fade(fy);
+			const Float4 w = fade(fz);
+
+			return tri_mix(noise_grad(hash_uint3(X, Y, Z), fx, fy, fz),
+				noise_grad(hash_uint3(X + 1u, Y, Z), fx - 1.0f, fy, fz),
+				noise_grad(hash_uint3(X, Y + 1u, Z), fx, fy - 1.0f, fz),
+				noise_grad(hash_uint3(X + 1u, Y + 1u, Z), fx - 1.0f, fy - 1.0f, fz),
+				noise_grad(hash_uint3(X, Y, Z + 1u), fx, fy, fz - 1.0f),
+				noise_grad(hash_uint3(X + 1u, Y, Z + 1u), fx - 1.0f, fy, fz - 1.0f),
+				noise_grad(hash_uint3(X, Y + 1u, Z + 1u), fx, fy - 1.0f, fz - 1.0f),
+				noise_grad(hash_uint3(X + 1u, Y + 1u, Z + 1u), fx - 1.0f, fy - 1.0f, fz - 1.0f),
+				u,
+				v,
+				w);
+		}
+
+		template<size_t N>
+		Float4 snoise(const Vec<N>& p) {
+			constexpr float scale = N == 1 ? 0.2500f : N == 2 ? 0.6616f : 0.9820f;
+			const Float4 r = noise_perlin(p);
+			return select(is_inf(r), 0.0f, scale * r);
+		}
+
+		template<size_t N>
+		Float4 noise(const Vec<N>& p) {
+			return 0.5f * snoise(p) + 0.5f;
+		}
+
+		template<size_t N>
+		Vec<N> scale_vec(const float scale, const Vec<N>& p) {
+			Vec<N> scaled;
+			for (size_t c = 0; c < N; ++c) {
+				scaled[c] = scale * p[c];
+			}
+			return scaled;
+		}
+
+		template<size_t N>
+		Float4 fractal_noise(const Vec<N>& p, float octaves, const float roughness) {
+			float fscale = 1.0f;
+			float amp = 1.0f;
+			float maxamp = 0.0f;
+			Float4 sum = 0.0f;
+			octaves = glm::clamp(octaves, 0.0f, 15.0f);
+			const int n = static_cast<int>(octaves);
+			for (int i = 0; i <= n; i++) {
+				const Float4 t = noise(scale_vec(fscale, p));
+				sum += t * amp;
+				maxamp += amp;
+				amp *= glm::clamp(roughness, 0.0f, 1.0f);
+				fscale *= 2.0f;
+			}
+			const float rmd = octaves - std::floor(octaves);
+			if (rmd != 0.0f) {
+				const Float4 t = noise(scale_vec(fscale, p));
+				Float4 sum2 = sum + t * amp;
+				sum /= maxamp;
+				sum2 /= maxamp + amp;
+				return (1.0f - rmd) * sum + rmd * sum2;
+			}
+			return sum / maxamp;
+		}
+	}
+}
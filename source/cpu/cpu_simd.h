@@ -0,0 +1,242 @@
+#pragma once
+//Four float or uint lanes over SSE2, which every x64 CPU has, so the kernels vectorize without depending on /arch flags.
+//Operators mirror the scalar code they replace; comparisons return all-ones lane masks that select() consumes.
+#include <emmintrin.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace cpu::simd {
+	struct Float4 {
+		__m128 v;
+
+		Float4() = default;
+		Float4(const __m128 v) : v(v) {}
+		Float4(const float s) : v(_mm_set1_ps(s)) {}
+
+		[[nodiscard]] static Float4 load(const float* p) noexcept {
+			return _mm_loadu_ps(p);
+		}
+
+		void store(float* p) const noexcept {
+			_mm_storeu_ps(p, v);
+		}
+
+		[[nodiscard]] float operator[](const size_t lane) const noexcept {
+			alignas(16) float lanes[4];
+			_mm_store_ps(lanes, v);
+			return lanes[lane];
+		}
+	};
+
+	struct UInt4 {
+		__m128i v;
+
+		UInt4() = default;
+		UInt4(const __m128i v) : v(v) {}
+		UInt4(const uint32_t s) : v(_mm_set1_epi32(static_cast<int32_t>(s))) {}
+
+		[[nodiscard]] uint32_t operator[](const size_t lane) const noexcept {
+			alignas(16) uint32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+			return lanes[lane];
+		}
+	};
+
+	//N components of a vector, each holding four lanes
+	template<size_t N>
+	using Vec = std::array<Float4, N>;
+
+	inline Float4 operator+(const Float4 a, const Float4 b) { return _mm_add_ps(a.v, b.v); }
+	inline Float4 operator-(const Float4 a, const Float4 b) { return _mm_sub_ps(a.v, b.v); }
+	inline Float4 operator*(const Float4 a, const Float4 b) { return _mm_mul_ps(a.v, b.v); }
+	inline Float4 operator/(const Float4 a, const Float4 b) { return _mm_div_ps(a.v, b.v); }
+	inline Float4 operator-(const Float4 a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+	inline Float4& operator+=(Float4& a, const Float4 b) { return a = a + b; }
+	inline Float4& operator-=(Float4& a, const Float4 b) { return a = a - b; }
+	inline Float4& operator*=(Float4& a, const Float4 b) { return a = a * b; }
+	inline Float4& operator/=(Float4& a, const Float4 b) { return a = a / b; }
+
+	inline Float4 operator<(const Float4 a, const Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+	inline Float4 operator<=(const Float4 a, const Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+	inline Float4 operator>(const Float4 a, const Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+	inline Float4 operator>=(const Float4 a, const Float4 b) { return _mm_cmpge_ps(a.v, b.v); }
+	inline Float4 operator==(const Float4 a, const Float4 b) { return _mm_cmpeq_ps(a.v, b.v); }
+	inline Float4 operator&(const Float4 a, const Float4 b) { return _mm_and_ps(a.v, b.v); }
+	inline Float4 operator|(const Float4 a, const Float4 b) { return _mm_or_ps(a.v, b.v); }
+
+	inline UInt4 operator+(const UInt4 a, const UInt4 b) { return _mm_add_epi32(a.v, b.v); }
+	inline UInt4 operator-(const UInt4 a, const UInt4 b) { return _mm_sub_epi32(a.v, b.v); }
+	inline UInt4 operator^(const UInt4 a, const UInt4 b) { return _mm_xor_si128(a.v, b.v); }
+	inline UInt4 operator&(const UInt4 a, const UInt4 b) { return _mm_and_si128(a.v, b.v); }
+	inline UInt4 operator|(const UInt4 a, const UInt4 b) { return _mm_or_si128(a.v, b.v); }
+	inline UInt4& operator+=(UInt4& a, const UInt4 b) { return a = a + b; }
+	inline UInt4& operator-=(UInt4& a, const UInt4 b) { return a = a - b; }
+	inline UInt4& operator^=(UInt4& a, const UInt4 b) { return a = a ^ b; }
+	inline UInt4 operator==(const UInt4 a, const UInt4 b) { return _mm_cmpeq_epi32(a.v, b.v); }
+
+	//SSE2 compares signed ints, so both operands must stay below 2^31
+	inline UInt4 operator<(const UInt4 a, const UInt4 b) { return _mm_cmplt_epi32(a.v, b.v); }
+
+	template<int K>
+	UInt4 shift_left(const UInt4 a) { return _mm_slli_epi32(a.v, K); }
+
+	template<int K>
+	UInt4 shift_right(const UInt4 a) { return _mm_srli_epi32(a.v, K); }
+
+	inline UInt4 not_zero(const UInt4 a) {
+		return _mm_xor_si128(_mm_cmpeq_epi32(a.v, _mm_setzero_si128()), _mm_set1_epi32(-1));
+	}
+
+	inline Float4 select(const Float4 mask, const Float4 a, const Float4 b) {
+		return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+	}
+
+	inline Float4 select(const UInt4 mask, const Float4 a, const Float4 b) {
+		return select(Float4(_mm_castsi128_ps(mask.v)), a, b);
+	}
+
+	inline UInt4 select(const UInt4 mask, const UInt4 a, const UInt4 b) {
+		return _mm_or_si128(_mm_and_si128(mask.v, a.v), _mm_andnot_si128(mask.v, b.v));
+	}
+
+	[[nodiscard]] inline bool any(const Float4 mask) {
+		return _mm_movemask_ps(mask.v) != 0;
+	}
+
+	//operands swapped so ties and NaNs resolve like std::min and std::max
+	inline Float4 min(const Float4 a, const Float4 b) { return _mm_min_ps(b.v, a.v); }
+	inline Float4 max(const Float4 a, const Float4 b) { return _mm_max_ps(b.v, a.v); }
+	inline Float4 abs(const Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+	inline Float4 sqrt(const Float4 a) { return _mm_sqrt_ps(a.v); }
+
+	inline Float4 clamp(const Float4 x, const Float4 min_value, const Float4 max_value) {
+		return min(max(x, min_value), max_value);
+	}
+
+	//same formula as glm::mix
+	inline Float4 mix(const Float4 x, const Float4 y, const Float4 a) {
+		return x * (1.0f - a) + y * a;
+	}
+
+	//exact for |x| < 2^31, the range a scalar floor and int cast covers
+	inline Float4 floor(const Float4 x) {
+		const Float4 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x.v));
+		return truncated - (Float4(1.0f) & (truncated > x));
+	}
+
+	//truncates like static_cast<int32_t>, returned as the bits of the int
+	inline UInt4 to_int(const Float4 x) {
+		return _mm_cvttps_epi32(x.v);
+	}
+
+	inline Float4 to_float(const UInt4 a) {
+		//SSE2 only converts signed ints, so both halves are converted exactly and summed, which rounds once like a scalar cast
+		const __m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(a.v, 16));
+		const __m128 low = _mm_cvtepi32_ps(_mm_and_si128(a.v, _mm_set1_epi32(0xFFFF)));
+		return _mm_add_ps(_mm_mul_ps(high, _mm_set1_ps(65536.0f)), low);
+	}
+
+	inline UInt4 bit_cast_uint(const Float4 a) {
+		return _mm_castps_si128(a.v);
+	}
+
+	inline Float4 is_inf(const Float4 a) {
+		return abs(a) == Float4(std::numeric_limits<float>::infinity());
+	}
+
+	//calls a scalar function lane by lane, for the transcendental functions SSE2 has no instruction for
+	template<typename Func>
+	Float4 map(Func&& func, const Float4 a) {
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, a.v);
+		return _mm_setr_ps(func(lanes[0]), func(lanes[1]), func(lanes[2]), func(lanes[3]));
+	}
+
+	template<typename Func>
+	Float4 map(Func&& func, const Float4 a, const Float4 b) {
+		alignas(16) float lanes_a[4];
+		alignas(16) float lanes_b[4];
+		_mm_store_ps(lanes_a, a.v);
+		_mm_store_ps(lanes_b, b.v);
+		return _mm_setr_ps(func(lanes_a[0], lanes_b[0]), func(lanes_a[1], lanes_b[1]), func(lanes_a[2], lanes_b[2]), func(lanes_a[3], lanes_b[3]));
+	}
+
+	template<size_t N>
+	Vec<N> operator+(const Vec<N>& a, const Vec<N>& b) {
+		Vec<N> result;
+		for (size_t c = 0; c < N; ++c) {
+			result[c] = a[c] + b[c];
+		}
+		return result;
+	}
+
+	template<size_t N>
+	Vec<N> operator-(const Vec<N>& a, const Vec<N>& b) {
+		Vec<N> result;
+		for (size_t c = 0; c < N; ++c) {
+			result[c] = a[c] - b[c];
+		}
+		return result;
+	}
+
+	template<size_t N>
+	Vec<N> operator*(const Vec<N>& a, const Float4 b) {
+		Vec<N> result;
+		for (size_t c = 0; c < N; ++c) {
+			result[c] = a[c] * b;
+		}
+		return result;
+	}
+
+	template<size_t N>
+	Vec<N> operator/(const Vec<N>& a, const Float4 b) {
+		Vec<N> result;
+		for (size_t c = 0; c < N; ++c) {
+			result[c] = a[c] / b;
+		}
+		return result;
+	}
+
+	template<size_t N>
+	Vec<N> select(const Float4 mask, const Vec<N>& a, const Vec<N>& b) {
+		Vec<N> result;
+		for (size_t c = 0; c < N; ++c) {
+			result[c] = select(mask, a[c], b[c]);
+		}
+		return result;
+	}
+
+	//the lanes of a vector that is the same for all four pixels
+	template<int N>
+	Vec<N> splat(const glm::vec<N, float>& value) {
+		Vec<N> result;
+		for (size_t c = 0; c < N; ++c) {
+			result[c] = value[static_cast<glm::length_t>(c)];
+		}
+		return result;
+	}
+
+	template<size_t N>
+	Float4 dot(const Vec<N>& a, const Vec<N>& b) {
+		Float4 sum = a[0] * b[0];
+		for (size_t c = 1; c < N; ++c) {
+			sum += a[c] * b[c];
+		}
+		return sum;
+	}
+
+	template<size_t N>
+	Float4 length(const Vec<N>& a) {
+		return sqrt(dot(a, a));
+	}
+
+	//v * inversesqrt(dot(v, v)) like glm::normalize
+	template<size_t N>
+	Vec<N> normalize(const Vec<N>& a) {
+		return a * (1.0f / sqrt(dot(a, a)));
+	}
+}
@@ -5,6 +5,7 @@
 #include "nodes/node_color_ramp.h"
 #include "nodes/node_noise.h"
 #include "nodes/node_normal.h"
+#include "nodes/node_normal_compute.h"
 #include "nodes/node_pbr_shader.h"
 #include "nodes/node_polygon.h"
 #include "nodes/node_slope_blur.h"
@@ -0,0 +1,550 @@
+#include "gui_graph_file.h"
+#include "gui_node_editor.h"
+#include "../util/mapped_file.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+#include <stb_image.h>
+
+//defined with the rest of stb_image_write in vk_texture_exporter.cpp, the header only declares it there
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+namespace graph_file {
+	namespace {
+		template<typename NodeType>
+		using NodeFieldTypes = FieldTypeList<MetaInfo<typename NodeType::data_type>>;
+
+		//pin_type_hash of every input pin of a node type, in field order
+		template<typename NodeType>
+		constexpr static inline auto node_pin_types = [] <size_t... I> (std::index_sequence<I...>) {
+			return std::array<uint32_t, sizeof...(I)>{ pin_type_hash<typename NodeFieldTypes<NodeType>::template at<I>>... };
+		}(std::make_index_sequence<NodeFieldTypes<NodeType>::size>{});
+
+		template<typename NodeType>
+		constexpr static inline uint32_t node_output_num = [] {
+			using NodeDataT = typename NodeType::data_type;
+			if constexpr (image_data<NodeDataT>) {
+				return 1u;
+			}
+			else if constexpr (value_data<NodeDataT>) {
+				return static_cast<uint32_t>(NodeDataT::ResultType::Class::TotalFields);
+			}
+			else {
+				return 0u;
+			}
+		}();
+
+		const auto NODE_PIN_TYPES = [] <size_t... I> (std::index_sequence<I...>) {
+			return std::array<std::span<const uint32_t>, sizeof...(I)>{ node_pin_types<NodeTypeList::at<I>>... };
+		}(std::make_index_sequence<NodeTypeList::size>{});
+
+		constexpr auto NODE_OUTPUT_NUMS = [] <size_t... I> (std::index_sequence<I...>) {
+			return std::array{ node_output_num<NodeTypeList::at<I>>... };
+		}(std::make_index_sequence<NodeTypeList::size>{});
+
+		//PinTypeList as of version 2, whose pin records stored an index into it. Frozen here so those files keep loading
+		constexpr std::array version_2_pin_type_hashes{
+			pin_type_hash<TextureIdData>,
+			pin_type_hash<FloatData>,
+			pin_type_hash<IntData>,
+			pin_type_hash<BoolData>,
+			pin_type_hash<Color4Data>,
+			pin_type_hash<EnumData>,
+			pin_type_hash<ColorRampData>,
+			pin_type_hash<FloatTextureIdData>,
+			pin_type_hash<Color4TextureIdData>,
+		};
+
+		size_t node_type_index(const uint32_t type_hash) {
+			auto const type_iter = std::ranges::find(NODE_TYPE_HASH_VALUES, type_hash);
+			if (type_iter == NODE_TYPE_HASH_VALUES.end()) {
+				throw std::runtime_error("failed to load graph, unknown node type!");
+			}
+			return static_cast<size_t>(std::distance(NODE_TYPE_HASH_VALUES.begin(), type_iter));
+		}
+
+		template<typename PinType> requires (!std::same_as<PinType, ColorRampData>)
+		PinRecord make_pin(const PinType& data) {
+			PinRecord pin{ .type_hash = pin_type_hash<PinType> };
+			if constexpr (std::same_as<PinType, BoolData>) {
+				pin.integer = data.value ? 1 : 0;
+			}
+			else if constexpr (any_of<PinType, TextureIdData, IntData, EnumData>) {
+				pin.integer = static_cast<int32_t>(data.value);
+			}
+			else if constexpr (std::same_as<PinType, FloatData>) {
+				pin.floats[0] = data.value;
+			}
+			else if constexpr (std::same_as<PinType, FloatTextureIdData>) {
+				pin.floats[0] = data.value.number;  //the id is bound at runtime and never saved
+			}
+			else if constexpr (std::same_as<PinType, Color4Data>) {
+				std::ranges::copy(data.value, pin.floats);
+			}
+			else if constexpr (std::same_as<PinType, Color4TextureIdData>) {
+				std::ranges::copy(data.value.color, pin.floats);
+			}
+			return pin;
+		}
+
+		json pin_to_json(const GraphView& graph, const PinRecord& pin) {
+			json json_pin;
+			UNROLL<PinTypeList::size>([&] <size_t type_index> () {
+				using PinType = PinTypeList::at<type_index>;
+				if (pin.type_hash != pin_type_hash<PinType>) {
+					return;
+				}
+				if constexpr (std::same_as<PinType, ColorRampData>) {
+					json_pin = json::array();
+					for (auto const& mark : graph.marks_of(pin)) {
+						json_pin.emplace_back(json{
+							{"color", mark.color},
+							{"position", mark.position},
+							});
+					}
+				}
+				else {
+					json_pin = read_pin<PinType>(pin);
+				}
+				});
+			return json_pin;
+		}
+
+		template<typename PinType>
+		void add_pin_from_json(Graph& graph, const json& json_pin) {
+			if constexpr (std::same_as<PinType, ColorRampData>) {
+				PinRecord pin{
+					.type_hash = pin_type_hash<ColorRampData>,
+					.first_mark = static_cast<uint32_t>(graph.marks.size()),
+				};
+				for (auto const& json_mark : json_pin) {
+					auto const& json_color = json_mark.at("color");
+					graph.marks.push_back(MarkRecord{
+						.color = { json_color[0].get<float>(), json_color[1].get<float>(), json_color[2].get<float>(), json_color[3].get<float>() },
+						.position = json_mark.at("position").get<float>(),
+						});
+				}
+				pin.mark_count = static_cast<uint32_t>(graph.marks.size()) - pin.first_mark;
+				graph.pins.push_back(pin);
+			}
+			else {
+				graph.pins.push_back(make_pin(json_pin.get<PinType>()));
+			}
+			++graph.nodes.back().pin_count;
+		}
+
+		//table of count records at offset, checked to lie inside the mapped bytes
+		template<typename Record>
+		std::span<const Record> table_at(const std::span<const std::byte> bytes, const uint64_t offset, const uint32_t count) {
+			if (offset % alignof(Record) != 0 || offset > bytes.size() || (bytes.size() - offset) / sizeof(Record) < count) {
+				throw std::runtime_error("failed to load graph, a table lies outside the file!");
+			}
+			//records are trivially copyable and the view is page aligned, so the table is read where it was mapped
+			return { reinterpret_cast<const Record*>(bytes.data() + offset), count };
+		}
+
+		uint64_t align_offset(const uint64_t offset) {
+			constexpr uint64_t table_alignment = 8;
+			return (offset + table_alignment - 1) & ~(table_alignment - 1);
+		}
+
+		//64-bit FNV-1a, same as the shader cache
+		uint64_t hash_bytes(uint64_t hash, const std::span<const std::byte> bytes) {
+			for (auto const byte : bytes) {
+				hash = (hash ^ static_cast<uint64_t>(byte)) * 0x100000001b3ull;
+			}
+			return hash;
+		}
+
+		template<typename T>
+		uint64_t hash_value(const uint64_t hash, const T& value) {
+			return hash_bytes(hash, std::as_bytes(std::span{ &value, 1 }));
+		}
+
+		uint64_t node_own_hash(const GraphView& graph, const NodeRecord& node) {
+			auto hash = hash_value(0xcbf29ce484222325ull, node.type_hash);
+			for (auto pin : graph.pins_of(node)) {
+				if (pin.type_hash == pin_type_hash<TextureIdData>) {
+					pin.integer = 0;  //bound at runtime
+				}
+				hash = hash_value(hash, pin);
+				for (auto const& mark : graph.marks_of(pin)) {
+					hash = hash_value(hash, mark);
+				}
+			}
+			return hash;
+		}
+	}
+
+	PinRecord to_pin_record(const PinVariant& value, std::vector<MarkRecord>& marks) {
+		return std::visit([&](auto&& data) {
+			using PinType = std::decay_t<decltype(data)>;
+			if constexpr (std::same_as<PinType, ColorRampData>) {
+				PinRecord pin{
+					.type_hash = pin_type_hash<ColorRampData>,
+					.first_mark = static_cast<uint32_t>(marks.size()),
+				};
+				for (auto const mark : data.ui_value->getMarks()) {
+					marks.push_back(MarkRecord{
+						.color = { mark->color[0], mark->color[1], mark->color[2], mark->color[3] },
+						.position = mark->position,
+						});
+				}
+				pin.mark_count = static_cast<uint32_t>(marks.size()) - pin.first_mark;
+				return pin;
+			}
+			else {
+				return make_pin(data);
+			}
+			}, value);
+	}
+
+	void Graph::add_node(const uint32_t type_hash, const float x, const float y) {
+		nodes.push_back(NodeRecord{
+			.type_hash = type_hash,
+			.first_pin = static_cast<uint32_t>(pins.size()),
+			.pin_count = 0,
+			.pos = { x, y },
+			});
+	}
+
+	void Graph::add_pin(const PinVariant& value) {
+		pins.push_back(to_pin_record(value, marks));
+		++nodes.back().pin_count;
+	}
+
+	void Graph::add_bake(BakeRecord bake, const std::span<const std::byte> compressed_output, const std::span<const std::byte> compressed_preview) {
+		bake.output_offset = bake_data.size();
+		bake.output_size = compressed_output.size();
+		bake_data.insert(bake_data.end(), compressed_output.begin(), compressed_output.end());
+		bake.preview_offset = bake_data.size();
+		bake.preview_size = compressed_preview.size();
+		bake_data.insert(bake_data.end(), compressed_preview.begin(), compressed_preview.end());
+		bakes.push_back(bake);
+	}
+
+	GraphView Graph::view() const {
+		return GraphView{
+			.view_origin = { view_origin[0], view_origin[1] },
+			.view_scale = view_scale,
+			.nodes = nodes,
+			.pins = pins,
+			.links = links,
+			.marks = marks,
+			.bakes = bakes,
+			.bake_data = bake_data,
+		};
+	}
+
+	BinaryGraphFile::BinaryGraphFile(const std::filesystem::path& file_path) : file(std::make_unique<MappedFile>(file_path)) {
+		auto const bytes = file->bytes();
+		Header header{};
+		if (bytes.size() < header_v1_size) {
+			throw std::runtime_error("failed to load graph " + file_path.string() + ", not a .txgb file!");
+		}
+		std::memcpy(&header, bytes.data(), header_v1_size);
+		if (header.magic != binary_magic) {
+			throw std::runtime_error("failed to load graph " + file_path.string() + ", not a .txgb file!");
+		}
+		if (header.version == 1) {
+			header.bake_count = 0;
+		}
+		else if (header.version >= 2 && header.version <= binary_version && bytes.size() >= sizeof(Header)) {
+			std::memcpy(&header, bytes.data(), sizeof(Header));
+		}
+		else {
+			throw std::runtime_error("failed to load graph " + file_path.string() + ", unsupported version " + std::to_string(header.version) + "!");
+		}
+
+		graph = GraphView{
+			.view_origin = { header.view_origin[0], header.view_origin[1] },
+			.view_scale = header.view_scale,
+			.nodes = table_at<NodeRecord>(bytes, header.node_offset, header.node_count),
+			.pins = table_at<PinRecord>(bytes, header.pin_offset, header.pin_count),
+			.links = table_at<LinkRecord>(bytes, header.link_offset, header.link_count),
+			.marks = table_at<MarkRecord>(bytes, header.mark_offset, header.mark_count),
+		};
+		if (header.version < 3) {
+			converted_pins.assign(graph.pins.begin(), graph.pins.end());
+			for (auto& pin : converted_pins) {
+				if (pin.type_hash >= version_2_pin_type_hashes.size()) {
+					throw std::runtime_error("failed to load graph " + file_path.string() + ", unknown pin type!");
+				}
+				pin.type_hash = version_2_pin_type_hashes[pin.type_hash];
+			}
+			graph.pins = converted_pins;
+		}
+		if (header.bake_count > 0) {
+			graph.bakes = table_at<BakeRecord>(bytes, header.bake_offset, header.bake_count);
+			if (header.bake_data_offset > bytes.size() || bytes.size() - header.bake_data_offset < header.bake_data_size) {
+				throw std::runtime_error("failed to load graph " + file_path.string() + ", baked outputs lie outside the file!");
+			}
+			graph.bake_data = bytes.subspan(header.bake_data_offset, header.bake_data_size);
+		}
+		validate(graph);
+	}
+
+	BinaryGraphFile::~BinaryGraphFile() = default;
+
+	GraphSource::GraphSource(const std::filesystem::path& file_path) {
+		if (is_binary(file_path)) {
+			binary_file = std::make_unique<BinaryGraphFile>(file_path);
+		}
+		else {
+			graph = read_json(file_path);
+		}
+	}
+
+	GraphView GraphSource::view() const {
+		return binary_file ? binary_file->view() : graph.view();
+	}
+
+	bool is_binary(const std::filesystem::path& file_path) {
+		return file_path.extension() == binary_extension;
+	}
+
+	void validate(const GraphView& graph) {
+		for (auto const& node : graph.nodes) {
+			auto const pin_types = NODE_PIN_TYPES[node_type_index(node.type_hash)];
+			if (node.first_pin > graph.pins.size() || graph.pins.size() - node.first_pin < node.pin_count || node.pin_count != pin_types.size()) {
+				throw std::runtime_error("failed to load graph, pins do not match their node type!");
+			}
+			for (uint32_t i = 0; i < node.pin_count; ++i) {
+				auto const& pin = graph.pins[node.first_pin + i];
+				if (pin.type_hash != pin_types[i]) {
+					throw std::runtime_error("failed to load graph, pins do not match their node type!");
+				}
+				if (pin.first_mark > graph.marks.size() || graph.marks.size() - pin.first_mark < pin.mark_count) {
+					throw std::runtime_error("failed to load graph, a color ramp lies outside the mark table!");
+				}
+			}
+		}
+		for (auto const& link : graph.links) {
+			if (link.start_node_index >= graph.nodes.size() || link.end_node_index >= graph.nodes.size() ||
+				link.start_pin_index >= NODE_OUTPUT_NUMS[node_type_index(graph.nodes[link.start_node_index].type_hash)] ||
+				link.end_pin_index >= graph.nodes[link.end_node_index].pin_count) {
+				throw std::runtime_error("failed to load graph, a link connects a missing pin!");
+			}
+		}
+		for (auto const& bake : graph.bakes) {
+			if (bake.node_index >= graph.nodes.size() ||
+				bake.output_offset > graph.bake_data.size() || graph.bake_data.size() - bake.output_offset < bake.output_size ||
+				bake.preview_offset > graph.bake_data.size() || graph.bake_data.size() - bake.preview_offset < bake.preview_size) {
+				throw std::runtime_error("failed to load graph, a baked output lies outside the bake data!");
+			}
+		}
+	}
+
+	std::vector<uint64_t> parameter_hashes(const GraphView& graph) {
+		//input links of every node, ordered by input pin so the hash does not depend on the link table order
+		std::vector<std::vector<LinkRecord>> input_links(graph.nodes.size());
+		for (auto const& link : graph.links) {
+			input_links[link.end_node_index].push_back(link);
+		}
+		for (auto& links : input_links) {
+			std::ranges::sort(links, {}, [](const LinkRecord& link) { return std::pair{ link.end_pin_index, link.start_pin_index }; });
+		}
+
+		enum class State : uint8_t { unvisited, visiting, done };
+		std::vector<State> states(graph.nodes.size(), State::unvisited);
+		std::vector<uint64_t> hashes(graph.nodes.size(), 0);
+		std::vector<uint32_t> stack;
+		for (uint32_t root = 0; root < graph.nodes.size(); ++root) {
+			stack.push_back(root);
+			while (!stack.empty()) {
+				auto const node_index = stack.back();
+				if (states[node_index] == State::done) {
+					stack.pop_back();
+					continue;
+				}
+				if (states[node_index] == State::unvisited) {
+					states[node_index] = State::visiting;
+					for (auto const& link : input_links[node_index]) {
+						if (states[link.start_node_index] == State::unvisited) {
+							stack.push_back(link.start_node_index);
+						}
+					}
+					continue;
+				}
+				//every input is hashed by now, a cycle would leave one visiting and hashing as 0
+				auto hash = node_own_hash(graph, graph.nodes[node_index]);
+				for (auto const& link : input_links[node_index]) {
+					hash = hash_value(hash, link.end_pin_index);
+					hash = hash_value(hash, link.start_pin_index);
+					hash = hash_value(hash, hashes[link.start_node_index]);
+				}
+				hashes[node_index] = hash;
+				states[node_index] = State::done;
+				stack.pop_back();
+			}
+		}
+		return hashes;
+	}
+
+	std::vector<std::byte> compress(const std::span<const std::byte> bytes) {
+		int compressed_size = 0;
+		//stb only reads the data, the parameter is just not const
+		auto const compressed = stbi_zlib_compress(reinterpret_cast<unsigned char*>(const_cast<std::byte*>(bytes.data())), static_cast<int>(bytes.size()), &compressed_size, 5);
+		if (compressed == nullptr) {
+			throw std::runtime_error("failed to compress baked output!");
+		}
+		auto const compressed_bytes = std::as_bytes(std::span{ compressed, static_cast<size_t>(compressed_size) });
+		std::vector<std::byte> result(compressed_bytes.begin(), compressed_bytes.end());
+		std::free(compressed);
+		return result;
+	}
+
+	bool decompress(const std::span<const std::byte> compressed, const std::span<std::byte> bytes) {
+		auto const size = stbi_zlib_decode_buffer(reinterpret_cast<char*>(bytes.data()), static_cast<int>(bytes.size()),
+			reinterpret_cast<const char*>(compressed.data()), static_cast<int>(compressed.size()));
+		return size >= 0 && static_cast<size_t>(size) == bytes.size();
+	}
+
+	void write_binary(const GraphView& graph, const std::filesystem::path& file_path) {
+		Header header{
+			.magic = binary_magic,
+			.version = binary_version,
+			.node_count = static_cast<uint32_t>(graph.nodes.size()),
+			.pin_count = static_cast<uint32_t>(graph.pins.size()),
+			.link_count = static_cast<uint32_t>(graph.links.size()),
+			.mark_count = static_cast<uint32_t>(graph.marks.size()),
+			.view_origin = { graph.view_origin[0], graph.view_origin[1] },
+			.view_scale = graph.view_scale,
+			.bake_count = static_cast<uint32_t>(graph.bakes.size()),
+			.bake_data_size = graph.bake_data.size(),
+		};
+		header.node_offset = align_offset(sizeof(Header));
+		header.pin_offset = align_offset(header.node_offset + graph.nodes.size_bytes());
+		header.link_offset = align_offset(header.pin_offset + graph.pins.size_bytes());
+		header.mark_offset = align_offset(header.link_offset + graph.links.size_bytes());
+		header.bake_offset = align_offset(header.mark_offset + graph.marks.size_bytes());
+		header.bake_data_offset = align_offset(header.bake_offset + graph.bakes.size_bytes());
+
+		std::ofstream o_file(file_path, std::ios::binary);
+		if (!o_file) {
+			throw std::runtime_error("failed to open file " + file_path.string() + "!");
+		}
+		uint64_t written_size = 0;
+		auto const write_table = [&](const uint64_t offset, const std::span<const std::byte> table) {
+			constexpr std::array<char, 8> padding{};
+			o_file.write(padding.data(), static_cast<std::streamsize>(offset - written_size));
+			o_file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size()));
+			written_size = offset + table.size();
+			};
+		write_table(0, std::as_bytes(std::span{ &header, 1 }));
+		write_table(header.node_offset, std::as_bytes(graph.nodes));
+		write_table(header.pin_offset, std::as_bytes(graph.pins));
+		write_table(header.link_offset, std::as_bytes(graph.links));
+		write_table(header.mark_offset, std::as_bytes(graph.marks));
+		write_table(header.bake_offset, std::as_bytes(graph.bakes));
+		write_table(header.bake_data_offset, graph.bake_data);
+		if (!o_file) {
+			throw std::runtime_error("failed to write file " + file_path.string() + "!");
+		}
+	}
+
+	json to_json(const GraphView& graph) {
+		json json_graph;
+		for (auto const& node : graph.nodes) {
+			json json_pins = json::array();
+			for (auto const& pin : graph.pins_of(node)) {
+				json_pins.emplace_back(pin_to_json(graph, pin));
+			}
+			json_graph["nodes"].emplace_back(json{
+				{"type", NODE_TYPE_NAMES[node_type_index(node.type_hash)]},
+				{"type_hash", node.type_hash},
+				{"pins", std::move(json_pins)},
+				{"pos", node.pos},
+				});
+		}
+		for (auto const& link : graph.links) {
+			json_graph["links"].emplace_back(json{
+				{"start_node_index", link.start_node_index},
+				{"start_pin_index", link.start_pin_index},
+				{"end_node_index", link.end_node_index},
+				{"end_pin_index", link.end_pin_index},
+				});
+		}
+		json_graph["view"] = {
+			{"origin", graph.view_origin},
+			{"scale", graph.view_scale},
+		};
+		return json_graph;
+	}
+
+	Graph from_json(const json& json_graph) {
+		Graph graph;
+		if (json_graph.contains("nodes")) {
+			for (auto const& json_node : json_graph["nodes"]) {
+				auto const type_hash = json_node.at("type_hash").get<uint32_t>();
+				auto const& json_pos = json_node.at("pos");
+				graph.add_node(type_hash, json_pos[0].get<float>(), json_pos[1].get<float>());
+
+				auto const& json_pins = json_node.at("pins");
+				UNROLL<NodeTypeList::size>([&] <size_t type_index> () {
+					using FieldTypes = NodeFieldTypes<NodeTypeList::at<type_index>>;
+					if (NODE_TYPE_HASH_VALUES[type_index] != type_hash) {
+						return;
+					}
+					if (json_pins.size() != FieldTypes::size) {
+						throw std::runtime_error("failed to load graph, pins do not match their node type!");
+					}
+					UNROLL<FieldTypes::size>([&] <size_t pin_index> () {
+						add_pin_from_json<typename FieldTypes::template at<pin_index>>(graph, json_pins[pin_index]);
+						});
+					});
+			}
+		}
+		if (json_graph.contains("links")) {
+			for (auto const& json_link : json_graph["links"]) {
+				graph.links.push_back(LinkRecord{
+					.start_node_index = json_link.at("start_node_index").get<uint32_t>(),
+					.start_pin_index = json_link.at("start_pin_index").get<uint32_t>(),
+					.end_node_index = json_link.at("end_node_index").get<uint32_t>(),
+					.end_pin_index = json_link.at("end_pin_index").get<uint32_t>(),
+					});
+			}
+		}
+		if (json_graph.contains("view")) {
+			auto const& json_view = json_graph["view"];
+			graph.view_origin[0] = json_view.at("origin")[0].get<float>();
+			graph.view_origin[1] = json_view.at("origin")[1].get<float>();
+			graph.view_scale = json_view.at("scale").get<float>();
+		}
+		validate(graph.view());
+		return graph;
+	}
+
+	Graph read_json(const std::filesystem::path& file_path) {
+		std::ifstream i_file(file_path);
+		if (!i_file) {
+			throw std::runtime_error("failed to open file " + file_path.string() + "!");
+		}
+		json json_graph;
+		i_file >> json_graph;
+		return from_json(json_graph);
+	}
+
+	void write_json(const GraphView& graph, const std::filesystem::path& file_path) {
+		std::ofstream o_file(file_path);
+		if (!o_file) {
+			throw std::runtime_error("failed to open file " + file_path.string() + "!");
+		}
+		o_file << std::setw(4) << to_json(graph) << std::endl;
+	}
+
+	void convert(const std::filesystem::path& source_path, const std::filesystem::path& destination_path) {
+		const GraphSource source(source_path);
+		if (is_binary(destination_path)) {
+			write_binary(source.view(), destination_path);
+		}
+		else {
+			write_json(source.view(), destination_path);
+		}
+	}
+}
@@ -0,0 +1,235 @@
+#pragma once
+#include "gui_pin_data.h"
+#include "../util/cpp_type.h"
+#include "../util/hash_str.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+class MappedFile;
+
+//Binary .txgb graph files. A header is followed by fixed-layout node, pin, link and color ramp mark tables, so a mapped
+//file is read in place without parsing. The same tables are built in memory when a .txg is loaded or a graph is saved,
+//which keeps one loading path in the node editor and makes .txg <-> .txgb conversion lossless.
+//Version 2 may also carry baked node outputs, zlib compressed and keyed by the parameter hash of their node. They are a
+//cache: .txg files never hold them and a node whose hash changed is simply evaluated again.
+//Version 3 stores pin types by name hash instead of their PinTypeList index, older pin tables are converted on load.
+namespace graph_file {
+	static_assert(std::endian::native == std::endian::little, "graph files are stored little endian");
+
+	constexpr static inline std::array<char, 4> binary_magic{ 'T', 'X', 'G', 'B' };
+	constexpr static inline uint32_t binary_version = 3;
+	constexpr static inline auto binary_extension = ".txgb";
+	constexpr static inline auto json_extension = ".txg";
+
+	struct Header {
+		std::array<char, 4> magic;
+		uint32_t version;
+		uint32_t node_count;
+		uint32_t pin_count;
+		uint32_t link_count;
+		uint32_t mark_count;
+		uint64_t node_offset;  //byte offsets of the tables from the start of the file
+		uint64_t pin_offset;
+		uint64_t link_offset;
+		uint64_t mark_offset;
+		float view_origin[2];
+		float view_scale;
+		uint32_t bake_count;  //reserved and zero in version 1
+		uint64_t bake_offset;  //version 2 from here on
+		uint64_t bake_data_offset;
+		uint64_t bake_data_size;
+	};
+
+	//version 1 headers end before bake_offset, their tables follow right after
+	constexpr static inline size_t header_v1_size = offsetof(Header, bake_offset);
+
+	struct NodeRecord {
+		uint32_t type_hash;  //NODE_TYPE_HASH_VALUES, stable across releases unlike the type index
+		uint32_t first_pin;
+		uint32_t pin_count;
+		float pos[2];
+	};
+
+	//one record per input pin, the members used depend on type_hash
+	struct PinRecord {
+		uint32_t type_hash;  //pin_type_hash, stable across PinTypeList changes unlike the type index
+		uint32_t first_mark;  //ColorRampData only
+		uint32_t mark_count;
+		int32_t integer;  //TextureIdData, IntData, BoolData, EnumData
+		float floats[4];  //FloatData, Color4Data, FloatTextureIdData, Color4TextureIdData
+	};
+
+	struct LinkRecord {
+		uint32_t start_node_index;
+		uint32_t start_pin_index;
+		uint32_t end_node_index;
+		uint32_t end_pin_index;
+	};
+
+	struct MarkRecord {
+		float color[4];
+		float position;
+	};
+
+	//output and preview of an image node as zlib streams in the bake data, both images share format
+	struct BakeRecord {
+		uint64_t parameter_hash;  //parameter_hashes() of the node when it was baked
+		uint32_t node_index;
+		uint32_t format;  //VkFormat
+		uint32_t width;
+		uint32_t height;
+		uint32_t preview_width;
+		uint32_t preview_height;
+		uint64_t output_offset;  //from the start of the bake data
+		uint64_t output_size;
+		uint64_t preview_offset;
+		uint64_t preview_size;
+	};
+
+	template<typename PinType>
+	constexpr static inline uint32_t pin_type_hash = hash_str(cpp_type_name<PinType>);
+
+	//non-owning view of the tables, into a mapped .txgb or a Graph
+	struct GraphView {
+		float view_origin[2] = { 0.0f, 0.0f };
+		float view_scale = 1.0f;
+		std::span<const NodeRecord> nodes;
+		std::span<const PinRecord> pins;
+		std::span<const LinkRecord> links;
+		std::span<const MarkRecord> marks;
+		std::span<const BakeRecord> bakes;
+		std::span<const std::byte> bake_data;
+
+		[[nodiscard]] std::span<const PinRecord> pins_of(const NodeRecord& node) const {
+			return pins.subspan(node.first_pin, node.pin_count);
+		}
+
+		[[nodiscard]] std::span<const MarkRecord> marks_of(const PinRecord& pin) const {
+			return marks.subspan(pin.first_mark, pin.mark_count);
+		}
+
+		[[nodiscard]] std::span<const std::byte> baked_output_of(const BakeRecord& bake) const {
+			return bake_data.subspan(bake.output_offset, bake.output_size);
+		}
+
+		[[nodiscard]] std::span<const std::byte> baked_preview_of(const BakeRecord& bake) const {
+			return bake_data.subspan(bake.preview_offset, bake.preview_size);
+		}
+	};
+
+	//tables owned in memory, filled while saving a graph or converting a .txg
+	struct Graph {
+		float view_origin[2] = { 0.0f, 0.0f };
+		float view_scale = 1.0f;
+		std::vector<NodeRecord> nodes;
+		std::vector<PinRecord> pins;
+		std::vector<LinkRecord> links;
+		std::vector<MarkRecord> marks;
+		std::vector<BakeRecord> bakes;
+		std::vector<std::byte> bake_data;
+
+		void add_node(uint32_t type_hash, float x, float y);
+
+		//appends an input pin to the last added node
+		void add_pin(const PinVariant& value);
+
+		//appends the compressed images of bake, filling in their offsets and sizes
+		void add_bake(BakeRecord bake, std::span<const std::byte> compressed_output, std::span<const std::byte> compressed_preview);
+
+		[[nodiscard]] GraphView view() const;
+	};
+
+	//.txgb mapped read-only, the tables are validated once and then read in place
+	class BinaryGraphFile {
+		std::unique_ptr<MappedFile> file;  //kept out of this header, mapped_file.h pulls in windows.h
+		std::vector<PinRecord> converted_pins;  //pins of version 1 and 2 files, whose records hold a PinTypeList index
+		GraphView graph;
+
+	public:
+		explicit BinaryGraphFile(const std::filesystem::path& file_path);
+
+		~BinaryGraphFile();
+
+		[[nodiscard]] const GraphView& view() const noexcept {
+			return graph;
+		}
+	};
+
+	//whichever file_path names, a mapped .txgb or a parsed .txg
+	class GraphSource {
+		std::unique_ptr<BinaryGraphFile> binary_file;
+		Graph graph;
+
+	public:
+		explicit GraphSource(const std::filesystem::path& file_path);
+
+		[[nodiscard]] GraphView view() const;
+	};
+
+	template<typename PinType> requires (!std::same_as<PinType, ColorRampData>)
+	PinType read_pin(const PinRecord& pin) {
+		PinType data{};
+		if constexpr (std::same_as<PinType, BoolData>) {
+			data.value = pin.integer != 0;
+		}
+		else if constexpr (std::same_as<PinType, EnumData>) {
+			data.value = static_cast<uint32_t>(pin.integer);
+		}
+		else if constexpr (any_of<PinType, TextureIdData, IntData>) {
+			data.value = pin.integer;
+		}
+		else if constexpr (std::same_as<PinType, FloatData>) {
+			data.value = pin.floats[0];
+		}
+		else if constexpr (std::same_as<PinType, FloatTextureIdData>) {
+			data.value.number = pin.floats[0];
+		}
+		else if constexpr (std::same_as<PinType, Color4Data>) {
+			std::ranges::copy(pin.floats, data.value);
+		}
+		else if constexpr (std::same_as<PinType, Color4TextureIdData>) {
+			std::ranges::copy(pin.floats, data.value.color);
+		}
+		return data;
+	}
+
+	//record of an input pin, the marks of a ColorRampData pin are appended to marks
+	[[nodiscard]] PinRecord to_pin_record(const PinVariant& value, std::vector<MarkRecord>& marks);
+
+	[[nodiscard]] bool is_binary(const std::filesystem::path& file_path);
+
+	//throws if a node type is unknown, pins do not match the fields of their node type or a table index is out of range
+	void validate(const GraphView& graph);
+
+	//Hash of the pins of every node combined with the hashes of the nodes linked to its inputs, so a node changes hash
+	//whenever anything it is evaluated from changes. Runtime texture ids are left out
+	[[nodiscard]] std::vector<uint64_t> parameter_hashes(const GraphView& graph);
+
+	[[nodiscard]] std::vector<std::byte> compress(std::span<const std::byte> bytes);
+
+	//false unless the stream inflates to exactly bytes.size() bytes
+	[[nodiscard]] bool decompress(std::span<const std::byte> compressed, std::span<std::byte> bytes);
+
+	void write_binary(const GraphView& graph, const std::filesystem::path& file_path);
+
+	//same document NodeEditor wrote before .txgb existed, baked outputs are dropped
+	[[nodiscard]] json to_json(const GraphView& graph);
+
+	[[nodiscard]] Graph from_json(const json& json_graph);
+
+	[[nodiscard]] Graph read_json(const std::filesystem::path& file_path);
+
+	void write_json(const GraphView& graph, const std::filesystem::path& file_path);
+
+	//converts between .txg and .txgb, picking both formats by extension
+	void convert(const std::filesystem::path& source_path, const std::filesystem::path& destination_path);
+}
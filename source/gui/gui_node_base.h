@@ -21,6 +21,18 @@ struct NumberInputWidgetInfo {
 	uint16_t decimal_places = 3;
 };
 
+//Neighbourhood of its inputs an image node reads for one output pixel, measured in output pixels.
+//Tiled evaluation pads every tile with the radii accumulated along the graph; a global footprint makes the graph untileable.
+struct SamplingFootprint {
+	float radius = 0.0f;
+	bool global = false;
+};
+
+template<typename InfoT>
+concept SamplingFootprintInfo = requires(const InfoT& info) {
+	{ InfoT::sampling_footprint(info) } -> std::convertible_to<SamplingFootprint>;
+};
+
 enum class AutoFormat {
 	False = 0,
 	True = 1
@@ -30,11 +42,3 @@ enum class FormatEnum {
 	False = 0,
 	True = 1
 };
-
-static constexpr inline StaticMap str_format_map{
-	std::pair{VK_FORMAT_R8G8B8A8_SRGB, "C8 SRGB", },
-	std::pair{VK_FORMAT_R8G8B8A8_UNORM, "C8 UNORM" },
-	std::pair{VK_FORMAT_R16_UNORM, "R16 UNORM" }
-};
-
-static constexpr inline auto format_str_array = str_format_map.values();
\ No newline at end of file
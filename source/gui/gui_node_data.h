@@ -4,17 +4,38 @@
 #include "../vk_initializers.h"
 #include "../vk_engine.h"
 #include "../vk_util.h"
+#include "../vk_uniform_arena.h"
+#include "../vk_parameter_ring.h"
+#include "../vk_pipeline_cache.h"
+#include "../vk_shader.h"
+#include "../vk_shader_cache.h"
+#include "../util/static_map.h"
+#include "../util/thread_pool.h"
 #include "gui_pin_data.h"
 #include <imgui_impl_vulkan.h>
+#include <iostream>
 #include <unordered_map>
 
 constexpr static inline uint32_t PREVIEW_IMAGE_SIZE = 128;
 constexpr static inline uint32_t TEXTURE_IMAGE_SIZE = 1024;
 
+//formats image nodes render to, format enum pins store the index
+static constexpr inline StaticMap str_format_map{
+	std::pair{VK_FORMAT_R8G8B8A8_SRGB, "C8 SRGB", },
+	std::pair{VK_FORMAT_R8G8B8A8_UNORM, "C8 UNORM" },
+	std::pair{VK_FORMAT_R16_UNORM, "R16 UNORM" }
+};
+
+static constexpr inline auto format_str_array = str_format_map.values();
+
 namespace engine {
 	class Shader;
 }
 
+//Generators declaring tile_transform read their uv window from a vec4 (offset.xy, scale.zw) that trails the Info block in the UBO
+template<typename InfoT>
+concept TileTransformInfo = requires { requires InfoT::tile_transform; };
+
 template<typename InfoType, typename ResultT>
 struct ValueData {
 	using InfoT = InfoType;
@@ -27,28 +48,61 @@ template<typename InfoType>
 struct UboMixin {
 	using InfoT = InfoType;
 
-	BufferPtr uniform_buffer;
+	constexpr static size_t tile_transform_offset = (sizeof(InfoT) + 15) & ~static_cast<size_t>(15);  //std140 vec4 alignment
+	constexpr static size_t ubo_size = TileTransformInfo<InfoT> ? tile_transform_offset + sizeof(glm::vec4) : sizeof(InfoT);
+
+	engine::UniformSlotPtr uniform_buffer;  //a slot of engine->uniform_arena unless a shared buffer is passed in
 
-	explicit UboMixin(VulkanEngine* engine, BufferPtr buffer = nullptr) {
+	//Host copy of the parameters for arena slots. Edits land here at any time and execute_graph() stages the dirty
+	//ones through engine->parameter_ring, so an evaluation in flight never sees a half written block.
+	//Shared buffers are read by the viewport every frame and are still written in place.
+	std::array<std::byte, ubo_size> staged_ubo{};
+	bool versioned = false;
+	bool ubo_dirty = false;
+
+	explicit UboMixin(VulkanEngine* engine, const BufferPtr& buffer = nullptr) {
 		if (buffer) {
-			uniform_buffer = buffer;
+			uniform_buffer = engine::UniformSlot::view(buffer);
+		}
+		else {
+			uniform_buffer = engine->uniform_arena->allocate(ubo_size);
+			versioned = true;
+			if constexpr (TileTransformInfo<InfoT>) {
+				update_tile_transform(identity_tile_transform);
+			}
+		}
+	}
+
+	inline static const glm::vec4 identity_tile_transform{ 0.0f, 0.0f, 1.0f, 1.0f };
+
+	void write_ubo(const void* data, const size_t size, const size_t offset = 0) {
+		if (versioned) {
+			memcpy(staged_ubo.data() + offset, data, size);
+			ubo_dirty = true;
 		}
 		else {
-			uniform_buffer = engine::Buffer::create_buffer(engine,
-				sizeof(InfoT),
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				PreferredMemoryType::VRAM_MAPPABLE,
-				SWAPCHAIN_INDEPENDENT_BIT);
+			uniform_buffer->copy_from_host(data, size, offset);
+		}
+	}
+
+	void stage_ubo(engine::ParameterRing& parameter_ring) {
+		if (ubo_dirty) {
+			parameter_ring.stage(uniform_buffer->buffer, uniform_buffer->offset, staged_ubo.data(), ubo_size);
+			ubo_dirty = false;
 		}
 	}
 
+	void update_tile_transform(const glm::vec4& tile_transform) requires TileTransformInfo<InfoT> {
+		write_ubo(&tile_transform, sizeof(glm::vec4), tile_transform_offset);
+	}
+
 	void update_ubo(const PinVariant& value, const size_t index) {  //use value to update the pin at the index  
 		if constexpr (has_field_type_v<InfoT, ColorRampData>) {
 			typename InfoT::UBO::Class::FieldAt(index, [&, index] (auto&& field_ubo) {
 				using PinUboT = typename std::decay_t<decltype(field_ubo)>::Type;
 				InfoT::Class::FieldAt(index, [&](auto&& field_ubo) {
 					using PinT = typename std::decay_t<decltype(field_ubo)>::Type;
-					uniform_buffer->copy_from_host(
+					write_ubo(
 						reinterpret_cast<const char*>(std::get_if<PinT>(&value)),
 						sizeof(PinUboT),
 						field_ubo.getOffset()
@@ -63,13 +117,13 @@ struct UboMixin {
 					std::visit([&](auto&& v) {
 						using StartPinT = std::decay_t<decltype(v)>;
 						if (std::same_as<StartPinT, FloatData>) {
-							uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(FloatData), field.getOffset());
+							write_ubo(reinterpret_cast<const char*>(&v), sizeof(FloatData), field.getOffset());
 						}
 						else if (std::same_as<StartPinT, TextureIdData>) {
-							uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(TextureIdData), field.getOffset() + sizeof(FloatData));
+							write_ubo(reinterpret_cast<const char*>(&v), sizeof(TextureIdData), field.getOffset() + sizeof(FloatData));
 						}
 						else if (std::same_as<StartPinT, FloatTextureIdData>) {
-							uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(FloatTextureIdData), field.getOffset());
+							write_ubo(reinterpret_cast<const char*>(&v), sizeof(FloatTextureIdData), field.getOffset());
 						}
 						else {
 							assert((false, "Error occurs when updating ubo. Pin type is FloatTextureIdData"));
@@ -80,13 +134,13 @@ struct UboMixin {
 					std::visit([&](auto&& v) {
 						using StartPinT = std::decay_t<decltype(v)>;
 						if (std::same_as<StartPinT, Color4Data>) {
-							uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(Color4Data), field.getOffset());
+							write_ubo(reinterpret_cast<const char*>(&v), sizeof(Color4Data), field.getOffset());
 						}
 						else if (std::same_as<StartPinT, TextureIdData>) {
-							uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(TextureIdData), field.getOffset() + sizeof(Color4Data));
+							write_ubo(reinterpret_cast<const char*>(&v), sizeof(TextureIdData), field.getOffset() + sizeof(Color4Data));
 						}
 						else if (std::same_as<StartPinT, Color4TextureIdData>) {
-							uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(Color4TextureIdData), field.getOffset());
+							write_ubo(reinterpret_cast<const char*>(&v), sizeof(Color4TextureIdData), field.getOffset());
 						}
 						else {
 							assert((false, "Error occurs when updating ubo. Pin type is Color4TextureIdData"));
@@ -94,7 +148,7 @@ struct UboMixin {
 						}, value);
 				}
 				else {
-					uniform_buffer->copy_from_host(reinterpret_cast<const char*>(std::get_if<PinT>(&value)), sizeof(PinT), field.getOffset());
+					write_ubo(reinterpret_cast<const char*>(std::get_if<PinT>(&value)), sizeof(PinT), field.getOffset());
 				}
 				});
 		}
@@ -108,13 +162,13 @@ struct UboMixin {
 				std::visit([&](auto&& v) {
 					using StartPinT = std::decay_t<decltype(v)>;
 					if (std::same_as<StartPinT, FloatData>) {
-						uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(FloatData), field.getOffset());
+						write_ubo(reinterpret_cast<const char*>(&v), sizeof(FloatData), field.getOffset());
 					}
 					else if (std::same_as<StartPinT, TextureIdData>) {
-						uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(TextureIdData), field.getOffset() + sizeof(FloatData));
+						write_ubo(reinterpret_cast<const char*>(&v), sizeof(TextureIdData), field.getOffset() + sizeof(FloatData));
 					}
 					else if (std::same_as<StartPinT, FloatTextureIdData>) {
-						uniform_buffer->copy_from_host(reinterpret_cast<const char*>(&v), sizeof(FloatTextureIdData), field.getOffset());
+						write_ubo(reinterpret_cast<const char*>(&v), sizeof(FloatTextureIdData), field.getOffset());
 					}
 					else {
 						assert((false, "Error occurs when updating ubo. Pin type is FloatTextureIdData"));
@@ -122,7 +176,7 @@ struct UboMixin {
 					}, value);
 			}
 			else if constexpr (std::same_as<PinT, StartPinT>) {
-				uniform_buffer->copy_from_host(reinterpret_cast<const char*>(std::get_if<PinT>(&value)), sizeof(PinT), field.getOffset());
+				write_ubo(reinterpret_cast<const char*>(std::get_if<PinT>(&value)), sizeof(PinT), field.getOffset());
 			}
 			});
 	}
@@ -147,7 +201,12 @@ struct ComponentUdf : UboMixin<InfoType> {
 	inline constexpr static auto shader_num = InfoT::shader_file_paths.size();
 	inline static std::array<VkDescriptorSetLayout, shader_num> ubo_descriptor_set_layouts{ nullptr };
 	inline static std::array<VkPipelineLayout, shader_num> image_processing_pipeline_layouts{ nullptr };
-	inline static std::array<VkPipeline, shader_num> image_processing_compute_pipelines{ nullptr };
+	using ComputePipelines = std::array<VkPipeline, shader_num>;
+	inline static ComputePipelines image_processing_compute_pipelines{ nullptr };
+	inline static std::shared_future<ComputePipelines> prewarmed_compute_pipelines;  //not yet adopted by a node
+	inline static bool shader_watched = false;
+	inline static bool compute_pipelines_stale = false;  //rebuilt by the next node created or reloaded
+	inline static uint32_t shader_generation = 0;  //bumped by every edit of the shaders
 
 	TexturePtr texture;
 	TexturePtr preview_texture;
@@ -156,6 +215,8 @@ struct ComponentUdf : UboMixin<InfoType> {
 	VkImageView result_image_view;
 	std::function<void(int)> record_image_processing_cmd_buffer_func;
 	std::function<void(int)> record_preview_cmd_buffer_func;
+	int input_texture_id = -1;  //input of the last recording, -1 until a texture is linked
+	uint32_t pipeline_generation = 0;  //shader_generation of the pipelines the node was recorded with
 
 	VkCommandBuffer ownership_release_cmd_buffer = nullptr;
 	VkCommandBuffer image_processing_cmd_buffer = nullptr;
@@ -179,9 +240,21 @@ struct ComponentUdf : UboMixin<InfoType> {
 	void create_image_processing_pipeline_resource(VulkanEngine* engine, VkFormat format) {
 		//update_ubo_descriptor_sets(engine);
 		create_image_processing_compute_pipelines(engine);
+		pipeline_generation = shader_generation;
 		create_image_processing_compute_command_buffer_func(engine);
 	}
 
+	[[nodiscard]] bool pipeline_outdated() const noexcept {
+		return pipeline_generation != shader_generation;
+	}
+
+	//records the node again with the pipelines of the edited shaders, the previous ones stay valid until shutdown
+	void reload_pipeline(VulkanEngine* engine) {
+		create_image_processing_compute_pipelines(engine);
+		pipeline_generation = shader_generation;
+		rebind_texture_descriptor_set(engine);
+	}
+
 	static void create_ubo_descriptor_set_layout(VulkanEngine* engine) {
 		std::array preprocess_layout_bindings{
 			vkinit::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
@@ -262,7 +335,7 @@ struct ComponentUdf : UboMixin<InfoType> {
 			this->height,
 			format,
 			VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | (is_gray_scale ? VK_IMAGE_USAGE_STORAGE_BIT : 0),
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (is_gray_scale ? VK_IMAGE_USAGE_STORAGE_BIT : 0),
 			TEMP_BIT,
 			is_gray_scale);
 
@@ -317,8 +390,8 @@ struct ComponentUdf : UboMixin<InfoType> {
 
 		const VkDescriptorBufferInfo uniform_buffer_info{
 			.buffer = this->uniform_buffer->buffer,
-			.offset = 0,
-			.range = sizeof(InfoT)
+			.offset = this->uniform_buffer->offset,
+			.range = this->ubo_size,
 		};
 
 		auto const descriptor_writes = std::array{
@@ -388,10 +461,21 @@ struct ComponentUdf : UboMixin<InfoType> {
 			nullptr);
 	}
 
-	void create_image_processing_compute_pipelines(VulkanEngine* engine) {
-
-		auto shader = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+	static void watch_shader_files(VulkanEngine* engine) {
+		if (shader_watched) {
+			return;
+		}
+		engine->shader_cache->subscribe(InfoT::shader_file_paths, [](auto const&) {
+			compute_pipelines_stale = true;
+			prewarmed_compute_pipelines = {};
+			++shader_generation;
+			});
+		shader_watched = true;
+	}
 
+	//safe to call from worker threads once the shaders and pipeline layouts exist
+	static ComputePipelines build_image_processing_compute_pipelines(VulkanEngine* engine, const ShaderPtr& shader) {
+		ComputePipelines pipelines{ nullptr };
 		for (size_t i = 0; i < shader->shader_modules.size(); ++i) {
 			const VkComputePipelineCreateInfo compute_pipeline_create_info{
 				.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -406,22 +490,76 @@ struct ComponentUdf : UboMixin<InfoType> {
 
 			if (vkCreateComputePipelines(
 				engine->device,
-				VK_NULL_HANDLE,
+				engine->pipeline_cache->handle(),
 				1,
 				&compute_pipeline_create_info,
 				nullptr,
-				&image_processing_compute_pipelines[i]) != VK_SUCCESS) {
+				&pipelines[i]) != VK_SUCCESS) {
+				for (auto const pipeline : pipelines) {
+					vkDestroyPipeline(engine->device, pipeline, nullptr);
+				}
 				throw std::runtime_error("failed to create graphics pipeline!");
 			}
+		}
+		return pipelines;
+	}
+
+	//see ComponentGraphicPipeline::prewarm_pipelines, compute pipelines do not depend on the format
+	static void prewarm_pipelines(VulkanEngine* engine, ThreadPool& thread_pool, std::span<const VkFormat>) {
+		if ((image_processing_compute_pipelines[0] && !compute_pipelines_stale) || prewarmed_compute_pipelines.valid()) {
+			return;
+		}
+		create_ubo_descriptor_set_layout(engine);
+		create_image_processing_pipeline_layouts(engine);
+		watch_shader_files(engine);
+
+		auto shader = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+		prewarmed_compute_pipelines = thread_pool.submit([engine, shader]() -> ComputePipelines {
+			try {
+				return build_image_processing_compute_pipelines(engine, shader);
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+				return { nullptr };
+			}
+			}).share();
 
-			engine->main_deletion_queue.push_function([device = engine->device, pipeline = image_processing_compute_pipelines[i]]{
+		engine->main_deletion_queue.push_function([device = engine->device, pipelines = prewarmed_compute_pipelines] {
+			for (auto const pipeline : pipelines.get()) {
 				vkDestroyPipeline(device, pipeline, nullptr);
-				});
+			}
+			});
+	}
+
+	static void create_image_processing_compute_pipelines(VulkanEngine* engine) {
+		if (image_processing_compute_pipelines[0] && !compute_pipelines_stale) {
+			return;
+		}
+		watch_shader_files(engine);
+		compute_pipelines_stale = false;
+
+		if (prewarmed_compute_pipelines.valid()) {
+			auto const pipelines = prewarmed_compute_pipelines.get();  //destroyed by the deletion queued in prewarm_pipelines()
+			prewarmed_compute_pipelines = {};
+			if (pipelines[0]) {
+				image_processing_compute_pipelines = pipelines;
+				return;
+			}
 		}
+
+		auto shader = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+		image_processing_compute_pipelines = build_image_processing_compute_pipelines(engine, shader);
+
+		engine->main_deletion_queue.push_function([device = engine->device, pipelines = image_processing_compute_pipelines]{
+			for (auto const pipeline : pipelines) {
+				vkDestroyPipeline(device, pipeline, nullptr);
+			}
+			});
 	}
 
 	void create_image_processing_compute_command_buffer_func(const VulkanEngine* engine) {
 		record_image_processing_cmd_buffer_func = [=](int input_image_idx) {
+			input_texture_id = input_image_idx;
 
 			VkCommandBufferAllocateInfo cmd_alloc_info = vkinit::command_buffer_allocate_info(engine->graphic_command_pool, 1);
 			if (vkAllocateCommandBuffers(engine->device, &cmd_alloc_info, &ownership_release_cmd_buffer) != VK_SUCCESS) {
@@ -601,6 +739,16 @@ struct ComponentUdf : UboMixin<InfoType> {
 		};
 	}
 
+	void rebind_texture_descriptor_set(const VulkanEngine* engine) {
+		if (input_texture_id < 0) {
+			return;
+		}
+		vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &ownership_release_cmd_buffer);
+		vkFreeCommandBuffers(engine->device, engine->compute_command_pool, 1, &image_processing_cmd_buffer);
+		record_image_processing_cmd_buffer_func(input_texture_id);
+		update_command_buffer_submit_info();
+	}
+
 	void update_command_buffer_submit_info() {
 		cmd_buffer_submit_info_0.commandBuffer = ownership_release_cmd_buffer;
 		submit_info_members[0].cmd_buffer_submit_info.commandBuffer = image_processing_cmd_buffer;
@@ -811,15 +959,22 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 	using InfoT = InfoType;
 
 	inline static VkDescriptorSetLayout ubo_descriptor_set_layout = nullptr;
+	inline static VkDescriptorSet ubo_descriptor_set = nullptr;  //shared by every node of this type, bound at the node's arena offset
 	inline static VkPipelineLayout image_processing_pipeline_layout = nullptr;
-	inline static std::unordered_map<VkFormat, VkPipeline> image_processing_pipelines;
-	inline static std::unordered_map<VkFormat, VkRenderPass> image_processing_render_passes;
+	//Nodes render with dynamic rendering, so the color attachment format is the only thing a pipeline variant depends on.
+	//Variants are indexed like str_format_map and built on first use
+	constexpr static inline size_t format_num = str_format_map.data.size();
+	inline static std::array<VkPipeline, format_num> image_processing_pipelines{ nullptr };
+	inline static std::array<std::shared_future<VkPipeline>, format_num> prewarmed_pipelines;  //not yet adopted by a node
+	inline static bool shader_watched = false;
+	inline static uint32_t shader_generation = 0;  //bumped by every edit of the shaders
 
 	TexturePtr texture;
 	TexturePtr preview_texture;
-	VkImageView render_target_image_view;
-	VkDescriptorSet ubo_descriptor_set;
-	VkFramebuffer image_processing_framebuffer;
+	VkPipeline image_processing_pipeline = VK_NULL_HANDLE;  //variant for texture->format
+	uint32_t pipeline_generation = 0;  //shader_generation of image_processing_pipeline
+	VkImageView render_target_image_view = VK_NULL_HANDLE;  //texture->image_view unless that one is swizzled
+	VkImageView owned_render_target_view = VK_NULL_HANDLE;
 	VkCommandBuffer image_processing_cmd_buffer = nullptr;
 	VkCommandBuffer generate_preview_cmd_buffer = nullptr;
 
@@ -841,20 +996,48 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 	explicit ComponentGraphicPipeline(VulkanEngine* engine) : UboMixin<InfoType>(engine) {}
 
 	void create_image_processing_pipeline_resource(VulkanEngine* engine, VkFormat format) {
-		create_image_processing_render_pass(engine, format);
-		create_image_processing_pipeline(engine, format);
-		create_framebuffer(engine, format);
+		image_processing_pipeline = create_image_processing_pipeline(engine, format);
+		pipeline_generation = shader_generation;
 		create_image_processing_command_buffer(engine, format);
 	}
 
+	[[nodiscard]] bool pipeline_outdated() const noexcept {
+		return pipeline_generation != shader_generation;
+	}
+
+	//records the node again with the pipeline of the edited shaders, the previous one stays valid until shutdown
+	void reload_pipeline(VulkanEngine* engine) {
+		image_processing_pipeline = create_image_processing_pipeline(engine, texture->format);
+		pipeline_generation = shader_generation;
+		record_image_processing_command_buffer(engine);
+	}
+
+	static size_t format_index(const VkFormat format) {
+		auto const index = static_cast<size_t>(str_format_map.index_of(format));
+		if (index >= format_num) {
+			throw std::runtime_error("unsupported node texture format!");
+		}
+		return index;
+	}
+
+	static bool is_gray_scale(const VkFormat format) {
+		return format == VK_FORMAT_R16_UNORM || format == VK_FORMAT_R16_SFLOAT;
+	}
+
 	static void create_ubo_descriptor_set_layout(VulkanEngine* engine) {
+		if (ubo_descriptor_set_layout) {
+			return;
+		}
 		std::array layout_bindings = {
-			vkinit::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0),
+			vkinit::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT, 0),
 		};
 		engine->create_descriptor_set_layout(layout_bindings, ubo_descriptor_set_layout);
 	}
 
-	void create_ubo_descriptor_sets(VulkanEngine* engine) {
+	static void create_ubo_descriptor_sets(VulkanEngine* engine) {
+		if (ubo_descriptor_set) {
+			return;
+		}
 		const VkDescriptorSetAllocateInfo ubo_descriptor_alloc_info{
 			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 			.descriptorPool = engine->dynamic_descriptor_pool,
@@ -865,13 +1048,11 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 		if (vkAllocateDescriptorSets(engine->device, &ubo_descriptor_alloc_info, &ubo_descriptor_set) != VK_SUCCESS) {
 			throw std::runtime_error("failed to allocate descriptor sets!");
 		}
-	}
 
-	void update_ubo_descriptor_sets(VulkanEngine* engine) {
 		const VkDescriptorBufferInfo uniform_buffer_info{
-			.buffer = this->uniform_buffer->buffer,
+			.buffer = engine->uniform_arena->buffer(),
 			.offset = 0,
-			.range = sizeof(InfoT)
+			.range = UboMixin<InfoType>::ubo_size,
 		};
 
 		const std::array descriptor_writes{
@@ -881,7 +1062,7 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 				.dstBinding = 0,
 				.dstArrayElement = 0,
 				.descriptorCount = 1,
-				.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				.pBufferInfo = &uniform_buffer_info,
 			},
 		};
@@ -889,7 +1070,10 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 		vkUpdateDescriptorSets(engine->device, descriptor_writes.size(), descriptor_writes.data(), 0, nullptr);
 	}
 
-	void create_image_processing_pipeline_layouts(VulkanEngine* engine) {
+	//the shared set points at the whole arena, the node's slot is selected by the dynamic offset at bind time
+	void update_ubo_descriptor_sets(VulkanEngine*) {}
+
+	static void create_image_processing_pipeline_layouts(VulkanEngine* engine) {
 		if (image_processing_pipeline_layout) {
 			return;
 		}
@@ -918,74 +1102,42 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 	}
 
 	void create_textures(VulkanEngine* engine, const VkFormat format) {
-		const bool is_gray_scale = (format == VK_FORMAT_R16_UNORM || format == VK_FORMAT_R16_SFLOAT);
-
 		texture = engine::Texture::create_device_texture(engine,
 			this->width,
 			this->height,
 			format,
 			VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
 			TEMP_BIT,
-			is_gray_scale);
+			is_gray_scale(format));
 
 		texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
 
-	static void create_image_processing_render_pass(VulkanEngine* engine, const VkFormat format) {
-		if (image_processing_render_passes.contains(format)) {
+	static void watch_shader_files(VulkanEngine* engine) {
+		if (shader_watched) {
 			return;
 		}
-		const VkAttachmentDescription color_attachment{
-			.format = format,
-			.samples = VK_SAMPLE_COUNT_1_BIT,
-			.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-			.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-			.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-			.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-			.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		};
-
-		constexpr VkAttachmentReference color_attachment_ref{
-			.attachment = 0,
-			.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-		};
-
-		const VkSubpassDescription subpass{
-			.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-			.colorAttachmentCount = 1,
-			.pColorAttachments = &color_attachment_ref,
-		};
-
-		const std::array attachments{ color_attachment };
-
-		const VkRenderPassCreateInfo render_pass_info{
-			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-			.attachmentCount = static_cast<uint32_t>(attachments.size()),
-			.pAttachments = attachments.data(),
-			.subpassCount = 1,
-			.pSubpasses = &subpass,
-			.dependencyCount = 0,
-			.pDependencies = nullptr,
-		};
-
-		if (vkCreateRenderPass(engine->device, &render_pass_info, nullptr, &image_processing_render_passes[format]) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create render pass!");
-		}
-
-		engine->main_deletion_queue.push_function([device = engine->device, render_pass = image_processing_render_passes[format]]{
-			vkDestroyRenderPass(device, render_pass, nullptr);
+		//built pipelines stay alive in main_deletion_queue for the nodes recorded with them,
+		//the next pipeline of each format is built from the edited shader
+		engine->shader_cache->subscribe(InfoT::shader_file_paths, [](auto const&) {
+			image_processing_pipelines.fill(nullptr);
+			prewarmed_pipelines.fill({});
+			++shader_generation;
 			});
+		shader_watched = true;
 	}
 
-	void create_image_processing_pipeline(VulkanEngine* engine, const VkFormat format) {
-		if (image_processing_pipelines.contains(format)) {
-			return;
-		}
+	//safe to call from worker threads once the shaders and pipeline layout exist
+	static VkPipeline build_image_processing_pipeline(VulkanEngine* engine, const ShaderPtr& shaders, const VkFormat format) {
 		engine::PipelineBuilder pipeline_builder(engine, engine::ENABLE_DYNAMIC_VIEWPORT, engine::DISABLE_VERTEX_INPUT);
 
-		auto shaders = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+		VkPipelineRenderingCreateInfo rendering_info{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+			.colorAttachmentCount = 1,
+			.pColorAttachmentFormats = &format,
+		};
+		pipeline_builder.p_next = &rendering_info;
 
 		for (auto shader_module : shaders->shader_modules) {
 			VkPipelineShaderStageCreateInfo shader_info{
@@ -997,44 +1149,63 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 			pipeline_builder.shaderStages.emplace_back(std::move(shader_info));
 		}
 
-		pipeline_builder.build_pipeline(engine->device, image_processing_render_passes[format], image_processing_pipeline_layout, image_processing_pipelines[format]);
-
-		engine->main_deletion_queue.push_function([device = engine->device, pipeline = image_processing_pipelines[format]]{
-			vkDestroyPipeline(device, pipeline, nullptr);
-			});
+		VkPipeline pipeline;
+		pipeline_builder.build_pipeline(engine->device, VK_NULL_HANDLE, image_processing_pipeline_layout, pipeline);
+		return pipeline;
 	}
 
-	void create_framebuffer(VulkanEngine* engine, const VkFormat format) {
-		VkFramebufferAttachmentImageInfo framebuffer_attachment_image_info{
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENT_IMAGE_INFO,
-			.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-			.width = width,
-			.height = height,
-			.layerCount = 1,
-			.viewFormatCount = 1,
-			.pViewFormats = &texture->format,
-		};
+	//Creates the layouts on the calling thread and compiles the pipeline of every format on thread_pool. Returns at once,
+	//create_image_processing_pipeline() adopts a prewarmed pipeline and only waits if it is still compiling
+	static void prewarm_pipelines(VulkanEngine* engine, ThreadPool& thread_pool, const std::span<const VkFormat> formats) {
+		create_ubo_descriptor_set_layout(engine);
+		create_image_processing_pipeline_layouts(engine);
+		watch_shader_files(engine);
 
-		VkFramebufferAttachmentsCreateInfo framebuffer_attachments_create_info{
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENTS_CREATE_INFO,
-			.attachmentImageInfoCount = 1,
-			.pAttachmentImageInfos = &framebuffer_attachment_image_info,
-		};
+		auto shaders = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+		for (auto const format : formats) {
+			auto const index = format_index(format);
+			if (image_processing_pipelines[index] || prewarmed_pipelines[index].valid()) {
+				continue;
+			}
+			auto pipeline = thread_pool.submit([engine, shaders, format]() -> VkPipeline {
+				try {
+					return build_image_processing_pipeline(engine, shaders, format);
+				}
+				catch (const std::exception& e) {
+					std::cerr << e.what() << std::endl;  //retried on first use, where the error surfaces as usual
+					return VK_NULL_HANDLE;
+				}
+				}).share();
 
-		const VkFramebufferCreateInfo framebuffer_info{
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-			.pNext = &framebuffer_attachments_create_info,
-			.flags = VK_FRAMEBUFFER_CREATE_IMAGELESS_BIT,
-			.renderPass = image_processing_render_passes[format],
-			.attachmentCount = 1,
-			.width = width,
-			.height = height,
-			.layers = 1,
-		};
+			engine->main_deletion_queue.push_function([device = engine->device, pipeline] {
+				vkDestroyPipeline(device, pipeline.get(), nullptr);
+				});
+			prewarmed_pipelines[index] = std::move(pipeline);
+		}
+	}
 
-		if (vkCreateFramebuffer(engine->device, &framebuffer_info, nullptr, &image_processing_framebuffer) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create framebuffer!");
+	static VkPipeline create_image_processing_pipeline(VulkanEngine* engine, const VkFormat format) {
+		auto const index = format_index(format);
+		if (image_processing_pipelines[index]) {
+			return image_processing_pipelines[index];
 		}
+		watch_shader_files(engine);
+
+		if (auto& prewarmed = prewarmed_pipelines[index]; prewarmed.valid()) {
+			auto const pipeline = prewarmed.get();  //destroyed by the deletion queued in prewarm_pipelines()
+			prewarmed = {};
+			if (pipeline) {
+				return image_processing_pipelines[index] = pipeline;
+			}
+		}
+
+		auto shaders = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+		image_processing_pipelines[index] = build_image_processing_pipeline(engine, shaders, format);
+
+		engine->main_deletion_queue.push_function([device = engine->device, pipeline = image_processing_pipelines[index]]{
+			vkDestroyPipeline(device, pipeline, nullptr);
+			});
+		return image_processing_pipelines[index];
 	}
 
 	void create_image_processing_command_buffer(VulkanEngine* engine, const VkFormat format) {
@@ -1044,6 +1215,36 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 			throw std::runtime_error("failed to allocate command buffers!");
 		}
 
+		//gray scale textures sample through an R -> RGB swizzle, attachments need the identity mapping
+		if (is_gray_scale(format)) {
+			const VkImageViewCreateInfo render_target_view_info{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.image = texture->image,
+				.viewType = VK_IMAGE_VIEW_TYPE_2D,
+				.format = format,
+				.subresourceRange = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.baseMipLevel = 0,
+					.levelCount = 1,
+					.baseArrayLayer = 0,
+					.layerCount = 1,
+				}
+			};
+
+			if (vkCreateImageView(engine->device, &render_target_view_info, nullptr, &owned_render_target_view) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create texture image view!");
+			}
+			render_target_image_view = owned_render_target_view;
+		}
+		else {
+			render_target_image_view = texture->image_view;
+		}
+
+		record_image_processing_command_buffer(engine);
+	}
+
+	//the command pool resets on begin, so the buffer is re-recorded in place and the submit infos stay valid
+	void record_image_processing_command_buffer(const VulkanEngine* engine) {
 		const VkCommandBufferBeginInfo begin_info{
 			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
 		};
@@ -1054,34 +1255,38 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 
 		VkExtent2D image_extent{ width, height };
 
-		const VkImageViewCreateInfo render_target_view_info{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-			.image = texture->image,
-			.viewType = VK_IMAGE_VIEW_TYPE_2D,
-			.format = format,
-			.subresourceRange = {
-				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1,
-			}
-		};
-
-		if (vkCreateImageView(engine->device, &render_target_view_info, nullptr, &render_target_image_view) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create texture image view!");
-		}
+		//every texel is written, so the previous contents are discarded
+		insert_image_memory_barrier(
+			image_processing_cmd_buffer,
+			texture->image,
+			VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+		);
 
-		const VkRenderPassAttachmentBeginInfo attachment_begin_info{
-			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_ATTACHMENT_BEGIN_INFO,
-			.attachmentCount = 1,
-			.pAttachments = &render_target_image_view,
+		const VkRenderingAttachmentInfo color_attachment{
+			.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+			.imageView = render_target_image_view,
+			.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
 		};
 
-		VkRenderPassBeginInfo render_pass_info = vkinit::render_pass_begin_info(image_processing_render_passes[format], image_extent, image_processing_framebuffer);
-		render_pass_info.pNext = &attachment_begin_info;
+		const VkRenderingInfo rendering_info{
+			.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+			.renderArea = {
+				.offset = { 0, 0 },
+				.extent = image_extent,
+			},
+			.layerCount = 1,
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &color_attachment,
+		};
 
-		vkCmdBeginRenderPass(image_processing_cmd_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRendering(image_processing_cmd_buffer, &rendering_info);
 
 		const VkViewport viewport{
 			.x = 0.0f,
@@ -1111,16 +1316,35 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 
 		vkCmdSetViewport(image_processing_cmd_buffer, 0, 1, &viewport);
 		vkCmdSetScissor(image_processing_cmd_buffer, 0, 1, &scissor);
-		vkCmdBindDescriptorSets(image_processing_cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, image_processing_pipeline_layout, 0, descriptor_sets.size(), descriptor_sets.data(), 0, nullptr);
-		vkCmdBindPipeline(image_processing_cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, image_processing_pipelines[format]);
+		const auto ubo_offset = static_cast<uint32_t>(this->uniform_buffer->offset);
+		vkCmdBindDescriptorSets(image_processing_cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, image_processing_pipeline_layout, 0, descriptor_sets.size(), descriptor_sets.data(), 1, &ubo_offset);
+		vkCmdBindPipeline(image_processing_cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, image_processing_pipeline);
 		vkCmdDraw(image_processing_cmd_buffer, 3, 1, 0, 0);
-		vkCmdEndRenderPass(image_processing_cmd_buffer);
+		vkCmdEndRendering(image_processing_cmd_buffer);
+
+		//the preview blit and exports read the result as a transfer source
+		insert_image_memory_barrier(
+			image_processing_cmd_buffer,
+			texture->image,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_COPY_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+		);
 
 		if (vkEndCommandBuffer(image_processing_cmd_buffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to record command buffer!");
 		}
 	}
 
+	void rebind_texture_descriptor_set(const VulkanEngine* engine) {
+		if constexpr (has_texture_field<InfoT>) {
+			record_image_processing_command_buffer(engine);
+		}
+	}
+
 	void update_command_buffer_submit_info() {
 		cmd_buffer_submit_info_0.commandBuffer = image_processing_cmd_buffer;
 		cmd_buffer_submit_info_1.commandBuffer = generate_preview_cmd_buffer;
@@ -1272,120 +1496,858 @@ struct ComponentGraphicPipeline : UboMixin<InfoType> {
 	}
 
 
-	void clear(VulkanEngine* engine) const {
-		vkDestroyImageView(engine->device, render_target_image_view, nullptr);
+	void clear(VulkanEngine* engine) {
+		vkDestroyImageView(engine->device, owned_render_target_view, nullptr);
+		owned_render_target_view = VK_NULL_HANDLE;
+		render_target_image_view = VK_NULL_HANDLE;
 		vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &image_processing_cmd_buffer);
-		vkDestroyFramebuffer(engine->device, image_processing_framebuffer, nullptr);
 	}
 };
 
-template<typename Component>
-struct ImageData : PinData, Component {
-	using InfoT = typename Component::InfoT;
-
-	VulkanEngine* engine;
+//Image node evaluated by one compute shader on the compute queue. The UBO, the shared dynamic UBO set and the bindless
+//input set follow ComponentGraphicPipeline, the kernel writes the result through the storage image at set 1, binding 0.
+//Workgroups are local_size x local_size invocations (16 unless Info declares local_size) and the shader receives that
+//size as specialization constants 0 and 1, so kernels are free to size shared memory by it and to use subgroup operations.
+//
+//Node textures belong to the graphics queue family. submit_info[0] releases the inputs on the graphics queue,
+//submit_info[1] acquires them, dispatches and releases the inputs and the result on the compute queue, and
+//submit_info[2] acquires them back on the graphics queue and blits the preview. The inputs are whatever texture ids the
+//UBO holds, so all three command buffers are recorded again by every evaluation.
+template<typename InfoType>
+struct ComponentComputePipeline : UboMixin<InfoType> {
+	using InfoT = InfoType;
 
-	int node_texture_id = -1;
+	static_assert(InfoT::shader_file_paths.size() == 1, "compute nodes are a single compute shader");
+	static_assert(!has_field_type_v<InfoT, ColorRampData>, "color ramp parameters are laid out for fragment nodes only");
+	static_assert(InfoT::default_format != VK_FORMAT_R8G8B8A8_SRGB, "compute nodes cannot store sRGB textures");
 
-	void* gui_texture = nullptr;  // ImTextureID handle
-	void* gui_preview_texture = nullptr;  // ImTextureID handle
+	constexpr static inline uint32_t local_size = [] {
+		if constexpr (requires { InfoT::local_size; }) {
+			return static_cast<uint32_t>(InfoT::local_size);
+		}
+		else {
+			return 16u;
+		}
+	}();
 
-	std::array<VkCommandBuffer, PbrMaterialTextureNum> copy_image_cmd_buffers;
+	inline static VkDescriptorSetLayout ubo_descriptor_set_layout = nullptr;
+	inline static VkDescriptorSet ubo_descriptor_set = nullptr;  //shared by every node of this type, bound at the node's arena offset
+	inline static VkDescriptorSetLayout storage_image_set_layout = nullptr;
+	inline static VkPipelineLayout image_processing_pipeline_layout = nullptr;
+	//images are written without a format qualifier, so one pipeline serves every format
+	inline static VkPipeline built_pipeline = nullptr;
+	inline static std::shared_future<VkPipeline> prewarmed_pipeline;  //not yet adopted by a node
+	inline static bool shader_watched = false;
+	inline static uint32_t shader_generation = 0;  //bumped by every edit of the shader
 
-	explicit ImageData(VulkanEngine* engine) :Component(engine), engine(engine) {
+	TexturePtr texture;
+	TexturePtr preview_texture;
+	VkPipeline image_processing_pipeline = VK_NULL_HANDLE;
+	uint32_t pipeline_generation = 0;  //shader_generation of image_processing_pipeline
+	VkImageView storage_image_view = VK_NULL_HANDLE;  //identity swizzled view of texture, storage views cannot swizzle
+	VkDescriptorSet storage_image_set = VK_NULL_HANDLE;
+	std::vector<VkImage> input_images;  //inputs of the last recording, transferred to the compute queue and back
 
-		create_semaphore();
+	VkCommandBuffer ownership_release_cmd_buffer = nullptr;
+	VkCommandBuffer image_processing_cmd_buffer = nullptr;
+	VkCommandBuffer generate_preview_cmd_buffer = nullptr;
 
-		Component::create_ubo_descriptor_set_layout(engine);
+	uint32_t width = TEXTURE_IMAGE_SIZE;
+	uint32_t height = TEXTURE_IMAGE_SIZE;
 
-		Component::create_ubo_descriptor_sets(engine);
+	VkSemaphore semaphore;
 
-		Component::create_image_processing_pipeline_layouts(engine);
+	std::vector<VkSemaphoreSubmitInfo> wait_semaphore_submit_info_0;
+	VkCommandBufferSubmitInfo cmd_buffer_submit_info_0;
+	VkSemaphoreSubmitInfo signal_semaphore_submit_info_0;
 
-		create_texture_resource(InfoT::default_format);
+	std::array<SubmitInfoMembers, 2> submit_info_members;
 
-		Component::create_cmd_buffer_submit_info();
-	}
+	std::array<VkSubmitInfo2, 3> submit_info;
 
-	void create_texture_resource(const VkFormat format) {
-		Component::create_textures(engine, format);
-		create_preview_texture(format);
-		update_image_descriptor_sets();
-		Component::update_ubo_descriptor_sets(engine);
-		Component::create_image_processing_pipeline_resource(engine, format);
+	explicit ComponentComputePipeline(VulkanEngine* engine) : UboMixin<InfoType>(engine) {}
 
-		Component::create_preview_command_buffer(engine);
-		create_copy_image_cmd_buffers();
+	//8-bit sRGB has no storage support on most devices and imageStore() does not encode, so sRGB formats are refused
+	//instead of storing linear values that consumers would decode again
+	static bool supports_format(const VkFormat format) noexcept {
+		return format != VK_FORMAT_R8G8B8A8_SRGB;
 	}
 
-	void recreate_texture_resource(const VkFormat format) {
-		Component::clear(engine);
-		vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &this->generate_preview_cmd_buffer);
-		create_texture_resource(format);
-		Component::update_command_buffer_submit_info();
+	static bool is_gray_scale(const VkFormat format) {
+		return format == VK_FORMAT_R16_UNORM || format == VK_FORMAT_R16_SFLOAT;
 	}
 
-	~ImageData() {
-		engine->texture_manager->delete_id(node_texture_id);
-		Component::clear(engine);
-		vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &this->generate_preview_cmd_buffer);
-		if constexpr (std::same_as<Component, ComponentUdf<InfoT>>) {
-			vkFreeDescriptorSets(engine->device, engine->dynamic_descriptor_pool, this->ubo_descriptor_sets.size(), this->ubo_descriptor_sets.data());
-			vkDestroyImageView(engine->device, this->result_image_view, nullptr);
+	void create_image_processing_pipeline_resource(VulkanEngine* engine, VkFormat) {
+		image_processing_pipeline = create_image_processing_pipeline(engine);
+		pipeline_generation = shader_generation;
+
+		const VkCommandBufferAllocateInfo release_alloc_info = vkinit::command_buffer_allocate_info(engine->graphic_command_pool, 1);
+		if (vkAllocateCommandBuffers(engine->device, &release_alloc_info, &ownership_release_cmd_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffers!");
 		}
-		else {
-			vkFreeDescriptorSets(engine->device, engine->dynamic_descriptor_pool, 1, &this->ubo_descriptor_set);
+		const VkCommandBufferAllocateInfo compute_alloc_info = vkinit::command_buffer_allocate_info(engine->compute_command_pool, 1);
+		if (vkAllocateCommandBuffers(engine->device, &compute_alloc_info, &image_processing_cmd_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffers!");
 		}
-		vkDestroySemaphore(engine->device, this->semaphore, nullptr);
 	}
 
-	void create_semaphore() {
-		constexpr VkSemaphoreTypeCreateInfo timeline_semaphore_create_info{
-			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
-			.pNext = nullptr,
-			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
-			.initialValue = 0,
-		};
-
-		const VkSemaphoreCreateInfo semaphore_create_info{
-			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-			.pNext = &timeline_semaphore_create_info,
-			.flags = 0,
-		};
+	[[nodiscard]] bool pipeline_outdated() const noexcept {
+		return pipeline_generation != shader_generation;
+	}
 
-		vkCreateSemaphore(engine->device, &semaphore_create_info, nullptr, &this->semaphore);
+	//the next evaluation records the node with the pipeline of the edited shader
+	void reload_pipeline(VulkanEngine* engine) {
+		image_processing_pipeline = create_image_processing_pipeline(engine);
+		pipeline_generation = shader_generation;
 	}
 
-	void update_image_descriptor_sets() const {
-		const VkDescriptorImageInfo image_info{
-			.sampler = this->texture->sampler,
-			.imageView = this->texture->image_view,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	static void create_ubo_descriptor_set_layout(VulkanEngine* engine) {
+		if (ubo_descriptor_set_layout) {
+			return;
+		}
+		std::array layout_bindings = {
+			vkinit::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT, 0),
 		};
+		engine->create_descriptor_set_layout(layout_bindings, ubo_descriptor_set_layout);
 
-		const std::array descriptor_writes{
-			VkWriteDescriptorSet {
-				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-				.dstSet = engine->texture_manager->descriptor_set,
-				.dstBinding = 0,
-				.dstArrayElement = static_cast<uint32_t>(node_texture_id),
-				.descriptorCount = 1,
-				.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				.pImageInfo = &image_info,
-			},
+		std::array storage_image_bindings = {
+			vkinit::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 0),
 		};
+		engine->create_descriptor_set_layout(storage_image_bindings, storage_image_set_layout);
+	}
 
-		vkUpdateDescriptorSets(engine->device, descriptor_writes.size(), descriptor_writes.data(), 0, nullptr);
+	static void create_ubo_descriptor_sets(VulkanEngine* engine) {
+		if (ubo_descriptor_set) {
+			return;
+		}
+		const VkDescriptorSetAllocateInfo ubo_descriptor_alloc_info{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.descriptorPool = engine->dynamic_descriptor_pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &ubo_descriptor_set_layout,
+		};
+
+		if (vkAllocateDescriptorSets(engine->device, &ubo_descriptor_alloc_info, &ubo_descriptor_set) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate descriptor sets!");
+		}
+
+		const VkDescriptorBufferInfo uniform_buffer_info{
+			.buffer = engine->uniform_arena->buffer(),
+			.offset = 0,
+			.range = UboMixin<InfoType>::ubo_size,
+		};
+
+		const VkWriteDescriptorSet descriptor_write{
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = ubo_descriptor_set,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+			.pBufferInfo = &uniform_buffer_info,
+		};
+
+		vkUpdateDescriptorSets(engine->device, 1, &descriptor_write, 0, nullptr);
+	}
+
+	//the UBO set is shared, only the node's own storage image is written here
+	void update_ubo_descriptor_sets(VulkanEngine* engine) {
+		if (!storage_image_set) {
+			const VkDescriptorSetAllocateInfo storage_image_alloc_info{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+				.descriptorPool = engine->dynamic_descriptor_pool,
+				.descriptorSetCount = 1,
+				.pSetLayouts = &storage_image_set_layout,
+			};
+
+			if (vkAllocateDescriptorSets(engine->device, &storage_image_alloc_info, &storage_image_set) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate descriptor sets!");
+			}
+		}
+
+		const VkImageViewCreateInfo storage_image_view_info{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.image = texture->image,
+			.viewType = VK_IMAGE_VIEW_TYPE_2D,
+			.format = texture->format,
+			.subresourceRange = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.baseMipLevel = 0,
+				.levelCount = 1,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			}
+		};
+
+		if (vkCreateImageView(engine->device, &storage_image_view_info, nullptr, &storage_image_view) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create texture image view!");
+		}
+
+		const VkDescriptorImageInfo storage_image_info{
+			.imageView = storage_image_view,
+			.imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+		};
+
+		const VkWriteDescriptorSet descriptor_write{
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = storage_image_set,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			.pImageInfo = &storage_image_info,
+		};
+
+		vkUpdateDescriptorSets(engine->device, 1, &descriptor_write, 0, nullptr);
+	}
+
+	static void create_image_processing_pipeline_layouts(VulkanEngine* engine) {
+		if (image_processing_pipeline_layout) {
+			return;
+		}
+
+		auto descriptor_set_layouts = [&] {
+			if constexpr (has_texture_field<InfoT>) {
+				return std::array{
+					ubo_descriptor_set_layout,
+					storage_image_set_layout,
+					engine->texture_manager->descriptor_set_layout,
+				};
+			}
+			else {
+				return std::array{ ubo_descriptor_set_layout, storage_image_set_layout };
+			}
+		}();
+
+		auto image_processing_pipeline_info = vkinit::pipeline_layout_create_info(descriptor_set_layouts);
+
+		if (vkCreatePipelineLayout(engine->device, &image_processing_pipeline_info, nullptr, &image_processing_pipeline_layout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		engine->main_deletion_queue.push_function([device = engine->device, pipeline_layout = image_processing_pipeline_layout]{
+			vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+			});
+	}
+
+	void create_textures(VulkanEngine* engine, const VkFormat format) {
+		if (!supports_format(format)) {
+			throw std::runtime_error("failed to create compute node texture, sRGB formats cannot be stored!");
+		}
+		texture = engine::Texture::create_device_texture(engine,
+			this->width,
+			this->height,
+			format,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			TEMP_BIT,
+			is_gray_scale(format));
+
+		texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	static void watch_shader_files(VulkanEngine* engine) {
+		if (shader_watched) {
+			return;
+		}
+		//the old pipeline stays alive in main_deletion_queue for the nodes still holding it
+		engine->shader_cache->subscribe(InfoT::shader_file_paths, [](auto const&) {
+			built_pipeline = nullptr;
+			prewarmed_pipeline = {};
+			++shader_generation;
+			});
+		shader_watched = true;
+	}
+
+	//safe to call from worker threads once the shader and pipeline layout exist
+	static VkPipeline build_image_processing_pipeline(VulkanEngine* engine, const ShaderPtr& shader) {
+		const std::array specialization_entries{
+			VkSpecializationMapEntry{ .constantID = 0, .offset = 0, .size = sizeof(uint32_t) },
+			VkSpecializationMapEntry{ .constantID = 1, .offset = 0, .size = sizeof(uint32_t) },
+		};
+
+		const VkSpecializationInfo specialization_info{
+			.mapEntryCount = static_cast<uint32_t>(specialization_entries.size()),
+			.pMapEntries = specialization_entries.data(),
+			.dataSize = sizeof(uint32_t),
+			.pData = &local_size,
+		};
+
+		const VkComputePipelineCreateInfo compute_pipeline_create_info{
+			.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+			.stage = {
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.stage = shader->shader_modules[0].stage,
+				.module = shader->shader_modules[0].shader,
+				.pName = "main",
+				.pSpecializationInfo = &specialization_info,
+			},
+			.layout = image_processing_pipeline_layout,
+		};
+
+		VkPipeline pipeline;
+		if (vkCreateComputePipelines(engine->device, engine->pipeline_cache->handle(), 1, &compute_pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute pipeline!");
+		}
+		return pipeline;
+	}
+
+	//see ComponentGraphicPipeline::prewarm_pipelines, compute pipelines do not depend on the format
+	static void prewarm_pipelines(VulkanEngine* engine, ThreadPool& thread_pool, std::span<const VkFormat>) {
+		if (built_pipeline || prewarmed_pipeline.valid()) {
+			return;
+		}
+		create_ubo_descriptor_set_layout(engine);
+		create_image_processing_pipeline_layouts(engine);
+		watch_shader_files(engine);
+
+		auto shader = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+		prewarmed_pipeline = thread_pool.submit([engine, shader]() -> VkPipeline {
+			try {
+				return build_image_processing_pipeline(engine, shader);
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+				return VK_NULL_HANDLE;
+			}
+			}).share();
+
+		engine->main_deletion_queue.push_function([device = engine->device, pipeline = prewarmed_pipeline] {
+			vkDestroyPipeline(device, pipeline.get(), nullptr);
+			});
+	}
+
+	static VkPipeline create_image_processing_pipeline(VulkanEngine* engine) {
+		if (built_pipeline) {
+			return built_pipeline;
+		}
+		watch_shader_files(engine);
+
+		if (prewarmed_pipeline.valid()) {
+			auto const pipeline = prewarmed_pipeline.get();  //destroyed by the deletion queued in prewarm_pipelines()
+			prewarmed_pipeline = {};
+			if (pipeline) {
+				return built_pipeline = pipeline;
+			}
+		}
+
+		auto shader = engine::Shader::createFromSpv(engine, InfoT::shader_file_paths);
+		built_pipeline = build_image_processing_pipeline(engine, shader);
+
+		engine->main_deletion_queue.push_function([device = engine->device, pipeline = built_pipeline]{
+			vkDestroyPipeline(device, pipeline, nullptr);
+			});
+		return built_pipeline;
+	}
+
+	//images behind the texture ids of the parameters staged for this evaluation, each one once
+	void collect_input_images(const VulkanEngine* engine) {
+		input_images.clear();
+		for (size_t i = 0; i < InfoT::Class::TotalFields; ++i) {
+			InfoT::Class::FieldAt(i, [&](auto& field) {
+				using PinT = typename std::decay_t<decltype(field)>::Type;
+				size_t id_offset;
+				if constexpr (std::same_as<PinT, TextureIdData>) {
+					id_offset = field.getOffset();
+				}
+				else if constexpr (std::same_as<PinT, FloatTextureIdData>) {
+					id_offset = field.getOffset() + sizeof(FloatData);
+				}
+				else if constexpr (std::same_as<PinT, Color4TextureIdData>) {
+					id_offset = field.getOffset() + sizeof(Color4Data);
+				}
+				else {
+					return;
+				}
+				int32_t texture_id;
+				memcpy(&texture_id, this->staged_ubo.data() + id_offset, sizeof(int32_t));
+				if (texture_id < 0) {
+					return;
+				}
+				auto const input = engine->texture_manager->textures.find(static_cast<uint32_t>(texture_id));
+				if (input == engine->texture_manager->textures.end() || !input->second || input->second->image == texture->image) {
+					return;
+				}
+				if (std::ranges::find(input_images, input->second->image) == input_images.end()) {
+					input_images.push_back(input->second->image);
+				}
+				});
+		}
+	}
+
+	//called by every evaluation while the previous one has retired, the command pools reset the buffers on begin
+	void record_image_processing_command_buffers(const VulkanEngine* engine) {
+		collect_input_images(engine);
+
+		auto const graphics_family = engine->queue_family_indices.graphics_family.value();
+		auto const compute_family = engine->queue_family_indices.compute_family.value();
+		const VkCommandBufferBeginInfo begin_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		};
+
+		//graphics queue: hand the inputs over once their producers signalled
+		if (vkBeginCommandBuffer(ownership_release_cmd_buffer, &begin_info) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		for (auto const input_image : input_images) {
+			insert_image_memory_barrier(
+				ownership_release_cmd_buffer,
+				input_image,
+				VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+				VK_ACCESS_2_NONE,
+				VK_PIPELINE_STAGE_2_NONE,
+				VK_ACCESS_2_NONE,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				graphics_family,
+				compute_family
+			);
+		}
+		if (vkEndCommandBuffer(ownership_release_cmd_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+
+		//compute queue
+		if (vkBeginCommandBuffer(image_processing_cmd_buffer, &begin_info) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		for (auto const input_image : input_images) {
+			insert_image_memory_barrier(
+				image_processing_cmd_buffer,
+				input_image,
+				VK_PIPELINE_STAGE_2_NONE,
+				VK_ACCESS_2_NONE,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				graphics_family,
+				compute_family
+			);
+		}
+
+		//every texel is written, so the result needs no ownership transfer on the way in
+		insert_image_memory_barrier(
+			image_processing_cmd_buffer,
+			texture->image,
+			VK_PIPELINE_STAGE_2_NONE,
+			VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_GENERAL
+		);
+
+		auto descriptor_sets = [&] {
+			if constexpr (has_texture_field<InfoT>) {
+				return std::array{
+					ubo_descriptor_set,
+					storage_image_set,
+					engine->texture_manager->descriptor_set,
+				};
+			}
+			else {
+				return std::array{ ubo_descriptor_set, storage_image_set };
+			}
+		}();
+
+		const auto ubo_offset = static_cast<uint32_t>(this->uniform_buffer->offset);
+		vkCmdBindPipeline(image_processing_cmd_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, image_processing_pipeline);
+		vkCmdBindDescriptorSets(image_processing_cmd_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, image_processing_pipeline_layout, 0, descriptor_sets.size(), descriptor_sets.data(), 1, &ubo_offset);
+		vkCmdDispatch(image_processing_cmd_buffer, (width + local_size - 1) / local_size, (height + local_size - 1) / local_size, 1);
+
+		for (auto const input_image : input_images) {
+			insert_image_memory_barrier(
+				image_processing_cmd_buffer,
+				input_image,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_NONE,
+				VK_PIPELINE_STAGE_2_NONE,
+				VK_ACCESS_2_NONE,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				compute_family,
+				graphics_family
+			);
+		}
+
+		insert_image_memory_barrier(
+			image_processing_cmd_buffer,
+			texture->image,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_NONE,
+			VK_ACCESS_2_NONE,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			compute_family,
+			graphics_family
+		);
+
+		if (vkEndCommandBuffer(image_processing_cmd_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+
+		//graphics queue: take everything back and blit the preview
+		if (vkBeginCommandBuffer(generate_preview_cmd_buffer, &begin_info) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		for (auto const input_image : input_images) {
+			insert_image_memory_barrier(
+				generate_preview_cmd_buffer,
+				input_image,
+				VK_PIPELINE_STAGE_2_NONE,
+				VK_ACCESS_2_NONE,
+				VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+				VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				compute_family,
+				graphics_family
+			);
+		}
+
+		insert_image_memory_barrier(
+			generate_preview_cmd_buffer,
+			texture->image,
+			VK_PIPELINE_STAGE_2_NONE,
+			VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_BLIT_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			compute_family,
+			graphics_family
+		);
+
+		insert_image_memory_barrier(
+			generate_preview_cmd_buffer,
+			preview_texture->image,
+			VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_BLIT_BIT,
+			VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+		);
+
+		const VkImageBlit image_blit{
+			.srcSubresource = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = 0,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+			.srcOffsets = {
+				{0, 0, 0},
+				{static_cast<int32_t>(texture->width), static_cast<int32_t>(texture->height), 1},
+			},
+			.dstSubresource = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = 0,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+			.dstOffsets = {
+				{0, 0, 0},
+				{static_cast<int32_t>(preview_texture->width), static_cast<int32_t>(preview_texture->height), 1},
+			},
+		};
+
+		vkCmdBlitImage(
+			generate_preview_cmd_buffer,
+			texture->image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			preview_texture->image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&image_blit,
+			VK_FILTER_LINEAR
+		);
+
+		insert_image_memory_barrier(
+			generate_preview_cmd_buffer,
+			preview_texture->image,
+			VK_PIPELINE_STAGE_2_BLIT_BIT,
+			VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_NONE,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		);
+
+		insert_image_memory_barrier(
+			generate_preview_cmd_buffer,
+			texture->image,
+			VK_PIPELINE_STAGE_2_BLIT_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT,
+			VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_NONE,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		);
+
+		if (vkEndCommandBuffer(generate_preview_cmd_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+	}
+
+	//recorded by every evaluation, which binds the current set anyway
+	void rebind_texture_descriptor_set(const VulkanEngine*) {}
+
+	void update_command_buffer_submit_info() {
+		cmd_buffer_submit_info_0.commandBuffer = ownership_release_cmd_buffer;
+		submit_info_members[0].cmd_buffer_submit_info.commandBuffer = image_processing_cmd_buffer;
+		submit_info_members[1].cmd_buffer_submit_info.commandBuffer = generate_preview_cmd_buffer;
+	}
+
+	void create_cmd_buffer_submit_info() {
+		cmd_buffer_submit_info_0 = VkCommandBufferSubmitInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+			.commandBuffer = ownership_release_cmd_buffer,
+		};
+
+		signal_semaphore_submit_info_0 = VkSemaphoreSubmitInfo{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.semaphore = semaphore,
+			.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		};
+
+		submit_info[0] = VkSubmitInfo2{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+			.pNext = nullptr,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &cmd_buffer_submit_info_0,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &signal_semaphore_submit_info_0,
+		};
+
+		const std::array cmd_buffers{ image_processing_cmd_buffer, generate_preview_cmd_buffer };
+		for (size_t i = 0; i < submit_info_members.size(); ++i) {
+			submit_info_members[i] = SubmitInfoMembers{
+				.wait_semaphore_submit_info = {
+					.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+					.pNext = nullptr,
+					.semaphore = semaphore,
+					.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+				},
+				.cmd_buffer_submit_info = {
+					.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+					.commandBuffer = cmd_buffers[i],
+				},
+				.signal_semaphore_submit_info = {
+					.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+					.pNext = nullptr,
+					.semaphore = semaphore,
+					.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+				}
+			};
+		}
+
+		for (size_t i = 1; i <= submit_info_members.size(); ++i) {
+			submit_info[i] = VkSubmitInfo2{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+				.waitSemaphoreInfoCount = 1,
+				.pWaitSemaphoreInfos = &submit_info_members[i - 1].wait_semaphore_submit_info,
+				.commandBufferInfoCount = 1,
+				.pCommandBufferInfos = &submit_info_members[i - 1].cmd_buffer_submit_info,
+				.signalSemaphoreInfoCount = 1,
+				.pSignalSemaphoreInfos = &submit_info_members[i - 1].signal_semaphore_submit_info,
+			};
+		}
+	}
+
+	//only allocated here, record_image_processing_command_buffers() records it together with the acquires
+	void create_preview_command_buffer(VulkanEngine* engine) {
+		const VkCommandBufferAllocateInfo cmd_alloc_info = vkinit::command_buffer_allocate_info(engine->graphic_command_pool, 1);
+
+		if (vkAllocateCommandBuffers(engine->device, &cmd_alloc_info, &generate_preview_cmd_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffers!");
+		}
+	}
+
+	void clear(VulkanEngine* engine) {
+		vkDestroyImageView(engine->device, storage_image_view, nullptr);
+		storage_image_view = VK_NULL_HANDLE;
+		vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &ownership_release_cmd_buffer);
+		vkFreeCommandBuffers(engine->device, engine->compute_command_pool, 1, &image_processing_cmd_buffer);
+	}
+};
+
+template<typename Component>
+struct ImageData : PinData, Component {
+	using InfoT = typename Component::InfoT;
+
+	VulkanEngine* engine;
+
+	int node_texture_id = -1;
+
+	void* gui_texture = nullptr;  // ImTextureID handle
+	void* gui_preview_texture = nullptr;  // ImTextureID handle
+
+	std::array<VkCommandBuffer, PbrMaterialTextureNum> copy_image_cmd_buffers;
+
+	bool resident = true;  //false while evict() has replaced the output with a placeholder
+	uint64_t last_use_frame = 0;  //NodeEditor residency clock of the last evaluation that wrote or read the output
+
+	explicit ImageData(VulkanEngine* engine) :Component(engine), engine(engine) {
+
+		create_semaphore();
+
+		Component::create_ubo_descriptor_set_layout(engine);
+
+		Component::create_ubo_descriptor_sets(engine);
+
+		Component::create_image_processing_pipeline_layouts(engine);
+
+		create_texture_resource(InfoT::default_format);
+
+		Component::create_cmd_buffer_submit_info();
+	}
+
+	void create_texture_resource(const VkFormat format) {
+		{
+			engine::MemoryCategoryScope memory_scope(MemoryCategory::NODE_TEXTURE);
+			Component::create_textures(engine, format);
+		}
+		create_preview_texture(format);
+		update_image_descriptor_sets();
+		Component::update_ubo_descriptor_sets(engine);
+		Component::create_image_processing_pipeline_resource(engine, format);
+
+		Component::create_preview_command_buffer(engine);
+		create_copy_image_cmd_buffers();
+	}
+
+	//whether the node can store its result in format, the editor does not offer the formats it cannot
+	static bool supports_format(const VkFormat format) noexcept {
+		if constexpr (requires { Component::supports_format(format); }) {
+			return Component::supports_format(format);
+		}
+		else {
+			return true;
+		}
+	}
+
+	void recreate_texture_resource(const VkFormat format) {
+		if (!supports_format(format)) {
+			std::cerr << "compute nodes cannot store " << str_format_map.at(format) << ", the node keeps "
+				<< str_format_map.at(this->texture->format) << std::endl;
+			return;
+		}
+		if (resident) {
+			Component::clear(engine);
+			vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &this->generate_preview_cmd_buffer);
+		}
+		resident = true;
+		create_texture_resource(format);
+		Component::update_command_buffer_submit_info();
+	}
+
+	//Drops the full resolution output of a graphics node with its render target and command buffers. The texture id and
+	//gui_texture show a 1x1 placeholder of the same format until rematerialize(), the preview is kept
+	void evict() requires std::same_as<Component, ComponentGraphicPipeline<InfoT>> {
+		const VkFormat format = this->texture->format;
+		Component::clear(engine);
+		vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &this->generate_preview_cmd_buffer);
+		{
+			engine::MemoryCategoryScope memory_scope(MemoryCategory::NODE_TEXTURE);
+			this->texture = engine::Texture::create_device_texture(engine,
+				1,
+				1,
+				format,
+				VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_USAGE_SAMPLED_BIT,
+				TEMP_BIT,
+				format == VK_FORMAT_R16_UNORM || format == VK_FORMAT_R16_SFLOAT);
+		}
+		this->texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		bind_node_texture();
+		resident = false;
+	}
+
+	//recreates what evict() dropped, the contents are undefined until the node is evaluated again
+	void rematerialize() requires std::same_as<Component, ComponentGraphicPipeline<InfoT>> {
+		const VkFormat format = this->texture->format;
+		{
+			engine::MemoryCategoryScope memory_scope(MemoryCategory::NODE_TEXTURE);
+			Component::create_textures(engine, format);
+		}
+		bind_node_texture();
+		Component::create_image_processing_pipeline_resource(engine, format);
+		Component::create_preview_command_buffer(engine);
+		Component::update_command_buffer_submit_info();
+		resident = true;
+	}
+
+	//swaps in the pipeline built from the edited shaders, rematerialize() picks it up for an evicted node
+	void reload_pipeline() {
+		if (resident) {
+			Component::reload_pipeline(engine);
+		}
+	}
+
+	void rebind_texture_descriptor_set(const VulkanEngine* engine) {
+		if (resident) {  //rematerialize() records against the current set
+			Component::rebind_texture_descriptor_set(engine);
+		}
+	}
+
+	~ImageData() {
+		engine->texture_manager->delete_id(node_texture_id);
+		if (resident) {
+			Component::clear(engine);
+			vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &this->generate_preview_cmd_buffer);
+		}
+		if constexpr (std::same_as<Component, ComponentUdf<InfoT>>) {
+			vkFreeDescriptorSets(engine->device, engine->dynamic_descriptor_pool, this->ubo_descriptor_sets.size(), this->ubo_descriptor_sets.data());
+			vkDestroyImageView(engine->device, this->result_image_view, nullptr);
+		}
+		else if constexpr (std::same_as<Component, ComponentComputePipeline<InfoT>>) {
+			vkFreeDescriptorSets(engine->device, engine->dynamic_descriptor_pool, 1, &this->storage_image_set);
+		}
+		vkDestroySemaphore(engine->device, this->semaphore, nullptr);
+	}
+
+	void create_semaphore() {
+		constexpr VkSemaphoreTypeCreateInfo timeline_semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.pNext = nullptr,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+
+		const VkSemaphoreCreateInfo semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &timeline_semaphore_create_info,
+			.flags = 0,
+		};
+
+		vkCreateSemaphore(engine->device, &semaphore_create_info, nullptr, &this->semaphore);
+	}
+
+	void update_image_descriptor_sets() const {
+		engine->texture_manager->queue_descriptor_write(static_cast<uint32_t>(node_texture_id), this->texture);
+	}
+
+	//points the texture id and gui_texture at the current output texture
+	void bind_node_texture() {
+		ImGui_ImplVulkan_UpdateTexture(gui_texture, this->texture->sampler, this->texture->image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		engine->texture_manager->textures[node_texture_id] = this->texture;
+		update_image_descriptor_sets();
 	}
 
 	void create_preview_texture(const VkFormat format) {
+		engine::MemoryCategoryScope memory_scope(MemoryCategory::PREVIEW);
 		const bool is_gray_scale = (format == VK_FORMAT_R16_UNORM || format == VK_FORMAT_R16_SFLOAT);
 		this->preview_texture = engine::Texture::create_device_texture(engine,
 			PREVIEW_IMAGE_SIZE,
 			PREVIEW_IMAGE_SIZE,
 			format,
 			VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			TEMP_BIT,
 			is_gray_scale);
 
@@ -2,11 +2,16 @@
 #include <imgui_internal.h>
 
 #include "../vk_shader.h"
+#include "../vk_texture_pool.h"
+#include "../vk_memory_stats.h"
+#include "../vk_pipeline_cache.h"
+#include "../vk_upload_ring.h"
 
 #include <IconsFontAwesome5.h>
 #include <json.hpp>
 #include <ranges>
 #include <fstream>
+#include <iostream>
 
 
 using json = nlohmann::json;
@@ -19,15 +24,14 @@ constexpr static bool is_component_graphic = std::derived_from<ref_t<NodeDataT>,
 template<typename NodeDataT>
 constexpr static bool is_component_udf = std::derived_from<ref_t<NodeDataT>, ComponentUdf<typename ref_t<NodeDataT>::InfoT>>;
 
+template<typename NodeDataT>
+constexpr static bool is_component_compute = std::derived_from<ref_t<NodeDataT>, ComponentComputePipeline<typename ref_t<NodeDataT>::InfoT>>;
+
 template <typename T, typename ArrayElementT>
 concept std_array = requires (std::remove_cvref_t<T> t) {
 	[] <size_t I> (std::array<ArrayElementT, I>) {}(t);
 };
 
-void to_json(json& j, const ImVec2& p) {
-	j = std::array{ p.x, p.y };
-}
-
 static ImRect imgui_get_item_rect() {
 	return ImRect(ImGui::GetItemRectMin(), ImGui::GetItemRectMax());
 }
@@ -93,7 +97,200 @@ namespace engine {
 		}
 	}
 
-	void NodeEditor::execute_graph(const std::vector<uint32_t>& sorted_nodes) {
+	//Adds the evicted graphics nodes the evaluation samples, directly or through other evicted nodes, and orders
+	//the result like topological_sort(). Their own resident inputs are still valid and are not re-evaluated
+	std::vector<uint32_t> NodeEditor::add_evicted_inputs(const std::vector<uint32_t>& sorted_nodes) {
+		std::vector<char> in_evaluation(nodes.size(), 0);
+		for (auto const i : sorted_nodes) {
+			in_evaluation[i] = 1;
+		}
+
+		std::vector<uint32_t> evicted_nodes;
+		std::vector<uint32_t> stack(sorted_nodes);
+		while (!stack.empty()) {
+			auto const idx = stack.back();
+			stack.pop_back();
+			for (auto& pin : nodes[idx].inputs) {
+				for (const Pin* connected_pin : pin.connected_pins) {
+					auto const input_idx = connected_pin->node_index;
+					std::visit([&](auto&& node_data) {
+						using NodeDataT = std::decay_t<decltype(node_data)>;
+						if constexpr (image_data<NodeDataT>) {
+							node_data->last_use_frame = residency_frame;
+							if (!node_data->resident && in_evaluation[input_idx] == 0) {
+								in_evaluation[input_idx] = 1;
+								evicted_nodes.push_back(input_idx);
+								stack.push_back(input_idx);
+							}
+						}
+						}, nodes[input_idx].data);
+				}
+			}
+		}
+		if (evicted_nodes.empty()) {
+			return sorted_nodes;
+		}
+
+		//post-order over output links restricted to the evaluation, consumers are emitted before their producers
+		std::vector<char> visited_nodes(nodes.size(), 0);
+		std::vector<uint32_t> result;
+		result.reserve(sorted_nodes.size() + evicted_nodes.size());
+		for (auto const root : evicted_nodes | std::views::reverse) {
+			if (visited_nodes[root] == 0) {
+				std::stack<int64_t> topo_sort_stack;
+				visited_nodes[root] = 1;
+				topo_sort_stack.push(root);
+				while (!topo_sort_stack.empty()) {
+					const int64_t idx = topo_sort_stack.top();
+					topo_sort_stack.pop();
+					if (idx < 0) {
+						result.emplace_back(~idx);
+						continue;
+					}
+					topo_sort_stack.push(~idx);
+					for (auto& pin : nodes[idx].outputs) {
+						for (const Pin* connected_pin : pin.connected_pins) {
+							auto const connected_node_idx = connected_pin->node_index;
+							if (in_evaluation[connected_node_idx] && visited_nodes[connected_node_idx] == 0) {
+								visited_nodes[connected_node_idx] = 1;
+								topo_sort_stack.push(connected_node_idx);
+							}
+						}
+					}
+				}
+			}
+		}
+		for (auto const i : sorted_nodes) {  //sorted_nodes is already ordered, keep it for what the evicted nodes did not reach
+			if (visited_nodes[i] == 0) {
+				result.push_back(i);
+			}
+		}
+		return result;
+	}
+
+	//UDF and compute nodes release their inputs to the compute queue family and acquire them back on the graphics queue,
+	//so no other consumer may sample those textures in between. The evaluated consumers of every texture are walked in
+	//submission order: a transferring consumer waits for the readers submitted before it, every later consumer waits
+	//for the last transfer. The waits only point backwards in submission order and cannot form a cycle.
+	//Returns what the PBR copies of each node wait for, the node itself or the consumer that handed it back last
+	std::vector<VkSemaphoreSubmitInfo> NodeEditor::order_queue_transfers(const std::vector<uint32_t>& sorted_nodes, const std::vector<uint64_t>& last_signal_values) {
+		enum class Access : uint8_t { None, Sample, Transfer };
+		std::vector<Access> accesses(nodes.size(), Access::None);
+		std::vector<size_t> submission_order(nodes.size(), 0);
+		for (size_t position = 0; auto const i : sorted_nodes | std::views::reverse) {
+			submission_order[i] = position++;
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					if constexpr (is_component_udf<NodeDataT>) {
+						if (node_data->submit_info[0].pCommandBufferInfos->commandBuffer) {
+							accesses[i] = Access::Transfer;
+						}
+					}
+					else if constexpr (is_component_compute<NodeDataT>) {
+						accesses[i] = Access::Transfer;
+					}
+					else {
+						accesses[i] = Access::Sample;
+					}
+				}
+				}, nodes[i].data);
+		}
+
+		auto const semaphore_of = [&](const uint32_t index) {
+			return std::visit([](auto&& node_data) -> VkSemaphore {
+				if constexpr (image_data<std::decay_t<decltype(node_data)>>) {
+					return node_data->semaphore;
+				}
+				else {
+					return nullptr;
+				}
+				}, nodes[index].data);
+		};
+		auto const wait_for = [&](const uint32_t index) {
+			return VkSemaphoreSubmitInfo{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.semaphore = semaphore_of(index),
+				.value = last_signal_values[index],
+				.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			};
+		};
+		auto const add_wait = [&](const uint32_t waiting_index, const uint32_t signaling_index) {
+			std::visit([&](auto&& node_data) {
+				if constexpr (image_data<std::decay_t<decltype(node_data)>>) {
+					node_data->wait_semaphore_submit_info_0.push_back(wait_for(signaling_index));
+				}
+				}, nodes[waiting_index].data);
+		};
+
+		std::vector<VkSemaphoreSubmitInfo> copy_waits(nodes.size());
+		std::vector<uint32_t> consumers;
+		std::vector<uint32_t> readers;
+		for (uint32_t producer = 0; producer < nodes.size(); ++producer) {
+			if (accesses[producer] != Access::None) {
+				copy_waits[producer] = wait_for(producer);
+			}
+			if (!semaphore_of(producer)) {
+				continue;
+			}
+			consumers.clear();
+			for (auto& pin : nodes[producer].outputs) {
+				for (const Pin* connected_pin : pin.connected_pins) {
+					if (accesses[connected_pin->node_index] != Access::None) {
+						consumers.push_back(connected_pin->node_index);
+					}
+				}
+			}
+			std::ranges::sort(consumers, {}, [&](const uint32_t index) { return submission_order[index]; });
+			consumers.erase(std::ranges::unique(consumers).begin(), consumers.end());
+
+			std::optional<uint32_t> last_transfer;
+			readers.clear();
+			for (auto const consumer : consumers) {
+				if (accesses[consumer] == Access::Transfer) {
+					for (auto const reader : readers) {
+						add_wait(consumer, reader);
+					}
+					if (last_transfer && readers.empty()) {
+						add_wait(consumer, *last_transfer);
+					}
+					last_transfer = consumer;
+					readers.clear();
+				}
+				else {
+					if (last_transfer) {
+						add_wait(consumer, *last_transfer);
+					}
+					readers.push_back(consumer);
+				}
+			}
+			if (last_transfer && accesses[producer] != Access::None) {
+				copy_waits[producer] = wait_for(*last_transfer);
+			}
+		}
+		return copy_waits;
+	}
+
+	void NodeEditor::execute_graph(const std::vector<uint32_t>& requested_nodes) {
+		if (texture_set_generation != engine->texture_manager->generation) {
+			rebind_texture_descriptor_set();
+		}
+
+		auto const sorted_nodes = add_evicted_inputs(requested_nodes);
+		for (auto const i : sorted_nodes) {
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					if constexpr (is_component_graphic<NodeDataT>) {
+						if (!node_data->resident) {
+							node_data->rematerialize();
+						}
+					}
+					node_data->last_use_frame = residency_frame;
+				}
+				}, nodes[i].data);
+		}
+
 		std::vector<VkSubmitInfo2> graphic_submits;
 		graphic_submits.reserve(sorted_nodes.size() * 2 + 2);
 		std::vector<VkSubmitInfo2> compute_submits;
@@ -101,30 +298,34 @@ namespace engine {
 		std::vector<CopyImageSubmitInfo> copy_image_submit_infos;
 		copy_image_submit_infos.reserve(PbrMaterialTextureNum);
 
+		std::vector<uint64_t> last_signal_values(nodes.size(), 0);
 		for (auto const i : sorted_nodes) {
 			std::visit([&](auto&& node_data) {
 				using NodeDataT = std::remove_reference_t<decltype(node_data)>;
 				if constexpr (image_data<NodeDataT>) {
 					node_data->wait_semaphore_submit_info_0.clear();
+					uint64_t counter;
+					vkGetSemaphoreCounterValue(engine->device, node_data->semaphore, &counter);
+					node_data->signal_semaphore_submit_info_0.value = counter + 1;
+					const uint64_t duration = ((node_data->submit_info.size() + 1) >> 1) << 1;
+					last_signal_values[i] = counter + duration;
 				}
 				}, nodes[i].data);
 		}
+		auto const copy_waits = order_queue_transfers(sorted_nodes, last_signal_values);
 
 		for (auto i : sorted_nodes | std::views::reverse) {
 
 			std::visit([&](auto&& node_data) {
 				using NodeDataT = std::decay_t<decltype(node_data)>;
 				if constexpr (image_data<NodeDataT>) {
-					uint64_t counter;
-					vkGetSemaphoreCounterValue(engine->device, node_data->semaphore, &counter);
-					node_data->signal_semaphore_submit_info_0.value = counter + 1;
-					const uint64_t duration = ((node_data->submit_info.size() + 1) >> 1) << 1;
-					uint64_t last_signal_counter = counter + duration;
+					const uint64_t counter = node_data->signal_semaphore_submit_info_0.value - 1;
+					uint64_t last_signal_counter = last_signal_values[i];
 
 					if constexpr (is_component_graphic<NodeDataT>) {
 						node_data->wait_semaphore_submit_info_1.value = counter + 1;
 						node_data->signal_semaphore_submit_info_1.value = last_signal_counter;
-						update_wait_semaphores(i, node_data, copy_image_submit_infos, last_signal_counter);
+						update_wait_semaphores(i, node_data, copy_image_submit_infos, last_signal_counter, copy_waits[i]);
 						graphic_submits.push_back(node_data->submit_info[0]);
 						graphic_submits.push_back(node_data->submit_info[1]);
 					}
@@ -134,12 +335,23 @@ namespace engine {
 							node_data->submit_info_members[0].signal_semaphore_submit_info.value = counter + 2;
 							node_data->submit_info_members[1].wait_semaphore_submit_info.value = counter + 2;
 							node_data->submit_info_members[1].signal_semaphore_submit_info.value = last_signal_counter;
-							update_wait_semaphores(i, node_data, copy_image_submit_infos, last_signal_counter);
+							update_wait_semaphores(i, node_data, copy_image_submit_infos, last_signal_counter, copy_waits[i]);
 							graphic_submits.push_back(node_data->submit_info[0]);
 							compute_submits.push_back(node_data->submit_info[1]);
 							graphic_submits.push_back(node_data->submit_info[2]);
 						}
 					}
+					else if constexpr (is_component_compute<NodeDataT>) {
+						node_data->record_image_processing_command_buffers(engine);
+						node_data->submit_info_members[0].wait_semaphore_submit_info.value = counter + 1;
+						node_data->submit_info_members[0].signal_semaphore_submit_info.value = counter + 2;
+						node_data->submit_info_members[1].wait_semaphore_submit_info.value = counter + 2;
+						node_data->submit_info_members[1].signal_semaphore_submit_info.value = last_signal_counter;
+						update_wait_semaphores(i, node_data, copy_image_submit_infos, last_signal_counter, copy_waits[i]);
+						graphic_submits.push_back(node_data->submit_info[0]);
+						compute_submits.push_back(node_data->submit_info[1]);
+						graphic_submits.push_back(node_data->submit_info[2]);
+					}
 				}
 				else if constexpr (value_data<NodeDataT>) {
 					recalculate_node(i);
@@ -166,6 +378,20 @@ namespace engine {
 			);
 		}
 
+		//snapshot the parameters of this evaluation, the copy is submitted to the graphics queue ahead of graphic_submits
+		//and reaches the compute queue through the node semaphores
+		for (auto const i : sorted_nodes) {
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					node_data->stage_ubo(*engine->parameter_ring);
+				}
+				}, nodes[i].data);
+		}
+		engine->parameter_ring->submit();
+
+		engine->texture_manager->flush_descriptor_writes(engine->device);
+
 		const std::array fences{ graphic_fence, compute_fence };
 		vkResetFences(engine->device, fences.size(), fences.data());
 
@@ -176,10 +402,146 @@ namespace engine {
 		if (vkQueueSubmit2(engine->compute_queue, compute_submits.size(), compute_submits.data(), compute_fence) != VK_SUCCESS) {
 			throw std::runtime_error("failed to submit draw command buffer to compute queue!");
 		}
+
+		//node textures released from here on are only reused once this evaluation has finished on both queues
+		engine->texture_pool->signal_submissions(engine->graphics_queue, engine->compute_queue);
+	}
+
+	//Outputs baked into other command buffers by image handle (UDF inputs, PBR copies, the displayed texture) stay
+	//resident, so only graphics nodes whose consumers all sample them through the bindless set are evicted.
+	//Compute nodes record their input handles at every evaluation, after the evicted inputs were brought back
+	bool NodeEditor::is_evictable(const uint32_t index) const {
+		auto const& node = nodes[index];
+		auto const graphic = [](auto&& node_data) {
+			using NodeDataT = std::decay_t<decltype(node_data)>;
+			if constexpr (image_data<NodeDataT>) {
+				return is_component_graphic<NodeDataT>;
+			}
+			else {
+				return false;
+			}
+			};
+		auto const bindless_consumer = [](auto&& node_data) {
+			using NodeDataT = std::decay_t<decltype(node_data)>;
+			if constexpr (image_data<NodeDataT>) {
+				return is_component_graphic<NodeDataT> || is_component_compute<NodeDataT>;
+			}
+			else {
+				return false;
+			}
+			};
+		if (node.id == display_node_id || !std::visit(graphic, node.data)) {
+			return false;
+		}
+		bool has_consumer = false;
+		for (auto& output : node.outputs) {
+			for (const Pin* connected_pin : output.connected_pins) {
+				has_consumer = true;
+				if (!std::visit(bindless_consumer, nodes[connected_pin->node_index].data)) {
+					return false;
+				}
+			}
+		}
+		return has_consumer;
+	}
+
+	void NodeEditor::enforce_residency_budget() {
+		++residency_frame;
+		if (graph_load) {  //nodes created but not evaluated yet look unused
+			return;
+		}
+		if (residency_budget == 0) {
+			for (auto const& heap : engine->memory_stats->heap_budgets()) {
+				if (heap.device_local) {
+					residency_budget = std::max(residency_budget, static_cast<VkDeviceSize>(heap.budget * default_residency_budget_ratio));
+				}
+			}
+		}
+		if (trim_frame != 0 && residency_frame >= trim_frame) {
+			//evicted textures were parked in the texture pool, free them once they retired
+			engine->texture_pool->trim(MemoryCategory::NODE_TEXTURE);
+			trim_frame = 0;
+		}
+
+		struct Candidate {
+			uint64_t last_use_frame;
+			uint32_t index;
+			VkDeviceSize bytes;
+		};
+		std::vector<Candidate> candidates;
+		resident_bytes = 0;
+		evicted_num = 0;
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					if (!node_data->resident) {
+						++evicted_num;
+						return;
+					}
+					resident_bytes += node_data->texture->allocation_size;
+					//frames in flight may still show the gui_texture of a node that was just displayed
+					if (node_data->last_use_frame + engine::TexturePool::retire_frame_num < residency_frame && is_evictable(i)) {
+						candidates.push_back({ node_data->last_use_frame, i, node_data->texture->allocation_size });
+					}
+				}
+				}, nodes[i].data);
+		}
+
+		if (resident_bytes <= residency_budget || tiled_evaluation ||
+			vkGetFenceStatus(engine->device, graphic_fence) != VK_SUCCESS ||
+			vkGetFenceStatus(engine->device, compute_fence) != VK_SUCCESS) {
+			return;
+		}
+
+		std::ranges::sort(candidates, std::less{}, &Candidate::last_use_frame);
+		for (auto const& candidate : candidates) {
+			if (resident_bytes <= residency_budget) {
+				break;
+			}
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					if constexpr (is_component_graphic<NodeDataT>) {
+						node_data->evict();
+					}
+				}
+				}, nodes[candidate.index].data);
+			resident_bytes -= candidate.bytes;
+			++evicted_num;
+			trim_frame = residency_frame + engine::TexturePool::retire_frame_num + 1;
+		}
+	}
+
+	//the bindless texture set was reallocated, re-record every node command buffer that bound the old one
+	void NodeEditor::rebind_texture_descriptor_set() {
+		wait_node_execute_fences();
+		for (auto& node : nodes) {
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					node_data->rebind_texture_descriptor_set(engine);
+				}
+				}, node.data);
+		}
+		texture_set_generation = engine->texture_manager->generation;
 	}
 
 	void NodeEditor::update_from(const uint32_t updated_node_index) {
-		if (vkGetFenceStatus(engine->device, graphic_fence) != VK_SUCCESS ||
+		if (tiled_evaluation) { //the graph is re-evaluated as a whole once the tiles are done
+			return;
+		}
+		if (std::ranges::find(deferred_update_nodes, updated_node_index) == deferred_update_nodes.end()) {
+			deferred_update_nodes.push_back(updated_node_index);
+		}
+		flush_deferred_updates();
+	}
+
+	//Parameter edits are versioned, so they are accepted while an evaluation is in flight and only the evaluation
+	//waits: the nodes edited meanwhile are evaluated together once the execute fences signal
+	void NodeEditor::flush_deferred_updates() {
+		if (deferred_update_nodes.empty() || tiled_evaluation || graph_load ||
+			vkGetFenceStatus(engine->device, graphic_fence) != VK_SUCCESS ||
 			vkGetFenceStatus(engine->device, compute_fence) != VK_SUCCESS) {
 			return;
 		}
@@ -191,12 +553,18 @@ namespace engine {
 		std::vector<uint32_t> sorted_nodes;
 		sorted_nodes.reserve(nodes.size());
 
-		topological_sort(updated_node_index, visited_nodes, sorted_nodes);
+		for (auto const updated_node_index : deferred_update_nodes) {
+			if (updated_node_index < nodes.size() && visited_nodes[updated_node_index] == 0) {
+				topological_sort(updated_node_index, visited_nodes, sorted_nodes);
+			}
+		}
+		deferred_update_nodes.clear();
 		execute_graph(sorted_nodes);
 	}
 
 	void NodeEditor::update_all_nodes() {
 		wait_node_execute_fences();
+		deferred_update_nodes.clear();
 
 		static std::vector<char> visited_nodes; //check if a node has been visited
 		visited_nodes.resize(nodes.size());
@@ -238,8 +606,26 @@ namespace engine {
 		//static bool first = true;
 		auto const& io = ImGui::GetIO();
 
+		finish_prewarm();
+		reload_edited_pipelines();
+		advance_graph_load();
+		advance_tiled_evaluation();
+		flush_deferred_updates();
+		enforce_residency_budget();
+
+		if (!ImGui::IsAnyItemActive() && !ImGui::IsMouseDown(ImGuiMouseButton_Left)) {  //a slider drag is one undo step
+			undo_history.seal();
+		}
+
+		bool undo_requested = false;
+		bool redo_requested = false;
 		if (ImGui::BeginMenuBar()) {
-			if (ImGui::BeginMenu("Add")) {
+			if (ImGui::BeginMenu("Edit")) {
+				undo_requested = ImGui::MenuItem("Undo", "Ctrl+Z", false, !graph_load && undo_history.can_undo());
+				redo_requested = ImGui::MenuItem("Redo", "Ctrl+Y", false, !graph_load && undo_history.can_redo());
+				ImGui::EndMenu();
+			}
+			if (ImGui::BeginMenu("Add", !graph_load)) {
 				node_menu<NodeMenu>();
 				ImGui::EndMenu();
 			}
@@ -254,7 +640,11 @@ namespace engine {
 		ed::Begin("My Editor", ImVec2(0.0f, 0.0f));
 
 		ed::Suspend();
-		if (ImGui::IsKeyPressed(ImGuiKey_Tab)) {
+		if (graph_load) {  //the canvas area on screen, its nodes are evaluated first once the graph is created
+			graph_load->visible_min = ed::ScreenToCanvas(ImGui::GetWindowPos());
+			graph_load->visible_max = ed::ScreenToCanvas(ImGui::GetWindowPos() + ImGui::GetWindowSize());
+		}
+		else if (ImGui::IsKeyPressed(ImGuiKey_Tab)) {
 			ImGui::OpenPopup("Add New Node");
 		}
 		if (ImGui::BeginPopup("Add New Node")) {
@@ -266,6 +656,19 @@ namespace engine {
 		//Set display node
 		if (auto const node_id = ed::GetDoubleClickedNode(); node_id != ed::NodeId::Invalid) {
 			display_node_id = node_id;
+			auto const display_node = std::ranges::find_if(nodes, [&](auto& node) {
+				return node.id == display_node_id;
+				});
+			if (display_node != nodes.end()) {
+				std::visit([&](auto&& node_data) {
+					using NodeDataT = std::decay_t<decltype(node_data)>;
+					if constexpr (image_data<NodeDataT>) {
+						if (!node_data->resident) {  //evicted outputs are recomputed when displayed
+							update_from(static_cast<uint32_t>(display_node - nodes.begin()));
+						}
+					}
+					}, display_node->data);
+			}
 		}
 
 		static std::optional<size_t> color_node_index;
@@ -370,6 +773,7 @@ namespace engine {
 									MetaInfo<NodeDataT>::Class::FieldAt(i, [&](auto& field) {
 										using NodeDataT = std::decay_t<decltype(node_data)>;
 										auto widget_info = field.template getAnnotation<NumberInputWidgetInfo>();
+										auto pin_state = get_pin_state(node_index, i);
 										ImGui::PushItemWidth(node_width - node_left_padding - node_right_padding);
 										ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 3.0f);
 										ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2{ 3.0f, 1.0f });
@@ -403,6 +807,7 @@ namespace engine {
 										ImGui::PopItemWidth();
 
 										if (response_flag) {
+											record_pin_edit(node_index, i, std::move(pin_state));
 											if constexpr (value_data<NodeDataT>) {
 												update_from(node_index);
 											}
@@ -455,6 +860,7 @@ namespace engine {
 									MetaInfo<NodeDataT>::Class::FieldAt(i, [&](auto& field) {
 										using NodeDataT = std::decay_t<decltype(node_data)>;
 										auto widget_info = field.template getAnnotation<NumberInputWidgetInfo>();
+										auto pin_state = get_pin_state(node_index, i);
 										ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 3.0f);
 										ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2{ 3.0f, 1.0f });
 										if (widget_info.enable_slider) {
@@ -476,6 +882,7 @@ namespace engine {
 										}
 										ImGui::PopStyleVar(2);
 										if (response_flag) {
+											record_pin_edit(node_index, i, std::move(pin_state));
 											if constexpr (shader_data<NodeDataT>) {
 												node_data.update_ubo(pin.default_value, i);
 												//update_from(node_index);
@@ -529,7 +936,9 @@ namespace engine {
 						else if constexpr (std::is_same_v<PinT, BoolData>) {
 							BoolData* bool_data = std::get_if<BoolData>(&node.inputs[i].default_value);
 
+							auto pin_state = get_pin_state(node_index, i);
 							if (ImGui::Checkbox(std::format("{}##{}", pin.name, pin.id.Get()).c_str(), &bool_data->value)) {
+								record_pin_edit(node_index, i, std::move(pin_state));
 								std::visit([&](auto&& node_data) {
 									using NodeT = std::decay_t<decltype(node_data)>;
 									if constexpr (image_data<NodeT>) {
@@ -689,12 +1098,14 @@ namespace engine {
 			auto& color_pin = color_node.inputs[pin_index];
 			ui.draw_pin_popup(color_pin, hit_color_pin, [this, pin_index, &data = color_node.data](Pin& pin) {
 
+				auto pin_state = get_pin_state(*color_node_index, pin_index);
 				if (ImGui::ColorPicker4(
 					std::format("##ColorPicker{}", pin.id.Get()).c_str(),
 					reinterpret_cast<float*>(&pin.default_value),
 					ImGuiColorEditFlags_None,
 					nullptr
 				)) {
+					record_pin_edit(*color_node_index, pin_index, std::move(pin_state));
 					std::visit([&](auto&& node_data) {
 						using NodeDataT = std::decay_t<decltype(node_data)>;
 						if constexpr (image_data<NodeDataT>) {
@@ -718,6 +1129,7 @@ namespace engine {
 			ui.draw_pin_popup(color_ramp_pin, hit_color_ramp_pin, [&](Pin& pin) {
 
 				auto& color_ramp_data = *std::get_if<ColorRampData>(&color_ramp_pin.default_value);
+				auto pin_state = get_pin_state(*color_ramp_node_index, *color_ramp_pin_index);
 				if (ImGui::GradientEditor(
 					std::format("ColorRampEditor##{}",
 						color_ramp_pin.id.Get()).c_str(),
@@ -725,6 +1137,7 @@ namespace engine {
 					color_ramp_data.dragging_mark,
 					color_ramp_data.selected_mark
 				)) {
+					record_pin_edit(*color_ramp_node_index, *color_ramp_pin_index, std::move(pin_state));
 					std::visit(Overloaded{
 						[&](image_data auto&& node_data) {
 						node_data->update_ubo(pin.default_value, *color_ramp_pin_index);
@@ -761,8 +1174,13 @@ namespace engine {
 								using NodeDataT = std::decay_t<decltype(node_data)>;
 								using AnnotationT = std::remove_cvref_t<decltype(items)>;
 								if constexpr (std_array<AnnotationT, const char*>) {
+									const bool format_enum = field.template getAnnotation<FormatEnum>() == FormatEnum::True;
 									for (size_t i = 0; i < items.size(); ++i) {
+										if (format_enum && !node_data->supports_format(str_format_map.get_key(i))) {
+											continue;
+										}
 										if (ImGui::MenuItem((std::string(" ") + items[i]).c_str())) {
+											auto pin_state = get_pin_state(*enum_node_index, *enum_pin_index);
 											std::get_if<EnumData>(&pin.default_value)->value = i;
 											if constexpr (image_data<NodeDataT>) {
 												if (field.template getAnnotation<FormatEnum>() == FormatEnum::True) {
@@ -774,6 +1192,7 @@ namespace engine {
 												}
 											}
 											update_from(*enum_node_index);
+											record_pin_edit(*enum_node_index, *enum_pin_index, std::move(pin_state));
 											ImGui::CloseCurrentPopup();
 											enum_node_index.reset();
 											enum_pin_index.reset();
@@ -788,9 +1207,11 @@ namespace engine {
 			ed::Resume();
 		}
 
-		create_new_link();
+		if (!graph_load) {  //load_node() and load_link() expect the graph to change only through them
+			create_new_link();
 
-		delete_node_or_link();
+			delete_node_or_link();
+		}
 
 		//shortcut
 		if (ImGui::IsKeyPressed(ImGuiKey_Space)) {
@@ -799,6 +1220,20 @@ namespace engine {
 		if (ImGui::IsKeyPressed(ImGuiKey_F)) {
 			ed::NavigateToSelection();
 		}
+		if (io.KeyCtrl && !io.WantTextInput) {
+			if (ImGui::IsKeyPressed(ImGuiKey_Z)) {
+				(io.KeyShift ? redo_requested : undo_requested) = true;
+			}
+			else if (ImGui::IsKeyPressed(ImGuiKey_Y)) {
+				redo_requested = true;
+			}
+		}
+		if (undo_requested) {
+			undo();
+		}
+		else if (redo_requested) {
+			redo();
+		}
 
 		ed::End();
 		ed::SetCurrentEditor(nullptr);
@@ -891,110 +1326,20 @@ namespace engine {
 							std::swap(start_pin_index, end_pin_index);
 						}
 
-						start_pin->connected_pins.emplace(end_pin);
-						if (!end_pin->connected_pins.empty()) {
-							auto const deleted_link = std::ranges::find_if(links, [=](auto& link) {
-								return link.end_pin->id == end_pin->id;
-								});
-							if (deleted_link != links.end()) {
-								links.erase(deleted_link);
-							}
-							for (Pin* pin : end_pin->connected_pins) {
-								pin->connected_pins.erase(end_pin);
-							}
-							end_pin->connected_pins.clear();
+						undo_history.begin_step();
+						if (auto const replaced_link = std::ranges::find_if(links, [=](auto& link) {
+							return link.end_pin == end_pin;
+							}); replaced_link != links.end()) {
+							undo_history.record(undo::RemoveLink{ get_link_record(*replaced_link) });
 						}
-						end_pin->connected_pins.emplace(start_pin);
-
-						links.emplace(ed::LinkId(get_next_id()), start_pin, end_pin);
-
-						std::visit([&](auto&& end_node_data) {
-							using EndNodeT = std::decay_t<decltype(end_node_data)>;
-							if constexpr (image_data<EndNodeT>) {
-
-								MetaInfo<EndNodeT>::Class::FieldAt(end_pin_index, [&](auto& field) {
-									if (field.template getAnnotation<AutoFormat>() == AutoFormat::True) {
-										std::visit([&](auto&& start_node_data) {
-											using StartNodeT = std::decay_t<decltype(start_node_data)>;
-											if constexpr (image_data<StartNodeT>) {
-												auto format = start_node_data->texture->format;
-												if (format != end_node_data->texture->format) {
-													wait_node_execute_fences();
-													end_node_data->recreate_texture_resource(format);
-												}
-											}
-											}, nodes[start_pin->node_index].data);
-									}
-									if constexpr (requires(EndNodeT node_data) { node_data->record_image_processing_cmd_buffer_func(0); }) {
-										std::visit([&](auto&& start_node_data) {
-											using StartNodeT = std::decay_t<decltype(start_node_data)>;
-											if constexpr (image_data<StartNodeT>) {
-												end_node_data->record_image_processing_cmd_buffer_func(start_node_data->node_texture_id);
-												end_node_data->record_preview_cmd_buffer_func(start_node_data->node_texture_id);
-												end_node_data->update_command_buffer_submit_info();
-											}
-											}, nodes[start_pin->node_index].data);
-									}
-									});
-								if (std::holds_alternative<FloatData>(start_pin->default_value) &&
-									std::holds_alternative<FloatTextureIdData>(end_pin->default_value)) {
-									std::get_if<FloatTextureIdData>(&end_pin->default_value)->value.id = -1;
-								}
-								end_node_data->update_ubo(start_pin->default_value, end_pin_index);
-							}
-							else if constexpr (shader_data<EndNodeT>) {
-								wait_node_execute_fences();
-								if (std::holds_alternative<FloatData>(start_pin->default_value) &&
-									std::holds_alternative<FloatTextureIdData>(end_pin->default_value)) {
-									std::get_if<FloatTextureIdData>(&end_pin->default_value)->value.id = -1;
-								}
-								else if (std::holds_alternative<Color4Data>(start_pin->default_value) &&
-									std::holds_alternative<Color4TextureIdData>(end_pin->default_value)) {
-									std::get_if<Color4TextureIdData>(&end_pin->default_value)->value.id = -1;
-								}
-								else {
-									std::visit([&](auto&& start_node_data) {
-										using StartNodeT = std::decay_t<decltype(start_node_data)>;
-										if constexpr (image_data<StartNodeT>) {
-											field_at(engine->pbr_material_texture_set, end_pin_index, [&](auto pbr_texture_id) {
-												auto input_format = start_node_data->texture->format;
-												auto& pbr_texture = engine->texture_manager->textures[pbr_texture_id];
-												if (pbr_texture == nullptr || input_format != pbr_texture->format) {
-													pbr_texture = Texture::create_device_texture(engine,
-														TEXTURE_WIDTH,
-														TEXTURE_HEIGHT,
-														input_format,
-														VK_IMAGE_ASPECT_COLOR_BIT,
-														VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-													pbr_texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-													engine->update_image_descriptor(pbr_texture, pbr_texture_id);
-													start_node_data->record_copy_image_cmd_buffers(end_pin_index);
-												}
-												});
-
-										}
-										}, nodes[start_pin->node_index].data);
-								}
-								end_node_data.update_ubo(start_pin->default_value, end_pin_index);
-
-								VkSubmitInfo submit_info{
-									.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-									.commandBufferCount = 1,
-								};
-
-								std::visit([&](auto&& start_node_data) {
-									using StartNodeT = std::decay_t<decltype(start_node_data)>;
-									if constexpr (image_data<StartNodeT>) {
-										submit_info.pCommandBuffers = &start_node_data->copy_image_cmd_buffers[end_pin_index];
-										vkResetFences(engine->device, 1, &graphic_fence);
-										vkQueueSubmit(engine->graphics_queue, 1, &submit_info, graphic_fence);
-										wait_node_execute_fences();
-									}
-									}, nodes[start_pin->node_index].data);
-							}
-							}, nodes[end_pin->node_index].data);
-
-						update_from(end_pin->node_index);
+						connect_pins(start_pin, end_pin);
+						undo_history.record(undo::AddLink{ graph_file::LinkRecord{
+							.start_node_index = start_pin->node_index,
+							.start_pin_index = static_cast<uint32_t>(start_pin_index),
+							.end_node_index = end_pin->node_index,
+							.end_pin_index = static_cast<uint32_t>(end_pin_index),
+						} });
+						undo_history.end_step();
 					}
 				}
 			}
@@ -1005,6 +1350,7 @@ namespace engine {
 
 	void NodeEditor::delete_node_or_link() {
 		if (ed::BeginDelete()) {
+			undo_history.begin_step();  //a node goes together with its links, which are queried first
 			// There may be many links marked for deletion, let's loop over them.
 			ed::LinkId deleted_link_id;
 			while (ed::QueryDeletedLink(&deleted_link_id)) {
@@ -1016,36 +1362,8 @@ namespace engine {
 						});
 
 					if (deleted_link != links.end()) {
-						auto link_start_pin = deleted_link->start_pin;
-						auto link_end_pin = deleted_link->end_pin;
-
-						link_start_pin->connected_pins.erase(link_end_pin);
-						link_end_pin->connected_pins.erase(link_start_pin);
-
-						links.erase(deleted_link);
-
-						std::visit([&](auto&& end_node_data) {
-							using EndNodeT = std::decay_t<decltype(end_node_data)>;
-							if constexpr (image_data<EndNodeT> || shader_data<EndNodeT>) {
-								std::visit([&](auto&& end_pin_value) {
-									using PinT = std::decay_t<decltype(end_pin_value)>;
-									if constexpr (std::same_as<PinT, TextureIdData>) {
-										end_pin_value.value = -1;
-									}
-									else if constexpr (std::same_as<PinT, FloatTextureIdData> || std::same_as<PinT, Color4TextureIdData>) {
-										end_pin_value.value.id = -1;
-									}
-									}, link_end_pin->default_value);
-								if constexpr (image_data<EndNodeT>) {
-									end_node_data->update_ubo(link_end_pin->default_value, get_input_pin_index(*link_end_pin));
-								}
-								else if constexpr (shader_data<EndNodeT>) {
-									end_node_data.update_ubo(link_end_pin->default_value, get_input_pin_index(*link_end_pin));
-								}
-							}
-							}, nodes[link_end_pin->node_index].data);
-						wait_node_execute_fences();
-						update_from(link_end_pin->node_index);
+						undo_history.record(undo::RemoveLink{ get_link_record(*deleted_link) });
+						remove_link(deleted_link);
 					}
 				}
 			}
@@ -1058,56 +1376,433 @@ namespace engine {
 						});
 
 					if (deleted_node != nodes.end()) {
-						color_pin_index.reset();
-						color_ramp_pin_index.reset();
-						enum_pin_index.reset();
-
-						wait_node_execute_fences();
-
-						for (auto iter = deleted_node + 1; iter != nodes.end(); ++iter) {
-							for (auto& input : iter->inputs) {
-								--input.node_index;
-							}
-							for (auto& output : iter->outputs) {
-								--output.node_index;
-							}
-						}
-						garbage_nodes.emplace_back(std::move(deleted_node->data));
-						nodes.erase(deleted_node);
+						auto const deleted_index = static_cast<uint32_t>(deleted_node - nodes.begin());
+						undo_history.record(undo::RemoveNode{ .node_index = deleted_index, .node = snapshot_node(deleted_index) });
+						remove_node(deleted_index);
 					}
 				}
 			}
+			undo_history.end_step();
 		}
 		ed::EndDelete(); // Wrap up deletion action
 	}
 
-	void NodeEditor::create_fence() {
-		auto constexpr fence_info = vkinit::fence_create_info(VK_FENCE_CREATE_SIGNALED_BIT);
-		if (vkCreateFence(engine->device, &fence_info, nullptr, &graphic_fence) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create graphic fence!");
-		}
+	void NodeEditor::connect_pins(Pin* start_pin, Pin* end_pin) {
+		auto const end_pin_index = get_input_pin_index(*end_pin);
+
+		//UDF inputs and PBR copies record the image handle, so an evicted output is brought back first
+		//and queued ahead of the consumer's update
+		std::visit([&](auto&& start_node_data) {
+			using StartNodeT = std::decay_t<decltype(start_node_data)>;
+			if constexpr (image_data<StartNodeT>) {
+				if constexpr (is_component_graphic<StartNodeT>) {
+					if (!start_node_data->resident) {
+						start_node_data->rematerialize();
+						deferred_update_nodes.push_back(start_pin->node_index);
+					}
+				}
+			}
+			}, nodes[start_pin->node_index].data);
 
-		if (vkCreateFence(engine->device, &fence_info, nullptr, &compute_fence) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create compute fence!");
+		if (!end_pin->connected_pins.empty()) {
+			auto const deleted_link = std::ranges::find_if(links, [=](auto& link) {
+				return link.end_pin->id == end_pin->id;
+				});
+			if (deleted_link != links.end()) {
+				links.erase(deleted_link);
+			}
+			for (Pin* pin : end_pin->connected_pins) {
+				pin->connected_pins.erase(end_pin);
+			}
+			end_pin->connected_pins.clear();
 		}
-	}
-
-	NodeEditor::NodeEditor(VulkanEngine* engine) :
-		engine(engine),
-		node_width(100 + engine->screen_width / 25),
-		node_left_padding(node_width * 0.03f),
-		node_right_padding(node_width * 0.015f),
-		ui(node_width)
-	{
-		ed::Config config;
-		//disable writing json
-		config.SaveSettings = [](const char*, size_t, ed::SaveReasonFlags, void*) {
-			return false;
-			};
-
-		config.SaveNodeSettings = [](ed::NodeId, const char*, size_t, ed::SaveReasonFlags, void*) {
-			return false;
-			};
+		start_pin->connected_pins.emplace(end_pin);
+		end_pin->connected_pins.emplace(start_pin);
+
+		links.emplace(ed::LinkId(get_next_id()), start_pin, end_pin);
+
+		std::visit([&](auto&& end_node_data) {
+			using EndNodeT = std::decay_t<decltype(end_node_data)>;
+			if constexpr (image_data<EndNodeT>) {
+
+				MetaInfo<EndNodeT>::Class::FieldAt(end_pin_index, [&](auto& field) {
+					if (field.template getAnnotation<AutoFormat>() == AutoFormat::True) {
+						std::visit([&](auto&& start_node_data) {
+							using StartNodeT = std::decay_t<decltype(start_node_data)>;
+							if constexpr (image_data<StartNodeT>) {
+								auto format = start_node_data->texture->format;
+								if (format != end_node_data->texture->format) {
+									wait_node_execute_fences();
+									end_node_data->recreate_texture_resource(format);
+								}
+							}
+							}, nodes[start_pin->node_index].data);
+					}
+					if constexpr (requires(EndNodeT node_data) { node_data->record_image_processing_cmd_buffer_func(0); }) {
+						std::visit([&](auto&& start_node_data) {
+							using StartNodeT = std::decay_t<decltype(start_node_data)>;
+							if constexpr (image_data<StartNodeT>) {
+								end_node_data->record_image_processing_cmd_buffer_func(start_node_data->node_texture_id);
+								end_node_data->record_preview_cmd_buffer_func(start_node_data->node_texture_id);
+								end_node_data->update_command_buffer_submit_info();
+							}
+							}, nodes[start_pin->node_index].data);
+					}
+					});
+				if (std::holds_alternative<FloatData>(start_pin->default_value) &&
+					std::holds_alternative<FloatTextureIdData>(end_pin->default_value)) {
+					std::get_if<FloatTextureIdData>(&end_pin->default_value)->value.id = -1;
+				}
+				end_node_data->update_ubo(start_pin->default_value, end_pin_index);
+			}
+			else if constexpr (shader_data<EndNodeT>) {
+				wait_node_execute_fences();
+				if (std::holds_alternative<FloatData>(start_pin->default_value) &&
+					std::holds_alternative<FloatTextureIdData>(end_pin->default_value)) {
+					std::get_if<FloatTextureIdData>(&end_pin->default_value)->value.id = -1;
+				}
+				else if (std::holds_alternative<Color4Data>(start_pin->default_value) &&
+					std::holds_alternative<Color4TextureIdData>(end_pin->default_value)) {
+					std::get_if<Color4TextureIdData>(&end_pin->default_value)->value.id = -1;
+				}
+				else {
+					std::visit([&](auto&& start_node_data) {
+						using StartNodeT = std::decay_t<decltype(start_node_data)>;
+						if constexpr (image_data<StartNodeT>) {
+							field_at(engine->pbr_material_texture_set, end_pin_index, [&](auto pbr_texture_id) {
+								auto input_format = start_node_data->texture->format;
+								auto& pbr_texture = engine->texture_manager->textures[pbr_texture_id];
+								if (pbr_texture == nullptr || input_format != pbr_texture->format) {
+									MemoryCategoryScope memory_scope(MemoryCategory::PBR_COPY);
+									pbr_texture = Texture::create_device_texture(engine,
+										TEXTURE_WIDTH,
+										TEXTURE_HEIGHT,
+										input_format,
+										VK_IMAGE_ASPECT_COLOR_BIT,
+										VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+									pbr_texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+									engine->update_image_descriptor(pbr_texture, pbr_texture_id);
+									start_node_data->record_copy_image_cmd_buffers(end_pin_index);
+								}
+								});
+
+						}
+						}, nodes[start_pin->node_index].data);
+				}
+				end_node_data.update_ubo(start_pin->default_value, end_pin_index);
+
+				VkSubmitInfo submit_info{
+					.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+					.commandBufferCount = 1,
+				};
+
+				std::visit([&](auto&& start_node_data) {
+					using StartNodeT = std::decay_t<decltype(start_node_data)>;
+					if constexpr (image_data<StartNodeT>) {
+						submit_info.pCommandBuffers = &start_node_data->copy_image_cmd_buffers[end_pin_index];
+						vkResetFences(engine->device, 1, &graphic_fence);
+						vkQueueSubmit(engine->graphics_queue, 1, &submit_info, graphic_fence);
+						wait_node_execute_fences();
+					}
+					}, nodes[start_pin->node_index].data);
+			}
+			}, nodes[end_pin->node_index].data);
+
+		update_from(end_pin->node_index);
+	}
+
+	void NodeEditor::remove_link(const std::unordered_set<Link>::iterator link) {
+		auto link_start_pin = link->start_pin;
+		auto link_end_pin = link->end_pin;
+
+		link_start_pin->connected_pins.erase(link_end_pin);
+		link_end_pin->connected_pins.erase(link_start_pin);
+
+		links.erase(link);
+
+		std::visit([&](auto&& end_node_data) {
+			using EndNodeT = std::decay_t<decltype(end_node_data)>;
+			if constexpr (image_data<EndNodeT> || shader_data<EndNodeT>) {
+				std::visit([&](auto&& end_pin_value) {
+					using PinT = std::decay_t<decltype(end_pin_value)>;
+					if constexpr (std::same_as<PinT, TextureIdData>) {
+						end_pin_value.value = -1;
+					}
+					else if constexpr (std::same_as<PinT, FloatTextureIdData> || std::same_as<PinT, Color4TextureIdData>) {
+						end_pin_value.value.id = -1;
+					}
+					}, link_end_pin->default_value);
+				if constexpr (image_data<EndNodeT>) {
+					end_node_data->update_ubo(link_end_pin->default_value, get_input_pin_index(*link_end_pin));
+				}
+				else if constexpr (shader_data<EndNodeT>) {
+					end_node_data.update_ubo(link_end_pin->default_value, get_input_pin_index(*link_end_pin));
+				}
+			}
+			}, nodes[link_end_pin->node_index].data);
+		wait_node_execute_fences();
+		update_from(link_end_pin->node_index);
+	}
+
+	void NodeEditor::remove_node(const uint32_t node_index) {
+		color_pin_index.reset();
+		color_ramp_pin_index.reset();
+		enum_pin_index.reset();
+
+		wait_node_execute_fences();
+		const bool tiling_cancelled = cancel_tiled_evaluation();
+
+		auto const deleted_node = nodes.begin() + node_index;
+		for (auto iter = deleted_node + 1; iter != nodes.end(); ++iter) {
+			for (auto& input : iter->inputs) {
+				--input.node_index;
+			}
+			for (auto& output : iter->outputs) {
+				--output.node_index;
+			}
+		}
+		std::erase(deferred_update_nodes, node_index);
+		for (auto& index : deferred_update_nodes) {
+			if (index > node_index) {
+				--index;
+			}
+		}
+		garbage_nodes.emplace_back(std::move(deleted_node->data));
+		nodes.erase(deleted_node);
+		if (tiling_cancelled) {
+			update_all_nodes();
+		}
+	}
+
+	PinState NodeEditor::get_pin_state(const uint32_t node_index, const uint32_t pin_index) const {
+		auto const& pin_value = nodes[node_index].inputs[pin_index].default_value;
+		if (std::holds_alternative<ColorRampData>(pin_value)) {
+			auto marks = std::make_shared<std::vector<graph_file::MarkRecord>>();
+			auto const record = graph_file::to_pin_record(pin_value, *marks);
+			return PinState{ .record = record, .marks = std::move(marks) };
+		}
+		std::vector<graph_file::MarkRecord> no_marks;
+		return PinState{ .record = graph_file::to_pin_record(pin_value, no_marks) };
+	}
+
+	void NodeEditor::set_pin_state(const uint32_t node_index, const uint32_t pin_index, const PinState& state) {
+		auto& node = nodes[node_index];
+		auto& pin_value = node.inputs[pin_index].default_value;
+		std::visit([&](auto&& value) {
+			using PinT = std::decay_t<decltype(value)>;
+			if constexpr (std::same_as<PinT, ColorRampData>) {
+				value.dragging_mark = nullptr;  //the marks they point to are about to be deleted
+				value.selected_mark = nullptr;
+				value.ui_value->clear_marks();
+				for (auto const& mark : *state.marks) {
+					value.ui_value->insert_mark(mark.position, ImColor(mark.color[0], mark.color[1], mark.color[2], mark.color[3]));
+				}
+				value.ui_value->refreshCache();
+			}
+			else if constexpr (any_of<PinT, FloatTextureIdData, Color4TextureIdData>) {  //keep the texture id bound by a link
+				auto const id = value.value.id;
+				value = graph_file::read_pin<PinT>(state.record);
+				value.value.id = id;
+			}
+			else if constexpr (!std::same_as<PinT, TextureIdData>) {
+				value = graph_file::read_pin<PinT>(state.record);
+			}
+			}, pin_value);
+
+		std::visit([&](auto&& node_data) {
+			using NodeDataT = std::decay_t<decltype(node_data)>;
+			if constexpr (image_data<NodeDataT>) {
+				MetaInfo<NodeDataT>::Class::FieldAt(pin_index, [&](auto& field) {
+					auto const enum_data = std::get_if<EnumData>(&pin_value);
+					if (enum_data && field.template getAnnotation<FormatEnum>() == FormatEnum::True) {
+						if (!node_data->supports_format(str_format_map.get_key(enum_data->value))) {  //the pin shows what the node stores
+							std::cerr << "compute nodes cannot store " << str_format_map.get_value(enum_data->value) << ", the node keeps "
+								<< str_format_map.at(node_data->texture->format) << std::endl;
+							enum_data->value = static_cast<EnumData::value_t>(str_format_map.index_of(node_data->texture->format));
+							return;
+						}
+						wait_node_execute_fences();
+						node_data->recreate_texture_resource(str_format_map.get_key(enum_data->value));
+					}
+					else {
+						node_data->update_ubo(pin_value, pin_index);
+					}
+					});
+				if (auto const ramp = std::get_if<ColorRampData>(&pin_value)) {
+					wait_node_execute_fences();
+					engine::SetupBatch::submit(engine, ramp->ubo_value->command_buffer);
+				}
+				update_from(node_index);
+			}
+			else if constexpr (value_data<NodeDataT>) {
+				update_from(node_index);
+			}
+			else if constexpr (shader_data<NodeDataT>) {
+				node_data.update_ubo(pin_value, pin_index);
+			}
+			}, node.data);
+	}
+
+	void NodeEditor::record_pin_edit(const uint32_t node_index, const uint32_t pin_index, PinState before) {
+		undo_history.record(undo::EditPin{
+			.node_index = node_index,
+			.pin_index = pin_index,
+			.before = std::move(before),
+			.after = get_pin_state(node_index, pin_index),
+			});
+	}
+
+	graph_file::LinkRecord NodeEditor::get_link_record(const Link& link) const {
+		return graph_file::LinkRecord{
+			.start_node_index = link.start_pin->node_index,
+			.start_pin_index = static_cast<uint32_t>(get_output_pin_index(*link.start_pin)),
+			.end_node_index = link.end_pin->node_index,
+			.end_pin_index = static_cast<uint32_t>(get_input_pin_index(*link.end_pin)),
+		};
+	}
+
+	std::unordered_set<Link>::iterator NodeEditor::find_link(const graph_file::LinkRecord& link) {
+		auto const end_pin = &nodes[link.end_node_index].inputs[link.end_pin_index];
+		return std::ranges::find_if(links, [=](auto& link) {
+			return link.end_pin == end_pin;
+			});
+	}
+
+	std::shared_ptr<const graph_file::Graph> NodeEditor::snapshot_node(const uint32_t node_index) const {
+		auto const& node = nodes[node_index];
+		auto const pos = ed::GetNodePosition(node.id);
+		auto snapshot = std::make_shared<graph_file::Graph>();
+		snapshot->add_node(NODE_TYPE_HASH_VALUES[node.data.index()], pos.x, pos.y);
+		for (auto const& input : node.inputs) {
+			snapshot->add_pin(input.default_value);
+		}
+		return snapshot;
+	}
+
+	void NodeEditor::insert_node(const uint32_t node_index, const graph_file::Graph& snapshot) {
+		color_pin_index.reset();
+		color_ramp_pin_index.reset();
+		enum_pin_index.reset();
+
+		auto const created_index = load_node(snapshot.view(), 0);
+		std::rotate(nodes.begin() + node_index, nodes.begin() + created_index, nodes.end());
+		for (auto index = node_index; index < nodes.size(); ++index) {
+			for (auto& input : nodes[index].inputs) {
+				input.node_index = index;
+			}
+			for (auto& output : nodes[index].outputs) {
+				output.node_index = index;
+			}
+		}
+		for (auto& index : deferred_update_nodes) {
+			if (index >= node_index) {
+				++index;
+			}
+		}
+		update_from(node_index);
+	}
+
+	//Steps are applied with the same primitives the widgets use, so an undone pin edit re-evaluates only the nodes
+	//downstream of it and recreated nodes take their textures from the texture pool like new ones
+	void NodeEditor::undo() {
+		if (graph_load || !undo_history.can_undo()) {
+			return;
+		}
+		wait_node_execute_fences();
+		const bool tiling_cancelled = cancel_tiled_evaluation();
+
+		auto step = undo_history.take_undo();
+		for (auto& operation : step | std::views::reverse) {
+			std::visit(Overloaded{
+				[&](const undo::EditPin& edit) {
+					set_pin_state(edit.node_index, edit.pin_index, edit.before);
+				},
+				[&](const undo::AddLink& add) {
+					remove_link(find_link(add.link));
+				},
+				[&](const undo::RemoveLink& remove) {
+					connect_pins(&nodes[remove.link.start_node_index].outputs[remove.link.start_pin_index],
+						&nodes[remove.link.end_node_index].inputs[remove.link.end_pin_index]);
+				},
+				[&](undo::AddNode& add) {
+					add.node = snapshot_node(add.node_index);
+					remove_node(add.node_index);
+				},
+				[&](const undo::RemoveNode& remove) {
+					insert_node(remove.node_index, *remove.node);
+				},
+				}, operation);
+		}
+		undo_history.push_undone(std::move(step));
+
+		if (tiling_cancelled) {
+			update_all_nodes();
+		}
+	}
+
+	void NodeEditor::redo() {
+		if (graph_load || !undo_history.can_redo()) {
+			return;
+		}
+		wait_node_execute_fences();
+		const bool tiling_cancelled = cancel_tiled_evaluation();
+
+		auto step = undo_history.take_redo();
+		for (auto& operation : step) {
+			std::visit(Overloaded{
+				[&](const undo::EditPin& edit) {
+					set_pin_state(edit.node_index, edit.pin_index, edit.after);
+				},
+				[&](const undo::AddLink& add) {
+					connect_pins(&nodes[add.link.start_node_index].outputs[add.link.start_pin_index],
+						&nodes[add.link.end_node_index].inputs[add.link.end_pin_index]);
+				},
+				[&](const undo::RemoveLink& remove) {
+					remove_link(find_link(remove.link));
+				},
+				[&](const undo::AddNode& add) {
+					insert_node(add.node_index, *add.node);
+				},
+				[&](undo::RemoveNode& remove) {
+					remove.node = snapshot_node(remove.node_index);  //picks up moves made since it was undone
+					remove_node(remove.node_index);
+				},
+				}, operation);
+		}
+		undo_history.push_redone(std::move(step));
+
+		if (tiling_cancelled) {
+			update_all_nodes();
+		}
+	}
+
+	void NodeEditor::create_fence() {
+		auto constexpr fence_info = vkinit::fence_create_info(VK_FENCE_CREATE_SIGNALED_BIT);
+		if (vkCreateFence(engine->device, &fence_info, nullptr, &graphic_fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create graphic fence!");
+		}
+
+		if (vkCreateFence(engine->device, &fence_info, nullptr, &compute_fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute fence!");
+		}
+	}
+
+	NodeEditor::NodeEditor(VulkanEngine* engine) :
+		engine(engine),
+		node_width(100 + engine->screen_width / 25),
+		node_left_padding(node_width * 0.03f),
+		node_right_padding(node_width * 0.015f),
+		ui(node_width)
+	{
+		ed::Config config;
+		//disable writing json
+		config.SaveSettings = [](const char*, size_t, ed::SaveReasonFlags, void*) {
+			return false;
+			};
+
+		config.SaveNodeSettings = [](ed::NodeId, const char*, size_t, ed::SaveReasonFlags, void*) {
+			return false;
+			};
 		context = ed::CreateEditor(&config);
 
 		create_fence();
@@ -1120,158 +1815,780 @@ namespace engine {
 			vkDestroyFence(device, g_fence, nullptr);
 			ed::DestroyEditor(context);
 			});
+
+		prewarm_pipelines();
+	}
+
+	void NodeEditor::prewarm_pipelines() {
+		if (!prewarm_pending) {  //a pre-warm started while one is running is timed from the first
+			prewarm_begin = std::chrono::steady_clock::now();
+		}
+		constexpr auto formats = str_format_map.keys();
+		NodeTypeList::for_each([&]<typename NodeType>() {
+			using NodeDataT = typename NodeType::data_type;
+			if constexpr (image_data<NodeDataT>) {
+				ref_t<NodeDataT>::prewarm_pipelines(engine, pipeline_workers, formats);
+			}
+			});
+		prewarm_pending = true;
+	}
+
+	void NodeEditor::finish_prewarm() {
+		if (!prewarm_pending || pipeline_workers.pending() > 0) {
+			return;
+		}
+		prewarm_pending = false;
+		last_prewarm_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - prewarm_begin).count();
+		try {
+			engine->pipeline_cache->save();  //keep the warm cache even if this session does not exit cleanly
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+		}
+	}
+
+	//Shader edits drop the pipelines built from the old modules, prewarm_pipelines() compiles only those again. Nodes
+	//still record the old pipelines until every job is done, then the outdated ones are re-recorded and evaluated again
+	void NodeEditor::reload_edited_pipelines() {
+		if (auto const reload_count = engine->shader_cache->reload_count(); reload_count != shader_reload_count) {
+			shader_reload_count = reload_count;
+			prewarm_pipelines();
+			pipelines_reloading = true;
+		}
+		if (!pipelines_reloading || pipeline_workers.pending() > 0 || tiled_evaluation ||
+			vkGetFenceStatus(engine->device, graphic_fence) != VK_SUCCESS ||
+			vkGetFenceStatus(engine->device, compute_fence) != VK_SUCCESS) {
+			return;
+		}
+		pipelines_reloading = false;
+
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					if (!node_data->resident || !node_data->pipeline_outdated()) {
+						return;
+					}
+					try {
+						node_data->reload_pipeline();
+						deferred_update_nodes.push_back(i);
+					}
+					catch (const std::exception& e) {
+						//a shader that does not link keeps the node on its previous pipeline
+						std::cerr << e.what() << std::endl;
+					}
+				}
+				}, nodes[i].data);
+		}
+		flush_deferred_updates();
+	}
+
+	TexturePtr NodeEditor::get_display_texture() const {
+		auto const display_node = std::ranges::find_if(nodes, [&](auto& node) {
+			return node.id == display_node_id;
+			});
+		if (display_node == nodes.end()) {
+			return nullptr;
+		}
+		return std::visit([](auto&& node_data) -> TexturePtr {
+			using NodeDataT = std::decay_t<decltype(node_data)>;
+			if constexpr (image_data<NodeDataT>) {
+				return node_data->texture;
+			}
+			else {
+				return nullptr;
+			}
+			}, display_node->data);
 	}
 
-	void NodeEditor::serialize(const std::string_view file_path) {
-		json json_file;
+	std::vector<uint32_t> NodeEditor::sort_upstream_nodes(const uint32_t node_index) const {
+		std::vector<char> visited_nodes(nodes.size(), 0);
+		std::vector<uint32_t> sorted_nodes;
+		std::stack<int64_t> topo_sort_stack;
+
+		visited_nodes[node_index] = 1;
+		topo_sort_stack.push(node_index);
+
+		while (!topo_sort_stack.empty()) { //post-order over input links, producers are emitted before their consumers
+			const int64_t idx = topo_sort_stack.top();
+			topo_sort_stack.pop();
+
+			if (idx < 0) {
+				sorted_nodes.emplace_back(~idx);
+			}
+			else {
+				topo_sort_stack.push(~idx);
+				for (auto& pin : nodes[idx].inputs) {
+					for (const Pin* connected_pin : pin.connected_pins) {
+						auto const connected_node_idx = connected_pin->node_index;
+						if (visited_nodes[connected_node_idx] == 0) {
+							visited_nodes[connected_node_idx] = 1;
+							topo_sort_stack.push(connected_node_idx);
+						}
+					}
+				}
+			}
+		}
+
+		std::ranges::reverse(sorted_nodes); //same order as topological_sort(), execute_graph() walks it backwards
+		return sorted_nodes;
+	}
+
+	SamplingFootprint NodeEditor::get_node_footprint(const uint32_t node_index) {
+		return std::visit([&](auto&& node_data) -> SamplingFootprint {
+			using NodeDataT = std::decay_t<decltype(node_data)>;
+			if constexpr (image_data<NodeDataT>) {
+				using InfoT = typename ref_t<NodeDataT>::InfoT;
+				if constexpr (SamplingFootprintInfo<InfoT>) {
+					InfoT info{};
+					for (size_t index = 0; index < InfoT::Class::TotalFields; ++index) {
+						InfoT::Class::FieldAt(info, index, [&](auto& field, auto& value) {
+							using PinT = typename std::decay_t<decltype(field)>::Type;
+							std::visit([&](auto&& input_value) {
+								using StartPinT = std::decay_t<decltype(input_value)>;
+								if constexpr (std::same_as<StartPinT, PinT>) {
+									value = input_value;
+								}
+								else if constexpr (std::same_as<PinT, FloatTextureIdData> && std::same_as<StartPinT, FloatData>) {
+									value.value.number = input_value.value;
+								}
+								else if constexpr (std::same_as<PinT, FloatTextureIdData> && std::same_as<StartPinT, TextureIdData>) {
+									value.value.id = input_value.value;
+								}
+								}, nodes[node_index].evaluate_input(index));
+							});
+					}
+					return InfoT::sampling_footprint(info);
+				}
+			}
+			return {};  //pointwise
+			}, nodes[node_index].data);
+	}
+
+	void NodeEditor::set_tile_transform(const std::vector<uint32_t>& sorted_nodes, const glm::vec4& tile_transform) {
+		for (auto const i : sorted_nodes) {
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					if constexpr (TileTransformInfo<typename ref_t<NodeDataT>::InfoT>) {
+						node_data->update_tile_transform(tile_transform);
+					}
+				}
+				}, nodes[i].data);
+		}
+	}
+
+	bool NodeEditor::begin_tiled_export(const uint32_t output_size, std::filesystem::path file_path, const ExportFileFormat file_format) {
+		auto const display_node = std::ranges::find_if(nodes, [&](auto& node) {
+			return node.id == display_node_id;
+			});
+		auto const texture = get_display_texture();
+		if (tiled_evaluation || graph_load || texture == nullptr || !TextureExporter::is_format_supported(texture->format)) {
+			return false;
+		}
+
+		auto const node_index = static_cast<uint32_t>(display_node - nodes.begin());
+		auto sorted_nodes = sort_upstream_nodes(node_index);
+
+		//halo needed around the output of each node, propagated from the display node towards the generators
+		std::vector<float> node_halos(nodes.size(), 0.0f);
+		for (auto const i : sorted_nodes) {
+			auto const footprint = get_node_footprint(i);
+			if (footprint.global) {
+				std::cerr << "tiled export skipped: " << nodes[i].name << " node reads the whole image" << std::endl;
+				return false;
+			}
+			for (auto& pin : nodes[i].inputs) {
+				for (const Pin* connected_pin : pin.connected_pins) {
+					auto& input_halo = node_halos[connected_pin->node_index];
+					input_halo = std::max(input_halo, node_halos[i] + footprint.radius);
+				}
+			}
+		}
+
+		auto const halo = static_cast<uint32_t>(std::ceil(std::ranges::max(node_halos)));
+		if (halo > texture->width / 4) {
+			std::cerr << "tiled export skipped: sampling halo of " << halo << " pixels is too large for " << texture->width << " pixel tiles" << std::endl;
+			return false;
+		}
+
+		auto const core_size = texture->width - 2 * halo;
+		auto const tile_num_per_axis = (output_size + core_size - 1) / core_size;
+		tiled_evaluation = TiledEvaluation{
+			.sorted_nodes = std::move(sorted_nodes),
+			.texture = texture,
+			.canvas = engine->texture_exporter->begin_tiled_export(std::move(file_path), file_format, texture->format, output_size, output_size, tile_num_per_axis * tile_num_per_axis),
+			.output_size = output_size,
+			.halo = halo,
+			.core_size = core_size,
+			.tile_num_per_axis = tile_num_per_axis,
+		};
+		return true;
+	}
+
+	void NodeEditor::advance_tiled_evaluation() {
+		if (!tiled_evaluation ||
+			vkGetFenceStatus(engine->device, graphic_fence) != VK_SUCCESS ||
+			vkGetFenceStatus(engine->device, compute_fence) != VK_SUCCESS) {
+			return;
+		}
+
+		auto& evaluation = *tiled_evaluation;
+		auto const tile_x = evaluation.next_tile % evaluation.tile_num_per_axis;
+		auto const tile_y = evaluation.next_tile / evaluation.tile_num_per_axis;
+		auto const core_x = static_cast<int32_t>(tile_x * evaluation.core_size);
+		auto const core_y = static_cast<int32_t>(tile_y * evaluation.core_size);
+
+		if (evaluation.tile_in_flight) {
+			//the copy is queued behind the evaluation and ahead of the next tile on the graphics queue
+			auto const halo = static_cast<int32_t>(evaluation.halo);
+			const VkRect2D core_region{
+				.offset = { halo, halo },
+				.extent = {
+					std::min(evaluation.core_size, evaluation.output_size - tile_x * evaluation.core_size),
+					std::min(evaluation.core_size, evaluation.output_size - tile_y * evaluation.core_size),
+				},
+			};
+			if (!engine->texture_exporter->export_tile(evaluation.canvas, evaluation.texture, core_region, { core_x, core_y })) {
+				return;
+			}
+			evaluation.tile_in_flight = false;
+			if (++evaluation.next_tile == evaluation.tile_num_per_axis * evaluation.tile_num_per_axis) {
+				cancel_tiled_evaluation();
+				update_all_nodes();
+			}
+			return;
+		}
+
+		auto const output_size = static_cast<float>(evaluation.output_size);
+		set_tile_transform(evaluation.sorted_nodes, glm::vec4{
+			static_cast<float>(core_x - static_cast<int32_t>(evaluation.halo)) / output_size,
+			static_cast<float>(core_y - static_cast<int32_t>(evaluation.halo)) / output_size,
+			static_cast<float>(evaluation.texture->width) / output_size,
+			static_cast<float>(evaluation.texture->height) / output_size,
+			});
+		execute_graph(evaluation.sorted_nodes);
+		evaluation.tile_in_flight = true;
+	}
+
+	bool NodeEditor::cancel_tiled_evaluation() {
+		if (!tiled_evaluation) {
+			return false;
+		}
+		wait_node_execute_fences();
+		set_tile_transform(tiled_evaluation->sorted_nodes, { 0.0f, 0.0f, 1.0f, 1.0f });
+		tiled_evaluation.reset();
+		return true;
+	}
+
+	std::optional<float> NodeEditor::get_tiled_export_progress() const {
+		if (!tiled_evaluation) {
+			return std::nullopt;
+		}
+		return static_cast<float>(tiled_evaluation->next_tile) / static_cast<float>(tiled_evaluation->tile_num_per_axis * tiled_evaluation->tile_num_per_axis);
+	}
+
+	void NodeEditor::serialize(const std::string_view file_path, const bool with_baked_outputs) {
+		if (graph_load) {
+			throw std::runtime_error("failed to save graph, a graph is still loading!");
+		}
+		graph_file::Graph graph;
 		ed::SetCurrentEditor(context);
 		for (auto& node : nodes) {
-			json_file["nodes"].emplace_back(json{
-				{"type", NODE_TYPE_NAMES[node.data.index()]},
-				{"type_hash", NODE_TYPE_HASH_VALUES[node.data.index()]},
-				{"pins", node.inputs},
-				{"pos", GetNodePosition(node.id)},
-				});
+			auto const pos = GetNodePosition(node.id);
+			graph.add_node(NODE_TYPE_HASH_VALUES[node.data.index()], pos.x, pos.y);
+			for (auto const& pin : node.inputs) {
+				graph.add_pin(pin.default_value);
+			}
 		}
 		for (auto& link : links) {
-			auto start_node_index = link.start_pin->node_index;
-			auto start_pin_index = get_output_pin_index(*link.start_pin);
-			auto end_node_index = link.end_pin->node_index;
-			auto end_pin_index = get_input_pin_index(*link.end_pin);
-
-			json_file["links"].emplace_back(json{
-				{"start_node_index", start_node_index},
-				{"start_pin_index", start_pin_index},
-				{"end_node_index", end_node_index},
-				{"end_pin_index", end_pin_index},
+			graph.links.push_back(graph_file::LinkRecord{
+				.start_node_index = link.start_pin->node_index,
+				.start_pin_index = static_cast<uint32_t>(get_output_pin_index(*link.start_pin)),
+				.end_node_index = link.end_pin->node_index,
+				.end_pin_index = static_cast<uint32_t>(get_input_pin_index(*link.end_pin)),
 				});
 		}
+		graph.view_origin[0] = ed::GetCurrentViewOrigin().x;
+		graph.view_origin[1] = ed::GetCurrentViewOrigin().y;
+		graph.view_scale = ed::GetCurrentViewScale();
+		ed::SetCurrentEditor(nullptr);
 
-		json_file["view"] = {
-			{
-				"origin",{
-					ed::GetCurrentViewOrigin().x,
-					ed::GetCurrentViewOrigin().y,
-				}
-			},
-			{
-				"scale", ed::GetCurrentViewScale(),
+		if (graph_file::is_binary(file_path)) {
+			if (with_baked_outputs) {
+				bake_outputs(graph);
+			}
+			graph_file::write_binary(graph.view(), file_path);
+		}
+		else {
+			graph_file::write_json(graph.view(), file_path);
+		}
+	}
+
+	void NodeEditor::bake_outputs(graph_file::Graph& graph) {
+		//tiles and deferred edits would leave outputs that do not match the saved parameters
+		if (cancel_tiled_evaluation()) {
+			update_all_nodes();
+		}
+		wait_node_execute_fences();
+		flush_deferred_updates();
+		wait_node_execute_fences();
+
+		std::vector<char> visited_nodes(nodes.size(), 0);
+		std::vector<uint32_t> sorted_nodes;
+		sorted_nodes.reserve(nodes.size());
+		for (auto const i : std::views::iota(0u, nodes.size())) {
+			if (visited_nodes[i] == 0) {
+				topological_sort(i, visited_nodes, sorted_nodes);
 			}
+		}
+		std::vector<uint32_t> evicted_nodes;
+		std::ranges::copy_if(sorted_nodes, std::back_inserter(evicted_nodes), [&](const uint32_t i) {
+			return std::visit([](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					if constexpr (is_component_graphic<NodeDataT>) {
+						return !node_data->resident;
+					}
+				}
+				return false;
+				}, nodes[i].data);
+			});
+		if (!evicted_nodes.empty()) {
+			execute_graph(evicted_nodes);
+			wait_node_execute_fences();
+		}
+
+		struct PendingBake {
+			graph_file::BakeRecord bake;
+			std::future<std::vector<std::byte>> output;
+			std::future<std::vector<std::byte>> preview;
 		};
-		std::ofstream o_file(file_path.data());
-		o_file << std::setw(4) << json_file << std::endl;
-		ed::SetCurrentEditor(nullptr);
+
+		//read back on this thread while the workers compress, a bounded window keeps the uncompressed texels in check
+		ThreadPool compress_workers{ std::max(2u, std::thread::hardware_concurrency()) - 1 };
+		auto const max_pending_num = compress_workers.size() * 2;
+		std::deque<PendingBake> pending_bakes;
+		auto const finish_oldest_bake = [&] {
+			auto& pending = pending_bakes.front();
+			graph.add_bake(pending.bake, pending.output.get(), pending.preview.get());
+			pending_bakes.pop_front();
+			};
+
+		auto const hashes = graph_file::parameter_hashes(graph.view());
+		for (auto const i : std::views::iota(0u, nodes.size())) {
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					auto const& texture = node_data->texture;
+					auto const& preview_texture = node_data->preview_texture;
+					if (!engine::TextureExporter::is_format_supported(texture->format) || preview_texture->format != texture->format) {
+						std::cerr << "bake skipped: " << nodes[i].name << " node has an unsupported format" << std::endl;
+						return;
+					}
+					if (pending_bakes.size() >= max_pending_num) {
+						finish_oldest_bake();
+					}
+					pending_bakes.push_back(PendingBake{
+						.bake = {
+							.parameter_hash = hashes[i],
+							.node_index = i,
+							.format = static_cast<uint32_t>(texture->format),
+							.width = texture->width,
+							.height = texture->height,
+							.preview_width = preview_texture->width,
+							.preview_height = preview_texture->height,
+						},
+						.output = compress_workers.submit([pixels = engine->texture_exporter->read_pixels(texture)] {
+							return graph_file::compress(pixels);
+						}),
+						.preview = compress_workers.submit([pixels = engine->texture_exporter->read_pixels(preview_texture)] {
+							return graph_file::compress(pixels);
+						}),
+						});
+				}
+				}, nodes[i].data);
+		}
+		while (!pending_bakes.empty()) {
+			finish_oldest_bake();
+		}
 	}
 
-	void NodeEditor::deserialize(const std::string_view file_path) {
-		std::ifstream i_file(file_path.data());
-		json json_file;
-		i_file >> json_file;
-		ed::SetCurrentEditor(context);
+	void NodeEditor::apply_bakes(const graph_file::GraphView& graph) {
+		wait_node_execute_fences();
 
-		for (size_t node_index = 0; node_index < json_file["nodes"].size(); ++node_index) {
-			auto& json_node = json_file["nodes"][node_index];
-			UNROLL<NodeTypeList::size>([&] <std::size_t type_index>() {
-				if (json_node["type_hash"] == NODE_TYPE_HASH_VALUES[type_index]) {
-					using NodeType = NodeTypeList::at<type_index>;
-					create_node<NodeType>();
-
-					using NodeDataT = typename NodeType::data_type;
-					using InfoT = MetaInfo<NodeDataT>;
-					using FieldTypes = FieldTypeList<InfoT>;
-
-					UNROLL<FieldTypes::size>([&] <size_t pin_index>() {
-						using PinType = typename FieldTypes::template at<pin_index>;
-						auto& node = nodes[node_index];
-						auto& pin_value = node.inputs[pin_index].default_value;
-
-						if constexpr (std::same_as<PinType, ColorRampData>) {
-							auto const& ramp_ui_value = std::get_if<ColorRampData>(&pin_value)->ui_value;
-							ramp_ui_value->clear_marks();
-							for (auto& json_mark : json_node["pins"][pin_index]) {
-								ramp_ui_value->insert_mark(json_mark["position"].get<float>(), json_mark["color"].get<ImColor>());
-							}
-							ramp_ui_value->refreshCache();
-							wait_node_execute_fences();
-							const VkSubmitInfo submit_info{
-								.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-								.commandBufferCount = 1,
-								.pCommandBuffers = &(std::get_if<ColorRampData>(&pin_value)->ubo_value->command_buffer),
-							};
-							vkResetFences(engine->device, 1, &graphic_fence);
-							vkQueueSubmit(engine->graphics_queue, 1, &submit_info, graphic_fence);
-							wait_node_execute_fences();
-						}
-						else if constexpr (!std::same_as<PinType, TextureIdData>) {
-							pin_value = json_node["pins"][pin_index].get<PinType>();
-							if constexpr (image_data<NodeDataT>) {
-								(*std::get_if<NodeDataT>(&node.data))->update_ubo(pin_value, pin_index);
-							}
-							else if constexpr (shader_data<NodeDataT>) {
-								std::get_if<NodeDataT>(&node.data)->update_ubo(pin_value, pin_index);
+		struct PendingBake {
+			uint32_t node_index;
+			engine::TexturePtr texture;
+			engine::TexturePtr preview_texture;
+			std::future<std::optional<std::pair<std::vector<std::byte>, std::vector<std::byte>>>> pixels;
+		};
+
+		//workers inflate while this thread uploads, in the same bounded window as bake_outputs()
+		ThreadPool decompress_workers{ std::max(2u, std::thread::hardware_concurrency()) - 1 };
+		auto const max_pending_num = decompress_workers.size() * 2;
+		std::deque<PendingBake> pending_bakes;
+		std::vector<char> baked_nodes(nodes.size(), 0);
+		uint64_t last_upload = 0;
+		auto const finish_oldest_bake = [&] {
+			auto& pending = pending_bakes.front();
+			if (auto const pixels = pending.pixels.get()) {
+				pending.texture->upload_pixels(pixels->first);
+				last_upload = pending.preview_texture->upload_pixels(pixels->second);
+				baked_nodes[pending.node_index] = 1;
+			}
+			else {
+				std::cerr << "bake skipped: " << nodes[pending.node_index].name << " node has a corrupted baked output" << std::endl;
+			}
+			pending_bakes.pop_front();
+			};
+
+		auto const hashes = graph_file::parameter_hashes(graph);
+		for (auto const& bake : graph.bakes) {
+			if (hashes[bake.node_index] != bake.parameter_hash) {
+				continue;
+			}
+			std::visit([&](auto&& node_data) {
+				using NodeDataT = std::decay_t<decltype(node_data)>;
+				if constexpr (image_data<NodeDataT>) {
+					auto const& texture = node_data->texture;
+					auto const& preview_texture = node_data->preview_texture;
+					auto const format = static_cast<VkFormat>(bake.format);
+					if (texture->format != format || preview_texture->format != format ||
+						texture->width != bake.width || texture->height != bake.height ||
+						preview_texture->width != bake.preview_width || preview_texture->height != bake.preview_height ||
+						!engine::TextureExporter::is_format_supported(format)) {
+						return;
+					}
+					if (pending_bakes.size() >= max_pending_num) {
+						finish_oldest_bake();
+					}
+					auto const texel_size = engine::TextureExporter::texel_size(format);
+					pending_bakes.push_back(PendingBake{
+						.node_index = bake.node_index,
+						.texture = texture,
+						.preview_texture = preview_texture,
+						.pixels = decompress_workers.submit([&graph, &bake, texel_size]
+							-> std::optional<std::pair<std::vector<std::byte>, std::vector<std::byte>>> {
+							std::vector<std::byte> output(static_cast<size_t>(bake.width) * bake.height * texel_size);
+							std::vector<std::byte> preview(static_cast<size_t>(bake.preview_width) * bake.preview_height * texel_size);
+							if (!graph_file::decompress(graph.baked_output_of(bake), output) ||
+								!graph_file::decompress(graph.baked_preview_of(bake), preview)) {
+								return std::nullopt;
 							}
-						}
-					});
+							return std::pair{ std::move(output), std::move(preview) };
+						}),
+						});
 				}
-			});
+				}, nodes[bake.node_index].data);
+		}
+		while (!pending_bakes.empty()) {
+			finish_oldest_bake();
+		}
+		if (last_upload > 0) {
+			engine->upload_ring->wait(last_upload);
+		}
 
-			ed::SetNodePosition(nodes[node_index].id, ImVec2{ json_node["pos"][0], json_node["pos"][1] });
+		std::vector<char> visited_nodes(nodes.size(), 0);
+		std::vector<uint32_t> sorted_nodes;
+		sorted_nodes.reserve(nodes.size());
+		for (auto const i : std::views::iota(0u, nodes.size())) {
+			if (visited_nodes[i] == 0) {
+				topological_sort(i, visited_nodes, sorted_nodes);
+			}
 		}
 
-		for (auto& json_link : json_file["links"]) {
-			auto const start_node_index = json_link["start_node_index"].get<int>();
-			auto const start_pin_index = json_link["start_pin_index"].get<int>();
-			auto const end_node_index = json_link["end_node_index"].get<int>();
-			auto const end_pin_index = json_link["end_pin_index"].get<int>();
+		//producers come first in reverse, so the inputs of a node are settled before it. A node is evaluated when it has
+		//no bake, an input image is evaluated or it feeds a material, whose texture copies only run after an evaluation
+		std::vector<char> stale_nodes(nodes.size(), 0);
+		for (auto const i : sorted_nodes | std::views::reverse) {
+			if (!hold_image_data(nodes[i].data)) {
+				continue;
+			}
+			bool stale = baked_nodes[i] == 0;
+			for (auto const& pin : nodes[i].inputs) {
+				for (const Pin* connected_pin : pin.connected_pins) {
+					stale = stale || stale_nodes[connected_pin->node_index] != 0;
+				}
+			}
+			for (auto const& pin : nodes[i].outputs) {
+				for (const Pin* connected_pin : pin.connected_pins) {
+					stale = stale || std::visit([](auto&& node_data) {
+						return shader_data<std::decay_t<decltype(node_data)>>;
+						}, nodes[connected_pin->node_index].data);
+				}
+			}
+			stale_nodes[i] = stale ? 1 : 0;
+		}
+
+		std::vector<uint32_t> requested_nodes;
+		std::ranges::copy_if(sorted_nodes, std::back_inserter(requested_nodes), [&](const uint32_t i) {
+			return !hold_image_data(nodes[i].data) || stale_nodes[i] != 0;
+			});
+		execute_graph(requested_nodes);
+		wait_node_execute_fences();
+	}
 
-			auto& start_pin = nodes[start_node_index].outputs[start_pin_index];
-			auto& end_pin = nodes[end_node_index].inputs[end_pin_index];
-			start_pin.connected_pins.emplace(&end_pin);
-			end_pin.connected_pins.emplace(&start_pin);
-			links.emplace(ed::LinkId(get_next_id()), &start_pin, &end_pin);
+	void NodeEditor::deserialize(const std::string_view file_path) {
+		cancel_graph_load();
+		last_load_timings = {};
+		graph_load.emplace(GraphLoad{
+			.file_path = std::filesystem::path(file_path),
+			.begin = std::chrono::steady_clock::now(),
+			.pending_source = graph_load_worker.submit([file_path = std::filesystem::path(file_path)] {
+				return std::make_unique<graph_file::GraphSource>(file_path);
+			}),
+			});
+	}
 
-			std::visit([&](auto&& end_node_data) {
-				using EndNodeDataT = std::decay_t<decltype(end_node_data)>;
-				if constexpr (image_data<EndNodeDataT>) {
-					end_node_data->update_ubo(start_pin.default_value, end_pin_index);
+	//Runs the load for up to graph_load_frame_budget per frame. Nodes and links are created in chunks, each chunk with
+	//one SetupBatch. Then the upstream branches of the displayed and visible nodes are evaluated, and the rest after them
+	void NodeEditor::advance_graph_load() {
+		if (!graph_load) {
+			return;
+		}
+		auto& load = *graph_load;
+		auto const frame_begin = std::chrono::steady_clock::now();
+		auto const elapsed_ms = [](const std::chrono::steady_clock::time_point begin) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			};
+		auto const evaluation_idle = [&] {
+			return vkGetFenceStatus(engine->device, graphic_fence) == VK_SUCCESS && vkGetFenceStatus(engine->device, compute_fence) == VK_SUCCESS;
+			};
+
+		try {
+			switch (load.stage) {
+			case GraphLoad::Stage::PARSE: {
+				if (load.pending_source.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+					return;
 				}
-				if constexpr (shader_data<EndNodeDataT>) {
-					end_node_data.update_ubo(start_pin.default_value, end_pin_index);
-					std::visit([&](auto&& start_node_data) {
-						using StartNodeT = std::decay_t<decltype(start_node_data)>;
-						if constexpr (image_data<StartNodeT>) {
-							field_at(engine->pbr_material_texture_set, end_pin_index, [&](auto pbr_texture_id) {
-								auto input_format = start_node_data->texture->format;
-								auto& pbr_texture = engine->texture_manager->textures[pbr_texture_id];
-								if (pbr_texture == nullptr || input_format != pbr_texture->format) {
-									pbr_texture = Texture::create_device_texture(engine,
-										TEXTURE_WIDTH,
-										TEXTURE_HEIGHT,
-										input_format,
-										VK_IMAGE_ASPECT_COLOR_BIT,
-										VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-									pbr_texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-									engine->update_image_descriptor(pbr_texture, pbr_texture_id);
-									start_node_data->record_copy_image_cmd_buffers(end_pin_index);
-								}
-								});
-						}
-						}, nodes[start_node_index].data);
+				load.source = load.pending_source.get();
+				load.graph = load.source->view();
+				last_load_timings.parse = elapsed_ms(load.begin);
+				nodes.reserve(nodes.size() + load.graph.nodes.size());
+				ed::SetCurrentEditor(context);
+				ed::SetCurrentView(ImVec2{ load.graph.view_origin[0], load.graph.view_origin[1] }, load.graph.view_scale);
+				ed::SetCurrentEditor(nullptr);
+				load.stage = GraphLoad::Stage::CREATE;
+				break;
+			}
+			case GraphLoad::Stage::CREATE: {
+				auto const create_begin = std::chrono::steady_clock::now();
+				ed::SetCurrentEditor(context);
+				std::optional<SetupBatch> setup_batch(std::in_place, engine);
+				while (elapsed_ms(frame_begin) < graph_load_frame_budget) {
+					if (load.next_node < load.graph.nodes.size()) {
+						load_node(load.graph, load.next_node++);
+					}
+					else if (load.next_link < load.graph.links.size()) {
+						load_link(load.graph.links[load.next_link++]);
+					}
+					else {
+						load.stage = GraphLoad::Stage::EVALUATE_VISIBLE;
+						break;
+					}
+				}
+				ed::SetCurrentEditor(nullptr);
+				last_load_timings.create += elapsed_ms(create_begin);
+				auto const upload_begin = std::chrono::steady_clock::now();
+				setup_batch.reset();
+				last_load_timings.upload += elapsed_ms(upload_begin);
+				break;
+			}
+			case GraphLoad::Stage::EVALUATE_VISIBLE: {
+				if (!evaluation_idle()) {
+					return;
 				}
-				}, nodes[end_node_index].data);
+				load.evaluation_begin = std::chrono::steady_clock::now();
+				if (!load.graph.bakes.empty()) {
+					apply_bakes(load.graph);  //bakes leave little to evaluate, so it happens in one go
+					load.stage = GraphLoad::Stage::FINISH;
+					break;
+				}
+				auto const [visible_nodes, remaining_nodes] = split_visible_evaluation(load.visible_min, load.visible_max);
+				execute_graph(visible_nodes);
+				load.remaining_nodes = remaining_nodes;
+				load.stage = GraphLoad::Stage::EVALUATE_REST;
+				break;
+			}
+			case GraphLoad::Stage::EVALUATE_REST: {
+				if (!evaluation_idle()) {
+					return;
+				}
+				execute_graph(load.remaining_nodes);
+				load.stage = GraphLoad::Stage::FINISH;
+				break;
+			}
+			case GraphLoad::Stage::FINISH: {
+				if (!evaluation_idle()) {
+					return;
+				}
+				last_load_timings.evaluate = elapsed_ms(load.evaluation_begin);
+				last_load_timings.total = elapsed_ms(load.begin);
+				graph_load.reset();
+				flush_deferred_updates();  //edits made while loading
+				break;
+			}
+			}
 		}
+		catch (const std::exception& e) {
+			//whatever was created so far stays in the editor
+			std::cerr << e.what() << std::endl;
+			ed::SetCurrentEditor(nullptr);
+			graph_load.reset();
+		}
+	}
 
-		update_all_nodes();
+	bool NodeEditor::cancel_graph_load() {
+		if (!graph_load) {
+			return false;
+		}
+		wait_node_execute_fences();
+		graph_load.reset();  //a parse still running finishes on graph_load_worker and is dropped
+		return true;
+	}
 
-		ed::SetCurrentView(
-			ImVec2{
-				json_file["view"]["origin"][0].get<float>(),
-				json_file["view"]["origin"][1].get<float>()
-			},
-			json_file["view"]["scale"].get<float>()
-		);
+	std::optional<float> NodeEditor::get_graph_load_progress() const {
+		if (!graph_load) {
+			return std::nullopt;
+		}
+		//nodes and links count one step each, both evaluation passes one step together
+		auto const& load = *graph_load;
+		auto const step_num = load.graph.nodes.size() + load.graph.links.size() + 1;
+		auto const done_num = load.next_node + load.next_link + (load.stage == GraphLoad::Stage::FINISH ? 1 : 0);
+		return static_cast<float>(done_num) / static_cast<float>(step_num);
+	}
 
+	//Nodes upstream of the displayed node or of a node in the visible canvas rectangle, then all others, both in
+	//topological_sort() order
+	std::pair<std::vector<uint32_t>, std::vector<uint32_t>> NodeEditor::split_visible_evaluation(const ImVec2& visible_min, const ImVec2& visible_max) {
+		const ImRect visible_rect(visible_min, visible_max);
+		std::vector<char> prioritized_nodes(nodes.size(), 0);
+		std::vector<uint32_t> stack;
+		ed::SetCurrentEditor(context);
+		for (auto const i : std::views::iota(0u, nodes.size())) {
+			auto const position = ed::GetNodePosition(nodes[i].id);
+			const ImRect node_rect(position, position + ed::GetNodeSize(nodes[i].id));
+			if (nodes[i].id == display_node_id || visible_rect.Overlaps(node_rect)) {
+				prioritized_nodes[i] = 1;
+				stack.push_back(i);
+			}
+		}
 		ed::SetCurrentEditor(nullptr);
+		while (!stack.empty()) {
+			auto const i = stack.back();
+			stack.pop_back();
+			for (auto const& pin : nodes[i].inputs) {
+				for (const Pin* connected_pin : pin.connected_pins) {
+					if (prioritized_nodes[connected_pin->node_index] == 0) {
+						prioritized_nodes[connected_pin->node_index] = 1;
+						stack.push_back(connected_pin->node_index);
+					}
+				}
+			}
+		}
+
+		std::vector<char> visited_nodes(nodes.size(), 0);
+		std::vector<uint32_t> sorted_nodes;
+		sorted_nodes.reserve(nodes.size());
+		for (auto const i : std::views::iota(0u, nodes.size())) {
+			if (visited_nodes[i] == 0) {
+				topological_sort(i, visited_nodes, sorted_nodes);
+			}
+		}
+		std::pair<std::vector<uint32_t>, std::vector<uint32_t>> split;
+		for (auto const i : sorted_nodes) {
+			(prioritized_nodes[i] != 0 ? split.first : split.second).push_back(i);
+		}
+		return split;
+	}
+
+	//graph was validated against the node types, so every node and pin it references exists
+	uint32_t NodeEditor::load_node(const graph_file::GraphView& graph, const size_t node_index) {
+		auto const& node_record = graph.nodes[node_index];
+		auto const pin_records = graph.pins_of(node_record);
+		auto const created_index = static_cast<uint32_t>(nodes.size());
+		UNROLL<NodeTypeList::size>([&] <std::size_t type_index>() {
+			if (node_record.type_hash == NODE_TYPE_HASH_VALUES[type_index]) {
+				using NodeType = NodeTypeList::at<type_index>;
+				create_node<NodeType>();
+
+				using NodeDataT = typename NodeType::data_type;
+				using InfoT = MetaInfo<NodeDataT>;
+				using FieldTypes = FieldTypeList<InfoT>;
+
+				UNROLL<FieldTypes::size>([&] <size_t pin_index>() {
+					using PinType = typename FieldTypes::template at<pin_index>;
+					auto& node = nodes[created_index];
+					auto& pin_value = node.inputs[pin_index].default_value;
+
+					if constexpr (std::same_as<PinType, ColorRampData>) {
+						auto const& ramp_ui_value = std::get_if<ColorRampData>(&pin_value)->ui_value;
+						ramp_ui_value->clear_marks();
+						for (auto const& mark : graph.marks_of(pin_records[pin_index])) {
+							ramp_ui_value->insert_mark(mark.position, ImColor(mark.color[0], mark.color[1], mark.color[2], mark.color[3]));
+						}
+						ramp_ui_value->refreshCache();  //create_node() queued the upload, it runs with the batch
+					}
+					else if constexpr (!std::same_as<PinType, TextureIdData>) {
+						pin_value = graph_file::read_pin<PinType>(pin_records[pin_index]);
+						if constexpr (image_data<NodeDataT>) {
+							(*std::get_if<NodeDataT>(&node.data))->update_ubo(pin_value, pin_index);
+						}
+						else if constexpr (shader_data<NodeDataT>) {
+							std::get_if<NodeDataT>(&node.data)->update_ubo(pin_value, pin_index);
+						}
+					}
+				});
+			}
+		});
+
+		ed::SetNodePosition(nodes[created_index].id, ImVec2{ node_record.pos[0], node_record.pos[1] });
+		return created_index;
+	}
+
+	void NodeEditor::load_link(const graph_file::LinkRecord& link) {
+		auto const start_node_index = link.start_node_index;
+		auto const start_pin_index = link.start_pin_index;
+		auto const end_node_index = link.end_node_index;
+		auto const end_pin_index = link.end_pin_index;
+
+		auto& start_pin = nodes[start_node_index].outputs[start_pin_index];
+		auto& end_pin = nodes[end_node_index].inputs[end_pin_index];
+		start_pin.connected_pins.emplace(&end_pin);
+		end_pin.connected_pins.emplace(&start_pin);
+		links.emplace(ed::LinkId(get_next_id()), &start_pin, &end_pin);
+
+		std::visit([&](auto&& end_node_data) {
+			using EndNodeDataT = std::decay_t<decltype(end_node_data)>;
+			if constexpr (image_data<EndNodeDataT>) {
+				end_node_data->update_ubo(start_pin.default_value, end_pin_index);
+			}
+			if constexpr (shader_data<EndNodeDataT>) {
+				end_node_data.update_ubo(start_pin.default_value, end_pin_index);
+				std::visit([&](auto&& start_node_data) {
+					using StartNodeT = std::decay_t<decltype(start_node_data)>;
+					if constexpr (image_data<StartNodeT>) {
+						field_at(engine->pbr_material_texture_set, end_pin_index, [&](auto pbr_texture_id) {
+							auto input_format = start_node_data->texture->format;
+							auto& pbr_texture = engine->texture_manager->textures[pbr_texture_id];
+							if (pbr_texture == nullptr || input_format != pbr_texture->format) {
+								MemoryCategoryScope memory_scope(MemoryCategory::PBR_COPY);
+								pbr_texture = Texture::create_device_texture(engine,
+									TEXTURE_WIDTH,
+									TEXTURE_HEIGHT,
+									input_format,
+									VK_IMAGE_ASPECT_COLOR_BIT,
+									VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+								pbr_texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+								engine->update_image_descriptor(pbr_texture, pbr_texture_id);
+								start_node_data->record_copy_image_cmd_buffers(end_pin_index);
+							}
+							});
+					}
+					}, nodes[start_node_index].data);
+			}
+			}, nodes[end_node_index].data);
 	}
 
 	void NodeEditor::recalculate_node(const size_t index) {
@@ -1290,10 +2607,14 @@ namespace engine {
 
 	void NodeEditor::clear() {
 		wait_node_execute_fences();
+		tiled_evaluation.reset();
+		graph_load.reset();
+		deferred_update_nodes.clear();
 		vkDeviceWaitIdle(engine->device);
 		color_pin_index.reset();
 		color_ramp_pin_index.reset();
 		enum_pin_index.reset();
+		undo_history.clear();
 		links.clear();
 		nodes.clear();
 		garbage_nodes.clear_all();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_set>
+#include <chrono>
 #include <concepts>
 #include <format>
 #include <functional>
@@ -10,11 +11,16 @@
 #include <imgui_impl_vulkan.h>
 
 #include "all_node_headers.h"
+#include "gui_graph_file.h"
 #include "gui_node_editor_ui.h"
 #include "gui_pin.h"
+#include "gui_undo_history.h"
 #include "../util/class_field_type_list.h"
 #include "../util/cpp_type.h"
 #include "../util/hash_str.h"
+#include "../util/thread_pool.h"
+#include "../vk_setup_batch.h"
+#include "../vk_texture_exporter.h"
 
 
 static std::string first_letter_to_upper(std::string_view str);
@@ -48,7 +54,8 @@ using NodeMenuFilter = TypeList<
 	NodeBlur,
 	NodeSlopeBlur,
 	NodeUdf,
-	NodeNormal
+	NodeNormal,
+	NodeNormalCompute
 >;
 
 using NodeMenuNumerical = TypeList<
@@ -273,6 +280,8 @@ namespace engine {
 
 		uint32_t internal_clock = 1;
 
+		uint32_t texture_set_generation = 0;  //TextureManager::generation the node command buffers were recorded against
+
 		GarbagePingPongBuffer<NodeDataVariant> garbage_nodes = GarbagePingPongBuffer<NodeDataVariant>();
 		constexpr inline static uint32_t garbage_collection_delay = 256;
 
@@ -290,12 +299,144 @@ namespace engine {
 
 		float preview_image_size;
 
-		
+		//Outputs larger than the node textures are evaluated tile by tile, one tile per frame. Every upstream image node
+		//renders the same window: the tile core padded by a halo covering the sampling footprints accumulated along the graph
+		struct TiledEvaluation {
+			std::vector<uint32_t> sorted_nodes;
+			TexturePtr texture;
+			std::shared_ptr<TextureExporter::TiledCanvas> canvas;
+			uint32_t output_size;
+			uint32_t halo;
+			uint32_t core_size;
+			uint32_t tile_num_per_axis;
+			uint32_t next_tile = 0;
+			bool tile_in_flight = false;
+		};
+
+		std::optional<TiledEvaluation> tiled_evaluation;
+
+		std::vector<uint32_t> deferred_update_nodes;  //edited while the previous evaluation was in flight
+
+		//deserialize() loads as a job that advance_graph_load() runs a slice of every frame, so the editor can be panned
+		//and pins edited while a huge graph streams in. Nodes and links are only added or removed by the job meanwhile
+		struct GraphLoad {
+			enum class Stage {
+				PARSE,  //on graph_load_worker
+				CREATE,
+				EVALUATE_VISIBLE,
+				EVALUATE_REST,
+				FINISH,
+			};
+
+			std::filesystem::path file_path;
+			std::chrono::steady_clock::time_point begin;
+			std::future<std::unique_ptr<graph_file::GraphSource>> pending_source;
+			std::unique_ptr<graph_file::GraphSource> source;
+			graph_file::GraphView graph;
+			Stage stage = Stage::PARSE;
+			uint32_t next_node = 0;
+			uint32_t next_link = 0;
+			ImVec2 visible_min{ 0.0f, 0.0f };  //canvas area shown by the editor, updated every frame
+			ImVec2 visible_max{ 0.0f, 0.0f };
+			std::vector<uint32_t> remaining_nodes;  //evaluated after the visible ones
+			std::chrono::steady_clock::time_point evaluation_begin;
+		};
+
+		constexpr inline static double graph_load_frame_budget = 8.0;  //milliseconds of loading per frame
+		std::optional<GraphLoad> graph_load;
+		ThreadPool graph_load_worker{ 1 };
+
+	public:
+		//milliseconds spent in each phase of the last deserialize(), create and upload summed over the frames they took
+		struct GraphLoadTimings {
+			double parse = 0.0;  //mapping a .txgb or parsing a .txg, then validating the tables
+			double create = 0.0;  //nodes, links and their GPU resources, with the setup commands only recorded
+			double upload = 0.0;  //submitting the recorded setup commands, once per frame
+			double evaluate = 0.0;  //uploading baked outputs and evaluating the graph, frames in between included
+			double total = 0.0;  //from deserialize() to the end of the evaluation, 0 until a load completes
+		};
+
+	private:
+		GraphLoadTimings last_load_timings;
+
+		//Residency: once resident node outputs exceed residency_budget the least recently used intermediate graphics
+		//outputs are evicted, they are recomputed when an evaluation samples them or they are displayed
+		constexpr inline static float default_residency_budget_ratio = 0.5f;  //of the largest device local heap budget
+		VkDeviceSize residency_budget = 0;  //picked from the heap budgets on the first frame
+		VkDeviceSize resident_bytes = 0;
+		size_t evicted_num = 0;
+		uint64_t residency_frame = 0;
+		uint64_t trim_frame = 0;  //frame at which evicted textures have retired from the texture pool, 0 if none
+
+		//Startup pre-warm: pipelines of every node type and format compile here while the editor is already interactive
+		ThreadPool pipeline_workers{ std::max(2u, std::thread::hardware_concurrency()) - 1 };  //leave a core to the main loop
+		bool prewarm_pending = false;
+		std::chrono::steady_clock::time_point prewarm_begin;
+		double last_prewarm_ms = 0.0;  //wall time of the last pre-warm until its queue drained, 0 until one has
+		uint64_t shader_reload_count = 0;  //ShaderModuleCache::reload_count() the node pipelines were last rebuilt for
+		bool pipelines_reloading = false;  //pipelines of edited shaders are compiling on pipeline_workers
+
+		UndoHistory undo_history;
 
 		uint64_t get_next_id() noexcept;
 
+		void prewarm_pipelines();
+
+		void finish_prewarm();
+
+		//rebuilds the pipelines of edited shaders in the background, then swaps them into the nodes between two evaluations
+		void reload_edited_pipelines();
+
+		void advance_graph_load();
+
+		std::pair<std::vector<uint32_t>, std::vector<uint32_t>> split_visible_evaluation(const ImVec2& visible_min, const ImVec2& visible_max);
+
+		//creates node node_index of graph after the nodes in the editor and returns its index there
+		uint32_t load_node(const graph_file::GraphView& graph, size_t node_index);
+
+		void load_link(const graph_file::LinkRecord& link);
+
+		//reads back and compresses the outputs of every image node, evicted ones are evaluated again first
+		void bake_outputs(graph_file::Graph& graph);
+
+		//uploads the baked outputs whose parameter hash still matches, then evaluates only the nodes left without one
+		void apply_bakes(const graph_file::GraphView& graph);
+
+		PinState get_pin_state(uint32_t node_index, uint32_t pin_index) const;
+
+		//writes state into the pin and re-evaluates the nodes downstream of it
+		void set_pin_state(uint32_t node_index, uint32_t pin_index, const PinState& state);
+
+		//records the edit of a pin widget, before is the state the widget was drawn with
+		void record_pin_edit(uint32_t node_index, uint32_t pin_index, PinState before);
+
+		graph_file::LinkRecord get_link_record(const Link& link) const;
+
+		std::unordered_set<Link>::iterator find_link(const graph_file::LinkRecord& link);
+
+		//links start_pin to end_pin, replacing the link end_pin had
+		void connect_pins(Pin* start_pin, Pin* end_pin);
+
+		void remove_link(std::unordered_set<Link>::iterator link);
+
+		[[nodiscard]] std::shared_ptr<const graph_file::Graph> snapshot_node(uint32_t node_index) const;
+
+		//creates the node of snapshot at node_index, the nodes from there on move up by one
+		void insert_node(uint32_t node_index, const graph_file::Graph& snapshot);
+
+		//the links of the node are expected to be removed already
+		void remove_node(uint32_t node_index);
+
+		void undo();
+
+		void redo();
+
 		void update_from(uint32_t node_index);
 
+		void flush_deferred_updates();
+
+		void rebind_texture_descriptor_set();
+
 		void build_node(uint32_t node_index);
 
 		template<typename NodeType>
@@ -317,16 +458,8 @@ namespace engine {
 
 					if constexpr (std::same_as<PinType, ColorRampData>) {
 						pin_value = std::move(ColorRampData(engine));
-
-						vkWaitForFences(engine->device, 1, &graphic_fence, VK_TRUE, VULKAN_WAIT_TIMEOUT);
-						const VkSubmitInfo submit_info{
-							.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-							.commandBufferCount = 1,
-							.pCommandBuffers = &std::get_if<ColorRampData>(&pin_value)->ubo_value->command_buffer,
-						};
-						vkResetFences(engine->device, 1, &graphic_fence);
-						vkQueueSubmit(engine->graphics_queue, 1, &submit_info, graphic_fence);
-						vkWaitForFences(engine->device, 1, &graphic_fence, VK_TRUE, VULKAN_WAIT_TIMEOUT);
+						//the upload reads the staging buffer when it runs, so in a SetupBatch it picks up marks set later
+						engine::SetupBatch::submit(engine, std::get_if<ColorRampData>(&pin_value)->ubo_value->command_buffer);
 					}
 					else {
 						pin_value = value;
@@ -343,7 +476,7 @@ namespace engine {
 				auto& node_data = *std::get_if<NodeDataType>(&node.data);
 				node.outputs[0].default_value = TextureIdData{ .value = node_data->node_texture_id };
 				if constexpr (!has_field_type_v<InfoT, ColorRampData>) {
-					node_data->uniform_buffer->copy_from_host(&ubo);
+					node_data->write_ubo(&ubo, sizeof(InfoT));
 				}
 			}
 			else if constexpr (value_data<NodeDataType>) {
@@ -368,6 +501,41 @@ namespace engine {
 			return gui_display_texture_handle;
 		}
 
+		TexturePtr get_display_texture() const;
+
+		//evaluates the display node at output_size x output_size and streams the tiles to the texture exporter
+		bool begin_tiled_export(uint32_t output_size, std::filesystem::path file_path, ExportFileFormat file_format);
+
+		std::optional<float> get_tiled_export_progress() const;
+
+		bool cancel_graph_load();
+
+		[[nodiscard]] std::optional<float> get_graph_load_progress() const;
+
+		[[nodiscard]] VkDeviceSize get_residency_budget() const noexcept {
+			return residency_budget;
+		}
+
+		void set_residency_budget(const VkDeviceSize budget) noexcept {
+			residency_budget = budget;
+		}
+
+		[[nodiscard]] VkDeviceSize get_resident_bytes() const noexcept {
+			return resident_bytes;
+		}
+
+		[[nodiscard]] size_t get_evicted_num() const noexcept {
+			return evicted_num;
+		}
+
+		[[nodiscard]] const GraphLoadTimings& get_last_load_timings() const noexcept {
+			return last_load_timings;
+		}
+
+		[[nodiscard]] double get_last_prewarm_ms() const noexcept {
+			return last_prewarm_ms;
+		}
+
 		void draw();
 
 		void create_new_link();
@@ -392,13 +560,17 @@ namespace engine {
 						if constexpr (std::same_as<SetPos, SetNodePositionTag>) {
 							ed::SetNodePosition(nodes[node_i].id, ed::ScreenToCanvas(ImGui::GetMousePos()));
 						}
+						undo_history.record(undo::AddNode{ .node_index = node_i });
 					}
 				}
 			});
 		}
 
-		void serialize(std::string_view file_path);
+		//.txgb paths are written as binary tables, any other path as .txg JSON. with_baked_outputs also stores the
+		//evaluated output and preview of every image node in a .txgb, so loading it only evaluates what changed since
+		void serialize(std::string_view file_path, bool with_baked_outputs = false);
 
+		//starts loading file_path, the graph fills in over the next frames
 		void deserialize(std::string_view file_path);
 
 		void clear();
@@ -429,7 +601,7 @@ namespace engine {
 		static void update_node_ubo(NodeDataVariant& node_data, const PinVariant& value, size_t index);
 
 		template<NodeDataConcept NodeDataT>
-		void update_wait_semaphores(const uint32_t i, const NodeDataT& node_data, std::vector<CopyImageSubmitInfo>& copy_image_submit_infos, uint64_t last_signal_counter) {
+		void update_wait_semaphores(const uint32_t i, const NodeDataT& node_data, std::vector<CopyImageSubmitInfo>& copy_image_submit_infos, uint64_t last_signal_counter, const VkSemaphoreSubmitInfo& copy_wait) {
 			for (auto& pin : nodes[i].outputs) {
 				for (auto const connected_pin : pin.connected_pins) {
 					std::visit([&](auto&& connected_node_data) {
@@ -444,13 +616,7 @@ namespace engine {
 						}
 						else if constexpr (shader_data<NodeDataT>) {
 							copy_image_submit_infos.emplace_back(
-								VkSemaphoreSubmitInfo{
-									.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
-									.pNext = nullptr,
-									.semaphore = node_data->semaphore,
-									.value = last_signal_counter,
-									.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-								},
+								copy_wait,
 								VkCommandBufferSubmitInfo{
 									.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
 									.commandBuffer = node_data->copy_image_cmd_buffers[get_input_pin_index(*connected_pin)],
@@ -470,7 +636,15 @@ namespace engine {
 
 		void topological_sort(uint32_t index, std::vector<char>& visited_nodes, std::vector<uint32_t>& sorted_nodes) const;
 
-		void execute_graph(const std::vector<uint32_t>& sorted_nodes);
+		std::vector<uint32_t> add_evicted_inputs(const std::vector<uint32_t>& sorted_nodes);
+
+		std::vector<VkSemaphoreSubmitInfo> order_queue_transfers(const std::vector<uint32_t>& sorted_nodes, const std::vector<uint64_t>& last_signal_values);
+
+		void execute_graph(const std::vector<uint32_t>& requested_nodes);
+
+		bool is_evictable(uint32_t index) const;
+
+		void enforce_residency_budget();
 
 		size_t get_input_pin_index(const Pin& pin) const {
 			const Node& node = nodes[pin.node_index];
@@ -486,6 +660,16 @@ namespace engine {
 			return ubo_index - node.outputs.begin();
 		}
 
+		std::vector<uint32_t> sort_upstream_nodes(uint32_t node_index) const;
+
+		SamplingFootprint get_node_footprint(uint32_t node_index);
+
+		void set_tile_transform(const std::vector<uint32_t>& sorted_nodes, const glm::vec4& tile_transform);
+
+		void advance_tiled_evaluation();
+
+		bool cancel_tiled_evaluation();
+
 		void wait_node_execute_fences() const {
 			const std::array fences{ graphic_fence, compute_fence };
 			vkWaitForFences(engine->device, fences.size(), fences.data(), VK_TRUE, VULKAN_WAIT_TIMEOUT);
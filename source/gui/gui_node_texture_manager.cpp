@@ -1,25 +1,138 @@
 #include "gui_node_texture_manager.h"
 #include "../vk_engine.h"
+#include <algorithm>
 #include <array>
-#include <ranges>
 #include <stdexcept>
 
-TextureManager::TextureManager(VulkanEngine* engine, uint32_t max_textures) {
-	
-	create_texture_array_descriptor_set_layouts(engine);
-	create_texture_array_descriptor_set(engine);
+namespace {
+	//UPDATE_AFTER_BIND limits count the descriptors of every set in a pipeline layout, samplers and images separately
+	uint32_t query_max_bindless_textures(VkPhysicalDevice physical_device) {
+		VkPhysicalDeviceVulkan12Properties vulkan12_properties{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+		};
+		VkPhysicalDeviceProperties2 properties{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+			.pNext = &vulkan12_properties,
+		};
+		vkGetPhysicalDeviceProperties2(physical_device, &properties);
 
-	for (auto i : std::views::iota(0u, max_textures)) {
-		unused_id.emplace(i);
+		return std::min({
+			VulkanEngine::max_bindless_textures_limit,
+			vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+			vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			vulkan12_properties.maxDescriptorSetUpdateAfterBindSamplers,
+			vulkan12_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+			});
 	}
 }
 
-void TextureManager::create_texture_array_descriptor_set_layouts(VulkanEngine* engine) {
+TextureManager::TextureManager(VulkanEngine* engine, uint32_t initial_capacity) :
+	engine(engine), max_capacity(query_max_bindless_textures(engine->physical_device)) {
+	initial_capacity = std::min(initial_capacity, max_capacity);
+	id_allocator = IdAllocator(initial_capacity);
+	pending_writes.resize(initial_capacity);
+	bound_infos.resize(initial_capacity);
+
+	create_texture_array_descriptor_set_layouts();
+	create_texture_array_descriptor_set(initial_capacity);
+
+	engine->main_deletion_queue.push_function([this] {
+		vkDestroyDescriptorPool(this->engine->device, descriptor_pool, nullptr);
+		});
+}
+
+bool TextureManager::grow() {
+	auto const old_capacity = capacity();
+	if (old_capacity >= max_capacity) {
+		return false;
+	}
+	auto const new_capacity = std::min(old_capacity * 2, max_capacity);
+
+	//the old set is bound by in-flight and pre-recorded command buffers, growth is rare enough to drain the device
+	vkDeviceWaitIdle(engine->device);
+
+	id_allocator.grow(new_capacity);
+	pending_writes.resize(new_capacity);
+	bound_infos.resize(new_capacity);
+
+	auto const old_descriptor_pool = descriptor_pool;
+	create_texture_array_descriptor_set(new_capacity);
+	vkDestroyDescriptorPool(engine->device, old_descriptor_pool, nullptr);
+
+	//the new set starts empty, replay what the old one held unless a newer write is already queued
+	for (uint32_t id = 0; id < old_capacity; ++id) {
+		if (bound_infos[id].imageView != VK_NULL_HANDLE && !pending_writes[id]) {
+			queue_descriptor_write(id, bound_infos[id].sampler, bound_infos[id].imageView);
+		}
+	}
+
+	++generation;
+	return true;
+}
+
+void TextureManager::queue_descriptor_write(const uint32_t id, const VkSampler sampler, const VkImageView image_view) {
+	if (!pending_writes[id]) {
+		pending_ids.emplace_back(id);
+	}
+	pending_writes[id] = VkDescriptorImageInfo{
+		.sampler = sampler,
+		.imageView = image_view,
+		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	};
+}
+
+void TextureManager::flush_descriptor_writes(const VkDevice device) {
+	if (pending_ids.empty()) {
+		return;
+	}
+	std::ranges::sort(pending_ids);
+	const auto [unique_end, _] = std::ranges::unique(pending_ids);
+	pending_ids.erase(unique_end, pending_ids.end());
+
+	std::vector<VkDescriptorImageInfo> image_infos;
+	image_infos.reserve(pending_ids.size());
+	std::vector<VkWriteDescriptorSet> descriptor_writes;
+	for (auto const id : pending_ids) {
+		if (!pending_writes[id]) {  //deleted after it was queued
+			continue;
+		}
+		const bool extends_run = !descriptor_writes.empty() &&
+			descriptor_writes.back().dstArrayElement + descriptor_writes.back().descriptorCount == id;
+		if (extends_run) {
+			++descriptor_writes.back().descriptorCount;
+		}
+		else {
+			descriptor_writes.emplace_back(VkWriteDescriptorSet{
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.dstSet = descriptor_set,
+				.dstBinding = 0,
+				.dstArrayElement = id,
+				.descriptorCount = 1,
+				.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				});
+		}
+		image_infos.emplace_back(*pending_writes[id]);
+		bound_infos[id] = *pending_writes[id];
+		pending_writes[id].reset();
+	}
+	pending_ids.clear();
+
+	//image_infos no longer reallocates, point each run at its first element
+	size_t image_info_index = 0;
+	for (auto& descriptor_write : descriptor_writes) {
+		descriptor_write.pImageInfo = image_infos.data() + image_info_index;
+		image_info_index += descriptor_write.descriptorCount;
+	}
+
+	vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptor_writes.size()), descriptor_writes.data(), 0, nullptr);
+}
+
+void TextureManager::create_texture_array_descriptor_set_layouts() {
 	std::array node_descriptor_set_layout_bindings{
 		VkDescriptorSetLayoutBinding{
 			.binding = 0,
 			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			.descriptorCount = engine->max_bindless_textures,
+			.descriptorCount = max_capacity,
 			.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
 		},
 	};
@@ -50,22 +163,36 @@ void TextureManager::create_texture_array_descriptor_set_layouts(VulkanEngine* e
 		throw std::runtime_error("failed to create descriptor set layout!");
 	}
 
-	engine->main_deletion_queue.push_function([=] {
-		vkDestroyDescriptorSetLayout(engine->device, descriptor_set_layout, nullptr);
+	engine->main_deletion_queue.push_function([device = engine->device, layout = descriptor_set_layout] {
+		vkDestroyDescriptorSetLayout(device, layout, nullptr);
 		});
 }
 
-void TextureManager::create_texture_array_descriptor_set(VulkanEngine* engine) {
+void TextureManager::create_texture_array_descriptor_set(const uint32_t capacity) {
+	const VkDescriptorPoolSize pool_size{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity };
+
+	const VkDescriptorPoolCreateInfo pool_info{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+		.maxSets = 1,
+		.poolSizeCount = 1,
+		.pPoolSizes = &pool_size,
+	};
+
+	if (vkCreateDescriptorPool(engine->device, &pool_info, nullptr, &descriptor_pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
 	VkDescriptorSetVariableDescriptorCountAllocateInfo variabl_descriptor_count_info{
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
 		.descriptorSetCount = 1,
-		.pDescriptorCounts = &engine->max_bindless_textures,
+		.pDescriptorCounts = &capacity,
 	};
 
 	const VkDescriptorSetAllocateInfo descriptor_alloc_info{
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 		.pNext = &variabl_descriptor_count_info,
-		.descriptorPool = engine->dynamic_descriptor_pool,
+		.descriptorPool = descriptor_pool,
 		.descriptorSetCount = 1,
 		.pSetLayouts = &descriptor_set_layout,
 	};
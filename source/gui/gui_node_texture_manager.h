@@ -1,47 +1,95 @@
 #pragma once
-#include <unordered_set>
+#include <optional>
+#include <stdexcept>
 #include <unordered_map>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include "../vk_image.h"
+#include "../util/id_allocator.h"
 
 class VulkanEngine;
 
 struct TextureManager {
+	VulkanEngine* engine;
+
 	std::unordered_map<uint32_t, TexturePtr> textures;
-	std::unordered_set<uint32_t> unused_id;
+	IdAllocator id_allocator;
 
+	//The layout declares max_capacity descriptors but the set is allocated with a variable count of capacity().
+	//When the ids run out the set is reallocated at twice the size, so pipeline layouts stay valid and only
+	//command buffers that bound the old set need re-recording: they compare against generation
 	VkDescriptorSetLayout descriptor_set_layout;
+	VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
 	VkDescriptorSet descriptor_set;
+	uint32_t max_capacity;
+	uint32_t generation = 0;
+
+	//Descriptor writes are queued per id (the last write wins) and flushed as one vkUpdateDescriptorSets
+	//before the next node graph or frame submission. Runs of consecutive ids share one VkWriteDescriptorSet.
+	std::vector<std::optional<VkDescriptorImageInfo>> pending_writes;
+	std::vector<uint32_t> pending_ids;
+	std::vector<VkDescriptorImageInfo> bound_infos;  //what the set holds per id, replayed into a grown set
+
+	void create_texture_array_descriptor_set_layouts();
+
+	void create_texture_array_descriptor_set(uint32_t capacity);
 
-	void create_texture_array_descriptor_set_layouts(VulkanEngine* engine);
+	TextureManager(VulkanEngine* engine, uint32_t initial_capacity);
 
-	void create_texture_array_descriptor_set(VulkanEngine* engine);
+	[[nodiscard]] uint32_t capacity() const noexcept {
+		return id_allocator.capacity();
+	}
+
+	[[nodiscard]] uint32_t size() const noexcept {
+		return id_allocator.size();
+	}
 
-	TextureManager(VulkanEngine* engine, uint32_t max_textures);
+	bool grow();
+
+	uint32_t allocate_id() {
+		auto id = id_allocator.allocate();
+		if (!id && grow()) {
+			id = id_allocator.allocate();
+		}
+		if (!id) {
+			throw std::runtime_error("failed to allocate texture id, the bindless texture array is full!");
+		}
+		return *id;
+	}
 
 	auto get_id() {
-		auto id = *unused_id.begin();
+		auto const id = allocate_id();
 		textures.emplace(id, nullptr);
-		unused_id.erase(id);
 		return id;
 	}
 
 	auto add_texture(const TexturePtr& texture) {
-		auto id = *unused_id.begin();
+		auto const id = allocate_id();
 		textures.emplace(id, texture);
-		unused_id.erase(id);
 		return id;
 	}
 
-	auto add_texture(TexturePtr&& texture) noexcept {
-		auto id = *unused_id.begin();
+	auto add_texture(TexturePtr&& texture) {
+		auto const id = allocate_id();
 		textures.emplace(id, std::move(texture));
-		unused_id.erase(id);
 		return id;
 	}
 
 	void delete_id(uint32_t id) {
-		unused_id.emplace(id);
+		if (!id_allocator.is_allocated(id)) {
+			return;
+		}
+		pending_writes[id].reset();  //the image view may be destroyed before the next flush
+		bound_infos[id] = {};
+		id_allocator.release(id);
 		textures.erase(id);
 	}
-};
\ No newline at end of file
+
+	void queue_descriptor_write(uint32_t id, VkSampler sampler, VkImageView image_view);
+
+	void queue_descriptor_write(uint32_t id, const TexturePtr& texture) {
+		queue_descriptor_write(id, texture->sampler, texture->image_view);
+	}
+
+	void flush_descriptor_writes(VkDevice device);
+};
@@ -3,6 +3,8 @@
 #include "../vk_util.h"
 #include "../vk_image.h"
 #include "../vk_initializers.h"
+#include "../vk_sampler_cache.h"
+#include "../vk_setup_batch.h"
 
 
 constexpr uint32_t RAMP_TEXTURE_SIZE = 256;
@@ -76,17 +78,9 @@ RampTexture::RampTexture(VulkanEngine* engine) :
 		throw std::runtime_error("failed to create texture image view!");
 	}
 
-	const VkSamplerCreateInfo sampler_info = vkinit::sampler_create_info(
-		engine->physical_device,
-		VK_FILTER_LINEAR,
-		1,
-		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+	sampler = engine->sampler_cache->get(VK_FILTER_LINEAR, 1, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
 
-	if (vkCreateSampler(engine->device, &sampler_info, nullptr, &sampler) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create texture sampler!");
-	}
-
-	engine::immediate_submit(engine, [=](VkCommandBuffer cmd) {
+	engine::SetupBatch::record(engine, QueueFamilyCategory::GRAPHICS, [=](VkCommandBuffer cmd) {
 		const VkImageMemoryBarrier2 image_memory_barrier{
 			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
 			.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
@@ -114,34 +108,14 @@ RampTexture::RampTexture(VulkanEngine* engine) :
 		vkCmdPipelineBarrier2(cmd, &dependency_info);
 		});
 
-	VkDescriptorImageInfo image_info{
-		.sampler = sampler,
-		.imageView = image_view,
-		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-	};
-
 	color_ramp_texture_id = engine->texture_manager->get_id();
-
-	const std::array descriptor_writes{
-		VkWriteDescriptorSet {
-			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-			.dstSet = engine->texture_manager->descriptor_set,
-			.dstBinding = 0,
-			.dstArrayElement = color_ramp_texture_id,
-			.descriptorCount = 1,
-			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			.pImageInfo = &image_info,
-		},
-	};
-
-	vkUpdateDescriptorSets(engine->device, descriptor_writes.size(), descriptor_writes.data(), 0, nullptr);
+	engine->texture_manager->queue_descriptor_write(color_ramp_texture_id, sampler, image_view);
 
 	create_command_buffer();
 }
 
 RampTexture::~RampTexture() {
 	engine->texture_manager->delete_id(color_ramp_texture_id);
-	vkDestroySampler(engine->device, sampler, nullptr);
 	vkDestroyImageView(engine->device, image_view, nullptr);
 	vkDestroyImage(engine->device, image, nullptr);
 	vkFreeMemory(engine->device, memory, nullptr);
@@ -91,7 +91,7 @@ struct RampTexture {
 	VulkanEngine* engine;
 	VkImage image;
 	VkImageView image_view;
-	VkSampler sampler;
+	VkSampler sampler;  //owned by engine->sampler_cache
 	VkDeviceMemory memory;
 	engine::Buffer staging_buffer;
 	VkCommandBuffer command_buffer;
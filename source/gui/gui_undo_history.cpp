@@ -0,0 +1,99 @@
+#include "gui_undo_history.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace engine {
+	void UndoHistory::begin_step() {
+		++step_depth;
+	}
+
+	void UndoHistory::end_step() {
+		assert(step_depth > 0);
+		if (--step_depth == 0 && !open_step.empty()) {
+			sealed = true;
+			push(std::exchange(open_step, {}));
+		}
+	}
+
+	void UndoHistory::record(undo::Operation operation) {
+		redo_steps.clear();
+		if (auto const edit = std::get_if<undo::EditPin>(&operation)) {
+			share_marks(edit->before);
+			share_marks(edit->after);
+			if (step_depth == 0 && !sealed && !undo_steps.empty() && undo_steps.back().size() == 1) {
+				auto const last_edit = std::get_if<undo::EditPin>(&undo_steps.back().front());
+				if (last_edit && last_edit->node_index == edit->node_index && last_edit->pin_index == edit->pin_index) {
+					last_edit->after = std::move(edit->after);
+					return;
+				}
+			}
+		}
+		if (step_depth > 0) {
+			open_step.push_back(std::move(operation));
+			return;
+		}
+		sealed = !std::holds_alternative<undo::EditPin>(operation);
+		push(undo::Step{ std::move(operation) });
+	}
+
+	void UndoHistory::seal() noexcept {
+		sealed = true;
+	}
+
+	undo::Step UndoHistory::take_undo() {
+		assert(can_undo());
+		auto step = std::move(undo_steps.back());
+		undo_steps.pop_back();
+		sealed = true;
+		return step;
+	}
+
+	undo::Step UndoHistory::take_redo() {
+		assert(can_redo());
+		auto step = std::move(redo_steps.back());
+		redo_steps.pop_back();
+		sealed = true;
+		return step;
+	}
+
+	void UndoHistory::push_undone(undo::Step step) {
+		redo_steps.push_back(std::move(step));
+	}
+
+	void UndoHistory::push_redone(undo::Step step) {
+		push(std::move(step));
+	}
+
+	void UndoHistory::clear() noexcept {
+		undo_steps.clear();
+		redo_steps.clear();
+		open_step.clear();
+		step_depth = 0;
+		sealed = true;
+		last_marks.reset();
+	}
+
+	//a ramp edit starts from the marks the previous one ended with, so consecutive steps point at one copy
+	void UndoHistory::share_marks(PinState& state) {
+		if (!state.marks) {
+			return;
+		}
+		if (last_marks && std::ranges::equal(*last_marks, *state.marks, [](auto const& a, auto const& b) {
+			return a.position == b.position && std::ranges::equal(a.color, b.color);
+			})) {
+			state.marks = last_marks;
+		}
+		else {
+			last_marks = state.marks;
+		}
+	}
+
+	void UndoHistory::push(undo::Step step) {
+		undo_steps.push_back(std::move(step));
+		if (undo_steps.size() > max_step_num) {
+			undo_steps.pop_front();
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "gui_graph_file.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <variant>
+#include <vector>
+
+namespace engine {
+	//value of an input pin as graph files store it, the marks of a color ramp are shared by the steps holding the same ramp
+	struct PinState {
+		graph_file::PinRecord record{};
+		std::shared_ptr<const std::vector<graph_file::MarkRecord>> marks;
+	};
+
+	//Operations of the undo history. Nodes are referred to by index: steps are undone and redone strictly in order, so the
+	//indices an operation was recorded with are the ones in the editor whenever it is applied again
+	namespace undo {
+		struct EditPin {
+			uint32_t node_index;
+			uint32_t pin_index;
+			PinState before;
+			PinState after;
+		};
+
+		struct AddLink {
+			graph_file::LinkRecord link;
+		};
+
+		struct RemoveLink {
+			graph_file::LinkRecord link;
+		};
+
+		//node is a single node graph taken whenever the node leaves the editor, undo and redo share it
+		struct AddNode {
+			uint32_t node_index;
+			std::shared_ptr<const graph_file::Graph> node;
+		};
+
+		struct RemoveNode {
+			uint32_t node_index;
+			std::shared_ptr<const graph_file::Graph> node;
+		};
+
+		using Operation = std::variant<EditPin, AddLink, RemoveLink, AddNode, RemoveNode>;
+
+		using Step = std::vector<Operation>;  //undone as a whole, in reverse order
+	}
+
+	//Command log of the node editor. Only what an edit changed is kept: pin edits hold the two pin records, links their
+	//four indices and removed nodes one snapshot. Edits of the same pin coalesce until seal() so a slider drag is one step,
+	//and the oldest steps are dropped past max_step_num
+	class UndoHistory {
+	public:
+		constexpr static inline size_t max_step_num = 1000;
+
+		//operations recorded until end_step() form one step, empty steps are dropped
+		void begin_step();
+
+		void end_step();
+
+		void record(undo::Operation operation);
+
+		//the next pin edit starts a new step, call once the widget being edited is released
+		void seal() noexcept;
+
+		[[nodiscard]] bool can_undo() const noexcept {
+			return !undo_steps.empty();
+		}
+
+		[[nodiscard]] bool can_redo() const noexcept {
+			return !redo_steps.empty();
+		}
+
+		//the caller applies the step and hands it back with push_undone() or push_redone()
+		[[nodiscard]] undo::Step take_undo();
+
+		[[nodiscard]] undo::Step take_redo();
+
+		void push_undone(undo::Step step);
+
+		void push_redone(undo::Step step);
+
+		void clear() noexcept;
+
+	private:
+		std::deque<undo::Step> undo_steps;
+		std::vector<undo::Step> redo_steps;
+		undo::Step open_step;
+		uint32_t step_depth = 0;
+		bool sealed = true;
+		std::shared_ptr<const std::vector<graph_file::MarkRecord>> last_marks;  //most recently recorded ramp marks
+
+		void share_marks(PinState& state);
+
+		void push(undo::Step step);
+	};
+}
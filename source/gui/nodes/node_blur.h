@@ -10,7 +10,9 @@ struct NodeBlur : NodeTypeImageBase {
 			.value = -1
 		};
 
-		NOTE(intensity, NumberInputWidgetInfo{ .min = 0, .max = 10, .speed = 0.005f, .enable_slider = false })
+		constexpr static float max_intensity = 10.0f;  //intensity textures are clamped to the pin range
+
+		NOTE(intensity, NumberInputWidgetInfo{ .min = 0, .max = max_intensity, .speed = 0.005f, .enable_slider = false })
 		FloatTextureIdData intensity {
 			.value = {
 				.number = 1.0f,
@@ -35,6 +37,11 @@ struct NodeBlur : NodeTypeImageBase {
 		};
 
 		constexpr auto static default_format = VK_FORMAT_R8G8B8A8_SRGB;
+
+		static SamplingFootprint sampling_footprint(const Info& info) {
+			const float intensity = info.intensity.value.id < 0 ? info.intensity.value.number : max_intensity;
+			return { .radius = intensity * static_cast<float>(info.samples.value) * 0.5f };
+		}
 	};
 
 	using data_type = std::shared_ptr<ImageData<ComponentGraphicPipeline<Info>>>;
@@ -67,6 +67,8 @@ struct NodeNoise : NodeTypeImageBase {
 		};
 
 		constexpr auto static default_format = VK_FORMAT_R16_UNORM;
+
+		constexpr static bool tile_transform = true;
 	};
 
 	using data_type = std::shared_ptr<ImageData<ComponentGraphicPipeline<Info>>>;
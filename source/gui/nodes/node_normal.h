@@ -37,6 +37,10 @@ struct NodeNormal : NodeTypeImageBase {
 		};
 
 		constexpr auto static default_format = VK_FORMAT_R8G8B8A8_UNORM;
+
+		static SamplingFootprint sampling_footprint(const Info& info) {
+			return { .radius = info.max_range.value };
+		}
 	};
 
 	using data_type = std::shared_ptr<ImageData<ComponentGraphicPipeline<Info>>>;
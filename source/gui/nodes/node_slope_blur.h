@@ -40,6 +40,12 @@ struct NodeSlopeBlur : NodeTypeImageBase {
 		};
 
 		constexpr auto static default_format = VK_FORMAT_R8G8B8A8_SRGB;
+
+		//the march length is intensity^2 in uv units of the whole node texture, which passes any tile halo from an
+		//intensity of about 0.4 on, so the node is not tiled
+		static SamplingFootprint sampling_footprint(const Info&) {
+			return { .global = true };
+		}
 	};
 
 	using data_type = std::shared_ptr<ImageData<ComponentGraphicPipeline<Info>>>;
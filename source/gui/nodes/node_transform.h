@@ -55,6 +55,10 @@ struct NodeTransform : NodeTypeImageBase {
 		};
 
 		constexpr auto static default_format = VK_FORMAT_R16_UNORM; 
+
+		static SamplingFootprint sampling_footprint(const Info&) {
+			return { .global = true };
+		}
 	};
 
 	using data_type = std::shared_ptr<ImageData<ComponentGraphicPipeline<Info>>>;
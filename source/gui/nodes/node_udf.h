@@ -25,6 +25,10 @@ struct NodeUdf : NodeTypeImageBase {
 		};
 
 		constexpr auto static default_format = VK_FORMAT_R16_UNORM; 
+
+		static SamplingFootprint sampling_footprint(const Info&) {
+			return { .global = true };
+		}
 	};
 
 	using data_type = std::shared_ptr<ImageData<ComponentUdf<Info>>>;
@@ -1,7 +1,53 @@
 #include "vk_engine.h"
+#include "cpu/cpu_graph_evaluator.h"
+#include <algorithm>
+#include <format>
 #include <iostream>
+#include <string_view>
 
-int main() {
+//Headless path: evaluates a saved graph on the CPU and writes every image node to out_dir, no GPU required
+static int evaluate_graph_on_cpu(const std::filesystem::path& graph_path, const std::filesystem::path& out_dir) {
+	try {
+		cpu::GraphEvaluator evaluator;
+		evaluator.load(graph_path);
+		evaluator.evaluate();
+		std::filesystem::create_directories(out_dir);
+		for (size_t i = 0; i < evaluator.node_count(); ++i) {
+			if (evaluator.image(i)) {
+				auto file_name = std::format("{}_{}.png", i, evaluator.node_name(i));
+				std::ranges::replace(file_name, ' ', '_');
+				evaluator.save(i, out_dir / file_name);
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+//Rewrites a graph between .txg and .txgb, the formats follow the extensions
+static int convert_graph(const std::filesystem::path& source_path, const std::filesystem::path& destination_path) {
+	try {
+		graph_file::convert(source_path, destination_path);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc == 4 && std::string_view(argv[1]) == "--cpu") {
+		return evaluate_graph_on_cpu(argv[2], argv[3]);
+	}
+	if (argc == 4 && std::string_view(argv[1]) == "--convert") {
+		return convert_graph(argv[2], argv[3]);
+	}
 
 	try {
 		VulkanEngine app;
@@ -13,4 +59,4 @@ int main() {
 	}
 
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
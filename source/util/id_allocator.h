@@ -0,0 +1,83 @@
+#pragma once
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//Lowest-free-first id allocator over a two level bitmap. A set bit in words marks a free id,
+//a set bit in summary marks a word that still has a free id, so allocate() and release() touch
+//one summary word and one id word: O(1) for up to 64 * 64 ids and deterministic across runs.
+//grow() appends free ids without moving the allocated ones, larger capacities scan one summary word per 4096 ids.
+class IdAllocator {
+	std::vector<uint64_t> words;
+	std::vector<uint64_t> summary;
+	uint32_t id_capacity = 0;
+	uint32_t allocated_num = 0;
+
+	constexpr static uint32_t word_bits = 64;
+
+public:
+	explicit IdAllocator(const uint32_t capacity = 0) : id_capacity(capacity) {
+		words.assign((capacity + word_bits - 1) / word_bits, ~uint64_t{ 0 });
+		if (const uint32_t tail_bits = capacity % word_bits) {
+			words.back() = (uint64_t{ 1 } << tail_bits) - 1;
+		}
+		summary.assign((words.size() + word_bits - 1) / word_bits, 0);
+		for (size_t w = 0; w < words.size(); ++w) {
+			summary[w / word_bits] |= uint64_t{ 1 } << (w % word_bits);
+		}
+	}
+
+	[[nodiscard]] std::optional<uint32_t> allocate() {
+		for (size_t s = 0; s < summary.size(); ++s) {
+			if (summary[s] == 0) {
+				continue;
+			}
+			const size_t w = s * word_bits + std::countr_zero(summary[s]);
+			const auto id = static_cast<uint32_t>(w * word_bits + std::countr_zero(words[w]));
+			words[w] &= words[w] - 1;  //clear the lowest set bit
+			if (words[w] == 0) {
+				summary[s] &= ~(uint64_t{ 1 } << (w % word_bits));
+			}
+			++allocated_num;
+			return id;
+		}
+		return std::nullopt;
+	}
+
+	void release(const uint32_t id) {
+		assert(is_allocated(id));
+		const size_t w = id / word_bits;
+		words[w] |= uint64_t{ 1 } << (id % word_bits);
+		summary[w / word_bits] |= uint64_t{ 1 } << (w % word_bits);
+		--allocated_num;
+	}
+
+	void grow(const uint32_t new_capacity) {
+		assert(new_capacity >= id_capacity);
+		words.resize((new_capacity + word_bits - 1) / word_bits, 0);
+		for (uint32_t id = id_capacity; id < new_capacity; ++id) {
+			words[id / word_bits] |= uint64_t{ 1 } << (id % word_bits);
+		}
+		summary.resize((words.size() + word_bits - 1) / word_bits, 0);
+		for (size_t w = id_capacity / word_bits; w < words.size(); ++w) {
+			if (words[w] != 0) {
+				summary[w / word_bits] |= uint64_t{ 1 } << (w % word_bits);
+			}
+		}
+		id_capacity = new_capacity;
+	}
+
+	[[nodiscard]] bool is_allocated(const uint32_t id) const noexcept {
+		return id < id_capacity && (words[id / word_bits] >> (id % word_bits) & 1) == 0;
+	}
+
+	[[nodiscard]] uint32_t capacity() const noexcept {
+		return id_capacity;
+	}
+
+	[[nodiscard]] uint32_t size() const noexcept {
+		return allocated_num;
+	}
+};
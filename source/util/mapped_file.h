@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Read-only memory mapping of a whole file. The pages are backed by the file itself, so reading
+//them costs no copy into a heap buffer and the mapping goes away with the object.
+//An empty file maps to an empty span.
+class MappedFile {
+	const std::byte* view = nullptr;
+	size_t view_size = 0;
+
+	void unmap() noexcept {
+		if (view) {
+#if defined(_WIN32)
+			UnmapViewOfFile(view);
+#else
+			munmap(const_cast<std::byte*>(view), view_size);
+#endif
+		}
+		view = nullptr;
+		view_size = 0;
+	}
+
+public:
+	explicit MappedFile(const std::filesystem::path& file_path) {
+#if defined(_WIN32)
+		const HANDLE file = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("failed to open file " + file_path.string() + "!");
+		}
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size)) {
+			CloseHandle(file);
+			throw std::runtime_error("failed to get size of file " + file_path.string() + "!");
+		}
+		view_size = static_cast<size_t>(file_size.QuadPart);
+		if (view_size > 0) {
+			const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);  //the mapping keeps the file open
+			if (!mapping) {
+				throw std::runtime_error("failed to map file " + file_path.string() + "!");
+			}
+			view = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);  //and the view keeps the mapping alive
+		}
+		else {
+			CloseHandle(file);
+		}
+#else
+		const int file = open(file_path.c_str(), O_RDONLY);
+		if (file < 0) {
+			throw std::runtime_error("failed to open file " + file_path.string() + "!");
+		}
+		struct stat file_stat {};
+		if (fstat(file, &file_stat) != 0) {
+			close(file);
+			throw std::runtime_error("failed to get size of file " + file_path.string() + "!");
+		}
+		view_size = static_cast<size_t>(file_stat.st_size);
+		if (view_size > 0) {
+			void* address = mmap(nullptr, view_size, PROT_READ, MAP_PRIVATE, file, 0);
+			view = address == MAP_FAILED ? nullptr : static_cast<const std::byte*>(address);
+		}
+		close(file);  //the mapping holds its own reference to the file
+#endif
+		if (view_size > 0 && !view) {
+			view_size = 0;
+			throw std::runtime_error("failed to map file " + file_path.string() + "!");
+		}
+	}
+
+	~MappedFile() {
+		unmap();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept :
+		view(std::exchange(other.view, nullptr)),
+		view_size(std::exchange(other.view_size, 0)) {}
+
+	MappedFile& operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			view = std::exchange(other.view, nullptr);
+			view_size = std::exchange(other.view_size, 0);
+		}
+		return *this;
+	}
+
+	[[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+		return { view, view_size };
+	}
+
+	[[nodiscard]] size_t size() const noexcept {
+		return view_size;
+	}
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+//Hands out ranges of a fixed size ring in FIFO order. Every range is tagged with the timeline value
+//that retires it and ranges are released in allocation order, so the free space is always one
+//contiguous run from head up to the oldest live range, possibly wrapping around the end of the ring.
+class RingAllocator {
+	struct Range {
+		uint64_t begin;
+		uint64_t value;
+	};
+
+	std::deque<Range> ranges;
+	uint64_t ring_capacity;
+	uint64_t head = 0;
+
+public:
+	explicit RingAllocator(const uint64_t capacity) : ring_capacity(capacity) {}
+
+	[[nodiscard]] std::optional<uint64_t> allocate(const uint64_t size, const uint64_t alignment, const uint64_t value) {
+		std::optional<uint64_t> begin;
+		if (ranges.empty()) {
+			if (size <= ring_capacity) {
+				begin = 0;  //nothing is live, start over at the front
+			}
+		}
+		else {
+			const uint64_t tail = ranges.front().begin;
+			const uint64_t offset = (head + alignment - 1) / alignment * alignment;
+			if (head > tail) {
+				//free space is [head, capacity) followed by [0, tail)
+				if (offset + size <= ring_capacity) {
+					begin = offset;
+				}
+				else if (size <= tail) {
+					begin = 0;
+				}
+			}
+			else if (head < tail && offset + size <= tail) {
+				begin = offset;
+			}
+			//head == tail while ranges are live means the ring is full
+		}
+
+		if (begin) {
+			head = *begin + size;
+			ranges.push_back({ *begin, value });
+		}
+		return begin;
+	}
+
+	void release(const uint64_t completed_value) {
+		while (!ranges.empty() && ranges.front().value <= completed_value) {
+			ranges.pop_front();
+		}
+	}
+
+	//value to wait for before the next range can be freed
+	[[nodiscard]] std::optional<uint64_t> oldest_value() const {
+		return ranges.empty() ? std::nullopt : std::optional(ranges.front().value);
+	}
+
+	[[nodiscard]] uint64_t capacity() const noexcept {
+		return ring_capacity;
+	}
+
+	[[nodiscard]] size_t size() const noexcept {
+		return ranges.size();
+	}
+};
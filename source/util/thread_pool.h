@@ -0,0 +1,89 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "util.h"
+
+//Fixed-size pool of std::jthread workers consuming a FIFO job queue
+class ThreadPool {
+	std::vector<std::jthread> workers;
+	std::deque<std::move_only_function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable_any job_available;
+	std::condition_variable_any all_done;
+	size_t busy_count = 0;
+
+	void worker_loop(const std::stop_token& stop_token) {
+		while (true) {
+			std::move_only_function<void()> job;
+			{
+				std::unique_lock lock(mutex);
+				if (!job_available.wait(lock, stop_token, [&] { return !jobs.empty(); })) {
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop_front();
+				++busy_count;
+			}
+			job();
+			{
+				std::scoped_lock lock(mutex);
+				--busy_count;
+			}
+			all_done.notify_all();
+		}
+	}
+
+public:
+	explicit ThreadPool(size_t thread_count = std::max(1u, std::thread::hardware_concurrency())) {
+		workers.reserve(thread_count);
+		for (size_t i = 0; i < thread_count; ++i) {
+			workers.emplace_back([this](std::stop_token stop_token) { worker_loop(stop_token); });
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	//pending jobs are drained before the workers are joined
+	~ThreadPool() {
+		wait_idle();
+		for (auto& worker : workers) {
+			worker.request_stop();
+		}
+		job_available.notify_all();
+		workers.clear();  //join while the mutex and condition variables the workers wait on are still alive
+	}
+
+	template <std::invocable Func>
+	auto submit(Func&& func) -> std::future<std::invoke_result_t<Func>> {
+		std::packaged_task<std::invoke_result_t<Func>()> task(FWD(func));
+		auto future = task.get_future();
+		{
+			std::scoped_lock lock(mutex);
+			jobs.emplace_back(std::move(task));
+		}
+		job_available.notify_one();
+		return future;
+	}
+
+	void wait_idle() {
+		std::unique_lock lock(mutex);
+		all_done.wait(lock, [&] { return jobs.empty() && busy_count == 0; });
+	}
+
+	[[nodiscard]] size_t size() const noexcept {
+		return workers.size();
+	}
+
+	[[nodiscard]] size_t pending() {
+		std::scoped_lock lock(mutex);
+		return jobs.size() + busy_count;
+	}
+};
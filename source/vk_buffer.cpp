@@ -24,10 +24,14 @@ namespace vk_base {
 			throw std::runtime_error("vma failed to create buffer!");
 		}
 		mapped_buffer = allocation_info.pMappedData;
+		memory_category = engine::MemoryStats::classify_buffer(buffer_usage, preferred_memory_type);
+		allocation_size = allocation_info.size;
+		engine::MemoryStats::track(memory_category, allocation_size);
 	}
 
 	Buffer::~Buffer() {
 		if (buffer != VK_NULL_HANDLE) {
+			engine::MemoryStats::untrack(memory_category, allocation_size);
 			vmaDestroyBuffer(vma_allocator, buffer, allocation);
 			buffer = VK_NULL_HANDLE;
 		}
@@ -46,6 +50,7 @@ namespace engine {
 		if (buffer_description & 0x00000001) {
 			((buffer_description == SWAPCHAIN_DEPENDENT_BIT) ? engine->swap_chain_deletion_queue : engine->main_deletion_queue).push_function([=] {
 				if (p_buffer->buffer != VK_NULL_HANDLE) {
+					MemoryStats::untrack(p_buffer->memory_category, p_buffer->allocation_size);
 					vmaDestroyBuffer(engine->vma_allocator, p_buffer->buffer, p_buffer->allocation);
 					p_buffer->buffer = VK_NULL_HANDLE;
 				}
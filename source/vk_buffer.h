@@ -1,6 +1,7 @@
 #pragma once
 #include "vk_types.h"
 #include "vk_memory.h"
+#include "vk_memory_stats.h"
 
 class VulkanEngine;
 
@@ -12,6 +13,8 @@ namespace vk_base {
 		VmaAllocation allocation;
 		VkDeviceSize size = 0;
 		void* mapped_buffer = nullptr;
+		MemoryCategory memory_category = MemoryCategory::OTHER;
+		VkDeviceSize allocation_size = 0;
 
 		Buffer(VmaAllocator vma_allocator, VkBufferUsageFlags buffer_usage, PreferredMemoryType preferred_memory_type, VkDeviceSize size);
 
@@ -6,6 +6,18 @@
 #include "vk_camera.h"
 #include "vk_gui.h"
 #include "vk_memory.h"
+#include "vk_texture_exporter.h"
+#include "vk_environment.h"
+#include "vk_sampler_cache.h"
+#include "vk_pipeline_cache.h"
+#include "vk_shader_cache.h"
+#include "vk_shader_source_watcher.h"
+#include "vk_texture_pool.h"
+#include "vk_upload_ring.h"
+#include "vk_uniform_arena.h"
+#include "vk_parameter_ring.h"
+#include "vk_memory_stats.h"
+#include "util/thread_pool.h"
 #include "gui/gui_node_editor.h"
 #include "gui/ImGuiFileDialog.h"
 
@@ -14,6 +26,8 @@
 #include <set>
 #include <filesystem>
 #include <chrono>
+#include <future>
+#include <optional>
 #include <algorithm>
 #include <iostream>
 
@@ -126,11 +140,18 @@ void VulkanEngine::framebuffer_resize_callback(GLFWwindow* window, int width, in
 }
 
 void VulkanEngine::init_vulkan() {
+	begin_environment_decode();
 	create_instance();
 	setup_debug_messenger();
 	create_surface();
 	pick_physical_device();
 	create_logical_device();
+	create_pipeline_cache();
+	create_shader_cache();
+	create_shader_source_watcher();
+	create_memory_stats();
+	create_sampler_cache();
+	create_texture_pool();
 
 	create_swap_chain();//recreateSwapChain
 	create_swap_chain_image_views();//recreateSwapChain
@@ -138,9 +159,14 @@ void VulkanEngine::init_vulkan() {
 	create_sync_objects();
 
 	create_command_pool();
+	create_upload_ring();
+	create_uniform_arena();
+	create_parameter_ring();
 
 	create_descriptor_pool();
 	create_texture_manager();
+	create_texture_exporter();
+	create_environment_baker();
 	parse_material_info();
 	create_descriptor_set_layouts();
 
@@ -166,6 +192,7 @@ void VulkanEngine::init_vulkan() {
 void VulkanEngine::main_loop() {
 	//bool running = true;
 	double last_time = 0.0;
+	uint32_t frame_index = 0;
 
 	while (!glfwWindowShouldClose(window)) {
 		const double time = glfwGetTime();
@@ -173,6 +200,13 @@ void VulkanEngine::main_loop() {
 		if (delta_time >= MAX_PERIOD) {
 			last_time = time;
 			glfwPollEvents();
+			texture_exporter->update();
+			memory_stats->update(frame_index++);
+			texture_pool->update();
+			upload_ring->update();
+			parameter_ring->update();
+			shader_source_watcher->poll(frame_index);
+			shader_cache->poll(frame_index);
 			draw_frame();
 		}
 	}
@@ -332,6 +366,7 @@ void VulkanEngine::create_logical_device() {
 		queue_family_indices.graphics_family.value(),
 		queue_family_indices.present_family.value(),
 		queue_family_indices.compute_family.value(),
+		queue_family_indices.transfer_family.value(),
 	};
 
 	float queue_priority = 1.0f;
@@ -349,6 +384,7 @@ void VulkanEngine::create_logical_device() {
 		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
 		.pNext = nullptr,
 		.synchronization2 = VK_TRUE,
+		.dynamicRendering = VK_TRUE,
 	};
 
 	VkPhysicalDeviceVulkan12Features vk12_features{
@@ -366,15 +402,22 @@ void VulkanEngine::create_logical_device() {
 	VkPhysicalDeviceFeatures device_features{
 		.sampleRateShading = VK_TRUE,
 		.samplerAnisotropy = VK_TRUE,
+		.shaderStorageImageWriteWithoutFormat = VK_TRUE,  //compute nodes write every node format through one pipeline
 	};
 
+	std::vector<const char*> device_extensions(DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
+	memory_budget_supported = check_device_extension_support(physical_device, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (memory_budget_supported) {
+		device_extensions.emplace_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
 	VkDeviceCreateInfo device_create_info{
 		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
 		.pNext = &vk12_features,
 		.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
 		.pQueueCreateInfos = queueCreateInfos.data(),
-		.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size()),
-		.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data(),
+		.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size()),
+		.ppEnabledExtensionNames = device_extensions.data(),
 		.pEnabledFeatures = &device_features,
 	};
 
@@ -393,8 +436,10 @@ void VulkanEngine::create_logical_device() {
 	vkGetDeviceQueue(device, queue_family_indices.graphics_family.value(), 0, &graphics_queue);
 	vkGetDeviceQueue(device, queue_family_indices.compute_family.value(), 0, &compute_queue);
 	vkGetDeviceQueue(device, queue_family_indices.present_family.value(), 0, &present_queue);
+	vkGetDeviceQueue(device, queue_family_indices.transfer_family.value(), 0, &transfer_queue);
 
 	VmaAllocatorCreateInfo allocator_create_info{
+		.flags = memory_budget_supported ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0u,
 		.physicalDevice = physical_device,
 		.device = device,
 		.instance = instance,
@@ -619,10 +664,26 @@ void VulkanEngine::create_swap_chain_image_views() {
 
 
 
-void VulkanEngine::parse_material_info() {
+struct VulkanEngine::PendingEnvironment {
+	ThreadPool workers;  //constructed first and destroyed last, jobs still queued when init fails are drained
+	std::optional<engine::PendingCubemap> cubemap;  //either six faces
+	std::future<engine::HdrImage> equirectangular_image;  //or one equirectangular image
 
-	//load_gltf();
+	explicit PendingEnvironment(const json& env_material_info_json) {
+		if (env_material_info_json["type"].get<std::string>() == "cubemap") {
+			cubemap.emplace(workers, std::vector<std::vector<std::string>>{ env_material_info_json["filePaths"].get<std::vector<std::string>>() });
+		}
+		else {
+			equirectangular_image = workers.submit([file_path = env_material_info_json["filePath"].get<std::string>()] {
+				return engine::HdrImage::load(file_path);
+				});
+		}
+	}
+};
 
+//Decoding the HDRi takes longer than creating the device, so it is queued before anything else in init_vulkan() and
+//parse_material_info() only waits for what is left. The lighting inputs are derived from it on the GPU
+void VulkanEngine::begin_environment_decode() {
 	auto env_material_info_json = R"(
 	{
 		"type": "cubemap",
@@ -633,66 +694,40 @@ void VulkanEngine::parse_material_info() {
 			"assets/textures/HDRi/output_neg_y.hdr",
 			"assets/textures/HDRi/output_pos_z.hdr",
 			"assets/textures/HDRi/output_neg_z.hdr"
-		],
-		"irradianceMapPaths": [
-			"assets/textures/HDRi/irradiance_map/irradiance_map_pos_x.exr",
-			"assets/textures/HDRi/irradiance_map/irradiance_map_neg_x.exr",
-			"assets/textures/HDRi/irradiance_map/irradiance_map_pos_y.exr",
-			"assets/textures/HDRi/irradiance_map/irradiance_map_neg_y.exr",
-			"assets/textures/HDRi/irradiance_map/irradiance_map_pos_z.exr",
-			"assets/textures/HDRi/irradiance_map/irradiance_map_neg_z.exr"
-		],
-		"prefilteredMapPaths": [
-			[
-				"assets/textures/HDRi/output_pos_x.hdr",
-				"assets/textures/HDRi/output_neg_x.hdr",
-				"assets/textures/HDRi/output_pos_y.hdr",
-				"assets/textures/HDRi/output_neg_y.hdr",
-				"assets/textures/HDRi/output_pos_z.hdr",
-				"assets/textures/HDRi/output_neg_z.hdr"
-			], [	
-				"assets/textures/HDRi/prefiltered_map/512@0.2/pre-filtered_map_pos_x.exr",
-				"assets/textures/HDRi/prefiltered_map/512@0.2/pre-filtered_map_neg_x.exr",
-				"assets/textures/HDRi/prefiltered_map/512@0.2/pre-filtered_map_pos_y.exr",
-				"assets/textures/HDRi/prefiltered_map/512@0.2/pre-filtered_map_neg_y.exr",
-				"assets/textures/HDRi/prefiltered_map/512@0.2/pre-filtered_map_pos_z.exr",
-				"assets/textures/HDRi/prefiltered_map/512@0.2/pre-filtered_map_neg_z.exr"
-			], [
-				"assets/textures/HDRi/prefiltered_map/256@0.4/pre-filtered_map_pos_x.exr",
-				"assets/textures/HDRi/prefiltered_map/256@0.4/pre-filtered_map_neg_x.exr",
-				"assets/textures/HDRi/prefiltered_map/256@0.4/pre-filtered_map_pos_y.exr",
-				"assets/textures/HDRi/prefiltered_map/256@0.4/pre-filtered_map_neg_y.exr",
-				"assets/textures/HDRi/prefiltered_map/256@0.4/pre-filtered_map_pos_z.exr",
-				"assets/textures/HDRi/prefiltered_map/256@0.4/pre-filtered_map_neg_z.exr"
-			], [
-				"assets/textures/HDRi/prefiltered_map/128@0.6/pre-filtered_map_pos_x.exr",
-				"assets/textures/HDRi/prefiltered_map/128@0.6/pre-filtered_map_neg_x.exr",
-				"assets/textures/HDRi/prefiltered_map/128@0.6/pre-filtered_map_pos_y.exr",
-				"assets/textures/HDRi/prefiltered_map/128@0.6/pre-filtered_map_neg_y.exr",
-				"assets/textures/HDRi/prefiltered_map/128@0.6/pre-filtered_map_pos_z.exr",
-				"assets/textures/HDRi/prefiltered_map/128@0.6/pre-filtered_map_neg_z.exr"
-			], [
-				"assets/textures/HDRi/prefiltered_map/64@0.8/pre-filtered_map_pos_x.exr",
-				"assets/textures/HDRi/prefiltered_map/64@0.8/pre-filtered_map_neg_x.exr",
-				"assets/textures/HDRi/prefiltered_map/64@0.8/pre-filtered_map_pos_y.exr",
-				"assets/textures/HDRi/prefiltered_map/64@0.8/pre-filtered_map_neg_y.exr",
-				"assets/textures/HDRi/prefiltered_map/64@0.8/pre-filtered_map_pos_z.exr",
-				"assets/textures/HDRi/prefiltered_map/64@0.8/pre-filtered_map_neg_z.exr"
-			], [
-				"assets/textures/HDRi/prefiltered_map/32@1.0/pre-filtered_map_pos_x.exr",
-				"assets/textures/HDRi/prefiltered_map/32@1.0/pre-filtered_map_neg_x.exr",
-				"assets/textures/HDRi/prefiltered_map/32@1.0/pre-filtered_map_pos_y.exr",
-				"assets/textures/HDRi/prefiltered_map/32@1.0/pre-filtered_map_neg_y.exr",
-				"assets/textures/HDRi/prefiltered_map/32@1.0/pre-filtered_map_pos_z.exr",
-				"assets/textures/HDRi/prefiltered_map/32@1.0/pre-filtered_map_neg_z.exr"
-			]
-		],
-		"BRDF_2D_LUT": "assets/textures/HDRi/BRDF_2D_LUT/BRDF_2D_LUT.png"
+		]
 	}
 	)"_json;
 
+	auto const type = env_material_info_json["type"].get<std::string>();
+	if (type != "cubemap" && type != "equirectangular") {
+		return;
+	}
+	pending_environment = std::make_unique<PendingEnvironment>(env_material_info_json);
+}
+
+//swaps in an equirectangular .hdr or .exr at the texture ids the pipelines were specialized with, the BRDF LUT is kept
+void VulkanEngine::load_environment(const std::string& file_path) {
+	engine::MemoryCategoryScope memory_scope(MemoryCategory::HDRI);
+	auto const cubemap = environment_baker->project_equirectangular(engine::HdrImage::load(file_path));
+	auto environment_maps = environment_baker->bake(cubemap);
+
+	vkDeviceWaitIdle(device);  //frames in flight may still sample the previous maps
+
+	auto const replace_texture = [this](const uint32_t id, const TexturePtr& texture) {
+		texture_manager->textures[id] = texture;
+		texture_manager->queue_descriptor_write(id, texture);
+	};
+	replace_texture(std::get<HDRiMaterialPtr>(materials["env_light"])->paras.base_color_texture_id, cubemap);
+	replace_texture(init_material_preview_ubo.irradiance_map_id, environment_maps.irradiance_map);
+	replace_texture(init_material_preview_ubo.prefiltered_map_id, environment_maps.prefiltered_map);
+}
+
+void VulkanEngine::parse_material_info() {
+
+	//load_gltf();
 
-	if (env_material_info_json["type"].get<std::string>() == "cubemap") {
+	if (pending_environment) {
+		engine::MemoryCategoryScope memory_scope(MemoryCategory::HDRI);
 		materials.emplace("env_light", std::make_shared<HDRiMaterial>());
 		auto const env_mat = *std::get_if<HDRiMaterialPtr>(&materials["env_light"]);
 		std::array spvFilePaths = {
@@ -702,23 +737,25 @@ void VulkanEngine::parse_material_info() {
 		env_mat->shaders = engine::Shader::createFromSpv(this, spvFilePaths);
 		//envMat->textureArrayIndex.emplace("cubemap", loaded_textures.size());
 		//envMat->paras.baseColorTextureID = loaded_textures.size();
-		env_mat->paras.base_color_texture_id = texture_manager->add_texture(
-			engine::Texture::load_cubemap_texture(this,
-				env_material_info_json["filePaths"].get<std::vector<std::string>>()));
+		//environment textures have no release callback so load_environment() can replace them
+		auto const cubemap = pending_environment->cubemap ?
+			pending_environment->cubemap->create_texture(this, TEMP_BIT) :
+			environment_baker->project_equirectangular(pending_environment->equirectangular_image.get());
+		pending_environment.reset();
+		auto environment_maps = environment_baker->bake(cubemap);
+
+		env_mat->paras.base_color_texture_id = texture_manager->add_texture(cubemap);
 		env_mat->textureArrayIndex.emplace("cubemap", env_mat->paras.base_color_texture_id);
-
-		init_material_preview_ubo.irradiance_map_id = texture_manager->add_texture(
-			engine::Texture::load_cubemap_texture(this,
-				env_material_info_json["irradianceMapPaths"].get<std::vector<std::string>>()));
-
-		init_material_preview_ubo.prefiltered_map_id = texture_manager->add_texture(
-			engine::Texture::load_prefiltered_map_texture(this,
-				env_material_info_json["prefilteredMapPaths"].get<std::vector<std::vector<std::string>>>()));
-
-		init_material_preview_ubo.brdf_LUT_id = texture_manager->add_texture(
-			engine::Texture::load_2d_texture(this,
-				env_material_info_json["BRDF_2D_LUT"].get<std::string>(),
-				false));
+		init_material_preview_ubo.irradiance_map_id = texture_manager->add_texture(std::move(environment_maps.irradiance_map));
+		init_material_preview_ubo.prefiltered_map_id = texture_manager->add_texture(std::move(environment_maps.prefiltered_map));
+		init_material_preview_ubo.brdf_LUT_id = texture_manager->add_texture(environment_baker->bake_brdf_lut());
+
+		main_deletion_queue.push_function([this, env_mat] {
+			for (auto const id : { env_mat->paras.base_color_texture_id, init_material_preview_ubo.irradiance_map_id,
+				init_material_preview_ubo.prefiltered_map_id, init_material_preview_ubo.brdf_LUT_id }) {
+				texture_manager->textures.erase(id);
+			}
+			});
 	}
 
 	//for (auto const& mat : loaded_materials) {
@@ -1137,10 +1174,94 @@ void VulkanEngine::create_uniform_buffers() {
 		SWAPCHAIN_INDEPENDENT_BIT);
 }
 
+void VulkanEngine::create_memory_stats() {
+	memory_stats = std::make_shared<engine::MemoryStats>(this);
+}
+
+void VulkanEngine::create_pipeline_cache() {
+	pipeline_cache = std::make_shared<engine::PipelineCache>(this, pipeline_cache_path);
+
+	main_deletion_queue.push_function([&cache = pipeline_cache] {
+		cache.reset();
+		});
+}
+
+void VulkanEngine::create_shader_cache() {
+	shader_cache = std::make_shared<engine::ShaderModuleCache>(this);
+
+	main_deletion_queue.push_function([&cache = shader_cache] {
+		cache.reset();
+		});
+}
+
+void VulkanEngine::create_shader_source_watcher() {
+	shader_source_watcher = std::make_shared<engine::ShaderSourceWatcher>(glsl_shader_directory, spirv_shader_directory);
+
+	main_deletion_queue.push_function([&watcher = shader_source_watcher] {
+		watcher.reset();  //waits for a compile in progress
+		});
+}
+
+void VulkanEngine::create_sampler_cache() {
+	sampler_cache = std::make_shared<engine::SamplerCache>(this);
+
+	main_deletion_queue.push_function([&cache = sampler_cache] {
+		cache.reset();
+		});
+}
+
+void VulkanEngine::create_texture_pool() {
+	texture_pool = std::make_shared<engine::TexturePool>(this);
+
+	main_deletion_queue.push_function([&pool = texture_pool] {
+		pool.reset();
+		});
+}
+
+void VulkanEngine::create_upload_ring() {
+	upload_ring = std::make_shared<engine::UploadRing>(this);
+
+	main_deletion_queue.push_function([&ring = upload_ring] {
+		ring.reset();
+		});
+}
+
+void VulkanEngine::create_uniform_arena() {
+	uniform_arena = std::make_shared<engine::UniformArena>(this);
+
+	main_deletion_queue.push_function([&arena = uniform_arena] {
+		arena.reset();
+		});
+}
+
+void VulkanEngine::create_parameter_ring() {
+	parameter_ring = std::make_shared<engine::ParameterRing>(this);
+
+	main_deletion_queue.push_function([&ring = parameter_ring] {
+		ring.reset();
+		});
+}
+
 void VulkanEngine::create_texture_manager() {
 	texture_manager = std::make_shared<TextureManager>(this, max_bindless_textures);
 }
 
+void VulkanEngine::create_texture_exporter() {
+	texture_exporter = std::make_shared<engine::TextureExporter>(this);
+
+	main_deletion_queue.push_function([&exporter = texture_exporter] {
+		exporter.reset();
+		});
+}
+
+void VulkanEngine::create_environment_baker() {
+	environment_baker = std::make_shared<engine::EnvironmentBaker>(this);
+
+	main_deletion_queue.push_function([&baker = environment_baker] {
+		baker.reset();
+		});
+}
+
 void VulkanEngine::create_descriptor_pool() {
 	const uint32_t descriptorSize = swapchain_image_count * 300;
 	std::vector<VkDescriptorPoolSize> poolSizes = {
@@ -1167,6 +1288,8 @@ void VulkanEngine::create_descriptor_pool() {
 	constexpr uint32_t descriptor_size = 2000;
 	std::array pool_sizes = {
 		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, descriptor_size },
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, max_node_types },
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, descriptor_size },
 		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, max_bindless_textures },
 	};
 
@@ -1426,29 +1549,7 @@ void VulkanEngine::create_sync_objects() {
 }
 
 void VulkanEngine::update_image_descriptor(const TexturePtr& texture, uint32_t index) const {
-	VkDescriptorImageInfo descriptor_image_info{
-			.sampler = texture->sampler,
-			.imageView = texture->image_view,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-	};
-
-	const std::array texture_array_writes{
-		VkWriteDescriptorSet{
-			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-			.dstSet = texture_manager->descriptor_set,
-			.dstBinding = 0,
-			.dstArrayElement = index,
-			.descriptorCount = 1,
-			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			.pImageInfo = &descriptor_image_info,
-		},
-	};
-
-	vkUpdateDescriptorSets(device,
-		texture_array_writes.size(),
-		texture_array_writes.data(),
-		0,
-		nullptr);
+	texture_manager->queue_descriptor_write(index, texture);
 }
 
 void VulkanEngine::init_imgui() {
@@ -1471,6 +1572,69 @@ void VulkanEngine::update_uniform_buffer(const uint32_t current_image) const {
 	uniform_buffers[current_image]->copy_from_host(&ubo);
 }
 
+void VulkanEngine::draw_memory_window(bool* p_open) const {
+	constexpr auto to_mib = [](const VkDeviceSize bytes) {
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	};
+
+	if (ImGui::Begin(" " ICON_FA_MEMORY " Memory", p_open, ImGuiWindowFlags_NoDocking)) {
+		ImGui::Text(memory_budget_supported ? "Budgets from VK_EXT_memory_budget" : "VK_EXT_memory_budget unavailable, budgets are estimated");
+
+		constexpr auto table_flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+		if (ImGui::BeginTable("Heaps", 4, table_flags)) {
+			ImGui::TableSetupColumn("Heap");
+			ImGui::TableSetupColumn("Usage / Budget");
+			ImGui::TableSetupColumn("VMA Allocations");
+			ImGui::TableSetupColumn("");
+			ImGui::TableHeadersRow();
+			auto const& heaps = memory_stats->heap_budgets();
+			for (size_t i = 0; i < heaps.size(); ++i) {
+				auto const& heap = heaps[i];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%zu %s", i, heap.device_local ? "VRAM" : "RAM");
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f / %.1f MiB", to_mib(heap.usage), to_mib(heap.budget));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f MiB (%u)", to_mib(heap.allocation_bytes), heap.allocation_num);
+				ImGui::TableNextColumn();
+				ImGui::ProgressBar(heap.budget ? static_cast<float>(heap.usage) / static_cast<float>(heap.budget) : 0.0f, ImVec2(-FLT_MIN, 0.0f));
+			}
+			ImGui::EndTable();
+		}
+
+		if (ImGui::BeginTable("Categories", 3, table_flags)) {
+			ImGui::TableSetupColumn("Category");
+			ImGui::TableSetupColumn("Size");
+			ImGui::TableSetupColumn("Allocations");
+			ImGui::TableHeadersRow();
+			for (size_t i = 0; i < memory_category_num; ++i) {
+				auto const [bytes, allocation_num] = engine::MemoryStats::category_usage(static_cast<MemoryCategory>(i));
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", memory_category_names[i].data());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f MiB", to_mib(bytes));
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", allocation_num);
+			}
+			ImGui::EndTable();
+		}
+		ImGui::Text("Texture pool: %zu idle (%.1f MiB)", texture_pool->idle_count(), to_mib(texture_pool->idle_bytes()));
+		ImGui::Text("Parameter arena: %.2f / %.1f MiB", to_mib(uniform_arena->used_bytes()), to_mib(engine::UniformArena::arena_size));
+		ImGui::Text("Node textures: %.1f MiB resident, %zu evicted", to_mib(node_editor->get_resident_bytes()), node_editor->get_evicted_num());
+		int budget_mib = static_cast<int>(node_editor->get_residency_budget() >> 20);
+		if (ImGui::DragInt("Node texture budget (MiB)", &budget_mib, 16.0f, 64, 1 << 16)) {
+			node_editor->set_residency_budget(static_cast<VkDeviceSize>(budget_mib) << 20);
+		}
+
+		if (ImGui::Button(" " ICON_FA_FILE_EXPORT " Export Snapshot")) {
+			ImGuiFileDialog::Instance()->OpenDialog("ExportMemoryDlgKey", "Export Memory Snapshot", ".json", ".", 1, nullptr, ImGuiFileDialogFlags_ConfirmOverwrite);
+		}
+	}
+	ImGui::End();
+}
+
 void VulkanEngine::imgui_render(const uint32_t image_index) {
 	const ImGuiIO& io = ImGui::GetIO();
 
@@ -1499,9 +1663,12 @@ void VulkanEngine::imgui_render(const uint32_t image_index) {
 	ImGui::DockSpace(dock_space_id, ImVec2(0.0f, 0.0f), ImGuiDockNodeFlags_PassthruCentralNode);
 
 	static bool first_time = true;
+	static uint32_t tiled_export_size = 0;
+	static bool show_memory_window = false;
 	if (first_time) {
 		ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByTypeDir, "", ImVec4(0.5f, 1.0f, 0.9f, 0.9f), ICON_FA_FOLDER);
 		ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByExtention, ".txg", ImVec4(1.0f, 1.0f, 0.0f, 0.9f), ICON_FA_CODE_BRANCH);
+		ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByExtention, ".txgb", ImVec4(1.0f, 1.0f, 0.0f, 0.9f), ICON_FA_CODE_BRANCH);
 	}
 
 	if (ImGui::BeginMenuBar()) {
@@ -1510,20 +1677,93 @@ void VulkanEngine::imgui_render(const uint32_t image_index) {
 				node_editor->clear();
 			}
 			if (ImGui::MenuItem(" " ICON_FA_FOLDER_OPEN " Open")) {
-				ImGuiFileDialog::Instance()->OpenDialog("OpenFileDlgKey", "Open File", ".txg", ".", 1, nullptr);
+				ImGuiFileDialog::Instance()->OpenDialog("OpenFileDlgKey", "Open File", ".txg,.txgb", ".", 1, nullptr);
+			}
+			if (ImGui::MenuItem(" " ICON_FA_SAVE " Save", nullptr, false, !node_editor->get_graph_load_progress())) {
+				ImGuiFileDialog::Instance()->OpenDialog("SaveFileDlgKey", "Save File", ".txg,.txgb", ".", 1, nullptr, ImGuiFileDialogFlags_ConfirmOverwrite);
 			}
-			if (ImGui::MenuItem(" " ICON_FA_SAVE " Save")) {
-				ImGuiFileDialog::Instance()->OpenDialog("SaveFileDlgKey", "Save File", ".txg", ".", 1, nullptr, ImGuiFileDialogFlags_ConfirmOverwrite);
+			if (ImGui::MenuItem(" " ICON_FA_SAVE " Save with Baked Outputs", nullptr, false, !node_editor->get_graph_load_progress())) {
+				ImGuiFileDialog::Instance()->OpenDialog("SaveBakedFileDlgKey", "Save File with Baked Outputs", ".txgb", ".", 1, nullptr, ImGuiFileDialogFlags_ConfirmOverwrite);
+			}
+			if (ImGui::MenuItem(" " ICON_FA_GLOBE " Load Environment")) {
+				ImGuiFileDialog::Instance()->OpenDialog("LoadEnvironmentDlgKey", "Load Environment", ".hdr,.exr", ".", 1, nullptr);
+			}
+			if (ImGui::BeginMenu(" " ICON_FA_FILE_EXPORT " Export")) {
+				if (ImGui::MenuItem(" Displayed Texture", nullptr, false, node_editor->get_display_texture() != nullptr)) {
+					ImGuiFileDialog::Instance()->OpenDialog("ExportTextureDlgKey", "Export Texture", ".png,.exr,.tga", ".", 1, nullptr, ImGuiFileDialogFlags_ConfirmOverwrite);
+				}
+				if (ImGui::BeginMenu(" Tiled Displayed Texture", node_editor->get_display_texture() != nullptr && !node_editor->get_tiled_export_progress())) {
+					for (auto const output_size : { 2048u, 4096u, 8192u, 16384u }) {
+						if (ImGui::MenuItem(std::format(" {0}x{0}", output_size).c_str())) {
+							tiled_export_size = output_size;
+							ImGuiFileDialog::Instance()->OpenDialog("ExportTiledDlgKey", "Export Tiled Texture", ".png,.exr,.tga", ".", 1, nullptr, ImGuiFileDialogFlags_ConfirmOverwrite);
+						}
+					}
+					ImGui::EndMenu();
+				}
+				if (ImGui::MenuItem(" PBR Texture Set")) {
+					ImGuiFileDialog::Instance()->OpenDialog("ExportPbrSetDlgKey", "Export PBR Texture Set", nullptr, ".", 1, nullptr);
+				}
+				ImGui::EndMenu();
 			}
 			ImGui::EndMenu();
 		}
+		if (ImGui::BeginMenu("View")) {
+			ImGui::MenuItem(" " ICON_FA_MEMORY " Memory", nullptr, &show_memory_window);
+			ImGui::EndMenu();
+		}
 		if (ImGui::BeginMenu("Help")) {
 			if (ImGui::MenuItem(" Document")) {
 
 			}
 			ImGui::EndMenu();
 		}
+		if (memory_stats->near_budget()) {
+			ImGui::TextColored(ImVec4(1.0f, 0.35f, 0.25f, 1.0f), " " ICON_FA_EXCLAMATION_TRIANGLE " VRAM %.f%%", memory_stats->device_local_usage_ratio() * 100.0f);
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Device local memory is close to its budget, new node textures may fail to allocate");
+			}
+		}
 		const ImVec2 fps_text_size = ImGui::CalcTextSize("FPS: 100(100ms)");
+		const ImVec2 texture_text_size = ImGui::CalcTextSize(" " ICON_FA_IMAGES " 00000/00000 ");
+		const float status_text_x = ImGui::GetWindowWidth() - fps_text_size.x - texture_text_size.x;
+		if (auto const progress = node_editor->get_graph_load_progress()) {
+			const ImVec2 loading_text_size = ImGui::CalcTextSize(" " ICON_FA_FOLDER_OPEN " Loading 100% ");
+			ImGui::SameLine(status_text_x - loading_text_size.x);
+			ImGui::Text(" " ICON_FA_FOLDER_OPEN " Loading %.f%%", *progress * 100.0f);
+		}
+		else if (auto const progress = node_editor->get_tiled_export_progress()) {
+			const ImVec2 tiling_text_size = ImGui::CalcTextSize(" " ICON_FA_TH " Tiling 100% ");
+			ImGui::SameLine(status_text_x - tiling_text_size.x);
+			ImGui::Text(" " ICON_FA_TH " Tiling %.f%%", *progress * 100.0f);
+		}
+		else if (auto const export_num = texture_exporter->in_flight_count(); export_num > 0) {
+			const ImVec2 export_text_size = ImGui::CalcTextSize(" " ICON_FA_FILE_EXPORT " Exporting 00 ");
+			ImGui::SameLine(status_text_x - export_text_size.x);
+			ImGui::Text(" " ICON_FA_FILE_EXPORT " Exporting %zu", export_num);
+		}
+		else if (auto const& timings = node_editor->get_last_load_timings(); timings.total > 0.0) {
+			const ImVec2 load_text_size = ImGui::CalcTextSize(" " ICON_FA_FOLDER_OPEN " 00000 ms ");
+			ImGui::SameLine(status_text_x - load_text_size.x);
+			ImGui::Text(" " ICON_FA_FOLDER_OPEN " %.f ms", timings.total);
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Last graph load\n  parse %.1f ms\n  create %.1f ms\n  upload %.1f ms\n  evaluate %.1f ms\nLast pipeline pre-warm %.1f ms",
+					timings.parse, timings.create, timings.upload, timings.evaluate, node_editor->get_last_prewarm_ms());
+			}
+		}
+		else if (auto const prewarm_ms = node_editor->get_last_prewarm_ms(); prewarm_ms > 0.0) {
+			const ImVec2 prewarm_text_size = ImGui::CalcTextSize(" " ICON_FA_COGS " 00000 ms ");
+			ImGui::SameLine(status_text_x - prewarm_text_size.x);
+			ImGui::Text(" " ICON_FA_COGS " %.f ms", prewarm_ms);
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Last pipeline pre-warm %.1f ms, at startup or after a shader edit", prewarm_ms);
+			}
+		}
+		ImGui::SameLine(status_text_x);
+		ImGui::Text(" " ICON_FA_IMAGES " %u/%u", texture_manager->size(), texture_manager->capacity());
+		if (ImGui::IsItemHovered()) {
+			ImGui::SetTooltip("Bindless textures in use / allocated, the table grows up to %u", texture_manager->max_capacity);
+		}
 		ImGui::SameLine(ImGui::GetWindowWidth() - fps_text_size.x);
 		ImGui::Text("FPS: %.f (%.fms)", io.Framerate, io.Framerate ? 1000.0f / io.Framerate : 0.0f);
 		ImGui::EndMenuBar();
@@ -1542,7 +1782,12 @@ void VulkanEngine::imgui_render(const uint32_t image_index) {
 		// action if OK
 		if (ImGuiFileDialog::Instance()->IsOk()) {
 			node_editor->clear();
-			node_editor->deserialize(ImGuiFileDialog::Instance()->GetFilePathName());
+			try {
+				node_editor->deserialize(ImGuiFileDialog::Instance()->GetFilePathName());
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+			}
 			// action
 		}
 		// close
@@ -1551,7 +1796,82 @@ void VulkanEngine::imgui_render(const uint32_t image_index) {
 
 	if (ImGuiFileDialog::Instance()->Display("SaveFileDlgKey", ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDocking, ImVec2{ file_dialog_min_x, file_dialog_min_y })) {
 		if (ImGuiFileDialog::Instance()->IsOk()) {
-			node_editor->serialize(ImGuiFileDialog::Instance()->GetFilePathName());
+			try {
+				node_editor->serialize(ImGuiFileDialog::Instance()->GetFilePathName());
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+			}
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (ImGuiFileDialog::Instance()->Display("SaveBakedFileDlgKey", ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDocking, ImVec2{ file_dialog_min_x, file_dialog_min_y })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			try {
+				node_editor->serialize(ImGuiFileDialog::Instance()->GetFilePathName(), true);
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+			}
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (ImGuiFileDialog::Instance()->Display("LoadEnvironmentDlgKey", ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDocking, ImVec2{ file_dialog_min_x, file_dialog_min_y })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			try {
+				load_environment(ImGuiFileDialog::Instance()->GetFilePathName());
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+			}
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (ImGuiFileDialog::Instance()->Display("ExportTextureDlgKey", ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDocking, ImVec2{ file_dialog_min_x, file_dialog_min_y })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			const std::filesystem::path file_path = ImGuiFileDialog::Instance()->GetFilePathName();
+			texture_exporter->export_texture(node_editor->get_display_texture(), file_path, TextureExporter::file_format_from_extension(file_path));
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (ImGuiFileDialog::Instance()->Display("ExportTiledDlgKey", ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDocking, ImVec2{ file_dialog_min_x, file_dialog_min_y })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			const std::filesystem::path file_path = ImGuiFileDialog::Instance()->GetFilePathName();
+			node_editor->begin_tiled_export(tiled_export_size, file_path, TextureExporter::file_format_from_extension(file_path));
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (show_memory_window) {
+		draw_memory_window(&show_memory_window);
+	}
+
+	if (ImGuiFileDialog::Instance()->Display("ExportMemoryDlgKey", ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDocking, ImVec2{ file_dialog_min_x, file_dialog_min_y })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			try {
+				memory_stats->save_snapshot(ImGuiFileDialog::Instance()->GetFilePathName());
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+			}
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (ImGuiFileDialog::Instance()->Display("ExportPbrSetDlgKey", ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoDocking, ImVec2{ file_dialog_min_x, file_dialog_min_y })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			const std::filesystem::path directory = ImGuiFileDialog::Instance()->GetCurrentPath();
+			PbrMaterialTextureSet::Class::ForEachField(pbr_material_texture_set, [&](auto& field, auto& texture_id) {
+				if (auto const& texture = texture_manager->textures[texture_id]) {
+					auto file_name = std::string(field.name);
+					file_name.erase(file_name.rfind("_id"));
+					texture_exporter->export_texture(texture, directory / (file_name + ".png"), ExportFileFormat::PNG);
+				}
+				});
 		}
 		ImGuiFileDialog::Instance()->Close();
 	}
@@ -1698,6 +2018,8 @@ void VulkanEngine::draw_frame() {
 
 	vkResetFences(device, 1, &frame_data[current_frame].in_flight_fence);
 
+	texture_manager->flush_descriptor_writes(device);
+
 	if (vkQueueSubmit(graphics_queue, 1, &submit_info, frame_data[current_frame].in_flight_fence) != VK_SUCCESS) {
 		throw std::runtime_error("failed to submit draw command buffer!");
 	}
@@ -1800,7 +2122,19 @@ bool VulkanEngine::is_device_suitable(const VkPhysicalDevice device) const {
 	VkPhysicalDeviceFeatures supported_features;
 	vkGetPhysicalDeviceFeatures(device, &supported_features);
 
-	return queue_family_indices.is_complete() && extensions_supported && swap_chain_adequate && supported_features.samplerAnisotropy;
+	return queue_family_indices.is_complete() && extensions_supported && swap_chain_adequate && supported_features.samplerAnisotropy && supported_features.shaderStorageImageWriteWithoutFormat;
+}
+
+bool VulkanEngine::check_device_extension_support(VkPhysicalDevice device, std::string_view extension_name) {
+	uint32_t extension_count;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+
+	std::vector<VkExtensionProperties> available_extensions(extension_count);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
+
+	return std::ranges::any_of(available_extensions, [&](const VkExtensionProperties& extension) {
+		return extension.extensionName == extension_name;
+		});
 }
 
 bool VulkanEngine::check_device_extension_support(VkPhysicalDevice device) {
@@ -1851,6 +2185,15 @@ QueueFamilyIndices VulkanEngine::find_queue_families(VkPhysicalDevice device) co
 		i++;
 	}
 
+	//the loop stops at the first complete family, keep looking for a transfer-only family for the upload ring
+	for (uint32_t family = 0; family < queue_family_count; ++family) {
+		const VkQueueFlags queue_flags = queue_families[family].queueFlags;
+		if ((queue_flags & VK_QUEUE_TRANSFER_BIT) && !(queue_flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			indices.transfer_family = family;
+			break;
+		}
+	}
+
 	VkBool32 present_support = false;
 	vkGetPhysicalDeviceSurfaceSupportKHR(device, indices.graphics_family.value(), surface, &present_support);
 	if (present_support) {
@@ -1952,4 +2295,6 @@ void VulkanEngine::set_camera() const {
 	camera.set_aspect_ratio(viewport_3d.width / viewport_3d.height);
 }
 
+VulkanEngine::VulkanEngine() = default;  //out of line, pending_environment is incomplete in the header
+
 VulkanEngine::~VulkanEngine() {}
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <vector>
 #include <cstdint>
 #include <deque>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <ranges>
 #include <unordered_map>
@@ -50,6 +52,17 @@ namespace engine {
 	class Texture;
 	class GUI;
 	class NodeEditor;
+	class TextureExporter;
+	class EnvironmentBaker;
+	class PipelineCache;
+	class ShaderModuleCache;
+	class ShaderSourceWatcher;
+	class SamplerCache;
+	class TexturePool;
+	class UploadRing;
+	class UniformArena;
+	class ParameterRing;
+	class MemoryStats;
 
 	struct Empty_Type;
 	template <typename ParaT> class Material;
@@ -106,6 +119,8 @@ struct MaterialPreviewUBO {
 
 class VulkanEngine {
 public:
+	VulkanEngine();
+
 	~VulkanEngine();
 
 	bool is_initialized{ false };
@@ -134,9 +149,12 @@ public:
 	VkQueue graphics_queue;
 	VkQueue compute_queue;
 	VkQueue present_queue;
+	VkQueue transfer_queue;
 	QueueFamilyIndices queue_family_indices;
 
 	VmaAllocator vma_allocator;
+	bool memory_budget_supported = false;  //VK_EXT_memory_budget is optional, VMA estimates budgets without it
+	std::shared_ptr<engine::MemoryStats> memory_stats;
 
 	VkSwapchainKHR swapchain;
 	std::vector<VkImage> swapchain_images;
@@ -193,13 +211,32 @@ public:
 
 	uint32_t swapchain_image_count;
 
-	constexpr static inline uint32_t max_bindless_textures = 800;
+	constexpr static inline uint32_t max_bindless_textures = 800;  //initial size of the bindless texture table
+	constexpr static inline uint32_t max_bindless_textures_limit = 1 << 16;  //the table doubles on demand up to this or the device limit
+	constexpr static inline uint32_t max_node_types = 64;  //one shared dynamic uniform buffer set per graphics node type
+	constexpr static inline std::string_view pipeline_cache_path = "cache/pipeline_cache.bin";  //relative to the working directory like assets/
+	constexpr static inline std::string_view glsl_shader_directory = "assets/glsl_shaders";
+	constexpr static inline std::string_view spirv_shader_directory = "assets/shaders";
 	//constexpr static inline uint32_t max_bindless_node_1d_textures = 50;
 	VkDescriptorPool dynamic_descriptor_pool;
 	std::shared_ptr<TextureManager> texture_manager;
+	std::shared_ptr<engine::TextureExporter> texture_exporter;
+	std::shared_ptr<engine::EnvironmentBaker> environment_baker;
+	std::shared_ptr<engine::PipelineCache> pipeline_cache;
+	std::shared_ptr<engine::ShaderModuleCache> shader_cache;
+	std::shared_ptr<engine::ShaderSourceWatcher> shader_source_watcher;
+	std::shared_ptr<engine::SamplerCache> sampler_cache;
+	std::shared_ptr<engine::TexturePool> texture_pool;
+	std::shared_ptr<engine::UploadRing> upload_ring;
+	std::shared_ptr<engine::UniformArena> uniform_arena;
+	std::shared_ptr<engine::ParameterRing> parameter_ring;
 
 	VkFence immediate_submit_fence;
 
+	//environment maps decoding on worker threads from the start of init_vulkan(), parse_material_info() uploads them
+	struct PendingEnvironment;
+	std::unique_ptr<PendingEnvironment> pending_environment;
+
 	void init_window();
 
 	static void framebuffer_resize_callback(GLFWwindow* window, int width, int height);
@@ -236,6 +273,10 @@ public:
 
 	void create_swap_chain_image_views();
 
+	void begin_environment_decode();
+
+	void load_environment(const std::string& file_path);
+
 	void parse_material_info();
 
 	void create_descriptor_set_layouts();
@@ -266,8 +307,30 @@ public:
 
 	void create_uniform_buffers();
 
+	void create_pipeline_cache();
+
+	void create_shader_cache();
+
+	void create_shader_source_watcher();
+
+	void create_sampler_cache();
+
+	void create_texture_pool();
+
+	void create_upload_ring();
+
+	void create_uniform_arena();
+
+	void create_parameter_ring();
+
+	void create_memory_stats();
+
 	void create_texture_manager();
 
+	void create_texture_exporter();
+
+	void create_environment_baker();
+
 	void create_descriptor_pool();
 
 	void create_descriptor_sets();
@@ -284,6 +347,8 @@ public:
 
 	void imgui_render(uint32_t image_index);
 
+	void draw_memory_window(bool* p_open) const;
+
 	static VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 
 	static VkPresentModeKHR choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes);
@@ -296,6 +361,8 @@ public:
 
 	static bool check_device_extension_support(VkPhysicalDevice device);
 
+	static bool check_device_extension_support(VkPhysicalDevice device, std::string_view extension_name);
+
 	QueueFamilyIndices find_queue_families(VkPhysicalDevice device) const;
 
 	static std::vector<const char*> get_required_extensions();
@@ -0,0 +1,328 @@
+#include "vk_environment.h"
+#include "vk_engine.h"
+#include "vk_initializers.h"
+#include "vk_pipeline_cache.h"
+#include "vk_shader.h"
+#include "vk_util.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+	namespace {
+		constexpr uint32_t local_size = 16;  //local_size_x and local_size_y of the env_*.comp shaders
+
+		constexpr uint32_t group_num(const uint32_t width) noexcept {
+			return (width + local_size - 1) / local_size;
+		}
+
+		//descriptor sets and level views of one bake, released after immediate_submit() has waited for it
+		class PassResources {
+		public:
+			PassResources(VkDevice device, VkDescriptorSetLayout descriptor_set_layout, const uint32_t set_num) :
+				device(device), descriptor_set_layout(descriptor_set_layout) {
+				const std::array pool_sizes{
+					VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_num },
+					VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, set_num },
+				};
+
+				const VkDescriptorPoolCreateInfo pool_info{
+					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+					.maxSets = set_num,
+					.poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
+					.pPoolSizes = pool_sizes.data(),
+				};
+
+				if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptor_pool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create descriptor pool!");
+				}
+			}
+
+			~PassResources() {
+				for (auto const view : views) {
+					vkDestroyImageView(device, view, nullptr);
+				}
+				vkDestroyDescriptorPool(device, descriptor_pool, nullptr);
+			}
+
+			PassResources(const PassResources&) = delete;
+			PassResources& operator=(const PassResources&) = delete;
+
+			//source is sampled at binding 0 unless it is null, level of target is written at binding 1 in VK_IMAGE_LAYOUT_GENERAL
+			VkDescriptorSet create_set(const Texture* source, const Image& target, const uint32_t level) {
+				const VkImageViewCreateInfo view_info{
+					.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+					.image = target.image,
+					.viewType = target.layer_count == 1 ? VK_IMAGE_VIEW_TYPE_2D : VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+					.format = target.format,
+					.subresourceRange = {
+						.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+						.baseMipLevel = level,
+						.levelCount = 1,
+						.baseArrayLayer = 0,
+						.layerCount = target.layer_count,
+					},
+				};
+
+				VkImageView view;
+				if (vkCreateImageView(device, &view_info, nullptr, &view) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create storage image view!");
+				}
+				views.push_back(view);
+
+				const VkDescriptorSetAllocateInfo alloc_info{
+					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+					.descriptorPool = descriptor_pool,
+					.descriptorSetCount = 1,
+					.pSetLayouts = &descriptor_set_layout,
+				};
+
+				VkDescriptorSet descriptor_set;
+				if (vkAllocateDescriptorSets(device, &alloc_info, &descriptor_set) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate descriptor set!");
+				}
+
+				const VkDescriptorImageInfo target_info{
+					.imageView = view,
+					.imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+				};
+
+				const VkDescriptorImageInfo source_info{
+					.sampler = source ? source->sampler : VK_NULL_HANDLE,
+					.imageView = source ? source->image_view : VK_NULL_HANDLE,
+					.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				};
+
+				const std::array descriptor_writes{
+					VkWriteDescriptorSet{
+						.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+						.dstSet = descriptor_set,
+						.dstBinding = 1,
+						.dstArrayElement = 0,
+						.descriptorCount = 1,
+						.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+						.pImageInfo = &target_info,
+					},
+					VkWriteDescriptorSet{
+						.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+						.dstSet = descriptor_set,
+						.dstBinding = 0,
+						.dstArrayElement = 0,
+						.descriptorCount = 1,
+						.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+						.pImageInfo = &source_info,
+					},
+				};
+
+				vkUpdateDescriptorSets(device, source ? 2 : 1, descriptor_writes.data(), 0, nullptr);
+				return descriptor_set;
+			}
+
+		private:
+			VkDevice device;
+			VkDescriptorSetLayout descriptor_set_layout;
+			VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+			std::vector<VkImageView> views;
+		};
+
+		//Uploads end in a barrier towards fragment or compute shader reads that an earlier graphics submission records.
+		//Chaining from those stages orders the passes after it without waiting on the host
+		void acquire_source(VkCommandBuffer command_buffer, const Image& source) {
+			source.insert_memory_barrier(command_buffer,
+				VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_NONE,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+
+		void begin_storage_writes(VkCommandBuffer command_buffer, const Image& target) {
+			target.insert_memory_barrier(command_buffer,
+				VK_PIPELINE_STAGE_2_NONE,
+				VK_ACCESS_2_NONE,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_GENERAL);
+		}
+
+		void end_storage_writes(VkCommandBuffer command_buffer, const Image& target) {
+			target.insert_memory_barrier(command_buffer,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+				VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+	}
+
+	EnvironmentBaker::EnvironmentBaker(VulkanEngine* engine) : engine(engine) {
+		std::array descriptor_set_layout_bindings{
+			vkinit::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+			vkinit::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+		};
+		engine->create_descriptor_set_layout(descriptor_set_layout_bindings, descriptor_set_layout);
+
+		std::array descriptor_set_layouts{ descriptor_set_layout };
+		auto pipeline_layout_info = vkinit::pipeline_layout_create_info(descriptor_set_layouts);
+		const VkPushConstantRange push_constant_range{
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.offset = 0,
+			.size = sizeof(float),  //roughness of the prefiltered level
+		};
+		pipeline_layout_info.pushConstantRangeCount = 1;
+		pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+		if (vkCreatePipelineLayout(engine->device, &pipeline_layout_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		auto const shader = Shader::createFromSpv(engine, shader_file_paths);
+		for (uint32_t pass = 0; pass < PASS_NUM; ++pass) {
+			const VkComputePipelineCreateInfo compute_pipeline_create_info{
+				.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+				.stage = {
+					.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+					.stage = shader->shader_modules[pass].stage,
+					.module = shader->shader_modules[pass].shader,
+					.pName = "main",
+				},
+				.layout = pipeline_layout,
+			};
+
+			if (vkCreateComputePipelines(engine->device, engine->pipeline_cache->handle(), 1, &compute_pipeline_create_info, nullptr, &pipelines[pass]) != VK_SUCCESS) {
+				for (auto const pipeline : pipelines) {
+					vkDestroyPipeline(engine->device, pipeline, nullptr);
+				}
+				vkDestroyPipelineLayout(engine->device, pipeline_layout, nullptr);
+				throw std::runtime_error("failed to create compute pipeline!");
+			}
+		}
+	}
+
+	EnvironmentBaker::~EnvironmentBaker() {
+		for (auto const pipeline : pipelines) {
+			vkDestroyPipeline(engine->device, pipeline, nullptr);
+		}
+		vkDestroyPipelineLayout(engine->device, pipeline_layout, nullptr);
+	}
+
+	TexturePtr EnvironmentBaker::project_equirectangular(const HdrImage& equirectangular_image) const {
+		auto const source = Texture::create_device_texture_unique(engine,
+			equirectangular_image.width,
+			equirectangular_image.height,
+			VK_FORMAT_R32G32B32A32_SFLOAT,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+		source->upload_pixels(equirectangular_image.bytes());
+
+		auto const width = std::clamp(std::bit_floor(static_cast<uint32_t>(equirectangular_image.width) / 4), min_cubemap_width, max_cubemap_width);
+		auto cubemap = create_storage_texture(width, std::bit_width(width), 6);
+
+		PassResources resources(engine->device, descriptor_set_layout, 1);
+		auto const descriptor_set = resources.create_set(source.get(), *cubemap, 0);
+
+		immediate_submit(engine, [&](VkCommandBuffer command_buffer) {
+			acquire_source(command_buffer, *source);
+			begin_storage_writes(command_buffer, *cubemap);
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[EQUIRECTANGULAR_TO_CUBE]);
+			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &descriptor_set, 0, nullptr);
+			vkCmdDispatch(command_buffer, group_num(width), group_num(width), 6);
+
+			//the first level was written, the blits of record_generate_mipmaps() fill the rest
+			cubemap->insert_memory_barrier(command_buffer,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+				VK_PIPELINE_STAGE_2_BLIT_BIT,
+				VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			cubemap->record_generate_mipmaps(command_buffer);
+			});
+
+		return cubemap;
+	}
+
+	EnvironmentMaps EnvironmentBaker::bake(const TexturePtr& cubemap) const {
+		constexpr uint32_t last_level = prefiltered_level_num - 1;
+		if (cubemap->width >> last_level == 0 || cubemap->mip_levels < static_cast<uint32_t>(std::bit_width(cubemap->width))) {
+			throw std::runtime_error("failed to bake environment, the cubemap needs a full mip chain of at least 32 texels!");
+		}
+
+		EnvironmentMaps maps{
+			.irradiance_map = create_storage_texture(irradiance_map_width, 1, 6),
+			.prefiltered_map = create_storage_texture(std::min(cubemap->width, prefiltered_map_width), prefiltered_level_num, 6),
+		};
+
+		PassResources resources(engine->device, descriptor_set_layout, 1 + prefiltered_level_num);
+		auto const irradiance_set = resources.create_set(cubemap.get(), *maps.irradiance_map, 0);
+		std::array<VkDescriptorSet, prefiltered_level_num> prefilter_sets;
+		for (uint32_t level = 0; level < prefiltered_level_num; ++level) {
+			prefilter_sets[level] = resources.create_set(cubemap.get(), *maps.prefiltered_map, level);
+		}
+
+		immediate_submit(engine, [&](VkCommandBuffer command_buffer) {
+			acquire_source(command_buffer, *cubemap);
+			begin_storage_writes(command_buffer, *maps.irradiance_map);
+			begin_storage_writes(command_buffer, *maps.prefiltered_map);
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[IRRADIANCE]);
+			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &irradiance_set, 0, nullptr);
+			vkCmdDispatch(command_buffer, group_num(irradiance_map_width), group_num(irradiance_map_width), 6);
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[PREFILTER]);
+			for (uint32_t level = 0; level < prefiltered_level_num; ++level) {
+				const float roughness = static_cast<float>(level) / last_level;
+				auto const level_width = maps.prefiltered_map->width >> level;
+				vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(float), &roughness);
+				vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &prefilter_sets[level], 0, nullptr);
+				vkCmdDispatch(command_buffer, group_num(level_width), group_num(level_width), 6);
+			}
+
+			end_storage_writes(command_buffer, *maps.irradiance_map);
+			end_storage_writes(command_buffer, *maps.prefiltered_map);
+			});
+
+		return maps;
+	}
+
+	TexturePtr EnvironmentBaker::bake_brdf_lut() const {
+		auto brdf_lut = create_storage_texture(brdf_lut_width, 1, 1);
+
+		PassResources resources(engine->device, descriptor_set_layout, 1);
+		auto const descriptor_set = resources.create_set(nullptr, *brdf_lut, 0);
+
+		immediate_submit(engine, [&](VkCommandBuffer command_buffer) {
+			begin_storage_writes(command_buffer, *brdf_lut);
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[BRDF_LUT]);
+			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &descriptor_set, 0, nullptr);
+			vkCmdDispatch(command_buffer, group_num(brdf_lut_width), group_num(brdf_lut_width), 1);
+
+			end_storage_writes(command_buffer, *brdf_lut);
+			});
+
+		return brdf_lut;
+	}
+
+	TexturePtr EnvironmentBaker::create_storage_texture(const uint32_t width, const uint32_t mip_levels, const uint32_t layer_count) const {
+		return std::make_shared<Texture>(engine,
+			width,
+			width,
+			mip_levels,
+			VK_SAMPLE_COUNT_1_BIT,
+			format,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			PreferredMemoryType::VRAM_UNMAPPABLE,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_FILTER_LINEAR,
+			layer_count,
+			layer_count == 6 ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0);
+	}
+}
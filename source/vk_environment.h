@@ -0,0 +1,69 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_image.h"
+
+#include <array>
+
+class VulkanEngine;
+
+namespace engine {
+	//image based lighting inputs the PBR shaders sample besides the BRDF LUT
+	struct EnvironmentMaps {
+		TexturePtr irradiance_map;
+		TexturePtr prefiltered_map;
+	};
+
+	//Derives image based lighting from one HDRi with compute passes on the graphics queue instead of offline tools:
+	//an equirectangular image is projected to a cubemap, which is convolved into the irradiance map and the GGX
+	//prefiltered mip chain. The BRDF LUT does not depend on the environment and is built once.
+	//Every call blocks until its passes finish. Textures come without a release callback and are destroyed with their
+	//last owner, so environments can be swapped at runtime once the device is idle
+	class EnvironmentBaker {
+	public:
+		constexpr static inline uint32_t min_cubemap_width = 64;
+		constexpr static inline uint32_t max_cubemap_width = 2048;
+		constexpr static inline uint32_t irradiance_map_width = 32;
+		constexpr static inline uint32_t prefiltered_map_width = 512;
+		constexpr static inline uint32_t prefiltered_level_num = 6;  //roughness 0, 0.2 ... 1.0 like the maps pbr.frag was tuned with
+		constexpr static inline uint32_t brdf_lut_width = 512;
+		constexpr static inline VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;  //storage and linear blit support are mandatory
+
+		explicit EnvironmentBaker(VulkanEngine* engine);
+
+		~EnvironmentBaker();
+
+		EnvironmentBaker(const EnvironmentBaker&) = delete;
+		EnvironmentBaker& operator=(const EnvironmentBaker&) = delete;
+
+		//faces are a quarter of the image width rounded down to a power of two, with a full mip chain
+		[[nodiscard]] TexturePtr project_equirectangular(const HdrImage& equirectangular_image) const;
+
+		//cubemap must have a full mip chain in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uploads still in flight are waited for
+		[[nodiscard]] EnvironmentMaps bake(const TexturePtr& cubemap) const;
+
+		[[nodiscard]] TexturePtr bake_brdf_lut() const;
+
+	private:
+		enum Pass : uint32_t {
+			EQUIRECTANGULAR_TO_CUBE,
+			IRRADIANCE,
+			PREFILTER,
+			BRDF_LUT,
+			PASS_NUM,
+		};
+
+		constexpr static inline std::array<const char*, PASS_NUM> shader_file_paths{
+			"assets/shaders/env_equirect_to_cube.comp.spv",
+			"assets/shaders/env_irradiance.comp.spv",
+			"assets/shaders/env_prefilter.comp.spv",
+			"assets/shaders/env_brdf_lut.comp.spv",
+		};
+
+		VulkanEngine* engine;
+		VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;  //sampled source at binding 0, written level at binding 1
+		VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+		std::array<VkPipeline, PASS_NUM> pipelines{};
+
+		[[nodiscard]] TexturePtr create_storage_texture(uint32_t width, uint32_t mip_levels, uint32_t layer_count) const;
+	};
+}
@@ -4,6 +4,7 @@
 #include "imgui_impl_glfw.h"
 #include "vk_util.h"
 #include "vk_image.h"
+#include "vk_pipeline_cache.h"
 
 #include <IconsFontAwesome5.h>
 #include <filesystem>
@@ -160,6 +161,7 @@ namespace engine {
 			.PhysicalDevice = engine->physical_device,
 			.Device = engine->device,
 			.Queue = engine->graphics_queue,
+			.PipelineCache = engine->pipeline_cache->handle(),
 			.DescriptorPool = imgui_descriptor_pool,
 			.MinImageCount = 3,
 			.ImageCount = 3,
@@ -2,9 +2,17 @@
 #include "vk_util.h"
 #include "vk_buffer.h"
 #include "vk_initializers.h"
-
+#include "vk_sampler_cache.h"
+#include "vk_setup_batch.h"
+#include "vk_texture_pool.h"
+#include "vk_upload_ring.h"
+#include "util/thread_pool.h"
+
+#include <algorithm>
+#include <array>
 #include <stdexcept>
 #include <filesystem>
+#include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -21,6 +29,68 @@
 #include <tinyexr.h>
 
 namespace engine {
+	namespace {
+		//Copies the staged mip levels into the texture on the transfer queue, then the graphics queue acquires it and either
+		//generates the remaining mipmaps or transitions it to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		uint64_t upload_texture(VulkanEngine* engine, const Texture& texture, const VkDeviceSize size, const UploadRing::FillFunc& fill,
+			const std::span<const VkDeviceSize> level_offsets, const bool generate_mipmaps) {
+			if (generate_mipmaps) {
+				texture.check_linear_blit_support();
+			}
+			auto& upload_ring = *engine->upload_ring;
+
+			return upload_ring.upload(size, fill,
+				[&](VkCommandBuffer command_buffer, VkBuffer staging_buffer, VkDeviceSize staging_offset) {
+					texture.insert_memory_barrier(command_buffer,
+						VK_PIPELINE_STAGE_2_NONE,
+						VK_ACCESS_2_NONE,
+						VK_PIPELINE_STAGE_2_COPY_BIT,
+						VK_ACCESS_2_TRANSFER_WRITE_BIT,
+						VK_IMAGE_LAYOUT_UNDEFINED,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+					for (uint32_t level = 0; level < level_offsets.size(); ++level) {
+						texture.record_copy_from_buffer(command_buffer, staging_buffer, staging_offset + level_offsets[level], level);
+					}
+
+					//release to the graphics family, the layout is kept so the acquire below matches it
+					texture.insert_memory_barrier(command_buffer,
+						VK_PIPELINE_STAGE_2_COPY_BIT,
+						VK_ACCESS_2_TRANSFER_WRITE_BIT,
+						VK_PIPELINE_STAGE_2_NONE,
+						VK_ACCESS_2_NONE,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						upload_ring.src_queue_family(),
+						upload_ring.dst_queue_family());
+				},
+				[&](VkCommandBuffer command_buffer) {
+					texture.insert_memory_barrier(command_buffer,
+						VK_PIPELINE_STAGE_2_COPY_BIT,
+						VK_ACCESS_2_NONE,
+						VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT,
+						VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						upload_ring.src_queue_family(),
+						upload_ring.dst_queue_family());
+
+					if (generate_mipmaps) {
+						texture.record_generate_mipmaps(command_buffer);
+					}
+					else {
+						texture.insert_memory_barrier(command_buffer,
+							VK_PIPELINE_STAGE_2_COPY_BIT,
+							VK_ACCESS_2_NONE,
+							VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+							VK_ACCESS_2_SHADER_READ_BIT,
+							VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+							VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+					}
+				});
+		}
+	}
+
 	Image::Image(VulkanEngine* engine, uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits sample_count_flag,
 		VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, PreferredMemoryType preferred_memory_type,
 		VkImageAspectFlags aspect_flags, uint32_t layer_count, VkImageCreateFlags image_flag, VkComponentMapping components) :
@@ -56,6 +126,8 @@ namespace engine {
 			) {
 			throw std::runtime_error("vma failed to create image!");
 		}
+		allocation_size = allocation_info.size;
+		MemoryStats::track(memory_category, allocation_size);
 
 		const VkImageViewCreateInfo view_info{
 			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
@@ -83,6 +155,7 @@ namespace engine {
 			image_view = VK_NULL_HANDLE;
 		}
 		if (image != VK_NULL_HANDLE) {
+			MemoryStats::untrack(memory_category, allocation_size);
 			vmaDestroyImage(engine->vma_allocator, image, allocation);
 			image = VK_NULL_HANDLE;
 		}
@@ -115,12 +188,9 @@ namespace engine {
 		);
 	}
 
+	//joins the open SetupBatch of this thread, if any
 	void Image::transition_image_layout(VkImageLayout old_layout, VkImageLayout new_layout, QueueFamilyCategory queue_family_category) {
-		auto [queue, command_pool] = queue_family_category == QueueFamilyCategory::GRAPHICS ?
-			std::tuple{ engine->graphics_queue, engine->graphic_command_pool } :
-			std::tuple{ engine->compute_queue,engine->compute_command_pool };
-
-		immediate_submit(engine, queue, command_pool, [&](VkCommandBuffer commandBuffer) {
+		SetupBatch::record(engine, queue_family_category, [&](VkCommandBuffer commandBuffer) {
 			VkPipelineStageFlags2 source_stage;
 			VkPipelineStageFlags2 destination_stage;
 			VkAccessFlags2 src_access_mask;
@@ -167,113 +237,108 @@ namespace engine {
 
 	void Image::copy_from_buffer(VkBuffer buffer, uint32_t mip_level) {
 		immediate_submit(engine, [&](VkCommandBuffer command_buffer) {
-			const VkBufferImageCopy region{
-				.bufferOffset = 0,
-				.bufferRowLength = 0,
-				.bufferImageHeight = 0,
-				.imageSubresource {
-					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-					.mipLevel = mip_level,
-					.baseArrayLayer = 0,
-					.layerCount = layer_count,
-				},
-				.imageOffset = { 0, 0, 0 },
-				.imageExtent = {
-					width >> mip_level,
-					height >> mip_level,
-					1,
-				},
-			};
-
-			vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			record_copy_from_buffer(command_buffer, buffer, 0, mip_level);
 			});
 	}
 
-	void Image::generate_mipmaps() const {
-		// Check if image format supports linear blitting
+	void Image::record_copy_from_buffer(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize buffer_offset, uint32_t mip_level) const {
+		const VkBufferImageCopy region{
+			.bufferOffset = buffer_offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = mip_level,
+				.baseArrayLayer = 0,
+				.layerCount = layer_count,
+			},
+			.imageOffset = { 0, 0, 0 },
+			.imageExtent = {
+				width >> mip_level,
+				height >> mip_level,
+				1,
+			},
+		};
+
+		vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
+
+	void Image::check_linear_blit_support() const {
 		VkFormatProperties format_properties;
 		vkGetPhysicalDeviceFormatProperties(engine->physical_device, format, &format_properties);
 
 		if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
 			throw std::runtime_error("texture image format does not support linear blitting!");
 		}
+	}
 
-		immediate_submit(engine, [=](VkCommandBuffer command_buffer) {
-
-			VkImageMemoryBarrier barrier{};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.image = image;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = layer_count;
-			barrier.subresourceRange.levelCount = 1;
-
-			int32_t mipWidth = width;
-			int32_t mipHeight = height;
-
-			for (uint32_t i = 1; i < mip_levels; i++) {
-				barrier.subresourceRange.baseMipLevel = i - 1;
-				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-				vkCmdPipelineBarrier(command_buffer,
-					VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-					0, nullptr,
-					0, nullptr,
-					1, &barrier);
-
-				VkImageBlit blit{
-					.srcSubresource = {
-						.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-						.mipLevel = i - 1,
-						.baseArrayLayer = 0,
-						.layerCount = layer_count,
-					},
-					.srcOffsets = {
-						{0, 0, 0},
-						{mipWidth, mipHeight, 1}
-					},
-					.dstSubresource = {
-						.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-						.mipLevel = i,
-						.baseArrayLayer = 0,
-						.layerCount = layer_count,
-					},
-					.dstOffsets = {
-						{ 0, 0, 0 },
-						{ mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 }
-					}
-				};
-
-				vkCmdBlitImage(command_buffer,
-					image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					1, &blit,
-					VK_FILTER_LINEAR);
-
-				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-				barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-				vkCmdPipelineBarrier(command_buffer,
-					VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-					0, nullptr,
-					0, nullptr,
-					1, &barrier);
-
-				if (mipWidth > 1) mipWidth /= 2;
-				if (mipHeight > 1) mipHeight /= 2;
-			}
+	void Image::generate_mipmaps() const {
+		check_linear_blit_support();
 
-			barrier.subresourceRange.baseMipLevel = mip_levels - 1;
+		immediate_submit(engine, [this](VkCommandBuffer command_buffer) {
+			record_generate_mipmaps(command_buffer);
+			});
+	}
+
+	void Image::record_generate_mipmaps(VkCommandBuffer command_buffer) const {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = image;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = layer_count;
+		barrier.subresourceRange.levelCount = 1;
+
+		int32_t mipWidth = width;
+		int32_t mipHeight = height;
+
+		for (uint32_t i = 1; i < mip_levels; i++) {
+			barrier.subresourceRange.baseMipLevel = i - 1;
 			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			vkCmdPipelineBarrier(command_buffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrier);
+
+			VkImageBlit blit{
+				.srcSubresource = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.mipLevel = i - 1,
+					.baseArrayLayer = 0,
+					.layerCount = layer_count,
+				},
+				.srcOffsets = {
+					{0, 0, 0},
+					{mipWidth, mipHeight, 1}
+				},
+				.dstSubresource = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.mipLevel = i,
+					.baseArrayLayer = 0,
+					.layerCount = layer_count,
+				},
+				.dstOffsets = {
+					{ 0, 0, 0 },
+					{ mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 }
+				}
+			};
+
+			vkCmdBlitImage(command_buffer,
+				image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blit,
+				VK_FILTER_LINEAR);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
 			vkCmdPipelineBarrier(command_buffer,
@@ -281,7 +346,22 @@ namespace engine {
 				0, nullptr,
 				0, nullptr,
 				1, &barrier);
-			});
+
+			if (mipWidth > 1) mipWidth /= 2;
+			if (mipHeight > 1) mipHeight /= 2;
+		}
+
+		barrier.subresourceRange.baseMipLevel = mip_levels - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
 	}
 
 	Texture::Texture(
@@ -303,25 +383,16 @@ namespace engine {
 		Image(engine, tex_width, tex_height, mip_levels, sample_count_flag, img_format, img_tiling,
 			img_usage, preferred_memory_type, aspect_flags, layer_count, image_flag, components) {
 
-		const VkSamplerCreateInfo sampler_info = vkinit::sampler_create_info(engine->physical_device, filter, mip_levels);
-
-		if (vkCreateSampler(engine->device, &sampler_info, nullptr, &sampler) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create texture sampler!");
-		}
+		sampler = engine->sampler_cache->get(filter, mip_levels);
 	}
 
-	Texture::~Texture() {
-		if (sampler != VK_NULL_HANDLE) {
-			vkDestroySampler(engine->device, sampler, nullptr);
-			sampler = VK_NULL_HANDLE;
-		}
-	}
+	Texture::~Texture() = default;
 
 	void Texture::add_resource_release_callback(CreateResourceFlagBits image_description) {
 		if (image_description & 0x00000001) {
 			((image_description == SWAPCHAIN_DEPENDENT_BIT) ? engine->swap_chain_deletion_queue : engine->main_deletion_queue).push_function([=] {
-				vkDestroySampler(engine->device, sampler, nullptr);
 				vkDestroyImageView(engine->device, image_view, nullptr);
+				MemoryStats::untrack(memory_category, allocation_size);
 				vmaDestroyImage(engine->vma_allocator, image, allocation);
 				image = VK_NULL_HANDLE;
 				image_view = VK_NULL_HANDLE;
@@ -382,10 +453,10 @@ namespace engine {
 		return texture;
 	}
 
-	TexturePtr Texture::create_device_texture(VulkanEngine* engine, uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspectFlags, VkImageUsageFlags usage_flag, CreateResourceFlagBits image_description, bool greyscale) {
-		TexturePtr texture;
+	std::unique_ptr<Texture> Texture::create_device_texture_unique(VulkanEngine* engine, uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspectFlags, VkImageUsageFlags usage_flag, bool greyscale) {
+		std::unique_ptr<Texture> texture;
 		if (greyscale) {
-			texture = std::make_shared<Texture>(
+			texture = std::make_unique<Texture>(
 				/*engine*/                engine,
 				/*width*/	              width,
 				/*height*/                height,
@@ -407,7 +478,7 @@ namespace engine {
 				});
 		}
 		else {
-			texture = std::make_shared<Texture>(engine,
+			texture = std::make_unique<Texture>(engine,
 				width,
 				height,
 				1,
@@ -419,6 +490,15 @@ namespace engine {
 				aspectFlags,
 				VK_FILTER_LINEAR);
 		}
+		return texture;
+	}
+
+	TexturePtr Texture::create_device_texture(VulkanEngine* engine, uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspectFlags, VkImageUsageFlags usage_flag, CreateResourceFlagBits image_description, bool greyscale) {
+		//node textures are created and dropped whenever nodes are added, deleted or change format, recycle them
+		if (image_description == TEMP_BIT && engine->texture_pool) {
+			return engine->texture_pool->acquire(width, height, format, aspectFlags, usage_flag, greyscale);
+		}
+		TexturePtr texture = create_device_texture_unique(engine, width, height, format, aspectFlags, usage_flag, greyscale);
 		texture->add_resource_release_callback(image_description);
 		return texture;
 	}
@@ -464,13 +544,6 @@ namespace engine {
 
 		const VkDeviceSize image_size = static_cast<uint64_t>(tex_width) * texHeight * texChannels;
 
-		auto const staging_buffer = engine::Buffer::create_buffer(engine,
-			image_size,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			PreferredMemoryType::RAM_FOR_UPLOAD,
-			TEMP_BIT);
-		staging_buffer->copy_from_host(host_pixels);
-
 		engine::TexturePtr texture;
 
 		if (enableMipmap) {
@@ -480,17 +553,21 @@ namespace engine {
 			texture = engine::Texture::create_2d_texture(engine, tex_width, texHeight, format, SWAPCHAIN_INDEPENDENT_BIT, 1);
 		}
 
-		texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-		texture->copy_from_buffer(staging_buffer->buffer);
-
-		//transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
-
-		texture->generate_mipmaps();
+		constexpr VkDeviceSize level_offsets[] = { 0 };
+		upload_texture(engine, *texture, image_size, [&](std::byte* staging_data) {
+			memcpy(staging_data, host_pixels, image_size);
+			}, level_offsets, texture->mip_levels > 1);
 
 		return texture;
 	}
 
+	uint64_t Texture::upload_pixels(const std::span<const std::byte> pixels) const {
+		constexpr VkDeviceSize level_offsets[] = { 0 };
+		return upload_texture(engine, *this, pixels.size(), [&](std::byte* staging_data) {
+			memcpy(staging_data, pixels.data(), pixels.size());
+			}, level_offsets, false);
+	}
+
 	TexturePtr Texture::load_2d_texture(VulkanEngine* engine, const std::string_view file_path, const bool enable_mipmap/*= true*/, const VkFormat format/* = VK_FORMAT_R8G8B8A8_SRGB*/) {
 		int tex_width, tex_height, tex_channels;
 		stbi_uc* pixels = stbi_load(file_path.data(), &tex_width, &tex_height, &tex_channels, STBI_rgb_alpha);
@@ -501,134 +578,109 @@ namespace engine {
 		return load_2d_texture_from_host(engine, pixels, tex_width, tex_height, tex_channels, enable_mipmap, format);
 	}
 
-	TexturePtr Texture::load_cubemap_texture(VulkanEngine* engine, const std::span<std::string const> file_paths) {
-		int tex_width, tex_height, tex_channels;
-		float* pixels[6];
-		for (int8_t i = 0; i < 6; i++) {
-			auto const extension_name = std::filesystem::path(file_paths[i]).extension();
-			if (extension_name == ".hdr") { // hdr layout: r8g8b8e8(32-bit)
-				pixels[i] = stbi_loadf(file_paths[i].c_str(), &tex_width, &tex_height, &tex_channels, 4);
-				if (!pixels[i]) {
-					throw std::runtime_error("Error occurs when loading hdr!");
-				}
+	void HdrImage::FreePixels::operator()(float* pixels) const noexcept {
+		stbi_image_free(pixels);  //LoadEXR allocates with malloc() as well
+	}
+
+	HdrImage HdrImage::load(const std::string& file_path) {
+		HdrImage image;
+		float* pixels = nullptr;
+		int tex_channels;
+		auto const extension_name = std::filesystem::path(file_path).extension();
+		if (extension_name == ".hdr") { // hdr layout: r8g8b8e8(32-bit)
+			pixels = stbi_loadf(file_path.c_str(), &image.width, &image.height, &tex_channels, 4);
+			if (!pixels) {
+				throw std::runtime_error("Error occurs when loading hdr!");
 			}
-			else if (extension_name == ".exr") {
-				const char* err;
-				const int ret = LoadEXR(&pixels[i], &tex_width, &tex_height, file_paths[i].c_str(), &err); // LoadEXR returned layout: r32g32b32a32
-
-				if (ret != TINYEXR_SUCCESS) {
-					if (err) {
-						printf("err: %s\n", err);
-						FreeEXRErrorMessage(err);
-						throw std::runtime_error("Error occurs when loading exr!");
-					}
+		}
+		else if (extension_name == ".exr") {
+			const char* err = nullptr;
+			const int ret = LoadEXR(&pixels, &image.width, &image.height, file_path.c_str(), &err); // LoadEXR returned layout: r32g32b32a32
+
+			if (ret != TINYEXR_SUCCESS) {
+				if (err) {
+					std::cerr << "err: " << err << std::endl;
+					FreeEXRErrorMessage(err);
 				}
-			}
-			else {
-				throw std::runtime_error("Failed to load texture image! Unsupported image format.");
+				throw std::runtime_error("Error occurs when loading exr!");
 			}
 		}
-
-		const VkDeviceSize layer_size = static_cast<uint64_t>(tex_width) * tex_height * 4 * sizeof(float);
-		const VkDeviceSize image_size = layer_size * 6;
-
-		auto const staging_buffer = engine::Buffer::create_buffer(engine,
-			image_size,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			PreferredMemoryType::RAM_FOR_UPLOAD,
-			TEMP_BIT);
-
-		for (int8_t i = 0; i < 6; i++) {
-			memcpy(static_cast<char*>(staging_buffer->mapped_buffer) + layer_size * i, pixels[i], layer_size);
-			stbi_image_free(pixels[i]);
+		else {
+			throw std::runtime_error("Failed to load texture image! Unsupported image format.");
 		}
-
-		auto texture = engine::Texture::create_cubemap_texture(engine, tex_width, VK_FORMAT_R32G32B32A32_SFLOAT, SWAPCHAIN_INDEPENDENT_BIT);
-
-		texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-		texture->copy_from_buffer(staging_buffer->buffer);
-
-		//transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
-
-		texture->generate_mipmaps();
-
-		return texture;
+		image.pixels.reset(pixels);
+		return image;
 	}
 
-	TexturePtr Texture::load_prefiltered_map_texture(VulkanEngine* engine, const std::span<std::vector<std::string> const> file_path_layers) {
-
-		TexturePtr texture;
-
-		for (uint32_t mip_level = 0; mip_level < file_path_layers.size(); mip_level++) {
-			auto& file_paths = file_path_layers[mip_level];
-			int tex_width, tex_height, tex_channels;
-			float* pixels[6];
-			for (int8_t i = 0; i < 6; i++) {
-				auto const extension_name = std::filesystem::path(file_paths[i]).extension();
-				if (extension_name == ".hdr") { // hdr layout: r8g8b8e8(32-bit)
-					pixels[i] = stbi_loadf(file_paths[i].c_str(), &tex_width, &tex_height, &tex_channels, 4);
-					if (!pixels[i]) {
-						throw std::runtime_error("Error occurs when loading hdr!");
-					}
-				}
-				else if (extension_name == ".exr") {
-					const char* err;
-					const int ret = LoadEXR(&pixels[i], &tex_width, &tex_height, file_paths[i].c_str(), &err); // LoadEXR returned layout: r32g32b32a32
-
-					if (ret != TINYEXR_SUCCESS) {
-						if (err) {
-							printf("err: %s\n", err);
-							FreeEXRErrorMessage(err);
-							throw std::runtime_error("Error occurs when loading exr!");
+	PendingCubemap::PendingCubemap(ThreadPool& workers, const std::vector<std::vector<std::string>>& file_path_levels, const PendingCubemap* shared_with) :
+		file_paths(file_path_levels) {
+		levels.resize(file_paths.size());
+		for (size_t level = 0; level < file_paths.size(); ++level) {
+			if (file_paths[level].size() != 6) {
+				throw std::runtime_error("failed to load cubemap, every level needs six faces!");
+			}
+			for (size_t face = 0; face < 6; ++face) {
+				auto const& file_path = file_paths[level][face];
+				if (shared_with) {
+					for (size_t shared_level = 0; shared_level < shared_with->levels.size() && !levels[level][face].valid(); ++shared_level) {
+						auto const shared_face = std::ranges::find(shared_with->file_paths[shared_level], file_path);
+						if (shared_face != shared_with->file_paths[shared_level].end()) {
+							levels[level][face] = shared_with->levels[shared_level][shared_face - shared_with->file_paths[shared_level].begin()];
 						}
 					}
 				}
-				else {
-					throw std::runtime_error("Failed to load texture image! Unsupported image format.");
+				if (!levels[level][face].valid()) {
+					levels[level][face] = workers.submit([file_path] {
+						return decode_face(file_path);
+						}).share();
 				}
 			}
+		}
+	}
 
-			const VkDeviceSize layer_size = static_cast<uint64_t>(tex_width) * tex_height * 4 * sizeof(float);
-			const VkDeviceSize image_size = layer_size * 6;
-
-			auto const staging_buffer = engine::Buffer::create_buffer(engine,
-				image_size,
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				PreferredMemoryType::RAM_FOR_UPLOAD,
-				TEMP_BIT);
-
-			for (int8_t i = 0; i < 6; i++) {
-				memcpy(static_cast<char*>(staging_buffer->mapped_buffer) + (layer_size * i), pixels[i], layer_size);
-				stbi_image_free(pixels[i]);
-			}
+	std::shared_ptr<const PendingCubemap::Face> PendingCubemap::decode_face(const std::string& file_path) {
+		auto face = std::make_shared<Face>(HdrImage::load(file_path));
+		if (face->width != face->height) {
+			throw std::runtime_error("failed to load cubemap, faces must be square!");
+		}
+		return face;
+	}
 
-			if (mip_level == 0) {
-				texture = engine::Texture::create_cubemap_texture(
-					engine,
-					tex_width,
-					VK_FORMAT_R32G32B32A32_SFLOAT,
-					SWAPCHAIN_INDEPENDENT_BIT,
-					static_cast<uint32_t>(file_path_layers.size()));
+	TexturePtr PendingCubemap::create_texture(VulkanEngine* engine, const CreateResourceFlagBits image_description) {
+		//levels are packed one after another in the staging allocation, six faces each
+		std::vector<std::array<std::shared_ptr<const Face>, 6>> faces(levels.size());
+		std::vector<VkDeviceSize> layer_sizes(levels.size());
+		std::vector<VkDeviceSize> level_offsets(levels.size());
+		VkDeviceSize image_size = 0;
+
+		for (size_t level = 0; level < levels.size(); ++level) {
+			for (size_t face = 0; face < 6; ++face) {
+				faces[level][face] = levels[level][face].get();
+				if (faces[level][face]->width != faces[level][0]->width) {
+					throw std::runtime_error("failed to load cubemap, faces of a level differ in size!");
+				}
 			}
-
-			texture->transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-			texture->copy_from_buffer(staging_buffer->buffer, mip_level);
+			auto const tex_width = faces[level][0]->width;
+			layer_sizes[level] = static_cast<uint64_t>(tex_width) * tex_width * 4 * sizeof(float);
+			level_offsets[level] = image_size;
+			image_size += layer_sizes[level] * 6;
 		}
+		levels.clear();  //faces shared with another cubemap are freed once it is created too
+
+		const bool generate_mipmaps = faces.size() == 1;
+		auto const base_width = static_cast<uint32_t>(faces[0][0]->width);
+		auto texture = generate_mipmaps ?
+			Texture::create_cubemap_texture(engine, base_width, VK_FORMAT_R32G32B32A32_SFLOAT, image_description) :
+			Texture::create_cubemap_texture(engine, base_width, VK_FORMAT_R32G32B32A32_SFLOAT, image_description, static_cast<uint32_t>(faces.size()));
+
+		upload_texture(engine, *texture, image_size, [&](std::byte* staging_data) {
+			for (size_t level = 0; level < faces.size(); ++level) {
+				for (size_t face = 0; face < 6; ++face) {
+					memcpy(staging_data + level_offsets[level] + layer_sizes[level] * face, faces[level][face]->pixels.get(), layer_sizes[level]);
+				}
+			}
+			}, level_offsets, generate_mipmaps);
 
-		//transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
-		immediate_submit(engine, [=](VkCommandBuffer command_buffer) {
-			texture->insert_memory_barrier(
-				command_buffer,
-				VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-				VK_ACCESS_2_TRANSFER_WRITE_BIT,
-				VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-				VK_ACCESS_2_SHADER_READ_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-			);
-			});
 		return texture;
 	}
 }
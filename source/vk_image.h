@@ -2,10 +2,17 @@
 
 #include "vk_types.h"
 #include "vk_memory.h"
+#include "vk_memory_stats.h"
 
+#include <array>
+#include <future>
+#include <memory>
 #include <span>
+#include <string>
+#include <vector>
 
 class VulkanEngine;
+class ThreadPool;
 
 enum class QueueFamilyCategory {
 	GRAPHICS,
@@ -28,6 +35,8 @@ namespace engine {
 		VkFormat format;
 		uint32_t mip_levels = 0;
 		uint32_t layer_count;
+		MemoryCategory memory_category = MemoryCategoryScope::current();
+		VkDeviceSize allocation_size = 0;
 
 		Image(VulkanEngine* engine, uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits sample_count_flag,
 			VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, PreferredMemoryType preferred_memory_type,
@@ -52,14 +61,21 @@ namespace engine {
 
 		void copy_from_buffer(VkBuffer buffer, uint32_t mip_level = 0);
 
+		void record_copy_from_buffer(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize buffer_offset, uint32_t mip_level) const;
+
+		void check_linear_blit_support() const;
+
 		void generate_mipmaps() const;
+
+		//expects every level in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL and leaves them in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		void record_generate_mipmaps(VkCommandBuffer command_buffer) const;
 	};
 
 
 	struct Texture : public Image {
 		using TexturePtr = std::shared_ptr<Texture>;
 	public:
-		VkSampler sampler = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;  //owned by engine->sampler_cache
 
 		Texture(VulkanEngine* engine, uint32_t tex_width, uint32_t tex_height, uint32_t mip_levels, VkSampleCountFlagBits sample_count_flag,
 			VkFormat img_format, VkImageTiling img_tiling, VkImageUsageFlags img_usage, PreferredMemoryType preferred_memory_type,
@@ -70,6 +86,10 @@ namespace engine {
 
 		void add_resource_release_callback(CreateResourceFlagBits image_description);
 
+		//replaces the first level with tightly packed texels through engine->upload_ring, the previous content is discarded.
+		//Returns the UploadRing value that marks the upload as complete
+		uint64_t upload_pixels(std::span<const std::byte> pixels) const;
+
 		static TexturePtr create_2d_texture(VulkanEngine* engine, uint32_t width, uint32_t height, VkFormat format, CreateResourceFlagBits image_description);
 
 		static TexturePtr create_2d_texture(VulkanEngine* engine, uint32_t width, uint32_t height, VkFormat format, CreateResourceFlagBits image_description, uint32_t mip_levels);
@@ -78,6 +98,9 @@ namespace engine {
 
 		static TexturePtr create_device_texture(VulkanEngine* engine, uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspectFlags, VkImageUsageFlags usage_flag, CreateResourceFlagBits image_description = SWAPCHAIN_INDEPENDENT_BIT, bool greyscale = false);
 
+		//a fresh texture without a release callback, the image is destroyed with the object
+		static std::unique_ptr<Texture> create_device_texture_unique(VulkanEngine* engine, uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspectFlags, VkImageUsageFlags usage_flag, bool greyscale = false);
+
 		static TexturePtr create_cubemap_texture(VulkanEngine* engine, uint32_t width, VkFormat format, CreateResourceFlagBits image_description);
 
 		static TexturePtr create_cubemap_texture(VulkanEngine* engine, uint32_t width, VkFormat format, CreateResourceFlagBits image_description, uint32_t mip_levels);
@@ -86,11 +109,46 @@ namespace engine {
 
 		static TexturePtr load_2d_texture(VulkanEngine* engine, std::string_view file_path, bool enable_mipmap = true, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
 
-		static TexturePtr load_cubemap_texture(VulkanEngine* engine, std::span<std::string const> file_paths);
-
-		static TexturePtr load_prefiltered_map_texture(VulkanEngine* engine, std::span<std::vector<std::string> const> file_path_layers);
 	};
 	using TexturePtr = std::shared_ptr<engine::Texture>;
+
+	//RGBA32F texels of an .hdr or .exr file
+	struct HdrImage {
+		struct FreePixels {
+			void operator()(float* pixels) const noexcept;
+		};
+
+		std::unique_ptr<float, FreePixels> pixels;
+		int width = 0;
+		int height = 0;
+
+		[[nodiscard]] static HdrImage load(const std::string& file_path);
+
+		[[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+			return { reinterpret_cast<const std::byte*>(pixels.get()), static_cast<size_t>(width) * height * 4 * sizeof(float) };
+		}
+	};
+
+	//Cubemap decoded to RGBA32F texels on a thread pool, one job per face and mip level, so an environment decodes while
+	//the device is being created. create_texture() waits for the faces and stages every level in one upload
+	class PendingCubemap {
+	public:
+		//each level lists its +x -x +y -y +z -z faces in .hdr or .exr, a single level gets its mipmaps generated.
+		//Faces shared_with already decodes are not decoded twice
+		PendingCubemap(ThreadPool& workers, const std::vector<std::vector<std::string>>& file_path_levels, const PendingCubemap* shared_with = nullptr);
+
+		[[nodiscard]] TexturePtr create_texture(VulkanEngine* engine, CreateResourceFlagBits image_description = SWAPCHAIN_INDEPENDENT_BIT);
+
+	private:
+		using Face = HdrImage;
+
+		using FaceFuture = std::shared_future<std::shared_ptr<const Face>>;
+
+		std::vector<std::vector<std::string>> file_paths;
+		std::vector<std::array<FaceFuture, 6>> levels;
+
+		static std::shared_ptr<const Face> decode_face(const std::string& file_path);
+	};
 }
 
 
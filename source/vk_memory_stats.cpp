@@ -0,0 +1,135 @@
+#include "vk_memory_stats.h"
+#include "vk_engine.h"
+
+#include <json.hpp>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace engine {
+	namespace {
+		thread_local MemoryCategory current_memory_category = MemoryCategory::OTHER;
+	}
+
+	MemoryCategoryScope::MemoryCategoryScope(const MemoryCategory category) noexcept : previous(current_memory_category) {
+		current_memory_category = category;
+	}
+
+	MemoryCategoryScope::~MemoryCategoryScope() {
+		current_memory_category = previous;
+	}
+
+	MemoryCategory MemoryCategoryScope::current() noexcept {
+		return current_memory_category;
+	}
+
+	MemoryStats::MemoryStats(VulkanEngine* engine) : engine(engine) {
+		const VkPhysicalDeviceMemoryProperties* memory_properties;
+		vmaGetMemoryProperties(engine->vma_allocator, &memory_properties);
+		heaps.resize(memory_properties->memoryHeapCount);
+		for (uint32_t i = 0; i < memory_properties->memoryHeapCount; ++i) {
+			heaps[i].device_local = memory_properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		}
+	}
+
+	void MemoryStats::track(const MemoryCategory category, const VkDeviceSize size) noexcept {
+		category_bytes[static_cast<size_t>(category)].fetch_add(size, std::memory_order_relaxed);
+		category_allocation_nums[static_cast<size_t>(category)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void MemoryStats::untrack(const MemoryCategory category, const VkDeviceSize size) noexcept {
+		category_bytes[static_cast<size_t>(category)].fetch_sub(size, std::memory_order_relaxed);
+		category_allocation_nums[static_cast<size_t>(category)].fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	MemoryStats::CategoryUsage MemoryStats::category_usage(const MemoryCategory category) noexcept {
+		return CategoryUsage{
+			.bytes = category_bytes[static_cast<size_t>(category)].load(std::memory_order_relaxed),
+			.allocation_num = category_allocation_nums[static_cast<size_t>(category)].load(std::memory_order_relaxed),
+		};
+	}
+
+	MemoryCategory MemoryStats::classify_buffer(const VkBufferUsageFlags usage, const PreferredMemoryType preferred_memory_type) noexcept {
+		if (preferred_memory_type == PreferredMemoryType::RAM_FOR_UPLOAD || preferred_memory_type == PreferredMemoryType::RAM_FOR_DOWNLOAD) {
+			return MemoryCategory::STAGING;
+		}
+		if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+			return MemoryCategory::UBO;
+		}
+		if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+			return MemoryCategory::MESH;
+		}
+		return MemoryCategoryScope::current();
+	}
+
+	void MemoryStats::update(const uint32_t frame_index) {
+		vmaSetCurrentFrameIndex(engine->vma_allocator, frame_index);
+
+		std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets;
+		vmaGetHeapBudgets(engine->vma_allocator, budgets.data());
+		for (size_t i = 0; i < heaps.size(); ++i) {
+			heaps[i].usage = budgets[i].usage;
+			heaps[i].budget = budgets[i].budget;
+			heaps[i].allocation_bytes = budgets[i].statistics.allocationBytes;
+			heaps[i].allocation_num = budgets[i].statistics.allocationCount;
+		}
+
+		auto const usage_ratio = device_local_usage_ratio();
+		if (!warned && usage_ratio >= budget_warning_ratio) {
+			std::cerr << std::format("warning: device local memory is at {:.0f}% of its budget, further node textures may fail to allocate!", usage_ratio * 100.0f) << std::endl;
+			warned = true;
+		}
+		else if (warned && usage_ratio < budget_warning_ratio - 0.05f) {  //hysteresis, warn again only after usage dropped
+			warned = false;
+		}
+	}
+
+	const std::vector<MemoryStats::HeapBudget>& MemoryStats::heap_budgets() const noexcept {
+		return heaps;
+	}
+
+	float MemoryStats::device_local_usage_ratio() const noexcept {
+		float ratio = 0.0f;
+		for (auto const& heap : heaps) {
+			if (heap.device_local && heap.budget > 0) {
+				ratio = std::max(ratio, static_cast<float>(heap.usage) / static_cast<float>(heap.budget));
+			}
+		}
+		return ratio;
+	}
+
+	bool MemoryStats::near_budget() const noexcept {
+		return device_local_usage_ratio() >= budget_warning_ratio;
+	}
+
+	void MemoryStats::save_snapshot(const std::filesystem::path& file_path) const {
+		json snapshot;
+		snapshot["memory_budget_extension"] = engine->memory_budget_supported;
+		for (size_t i = 0; i < heaps.size(); ++i) {
+			snapshot["heaps"].push_back({
+				{ "index", i },
+				{ "device_local", heaps[i].device_local },
+				{ "usage", heaps[i].usage },
+				{ "budget", heaps[i].budget },
+				{ "allocation_bytes", heaps[i].allocation_bytes },
+				{ "allocation_num", heaps[i].allocation_num },
+				});
+		}
+		for (size_t i = 0; i < memory_category_num; ++i) {
+			auto const [bytes, allocation_num] = category_usage(static_cast<MemoryCategory>(i));
+			snapshot["categories"][std::string(memory_category_names[i])] = {
+				{ "bytes", bytes },
+				{ "allocation_num", allocation_num },
+			};
+		}
+
+		std::ofstream o_file(file_path);
+		if (!o_file) {
+			throw std::runtime_error("failed to open memory snapshot file!");
+		}
+		o_file << std::setw(4) << snapshot;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_memory.h"
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+class VulkanEngine;
+
+enum class MemoryCategory : uint8_t {
+	NODE_TEXTURE = 0,
+	PREVIEW,
+	UBO,
+	PBR_COPY,
+	HDRI,
+	MESH,
+	STAGING,
+	OTHER,
+};
+
+inline constexpr size_t memory_category_num = static_cast<size_t>(MemoryCategory::OTHER) + 1;
+
+inline constexpr std::array<std::string_view, memory_category_num> memory_category_names{
+	"Node Textures", "Previews", "UBOs", "PBR Copies", "HDRi", "Meshes", "Staging", "Other",
+};
+
+namespace engine {
+	//Category images are attributed to while a scope is alive on this thread, buffers are classified by usage instead
+	class MemoryCategoryScope {
+	public:
+		explicit MemoryCategoryScope(MemoryCategory category) noexcept;
+
+		~MemoryCategoryScope();
+
+		MemoryCategoryScope(const MemoryCategoryScope&) = delete;
+		MemoryCategoryScope& operator=(const MemoryCategoryScope&) = delete;
+
+		[[nodiscard]] static MemoryCategory current() noexcept;
+
+	private:
+		MemoryCategory previous;
+	};
+
+	//Per heap budget and usage from VMA (exact with VK_EXT_memory_budget, estimated otherwise) plus the bytes every
+	//category holds. Images and buffers report themselves in track()/untrack(), so the counters are process wide.
+	class MemoryStats {
+	public:
+		constexpr static inline float budget_warning_ratio = 0.9f;
+
+		struct HeapBudget {
+			VkDeviceSize usage;
+			VkDeviceSize budget;
+			VkDeviceSize allocation_bytes;  //bytes in VMA allocations, usage also counts other processes and block slack
+			uint32_t allocation_num;
+			bool device_local;
+		};
+
+		struct CategoryUsage {
+			VkDeviceSize bytes;
+			uint32_t allocation_num;
+		};
+
+		explicit MemoryStats(VulkanEngine* engine);
+
+		static void track(MemoryCategory category, VkDeviceSize size) noexcept;
+
+		static void untrack(MemoryCategory category, VkDeviceSize size) noexcept;
+
+		[[nodiscard]] static CategoryUsage category_usage(MemoryCategory category) noexcept;
+
+		//buffers attribute themselves by usage and memory type, images by the current MemoryCategoryScope
+		[[nodiscard]] static MemoryCategory classify_buffer(VkBufferUsageFlags usage, PreferredMemoryType preferred_memory_type) noexcept;
+
+		//polls the heap budgets once per frame and warns on stderr when a device local heap crosses budget_warning_ratio
+		void update(uint32_t frame_index);
+
+		[[nodiscard]] const std::vector<HeapBudget>& heap_budgets() const noexcept;
+
+		//highest usage / budget ratio among device local heaps
+		[[nodiscard]] float device_local_usage_ratio() const noexcept;
+
+		[[nodiscard]] bool near_budget() const noexcept;
+
+		void save_snapshot(const std::filesystem::path& file_path) const;
+
+	private:
+		VulkanEngine* engine;
+		std::vector<HeapBudget> heaps;
+		bool warned = false;
+
+		static inline std::array<std::atomic<VkDeviceSize>, memory_category_num> category_bytes{};
+		static inline std::array<std::atomic<uint32_t>, memory_category_num> category_allocation_nums{};
+	};
+}
@@ -1,5 +1,6 @@
 #include "vk_mesh.h"
 #include "vk_engine.h"
+#include "vk_upload_ring.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
@@ -8,6 +9,8 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <array>
+#include <span>
 #include <stdexcept>
 #include <iostream>
 
@@ -214,14 +217,7 @@ namespace engine {
 
 	void Mesh::upload(VulkanEngine* engine) {
 		const VkDeviceSize vertex_buffer_size = sizeof(_vertices[0]) * _vertices.size();
-
-		auto const staging_vertex_buffer = engine::Buffer::create_buffer(engine,
-			vertex_buffer_size,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			PreferredMemoryType::RAM_FOR_UPLOAD,
-			TEMP_BIT);
-
-		staging_vertex_buffer->copy_from_host(_vertices.data());
+		const VkDeviceSize index_buffer_size = sizeof(_indices[0]) * _indices.size();
 
 		vertex_buffer = engine::Buffer::create_buffer(engine,
 			vertex_buffer_size,
@@ -229,24 +225,84 @@ namespace engine {
 			PreferredMemoryType::VRAM_UNMAPPABLE,
 			SWAPCHAIN_INDEPENDENT_BIT);
 
-		vertex_buffer->copy_from_buffer(engine, staging_vertex_buffer->buffer);
-
-		const VkDeviceSize index_buffer_size = sizeof(_indices[0]) * _indices.size();
-
-		auto const staging_index_buffer = engine::Buffer::create_buffer(engine,
-			index_buffer_size,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			PreferredMemoryType::RAM_FOR_UPLOAD,
-			TEMP_BIT);
-
-		staging_index_buffer->copy_from_host(_indices.data());
-
 		index_buffer = engine::Buffer::create_buffer(engine,
 			index_buffer_size,
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 			PreferredMemoryType::VRAM_UNMAPPABLE,
 			SWAPCHAIN_INDEPENDENT_BIT);
 
-		index_buffer->copy_from_buffer(engine, staging_index_buffer->buffer);
+		//vertices and indices share one staging range, indices follow the aligned vertex data
+		constexpr VkDeviceSize alignment = engine::UploadRing::default_alignment;
+		const VkDeviceSize index_offset = (vertex_buffer_size + alignment - 1) / alignment * alignment;
+		auto& upload_ring = *engine->upload_ring;
+
+		auto buffer_barriers = [&](const VkPipelineStageFlags2 src_stage_mask, const VkAccessFlags2 src_access_mask,
+			const VkPipelineStageFlags2 dst_stage_mask, const VkAccessFlags2 vertex_access_mask, const VkAccessFlags2 index_access_mask) {
+			return std::array{
+				VkBufferMemoryBarrier2{
+					.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+					.srcStageMask = src_stage_mask,
+					.srcAccessMask = src_access_mask,
+					.dstStageMask = dst_stage_mask,
+					.dstAccessMask = vertex_access_mask,
+					.srcQueueFamilyIndex = upload_ring.src_queue_family(),
+					.dstQueueFamilyIndex = upload_ring.dst_queue_family(),
+					.buffer = vertex_buffer->buffer,
+					.offset = 0,
+					.size = VK_WHOLE_SIZE,
+				},
+				VkBufferMemoryBarrier2{
+					.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+					.srcStageMask = src_stage_mask,
+					.srcAccessMask = src_access_mask,
+					.dstStageMask = dst_stage_mask,
+					.dstAccessMask = index_access_mask,
+					.srcQueueFamilyIndex = upload_ring.src_queue_family(),
+					.dstQueueFamilyIndex = upload_ring.dst_queue_family(),
+					.buffer = index_buffer->buffer,
+					.offset = 0,
+					.size = VK_WHOLE_SIZE,
+				},
+			};
+		};
+
+		auto record_barriers = [](VkCommandBuffer command_buffer, const std::span<const VkBufferMemoryBarrier2> barriers) {
+			const VkDependencyInfo dependency_info{
+				.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+				.bufferMemoryBarrierCount = static_cast<uint32_t>(barriers.size()),
+				.pBufferMemoryBarriers = barriers.data(),
+			};
+			vkCmdPipelineBarrier2(command_buffer, &dependency_info);
+		};
+
+		upload_ring.upload(index_offset + index_buffer_size,
+			[&](std::byte* staging_data) {
+				memcpy(staging_data, _vertices.data(), vertex_buffer_size);
+				memcpy(staging_data + index_offset, _indices.data(), index_buffer_size);
+			},
+			[&](VkCommandBuffer command_buffer, VkBuffer staging_buffer, VkDeviceSize staging_offset) {
+				const VkBufferCopy vertex_copy_region{
+					.srcOffset = staging_offset,
+					.size = vertex_buffer_size,
+				};
+				vkCmdCopyBuffer(command_buffer, staging_buffer, vertex_buffer->buffer, 1, &vertex_copy_region);
+
+				const VkBufferCopy index_copy_region{
+					.srcOffset = staging_offset + index_offset,
+					.size = index_buffer_size,
+				};
+				vkCmdCopyBuffer(command_buffer, staging_buffer, index_buffer->buffer, 1, &index_copy_region);
+
+				//release to the graphics family
+				record_barriers(command_buffer, buffer_barriers(
+					VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+					VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_ACCESS_2_NONE));
+			},
+			[&](VkCommandBuffer command_buffer) {
+				record_barriers(command_buffer, buffer_barriers(
+					VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_NONE,
+					VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+					VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, VK_ACCESS_2_INDEX_READ_BIT));
+			});
 	}
 }
@@ -0,0 +1,201 @@
+#include "vk_parameter_ring.h"
+#include "vk_engine.h"
+#include "vk_initializers.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+	ParameterRing::ParameterRing(VulkanEngine* engine) : engine(engine) {
+		ring_buffer = std::make_unique<Buffer>(
+			engine->vma_allocator,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			PreferredMemoryType::RAM_FOR_UPLOAD,
+			ring_size);
+
+		const VkCommandPoolCreateInfo pool_info = vkinit::command_pool_create_info(engine->queue_family_indices.graphics_family.value(), VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		if (vkCreateCommandPool(engine->device, &pool_info, nullptr, &command_pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create parameter command pool!");
+		}
+
+		constexpr VkSemaphoreTypeCreateInfo timeline_semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.pNext = nullptr,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+
+		const VkSemaphoreCreateInfo semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &timeline_semaphore_create_info,
+			.flags = 0,
+		};
+
+		if (vkCreateSemaphore(engine->device, &semaphore_create_info, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create parameter timeline semaphore!");
+		}
+	}
+
+	ParameterRing::~ParameterRing() {
+		wait(version);
+		reclaim(version);
+		vkDestroyCommandPool(engine->device, command_pool, nullptr);
+		vkDestroySemaphore(engine->device, semaphore, nullptr);
+	}
+
+	void ParameterRing::stage(const VkBuffer dst_buffer, const VkDeviceSize dst_offset, const void* data, const VkDeviceSize size) {
+		std::optional<VkDeviceSize> offset;
+		while (!(offset = ring_allocator.allocate(size, alignment, version + 1))) {
+			//ranges of the version being staged only free up after submit()
+			auto const oldest_value = ring_allocator.oldest_value();
+			if (!oldest_value || *oldest_value > version) {
+				throw std::runtime_error("failed to stage node parameters, the parameter ring is full!");
+			}
+			wait(*oldest_value);
+			reclaim(*oldest_value);
+		}
+
+		memcpy(static_cast<std::byte*>(ring_buffer->mapped_buffer) + *offset, data, size);
+		staged_copies.push_back({
+			.dst_buffer = dst_buffer,
+			.region = {
+				.srcOffset = *offset,
+				.dstOffset = dst_offset,
+				.size = size,
+			},
+		});
+	}
+
+	void ParameterRing::record_copies(const VkCommandBuffer command_buffer) {
+		//the previous evaluation may still read the uniforms about to be overwritten
+		constexpr VkMemoryBarrier2 war_barrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+			.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			.srcAccessMask = VK_ACCESS_2_NONE,
+			.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+			.dstAccessMask = VK_ACCESS_2_NONE,
+		};
+		constexpr VkMemoryBarrier2 raw_barrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+			.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+			.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			.dstAccessMask = VK_ACCESS_2_UNIFORM_READ_BIT,
+		};
+		auto record_barrier = [command_buffer](const VkMemoryBarrier2& barrier) {
+			const VkDependencyInfo dependency_info{
+				.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+				.memoryBarrierCount = 1,
+				.pMemoryBarriers = &barrier,
+			};
+			vkCmdPipelineBarrier2(command_buffer, &dependency_info);
+		};
+
+		record_barrier(war_barrier);
+
+		//one vkCmdCopyBuffer per destination buffer, in practice the uniform arena
+		std::ranges::stable_sort(staged_copies, std::less{}, &StagedCopy::dst_buffer);
+		std::vector<VkBufferCopy> regions;
+		regions.reserve(staged_copies.size());
+		for (auto copy = staged_copies.begin(); copy != staged_copies.end();) {
+			auto const dst_buffer = copy->dst_buffer;
+			regions.clear();
+			for (; copy != staged_copies.end() && copy->dst_buffer == dst_buffer; ++copy) {
+				regions.push_back(copy->region);
+			}
+			vkCmdCopyBuffer(command_buffer, ring_buffer->buffer, dst_buffer, static_cast<uint32_t>(regions.size()), regions.data());
+		}
+
+		record_barrier(raw_barrier);
+	}
+
+	std::optional<uint64_t> ParameterRing::submit() {
+		if (staged_copies.empty()) {
+			return std::nullopt;
+		}
+		vmaFlushAllocation(engine->vma_allocator, ring_buffer->allocation, 0, VK_WHOLE_SIZE);
+
+		const VkCommandBufferAllocateInfo cmd_allocate_info = vkinit::command_buffer_allocate_info(command_pool, 1);
+		VkCommandBuffer command_buffer;
+		if (vkAllocateCommandBuffers(engine->device, &cmd_allocate_info, &command_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffers!");
+		}
+
+		constexpr VkCommandBufferBeginInfo begin_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		};
+		if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		record_copies(command_buffer);
+		if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+		staged_copies.clear();
+
+		const VkCommandBufferSubmitInfo cmd_buffer_submit_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+			.commandBuffer = command_buffer,
+		};
+
+		const VkSemaphoreSubmitInfo signal_semaphore_submit_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.semaphore = semaphore,
+			.value = version + 1,
+			.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		};
+
+		const VkSubmitInfo2 submit_info{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &cmd_buffer_submit_info,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &signal_semaphore_submit_info,
+		};
+
+		if (vkQueueSubmit2(engine->graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit parameter command buffer!");
+		}
+
+		in_flight_versions.push_back({ .value = ++version, .command_buffer = command_buffer });
+		return version;
+	}
+
+	void ParameterRing::reclaim(const uint64_t completed_value) {
+		ring_allocator.release(completed_value);
+		while (!in_flight_versions.empty() && in_flight_versions.front().value <= completed_value) {
+			vkFreeCommandBuffers(engine->device, command_pool, 1, &in_flight_versions.front().command_buffer);
+			in_flight_versions.pop_front();
+		}
+	}
+
+	bool ParameterRing::is_complete(const uint64_t value) const {
+		uint64_t completed_value;
+		vkGetSemaphoreCounterValue(engine->device, semaphore, &completed_value);
+		return value <= completed_value;
+	}
+
+	void ParameterRing::wait(const uint64_t value) const {
+		const VkSemaphoreWaitInfo wait_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.semaphoreCount = 1,
+			.pSemaphores = &semaphore,
+			.pValues = &value,
+		};
+		if (vkWaitSemaphores(engine->device, &wait_info, VULKAN_WAIT_TIMEOUT) != VK_SUCCESS) {
+			throw std::runtime_error("failed to wait for node parameters to be copied!");
+		}
+	}
+
+	void ParameterRing::update() {
+		uint64_t completed_value;
+		vkGetSemaphoreCounterValue(engine->device, semaphore, &completed_value);
+		reclaim(completed_value);
+	}
+
+	size_t ParameterRing::in_flight_count() const noexcept {
+		return in_flight_versions.size();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_buffer.h"
+#include "util/ring_allocator.h"
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class VulkanEngine;
+
+namespace engine {
+	//Versions node parameters between the host and the GPU. The editor writes parameters into host shadows at any time,
+	//execute_graph() stages the dirty ones into this RAM_FOR_UPLOAD ring and submit() copies them into their uniform arena
+	//slots on the graphics queue, ahead of the evaluation that reads them. Every submission signals the next value of a
+	//timeline semaphore, its ring ranges are reused once that value completes, so a version stays intact until consumed.
+	//The copy is framed by barriers against earlier uniform reads and later ones, compute work is ordered behind it
+	//through the node semaphores that graphics submissions signal with ALL_COMMANDS.
+	class ParameterRing {
+	public:
+		constexpr static inline VkDeviceSize ring_size = 1ull << 20;
+		constexpr static inline VkDeviceSize alignment = 16;  //std140 vec4 alignment
+
+		explicit ParameterRing(VulkanEngine* engine);
+
+		~ParameterRing();
+
+		ParameterRing(const ParameterRing&) = delete;
+		ParameterRing& operator=(const ParameterRing&) = delete;
+
+		//copies size bytes of data into the ring, the next submit() writes them to dst_buffer at dst_offset
+		void stage(VkBuffer dst_buffer, VkDeviceSize dst_offset, const void* data, VkDeviceSize size);
+
+		//records and submits the staged copies, returns the value signaled once they are done or nullopt if nothing was staged
+		std::optional<uint64_t> submit();
+
+		[[nodiscard]] bool is_complete(uint64_t value) const;
+
+		void wait(uint64_t value) const;
+
+		//reclaims ring ranges and command buffers of finished versions, call once per frame
+		void update();
+
+		[[nodiscard]] size_t in_flight_count() const noexcept;
+
+	private:
+		struct StagedCopy {
+			VkBuffer dst_buffer;
+			VkBufferCopy region;
+		};
+
+		struct InFlightVersion {
+			uint64_t value;
+			VkCommandBuffer command_buffer;
+		};
+
+		VulkanEngine* engine;
+		std::unique_ptr<Buffer> ring_buffer;
+		RingAllocator ring_allocator{ ring_size };
+		std::vector<StagedCopy> staged_copies;
+		std::deque<InFlightVersion> in_flight_versions;
+
+		VkCommandPool command_pool = VK_NULL_HANDLE;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		uint64_t version = 0;  //value of the last submission
+
+		void reclaim(uint64_t completed_value);
+
+		void record_copies(VkCommandBuffer command_buffer);
+	};
+}
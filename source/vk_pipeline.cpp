@@ -2,10 +2,12 @@
 #include "vk_mesh.h"
 #include "vk_initializers.h"
 #include "vk_engine.h"
+#include "vk_pipeline_cache.h"
 #include <stdexcept>
 
 namespace engine {
-	PipelineBuilder::PipelineBuilder(VulkanEngine* engine, DynamicViewportFlagBits dynamic_viewport, VertexInputFlagBits enable_vertex_input) {
+	PipelineBuilder::PipelineBuilder(VulkanEngine* engine, DynamicViewportFlagBits dynamic_viewport, VertexInputFlagBits enable_vertex_input) :
+		pipeline_cache(engine->pipeline_cache->handle()) {
 		if (enable_vertex_input == ENABLE_VERTEX_INPUT) {
 			bindingDescriptions = Vertex::get_binding_descriptions();
 			attributeDescriptions = Vertex::get_attribute_descriptions();
@@ -102,7 +104,7 @@ namespace engine {
 			.subpass = 0,
 			.basePipelineHandle = VK_NULL_HANDLE,
 		};
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(device, pipeline_cache, 1, &pipeline_info, nullptr, &graphicsPipeline) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create graphics pipeline!");
 		}
 	}
@@ -34,6 +34,7 @@ namespace engine {
 		VkSpecializationInfo specializationInfo;
 		VkPipelineDynamicStateCreateInfo dynamicState;
 		void* p_next = VK_NULL_HANDLE;
+		VkPipelineCache pipeline_cache = VK_NULL_HANDLE;  //engine->pipeline_cache
 
 		const std::array<VkDynamicState, 2> dynamicStateEnables = {
 			VK_DYNAMIC_STATE_VIEWPORT,
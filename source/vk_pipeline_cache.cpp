@@ -0,0 +1,111 @@
+#include "vk_pipeline_cache.h"
+#include "vk_engine.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+	PipelineCache::PipelineCache(VulkanEngine* engine, std::filesystem::path file_path) :
+		engine(engine),
+		file_path(std::move(file_path)) {
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(engine->physical_device, &properties);
+		expected_header = Header{
+			.magic = header_magic,
+			.header_size = sizeof(Header),
+			.vendor_id = properties.vendorID,
+			.device_id = properties.deviceID,
+			.driver_version = properties.driverVersion,
+		};
+		memcpy(expected_header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		std::vector<char> initial_data;
+		if (std::ifstream i_file(this->file_path, std::ios::binary | std::ios::ate); i_file) {
+			auto const file_size = static_cast<uint64_t>(i_file.tellg());
+			Header header{};
+			i_file.seekg(0);
+			if (file_size >= sizeof(Header) && i_file.read(reinterpret_cast<char*>(&header), sizeof(Header))) {
+				//the blob itself also starts with VkPipelineCacheHeaderVersionOne, which the driver validates again
+				Header matching_header = expected_header;
+				matching_header.data_size = file_size - sizeof(Header);
+				if (header == matching_header) {
+					initial_data.resize(header.data_size);
+					if (!i_file.read(initial_data.data(), static_cast<std::streamsize>(initial_data.size()))) {
+						initial_data.clear();
+					}
+				}
+				else {
+					std::cerr << "pipeline cache " << this->file_path << " was written by another device or driver, starting empty" << std::endl;
+				}
+			}
+		}
+
+		const VkPipelineCacheCreateInfo pipeline_cache_info{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			.initialDataSize = initial_data.size(),
+			.pInitialData = initial_data.empty() ? nullptr : initial_data.data(),
+		};
+		if (vkCreatePipelineCache(engine->device, &pipeline_cache_info, nullptr, &pipeline_cache) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+		loaded = !initial_data.empty();
+	}
+
+	PipelineCache::~PipelineCache() {
+		try {
+			save();
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;  //a stale cache only costs compile time on the next launch
+		}
+		vkDestroyPipelineCache(engine->device, pipeline_cache, nullptr);
+	}
+
+	VkPipelineCache PipelineCache::handle() const noexcept {
+		return pipeline_cache;
+	}
+
+	void PipelineCache::merge(const std::span<const VkPipelineCache> src_caches) const {
+		if (src_caches.empty()) {
+			return;
+		}
+		if (vkMergePipelineCaches(engine->device, pipeline_cache, static_cast<uint32_t>(src_caches.size()), src_caches.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to merge pipeline caches!");
+		}
+	}
+
+	void PipelineCache::save() const {
+		size_t data_size = 0;
+		if (vkGetPipelineCacheData(engine->device, pipeline_cache, &data_size, nullptr) != VK_SUCCESS) {
+			throw std::runtime_error("failed to get pipeline cache data!");
+		}
+		std::vector<char> data(data_size);
+		if (vkGetPipelineCacheData(engine->device, pipeline_cache, &data_size, data.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to get pipeline cache data!");
+		}
+
+		Header header = expected_header;
+		header.data_size = data_size;
+
+		if (file_path.has_parent_path()) {
+			std::filesystem::create_directories(file_path.parent_path());
+		}
+		auto temp_path = file_path;
+		temp_path += ".tmp";
+		{
+			std::ofstream o_file(temp_path, std::ios::binary | std::ios::trunc);
+			if (!o_file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) ||
+				!o_file.write(data.data(), static_cast<std::streamsize>(data_size))) {
+				throw std::runtime_error("failed to write pipeline cache file!");
+			}
+		}
+		std::filesystem::rename(temp_path, file_path);
+	}
+
+	bool PipelineCache::loaded_from_disk() const noexcept {
+		return loaded;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "vk_types.h"
+
+#include <filesystem>
+#include <span>
+#include <type_traits>
+
+class VulkanEngine;
+
+namespace engine {
+	//One VkPipelineCache shared by every pipeline the engine builds. It is seeded from file_path at startup and written
+	//back when destroyed. The file starts with a Header naming the device and driver that produced the blob, and a blob
+	//from any other device or driver version is discarded before the driver ever sees it.
+	class PipelineCache {
+	public:
+		explicit PipelineCache(VulkanEngine* engine, std::filesystem::path file_path);
+
+		~PipelineCache();
+
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+
+		[[nodiscard]] VkPipelineCache handle() const noexcept;
+
+		//folds caches filled elsewhere (e.g. by worker threads) into the shared one
+		void merge(std::span<const VkPipelineCache> src_caches) const;
+
+		//writes the cache through a temporary file, so an interrupted save leaves the previous file intact
+		void save() const;
+
+		[[nodiscard]] bool loaded_from_disk() const noexcept;
+
+	private:
+		struct Header {
+			uint32_t magic;
+			uint32_t header_size;
+			uint32_t vendor_id;
+			uint32_t device_id;
+			uint32_t driver_version;
+			uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+			uint32_t reserved = 0;  //would be padding before data_size, named so no uninitialized bytes reach the file
+			uint64_t data_size;
+
+			bool operator==(const Header&) const = default;
+		};
+		static_assert(std::has_unique_object_representations_v<Header>, "Header is written to disk and must not have padding");
+
+		constexpr static inline uint32_t header_magic = 0x43505854;  //"TXPC"
+
+		VulkanEngine* engine;
+		std::filesystem::path file_path;
+		Header expected_header{};
+		VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+		bool loaded = false;
+	};
+}
@@ -0,0 +1,53 @@
+#include "vk_sampler_cache.h"
+#include "vk_engine.h"
+#include "vk_initializers.h"
+
+#include <ranges>
+#include <stdexcept>
+
+namespace engine {
+	size_t SamplerCache::KeyHash::operator()(const Key& key) const noexcept {
+		size_t seed = std::hash<uint32_t>{}(key.mip_levels);
+		for (auto const value : { static_cast<uint32_t>(key.filter), static_cast<uint32_t>(key.address_mode), static_cast<uint32_t>(key.anisotropy) }) {
+			seed ^= std::hash<uint32_t>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}
+		return seed;
+	}
+
+	SamplerCache::SamplerCache(VulkanEngine* engine) : engine(engine) {}
+
+	SamplerCache::~SamplerCache() {
+		for (auto const sampler : samplers | std::views::values) {
+			vkDestroySampler(engine->device, sampler, nullptr);
+		}
+	}
+
+	VkSampler SamplerCache::get(const VkFilter filter, const uint32_t mip_levels, const VkSamplerAddressMode address_mode, const bool anisotropy) {
+		const Key key{
+			.filter = filter,
+			.address_mode = address_mode,
+			.mip_levels = mip_levels,
+			.anisotropy = anisotropy,
+		};
+
+		std::lock_guard lock(mutex);
+		if (auto const iter = samplers.find(key); iter != samplers.end()) {
+			return iter->second;
+		}
+
+		VkSamplerCreateInfo sampler_info = vkinit::sampler_create_info(engine->physical_device, filter, mip_levels, address_mode);
+		sampler_info.anisotropyEnable = anisotropy ? VK_TRUE : VK_FALSE;
+
+		VkSampler sampler;
+		if (vkCreateSampler(engine->device, &sampler_info, nullptr, &sampler) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create texture sampler!");
+		}
+		samplers.emplace(key, sampler);
+		return sampler;
+	}
+
+	size_t SamplerCache::size() const {
+		std::lock_guard lock(mutex);
+		return samplers.size();
+	}
+}
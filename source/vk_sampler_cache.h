@@ -0,0 +1,44 @@
+#pragma once
+#include "vk_types.h"
+
+#include <mutex>
+#include <unordered_map>
+
+class VulkanEngine;
+
+namespace engine {
+	//Samplers are immutable and tiny but counted against maxSamplerAllocationCount, so textures with the same
+	//sampling state share one. The cache owns every sampler until the engine shuts down; textures only hold handles.
+	class SamplerCache {
+	public:
+		struct Key {
+			VkFilter filter;
+			VkSamplerAddressMode address_mode;
+			uint32_t mip_levels;
+			bool anisotropy;
+
+			bool operator==(const Key&) const = default;
+		};
+
+		explicit SamplerCache(VulkanEngine* engine);
+
+		~SamplerCache();
+
+		SamplerCache(const SamplerCache&) = delete;
+		SamplerCache& operator=(const SamplerCache&) = delete;
+
+		//thread safe, textures may be created by loader workers
+		VkSampler get(VkFilter filter, uint32_t mip_levels, VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT, bool anisotropy = true);
+
+		[[nodiscard]] size_t size() const;
+
+	private:
+		struct KeyHash {
+			size_t operator()(const Key& key) const noexcept;
+		};
+
+		VulkanEngine* engine;
+		mutable std::mutex mutex;
+		std::unordered_map<Key, VkSampler, KeyHash> samplers;
+	};
+}
@@ -0,0 +1,121 @@
+#include "vk_setup_batch.h"
+#include "vk_engine.h"
+#include "vk_initializers.h"
+#include "vk_util.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+
+namespace engine {
+	namespace {
+		thread_local SetupBatch* current_batch = nullptr;
+
+		//transfer and present work is never batched, like transition_image_layout() they fall back to the compute queue
+		size_t queue_slot(const QueueFamilyCategory queue_family_category) noexcept {
+			return queue_family_category == QueueFamilyCategory::GRAPHICS ? 0 : 1;
+		}
+
+		std::tuple<VkQueue, VkCommandPool> queue_of(const VulkanEngine* engine, const size_t slot) noexcept {
+			return slot == 0 ?
+				std::tuple{ engine->graphics_queue, engine->graphic_command_pool } :
+				std::tuple{ engine->compute_queue, engine->compute_command_pool };
+		}
+	}
+
+	SetupBatch::SetupBatch(VulkanEngine* engine) : engine(engine), outermost(current_batch == nullptr) {
+		if (outermost) {
+			current_batch = this;
+		}
+	}
+
+	SetupBatch::~SetupBatch() {
+		if (outermost) {
+			current_batch = nullptr;
+			flush();
+		}
+	}
+
+	void SetupBatch::submit(VulkanEngine* engine, VkCommandBuffer command_buffer) {
+		if (current_batch != nullptr) {
+			current_batch->prerecorded_command_buffers.push_back(command_buffer);
+			return;
+		}
+		const VkSubmitInfo submit_info{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.commandBufferCount = 1,
+			.pCommandBuffers = &command_buffer,
+		};
+		vkResetFences(engine->device, 1, &engine->immediate_submit_fence);
+		if (vkQueueSubmit(engine->graphics_queue, 1, &submit_info, engine->immediate_submit_fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit setup command buffer!");
+		}
+		vkWaitForFences(engine->device, 1, &engine->immediate_submit_fence, VK_TRUE, VULKAN_WAIT_TIMEOUT);
+	}
+
+	bool SetupBatch::is_open() noexcept {
+		return current_batch != nullptr;
+	}
+
+	VkCommandBuffer SetupBatch::open_command_buffer(const QueueFamilyCategory queue_family_category) {
+		if (current_batch == nullptr) {
+			return VK_NULL_HANDLE;
+		}
+		auto const slot = queue_slot(queue_family_category);
+		auto& command_buffer = current_batch->command_buffers[slot];
+		if (command_buffer == VK_NULL_HANDLE) {
+			auto const [queue, command_pool] = queue_of(current_batch->engine, slot);
+			const VkCommandBufferAllocateInfo alloc_info = vkinit::command_buffer_allocate_info(command_pool, 1);
+			if (vkAllocateCommandBuffers(current_batch->engine->device, &alloc_info, &command_buffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate command buffers!");
+			}
+			constexpr VkCommandBufferBeginInfo begin_info{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+				.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			};
+			if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+				throw std::runtime_error("failed to begin recording command buffer!");
+			}
+		}
+		return command_buffer;
+	}
+
+	void SetupBatch::submit_now(VulkanEngine* engine, const QueueFamilyCategory queue_family_category, const std::function<void(VkCommandBuffer)>& function) {
+		auto const [queue, command_pool] = queue_of(engine, queue_slot(queue_family_category));
+		immediate_submit(engine, queue, command_pool, function);
+	}
+
+	//runs in the destructor, so failures are reported instead of thrown
+	void SetupBatch::flush() {
+		for (size_t slot = 0; slot < command_buffers.size(); ++slot) {
+			std::vector<VkCommandBuffer> submitted_command_buffers;
+			if (command_buffers[slot] != VK_NULL_HANDLE) {
+				vkEndCommandBuffer(command_buffers[slot]);
+				submitted_command_buffers.push_back(command_buffers[slot]);
+			}
+			if (slot == 0) {  //prerecorded work may read images the recorded transitions prepared
+				submitted_command_buffers.insert(submitted_command_buffers.end(), prerecorded_command_buffers.begin(), prerecorded_command_buffers.end());
+			}
+			if (submitted_command_buffers.empty()) {
+				continue;
+			}
+
+			auto const [queue, command_pool] = queue_of(engine, slot);
+			const VkSubmitInfo submit_info{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+				.commandBufferCount = static_cast<uint32_t>(submitted_command_buffers.size()),
+				.pCommandBuffers = submitted_command_buffers.data(),
+			};
+			vkResetFences(engine->device, 1, &engine->immediate_submit_fence);
+			if (vkQueueSubmit(queue, 1, &submit_info, engine->immediate_submit_fence) != VK_SUCCESS) {
+				std::cerr << "failed to submit setup command buffers!" << std::endl;
+			}
+			else {
+				vkWaitForFences(engine->device, 1, &engine->immediate_submit_fence, VK_TRUE, VULKAN_WAIT_TIMEOUT);
+			}
+			if (command_buffers[slot] != VK_NULL_HANDLE) {
+				vkFreeCommandBuffers(engine->device, command_pool, 1, &command_buffers[slot]);
+			}
+		}
+	}
+}
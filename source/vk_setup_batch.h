@@ -0,0 +1,54 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_image.h"
+#include "util/util.h"
+
+#include <array>
+#include <concepts>
+#include <functional>
+#include <vector>
+
+class VulkanEngine;
+
+namespace engine {
+	//While in scope, one-off setup commands recorded on this thread (layout transitions of new images, color ramp uploads)
+	//go into one command buffer per queue instead of an immediate_submit() and fence wait each, and are submitted together
+	//when the scope ends. Scopes nest and the outermost one submits. Whatever the commands reference must outlive the scope
+	class SetupBatch {
+	public:
+		explicit SetupBatch(VulkanEngine* engine);
+
+		~SetupBatch();
+
+		SetupBatch(const SetupBatch&) = delete;
+		SetupBatch& operator=(const SetupBatch&) = delete;
+
+		//records function into the open batch of this thread, or submits it right away and waits when none is open
+		template<std::invocable<VkCommandBuffer> Func>
+		static void record(VulkanEngine* engine, const QueueFamilyCategory queue_family_category, Func&& function) {
+			if (auto const command_buffer = open_command_buffer(queue_family_category)) {
+				std::invoke(FWD(function), command_buffer);
+			}
+			else {
+				submit_now(engine, queue_family_category, FWD(function));
+			}
+		}
+
+		//a prerecorded graphics command buffer, submitted after the recorded commands or right away when no batch is open
+		static void submit(VulkanEngine* engine, VkCommandBuffer command_buffer);
+
+		[[nodiscard]] static bool is_open() noexcept;
+
+	private:
+		VulkanEngine* engine;
+		bool outermost;
+		std::array<VkCommandBuffer, 2> command_buffers{};  //graphics and compute, allocated on first use
+		std::vector<VkCommandBuffer> prerecorded_command_buffers;
+
+		static VkCommandBuffer open_command_buffer(QueueFamilyCategory queue_family_category);
+
+		static void submit_now(VulkanEngine* engine, QueueFamilyCategory queue_family_category, const std::function<void(VkCommandBuffer)>& function);
+
+		void flush();
+	};
+}
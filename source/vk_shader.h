@@ -1,6 +1,7 @@
 #pragma once
 #include "vk_types.h"
 #include "vk_engine.h"
+#include "vk_shader_cache.h"
 #include <filesystem>
 #include <string>
 
@@ -26,15 +27,10 @@ namespace engine {
 
 		Shader(VkDevice device, std::vector<ShaderModule>&& shaderModules);
 
+		//modules come from engine->shader_cache, which owns and destroys them
 		static ShaderPtr createFromSpv(VulkanEngine* engine, const std::span<const char* const> spv_file_paths) {
 			std::vector<ShaderModule> shaderModuleVector;
 			for (auto const& spv_file_path : spv_file_paths) {
-				auto spvCode = read_file(spv_file_path);
-				VkShaderModuleCreateInfo createInfo{};
-				createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-				createInfo.codeSize = spvCode.size();
-				createInfo.pCode = reinterpret_cast<const uint32_t*>(spvCode.data());
-
 				ShaderModule shaderModule;
 				auto extension = std::filesystem::path(spv_file_path).stem().extension().string();
 				if (extension == ".vert") {
@@ -50,15 +46,9 @@ namespace engine {
 					throw std::runtime_error("Illegal shader name! Please specify the stage!");
 				}
 
-				if (vkCreateShaderModule(engine->device, &createInfo, nullptr, &shaderModule.shader) != VK_SUCCESS) {
-					throw std::runtime_error("failed to create shader module!");
-				}
+				shaderModule.shader = engine->shader_cache->get(spv_file_path);
 
 				shaderModuleVector.emplace_back(std::move(shaderModule));
-
-				engine->main_deletion_queue.push_function([=] {
-					vkDestroyShaderModule(engine->device, shaderModule.shader, nullptr);
-					});
 			}
 				return std::make_shared<Shader>(engine->device, std::move(shaderModuleVector));
 		}
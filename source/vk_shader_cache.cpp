@@ -0,0 +1,154 @@
+#include "vk_shader_cache.h"
+#include "vk_engine.h"
+#include "util/mapped_file.h"
+
+#include <algorithm>
+#include <iostream>
+#include <ranges>
+#include <stdexcept>
+
+namespace engine {
+	namespace {
+		//64-bit FNV-1a, SPIR-V binaries are small enough that one pass per load is negligible
+		uint64_t hash_bytes(const std::span<const std::byte> bytes) {
+			uint64_t hash = 0xcbf29ce484222325ull;
+			for (auto const byte : bytes) {
+				hash = (hash ^ static_cast<uint64_t>(byte)) * 0x100000001b3ull;
+			}
+			return hash;
+		}
+	}
+
+	ShaderModuleCache::ShaderModuleCache(VulkanEngine* engine) : engine(engine) {}
+
+	ShaderModuleCache::~ShaderModuleCache() {
+		for (auto const shader : modules | std::views::values) {
+			vkDestroyShaderModule(engine->device, shader, nullptr);
+		}
+	}
+
+	std::string ShaderModuleCache::key_of(const std::filesystem::path& spv_path) {
+		std::error_code error_code;
+		auto canonical_path = std::filesystem::weakly_canonical(spv_path, error_code);
+		if (error_code) {
+			canonical_path = spv_path.lexically_normal();
+		}
+		return canonical_path.generic_string();
+	}
+
+	ShaderModuleCache::ContentKey ShaderModuleCache::load(const std::filesystem::path& spv_path) {
+		const MappedFile file(spv_path);
+		auto const bytes = file.bytes();
+		if (bytes.empty() || bytes.size() % sizeof(uint32_t) != 0) {
+			throw std::runtime_error("failed to load shader " + spv_path.string() + ", not a SPIR-V binary!");
+		}
+
+		const ContentKey content{ .hash = hash_bytes(bytes), .size = bytes.size() };
+		if (!modules.contains(content)) {
+			//mapped views are page aligned, so the words can be read in place
+			const VkShaderModuleCreateInfo create_info{
+				.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+				.codeSize = bytes.size(),
+				.pCode = reinterpret_cast<const uint32_t*>(bytes.data()),
+			};
+			VkShaderModule shader;
+			if (vkCreateShaderModule(engine->device, &create_info, nullptr, &shader) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create shader module!");
+			}
+			modules.emplace(content, shader);
+		}
+		return content;
+	}
+
+	VkShaderModule ShaderModuleCache::get(const std::filesystem::path& spv_path) {
+		auto key = key_of(spv_path);
+		auto entry = entries.find(key);
+		if (entry == entries.end()) {
+			std::error_code error_code;
+			auto const write_time = std::filesystem::last_write_time(spv_path, error_code);
+			if (error_code) {
+				throw std::runtime_error("failed to open shader " + spv_path.string() + "!");
+			}
+			auto const content = load(spv_path);
+			entry = entries.emplace(std::move(key), Entry{
+				.spv_path = spv_path,
+				.write_time = write_time,
+				.content = content,
+				}).first;
+		}
+		return modules.at(entry->second.content);
+	}
+
+	uint32_t ShaderModuleCache::subscribe(const std::span<const char* const> spv_paths, Listener listener) {
+		Subscription subscription{ .listener = std::move(listener) };
+		subscription.keys.reserve(spv_paths.size());
+		for (auto const spv_path : spv_paths) {
+			subscription.keys.emplace_back(key_of(spv_path));
+		}
+		subscriptions.emplace(next_subscription_id, std::move(subscription));
+		return next_subscription_id++;
+	}
+
+	void ShaderModuleCache::unsubscribe(const uint32_t subscription_id) {
+		subscriptions.erase(subscription_id);
+	}
+
+	void ShaderModuleCache::notify(const std::string& key, const std::filesystem::path& spv_path) {
+		//a listener may subscribe or unsubscribe, so walk a snapshot of the ids
+		std::vector<uint32_t> subscription_ids;
+		for (auto const& [id, subscription] : subscriptions) {
+			if (std::ranges::find(subscription.keys, key) != subscription.keys.end()) {
+				subscription_ids.push_back(id);
+			}
+		}
+		for (auto const id : subscription_ids) {
+			if (auto const subscription = subscriptions.find(id); subscription != subscriptions.end()) {
+				subscription->second.listener(spv_path);
+			}
+		}
+	}
+
+	void ShaderModuleCache::poll(const uint32_t frame_index) {
+		if (frame_index % poll_period != 0) {
+			return;
+		}
+
+		std::vector<std::pair<std::string, std::filesystem::path>> changed_files;
+		for (auto& [key, entry] : entries) {
+			std::error_code error_code;
+			auto const write_time = std::filesystem::last_write_time(entry.spv_path, error_code);
+			if (error_code || write_time == entry.write_time) {
+				continue;  //a file being replaced may briefly be missing, look again next time
+			}
+
+			entry.write_time = write_time;
+			try {
+				auto const content = load(entry.spv_path);
+				if (content != entry.content) {
+					entry.content = content;
+					changed_files.emplace_back(key, entry.spv_path);
+				}
+			}
+			catch (const std::exception& e) {
+				//most likely caught halfway through being written, finishing the write touches the file again
+				std::cerr << e.what() << std::endl;
+			}
+		}
+
+		if (!changed_files.empty()) {
+			++reloads;
+		}
+		//listeners may load shaders themselves, which must not happen while entries is being walked
+		for (auto const& [key, spv_path] : changed_files) {
+			notify(key, spv_path);
+		}
+	}
+
+	size_t ShaderModuleCache::module_count() const noexcept {
+		return modules.size();
+	}
+
+	uint64_t ShaderModuleCache::reload_count() const noexcept {
+		return reloads;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "vk_types.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VulkanEngine;
+
+namespace engine {
+	//Process-wide owner of every VkShaderModule. SPIR-V files are memory mapped and hashed, an entry per path remembers
+	//the module built from its current content, and paths with identical content share one module. poll() compares
+	//modification times every few frames and points an edited file at the module of its new content, then notifies
+	//whoever subscribed to that path so the pipelines built from the old module can be invalidated.
+	//Modules live as long as the cache, Shader objects handed out earlier stay valid and reverting an edit costs nothing.
+	class ShaderModuleCache {
+	public:
+		using Listener = std::function<void(const std::filesystem::path& spv_path)>;
+
+		constexpr static inline uint32_t poll_period = 30;  //frames between two scans of the watched files
+
+		explicit ShaderModuleCache(VulkanEngine* engine);
+
+		~ShaderModuleCache();
+
+		ShaderModuleCache(const ShaderModuleCache&) = delete;
+		ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+
+		//module for the current content of spv_path, loaded on first use
+		VkShaderModule get(const std::filesystem::path& spv_path);
+
+		//calls listener whenever one of spv_paths is rebuilt, returns the id to unsubscribe with
+		uint32_t subscribe(std::span<const char* const> spv_paths, Listener listener);
+
+		void unsubscribe(uint32_t subscription_id);
+
+		//rebuilds the modules of files modified since they were loaded, call once per frame
+		void poll(uint32_t frame_index);
+
+		[[nodiscard]] size_t module_count() const noexcept;
+
+		//bumped by every poll() that rebuilt a module, lets callers notice edits without subscribing
+		[[nodiscard]] uint64_t reload_count() const noexcept;
+
+	private:
+		struct ContentKey {
+			uint64_t hash;
+			uint64_t size;
+
+			bool operator==(const ContentKey&) const = default;
+		};
+
+		struct ContentKeyHash {
+			size_t operator()(const ContentKey& key) const noexcept {
+				return static_cast<size_t>(key.hash ^ (key.size * 0x9e3779b97f4a7c15ull));
+			}
+		};
+
+		struct Entry {
+			std::filesystem::path spv_path;
+			std::filesystem::file_time_type write_time;
+			ContentKey content;
+		};
+
+		struct Subscription {
+			std::vector<std::string> keys;
+			Listener listener;
+		};
+
+		VulkanEngine* engine;
+		std::unordered_map<std::string, Entry> entries;
+		std::unordered_map<ContentKey, VkShaderModule, ContentKeyHash> modules;
+		std::unordered_map<uint32_t, Subscription> subscriptions;
+		uint32_t next_subscription_id = 0;
+		uint64_t reloads = 0;
+
+		static std::string key_of(const std::filesystem::path& spv_path);
+
+		//maps the file and returns the key of its content, building the module for content not seen before
+		ContentKey load(const std::filesystem::path& spv_path);
+
+		void notify(const std::string& key, const std::filesystem::path& spv_path);
+	};
+}
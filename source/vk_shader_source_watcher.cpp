@@ -0,0 +1,155 @@
+#include "vk_shader_source_watcher.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+namespace engine {
+	ShaderSourceWatcher::ShaderSourceWatcher(std::filesystem::path glsl_directory, std::filesystem::path spv_directory) :
+		glsl_directory(std::move(glsl_directory)),
+		spv_directory(std::move(spv_directory)),
+		compiler(find_compiler()) {
+		std::error_code error_code;
+		if (!std::filesystem::is_directory(this->glsl_directory, error_code)) {
+			return;
+		}
+		for (auto const& entry : std::filesystem::directory_iterator(this->glsl_directory, error_code)) {
+			if (is_shader_source(entry.path())) {
+				track(entry.path(), entry.last_write_time(error_code));
+			}
+		}
+		watching = true;
+	}
+
+	//the Vulkan SDK first, then the copy compile_spirv.bat uses, then whatever glslc is on PATH
+	std::filesystem::path ShaderSourceWatcher::find_compiler() {
+#if defined(_WIN32)
+		constexpr auto compiler_name = "glslc.exe";
+		constexpr auto sdk_bin_directory = "Bin";
+#else
+		constexpr auto compiler_name = "glslc";
+		constexpr auto sdk_bin_directory = "bin";
+#endif
+		std::error_code error_code;
+		if (auto const sdk = std::getenv("VULKAN_SDK")) {
+			auto sdk_compiler = std::filesystem::path(sdk) / sdk_bin_directory / compiler_name;
+			if (std::filesystem::exists(sdk_compiler, error_code)) {
+				return sdk_compiler;
+			}
+		}
+		auto extern_compiler = std::filesystem::path("extern") / "vulkan" / "Bin" / compiler_name;
+		if (std::filesystem::exists(extern_compiler, error_code)) {
+			return extern_compiler;
+		}
+		return compiler_name;
+	}
+
+	bool ShaderSourceWatcher::is_shader_source(const std::filesystem::path& file_path) {
+		auto const extension = file_path.extension();
+		return extension == ".vert" || extension == ".frag" || extension == ".comp";
+	}
+
+	//follows #include "..." lines the way glslc resolves them, relative to the including file
+	std::vector<std::string> ShaderSourceWatcher::collect_includes(const std::filesystem::path& source_path) {
+		std::set<std::string> visited;
+		std::vector<std::filesystem::path> stack{ source_path };
+		while (!stack.empty()) {
+			auto const file_path = std::move(stack.back());
+			stack.pop_back();
+			std::ifstream file(file_path);
+			std::string line;
+			while (std::getline(file, line)) {
+				auto const directive = line.find_first_not_of(" \t");
+				if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0) {
+					continue;
+				}
+				auto const first_quote = line.find('"', directive);
+				auto const last_quote = line.find('"', first_quote + 1);
+				if (first_quote == std::string::npos || last_quote == std::string::npos) {
+					continue;
+				}
+				auto include_path = (file_path.parent_path() / line.substr(first_quote + 1, last_quote - first_quote - 1)).lexically_normal();
+				if (visited.insert(include_path.generic_string()).second) {
+					stack.push_back(std::move(include_path));
+				}
+			}
+		}
+		return { visited.begin(), visited.end() };
+	}
+
+	void ShaderSourceWatcher::track(const std::filesystem::path& source_path, const std::filesystem::file_time_type write_time) {
+		auto& source = shaders[source_path.lexically_normal().generic_string()];
+		source.write_time = write_time;
+		source.includes = collect_includes(source_path);
+		for (auto const& include : source.includes) {
+			if (!include_write_times.contains(include)) {
+				std::error_code error_code;
+				include_write_times[include] = std::filesystem::last_write_time(include, error_code);
+			}
+		}
+	}
+
+	void ShaderSourceWatcher::poll(const uint32_t frame_index) {
+		if (!watching || frame_index % poll_period != 0) {
+			return;
+		}
+
+		std::set<std::string> edited_includes;
+		for (auto& [include, write_time] : include_write_times) {
+			std::error_code error_code;
+			auto const current_write_time = std::filesystem::last_write_time(include, error_code);
+			if (!error_code && current_write_time != write_time) {
+				write_time = current_write_time;
+				edited_includes.insert(include);
+			}
+		}
+
+		std::error_code error_code;
+		for (auto const& entry : std::filesystem::directory_iterator(glsl_directory, error_code)) {
+			if (!is_shader_source(entry.path())) {
+				continue;
+			}
+			auto const write_time = entry.last_write_time(error_code);
+			if (error_code) {
+				continue;  //a file being replaced may briefly be missing, look again next time
+			}
+			auto const key = entry.path().lexically_normal().generic_string();
+			auto const source = shaders.find(key);
+			const bool edited = source == shaders.end() || source->second.write_time != write_time ||
+				std::ranges::any_of(source->second.includes, [&](auto const& include) { return edited_includes.contains(include); });
+			if (edited) {
+				track(entry.path(), write_time);
+				compile(entry.path());
+			}
+		}
+	}
+
+	void ShaderSourceWatcher::compile(const std::filesystem::path& source_path) {
+		//same naming as compile_spirv.bat, node_blur.frag becomes node_blur.frag.spv
+		auto spv_path = spv_directory / source_path.filename();
+		spv_path += ".spv";
+		compile_workers.submit([compiler = compiler, source_path, spv_path] {
+			auto temp_path = spv_path;
+			temp_path += ".tmp";
+			auto command = "\"" + compiler.string() + "\" \"" + source_path.string() + "\" -o \"" + temp_path.string() + "\"";
+#if defined(_WIN32)
+			command = "\"" + command + "\"";  //cmd.exe strips the outer quotes of a command starting with a quoted path
+#endif
+			std::error_code error_code;
+			if (std::system(command.c_str()) != 0) {
+				//glslc has printed the diagnostics, the previous SPIR-V stays in use
+				std::cerr << "failed to compile shader " << source_path << std::endl;
+				std::filesystem::remove(temp_path, error_code);
+				return;
+			}
+			//replacing the file in one step keeps ShaderModuleCache from reading a partial binary
+			std::filesystem::rename(temp_path, spv_path, error_code);
+			if (error_code) {
+				std::cerr << "failed to replace " << spv_path << ": " << error_code.message() << std::endl;
+				return;
+			}
+			});
+	}
+}
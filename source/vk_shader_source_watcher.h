@@ -0,0 +1,53 @@
+#pragma once
+#include "util/thread_pool.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+	//Recompiles GLSL to SPIR-V while the app runs, so shader edits need neither compile_spirv.bat nor a restart.
+	//poll() scans the top level .vert, .frag and .comp files of the GLSL directory every few frames. An edited shader,
+	//or every shader including an edited file, is compiled by glslc on a background thread. The SPIR-V is written next to
+	//the other binaries through a temporary file, and ShaderModuleCache::poll() then notices it like any other edit.
+	//Sources are only compared against the state seen at startup, the build compiles whatever changed before that.
+	class ShaderSourceWatcher {
+	public:
+		constexpr static inline uint32_t poll_period = 30;  //frames between two scans of the sources
+
+		ShaderSourceWatcher(std::filesystem::path glsl_directory, std::filesystem::path spv_directory);
+
+		ShaderSourceWatcher(const ShaderSourceWatcher&) = delete;
+		ShaderSourceWatcher& operator=(const ShaderSourceWatcher&) = delete;
+
+		//queues a compile for every source modified since the last scan, call once per frame
+		void poll(uint32_t frame_index);
+
+	private:
+		struct Source {
+			std::filesystem::file_time_type write_time;
+			std::vector<std::string> includes;  //keys of every file it includes, directly or not
+		};
+
+		std::filesystem::path glsl_directory;
+		std::filesystem::path spv_directory;
+		std::filesystem::path compiler;
+		std::unordered_map<std::string, Source> shaders;
+		std::unordered_map<std::string, std::filesystem::file_time_type> include_write_times;
+		bool watching = false;  //stays false without GLSL sources next to the executable, e.g. in a packaged build
+		ThreadPool compile_workers{ 1 };  //one worker keeps consecutive saves of a file in order
+
+		static std::filesystem::path find_compiler();
+
+		static bool is_shader_source(const std::filesystem::path& file_path);
+
+		static std::vector<std::string> collect_includes(const std::filesystem::path& source_path);
+
+		//rescans the includes of a shader and remembers their modification times
+		void track(const std::filesystem::path& source_path, std::filesystem::file_time_type write_time);
+
+		void compile(const std::filesystem::path& source_path);
+	};
+}
@@ -0,0 +1,578 @@
+#include "vk_texture_exporter.h"
+#include "vk_engine.h"
+#include "vk_initializers.h"
+#include "vk_util.h"
+#include "util/static_map.h"
+
+#include <bit>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <tinyexr.h>
+
+enum class ChannelType {
+	UNORM,
+	SRGB,
+	SFLOAT,
+};
+
+struct TexelLayout {
+	uint32_t channel_num;
+	uint32_t channel_size;
+	ChannelType channel_type;
+
+	constexpr bool operator==(const TexelLayout&) const = default;
+
+	[[nodiscard]] constexpr uint32_t texel_size() const noexcept {
+		return channel_num * channel_size;
+	}
+};
+
+static constexpr inline StaticMap format_texel_layout_map{
+	std::pair{ VK_FORMAT_R8_UNORM, TexelLayout{ 1, 1, ChannelType::UNORM } },
+	std::pair{ VK_FORMAT_R8G8B8A8_UNORM, TexelLayout{ 4, 1, ChannelType::UNORM } },
+	std::pair{ VK_FORMAT_R8G8B8A8_SRGB, TexelLayout{ 4, 1, ChannelType::SRGB } },
+	std::pair{ VK_FORMAT_R16_UNORM, TexelLayout{ 1, 2, ChannelType::UNORM } },
+	std::pair{ VK_FORMAT_R16G16B16A16_UNORM, TexelLayout{ 4, 2, ChannelType::UNORM } },
+	std::pair{ VK_FORMAT_R16_SFLOAT, TexelLayout{ 1, 2, ChannelType::SFLOAT } },
+	std::pair{ VK_FORMAT_R16G16B16A16_SFLOAT, TexelLayout{ 4, 2, ChannelType::SFLOAT } },
+	std::pair{ VK_FORMAT_R32_SFLOAT, TexelLayout{ 1, 4, ChannelType::SFLOAT } },
+	std::pair{ VK_FORMAT_R32G32B32A32_SFLOAT, TexelLayout{ 4, 4, ChannelType::SFLOAT } },
+};
+
+static float half_to_float(const uint16_t half) {
+	const uint32_t sign = (half & 0x8000u) << 16;
+	const uint32_t exponent = (half >> 10) & 0x1fu;
+	const uint32_t mantissa = half & 0x3ffu;
+	if (exponent == 0) { //zero or subnormal
+		const float value = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -value : value;
+	}
+	if (exponent == 0x1f) { //inf or nan
+		return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+	}
+	return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+static float srgb_to_linear(const float value) {
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+//Expand every channel to a float in its natural range, sRGB color channels are linearized
+static std::vector<float> decode_to_float(const std::byte* data, const size_t texel_num, const TexelLayout layout) {
+	std::vector<float> pixels(texel_num * layout.channel_num);
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		const std::byte* channel = data + i * layout.channel_size;
+		float value;
+		if (layout.channel_type == ChannelType::SFLOAT) {
+			if (layout.channel_size == 2) {
+				uint16_t half;
+				std::memcpy(&half, channel, sizeof(half));
+				value = half_to_float(half);
+			}
+			else {
+				std::memcpy(&value, channel, sizeof(value));
+			}
+		}
+		else if (layout.channel_size == 1) {
+			value = std::to_integer<uint8_t>(*channel) / 255.0f;
+		}
+		else {
+			uint16_t unorm;
+			std::memcpy(&unorm, channel, sizeof(unorm));
+			value = unorm / 65535.0f;
+		}
+		const bool is_alpha = layout.channel_num == 4 && i % 4 == 3;
+		pixels[i] = (layout.channel_type == ChannelType::SRGB && !is_alpha) ? srgb_to_linear(value) : value;
+	}
+	return pixels;
+}
+
+//Quantize to 8 bits without any transfer function, so data maps (height, roughness, ...) survive unchanged
+static std::vector<uint8_t> quantize_to_8bit(const std::byte* data, const size_t texel_num, const TexelLayout layout) {
+	std::vector<uint8_t> pixels(texel_num * layout.channel_num);
+	if (layout.channel_size == 1) {
+		std::memcpy(pixels.data(), data, pixels.size());
+		return pixels;
+	}
+	const auto decoded = decode_to_float(data, texel_num, layout);
+	std::ranges::transform(decoded, pixels.begin(), [](const float value) {
+		return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+		});
+	return pixels;
+}
+
+static uint32_t png_crc(const uint8_t* data, const size_t size, uint32_t crc = 0xffffffffu) {
+	static const auto crc_table = [] {
+		std::array<uint32_t, 256> table{};
+		for (uint32_t n = 0; n < 256; ++n) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k) {
+				c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		return table;
+	}();
+	for (size_t i = 0; i < size; ++i) {
+		crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+//stb_image_write only emits 8-bit PNGs, 16-bit channels are written here with stb's zlib compressor
+static bool write_png_16bit(const std::filesystem::path& file_path, const uint32_t width, const uint32_t height, const uint32_t channel_num, const std::vector<float>& pixels) {
+	const size_t row_size = 1 + static_cast<size_t>(width) * channel_num * 2;
+	std::vector<uint8_t> scanlines(row_size * height);
+	for (uint32_t y = 0; y < height; ++y) {
+		uint8_t* row = scanlines.data() + y * row_size;
+		row[0] = 0; //filter type: none
+		for (size_t i = 0; i < static_cast<size_t>(width) * channel_num; ++i) {
+			const auto value = static_cast<uint16_t>(std::clamp(pixels[y * width * channel_num + i], 0.0f, 1.0f) * 65535.0f + 0.5f);
+			row[1 + i * 2] = static_cast<uint8_t>(value >> 8); //PNG is big-endian
+			row[2 + i * 2] = static_cast<uint8_t>(value & 0xff);
+		}
+	}
+
+	int compressed_size = 0;
+	unsigned char* compressed = stbi_zlib_compress(scanlines.data(), static_cast<int>(scanlines.size()), &compressed_size, 8);
+	if (compressed == nullptr) {
+		return false;
+	}
+
+	std::vector<uint8_t> file_data{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	auto write_u32 = [&](const uint32_t value) {
+		file_data.insert(file_data.end(), {
+			static_cast<uint8_t>(value >> 24),
+			static_cast<uint8_t>(value >> 16),
+			static_cast<uint8_t>(value >> 8),
+			static_cast<uint8_t>(value) });
+		};
+	auto write_chunk = [&](const char* type, const uint8_t* data, const size_t size) {
+		write_u32(static_cast<uint32_t>(size));
+		const size_t chunk_begin = file_data.size();
+		file_data.insert(file_data.end(), type, type + 4);
+		file_data.insert(file_data.end(), data, data + size);
+		write_u32(~png_crc(file_data.data() + chunk_begin, size + 4));
+		};
+
+	const uint8_t color_type = channel_num == 4 ? 6 : 0; //RGBA or grey
+	const std::array<uint8_t, 13> header{
+		static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+		static_cast<uint8_t>(height >> 24), static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+		16, color_type, 0, 0, 0
+	};
+	write_chunk("IHDR", header.data(), header.size());
+	write_chunk("IDAT", compressed, compressed_size);
+	write_chunk("IEND", nullptr, 0);
+	STBIW_FREE(compressed);
+
+	std::ofstream o_file(file_path, std::ios::binary);
+	o_file.write(reinterpret_cast<const char*>(file_data.data()), static_cast<std::streamsize>(file_data.size()));
+	return o_file.good();
+}
+
+void engine::TextureExporter::encode_pixels(const std::byte* data, const uint32_t width, const uint32_t height, const VkFormat format,
+	const std::filesystem::path& file_path, const ExportFileFormat file_format) {
+	auto const layout = format_texel_layout_map.at(format);
+	auto const texel_num = static_cast<size_t>(width) * height;
+	auto const file_name = file_path.string();
+	bool success = false;
+
+	switch (file_format) {
+	case ExportFileFormat::EXR: {
+		const auto pixels = decode_to_float(data, texel_num, layout);
+		const char* error = nullptr;
+		success = SaveEXR(pixels.data(), width, height, layout.channel_num, layout.channel_size <= 2, file_name.c_str(), &error) == TINYEXR_SUCCESS;
+		if (error) {
+			std::cerr << "EXR export error: " << error << std::endl;
+			FreeEXRErrorMessage(error);
+		}
+		break;
+	}
+	case ExportFileFormat::PNG: {
+		if (layout.channel_size == 1) {
+			success = stbi_write_png(file_name.c_str(), width, height, layout.channel_num, data, width * layout.texel_size()) != 0;
+		}
+		else {
+			success = write_png_16bit(file_path, width, height, layout.channel_num, decode_to_float(data, texel_num, layout));
+		}
+		break;
+	}
+	case ExportFileFormat::TGA: {
+		const auto pixels = quantize_to_8bit(data, texel_num, layout);
+		success = stbi_write_tga(file_name.c_str(), width, height, layout.channel_num, pixels.data()) != 0;
+		break;
+	}
+	}
+
+	if (!success) {
+		std::cerr << "failed to export texture to " << file_name << std::endl;
+	}
+}
+
+namespace engine {
+	TextureExporter::TextureExporter(VulkanEngine* engine) : engine(engine) {
+		create_semaphore();
+		create_command_buffers();
+	}
+
+	TextureExporter::~TextureExporter() {
+		try {
+			flush();
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+		}
+		encode_workers.wait_idle();
+
+		for (auto& slot : slots) {
+			vkFreeCommandBuffers(engine->device, engine->graphic_command_pool, 1, &slot.command_buffer);
+		}
+		vkDestroySemaphore(engine->device, semaphore, nullptr);
+	}
+
+	//Exports requested before shutdown still reach their files: copies in flight are waited for and handed to the
+	//workers, which frees slots for the pending requests, until nothing is left to copy
+	void TextureExporter::flush() {
+		auto const copying = [&] {
+			return std::ranges::any_of(slots, [](const StagingSlot& slot) {
+				return slot.state.load(std::memory_order_acquire) == SlotState::COPYING;
+				});
+		};
+		while (!pending_requests.empty() || copying()) {
+			const VkSemaphoreWaitInfo wait_info{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+				.semaphoreCount = 1,
+				.pSemaphores = &semaphore,
+				.pValues = &timeline_value,
+			};
+			if (vkWaitSemaphores(engine->device, &wait_info, VULKAN_WAIT_TIMEOUT) != VK_SUCCESS) {
+				throw std::runtime_error("failed to wait for texture export copies, pending exports are dropped!");
+			}
+			update();
+			if (!pending_requests.empty()) {
+				encode_workers.wait_idle();
+			}
+		}
+	}
+
+	void TextureExporter::create_semaphore() {
+		constexpr VkSemaphoreTypeCreateInfo timeline_semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.pNext = nullptr,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+
+		const VkSemaphoreCreateInfo semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &timeline_semaphore_create_info,
+			.flags = 0,
+		};
+
+		if (vkCreateSemaphore(engine->device, &semaphore_create_info, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create export timeline semaphore!");
+		}
+	}
+
+	void TextureExporter::create_command_buffers() {
+		const VkCommandBufferAllocateInfo cmd_allocate_info = vkinit::command_buffer_allocate_info(engine->graphic_command_pool, 1);
+		for (auto& slot : slots) {
+			if (vkAllocateCommandBuffers(engine->device, &cmd_allocate_info, &slot.command_buffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate command buffers!");
+			}
+		}
+	}
+
+	bool TextureExporter::is_format_supported(const VkFormat format) noexcept {
+		return format_texel_layout_map.index_of(format) != format_texel_layout_map.data.size();
+	}
+
+	ExportFileFormat TextureExporter::file_format_from_extension(const std::filesystem::path& file_path) {
+		auto extension = file_path.extension().string();
+		std::ranges::transform(extension, extension.begin(), [](const char c) { return static_cast<char>(std::tolower(c)); });
+		if (extension == ".exr") {
+			return ExportFileFormat::EXR;
+		}
+		if (extension == ".tga") {
+			return ExportFileFormat::TGA;
+		}
+		return ExportFileFormat::PNG;
+	}
+
+	void TextureExporter::export_texture(const TexturePtr& texture, std::filesystem::path file_path, const ExportFileFormat file_format) {
+		if (texture == nullptr || !is_format_supported(texture->format)) {
+			std::cerr << "export skipped: unsupported texture format for " << file_path << std::endl;
+			return;
+		}
+		ExportRequest request{
+			.texture = texture,
+			.file_path = std::move(file_path),
+			.file_format = file_format,
+			.src_region = { { 0, 0 }, { texture->width, texture->height } },
+		};
+		if (!pending_requests.empty() || !try_submit(request)) {
+			pending_requests.emplace_back(std::move(request));
+		}
+	}
+
+	std::shared_ptr<TextureExporter::TiledCanvas> TextureExporter::begin_tiled_export(std::filesystem::path file_path, const ExportFileFormat file_format,
+		const VkFormat format, const uint32_t width, const uint32_t height, const uint32_t tile_num) {
+		if (!is_format_supported(format)) {
+			throw std::runtime_error("failed to begin tiled export: unsupported texture format!");
+		}
+		auto canvas = std::make_shared<TiledCanvas>();
+		canvas->file_path = std::move(file_path);
+		canvas->file_format = file_format;
+		canvas->width = width;
+		canvas->height = height;
+		canvas->format = format;
+		canvas->pixels.resize(static_cast<size_t>(width) * height * format_texel_layout_map.at(format).texel_size());
+		canvas->remaining_tile_num = tile_num;
+		return canvas;
+	}
+
+	bool TextureExporter::export_tile(const std::shared_ptr<TiledCanvas>& canvas, const TexturePtr& texture, const VkRect2D src_region, const VkOffset2D dst_offset) {
+		assert(texture->format == canvas->format);
+		ExportRequest request{
+			.texture = texture,
+			.file_path = canvas->file_path,
+			.file_format = canvas->file_format,
+			.src_region = src_region,
+			.canvas = canvas,
+			.dst_offset = dst_offset,
+		};
+		return try_submit(request);
+	}
+
+	bool TextureExporter::has_free_slot() const noexcept {
+		return std::ranges::any_of(slots, [](const StagingSlot& slot) {
+			return slot.state.load(std::memory_order_acquire) == SlotState::FREE;
+			});
+	}
+
+	bool TextureExporter::try_submit(ExportRequest& request) {
+		auto const slot_iter = std::ranges::find_if(slots, [](const StagingSlot& slot) {
+			return slot.state.load(std::memory_order_acquire) == SlotState::FREE;
+			});
+		if (slot_iter == slots.end()) {
+			return false;
+		}
+		auto& slot = *slot_iter;
+
+		auto const& texture = request.texture;
+		auto const [width, height] = request.src_region.extent;
+		const VkDeviceSize required_size = static_cast<VkDeviceSize>(width) * height * format_texel_layout_map.at(texture->format).texel_size();
+		if (slot.buffer == nullptr || slot.buffer->size < required_size) {
+			slot.buffer = std::make_unique<Buffer>(
+				engine->vma_allocator,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				PreferredMemoryType::RAM_FOR_DOWNLOAD,
+				required_size);
+		}
+
+		slot.width = width;
+		slot.height = height;
+		slot.format = texture->format;
+		slot.request = std::move(request);
+		slot.timeline_value = ++timeline_value;
+		record_copy_cmd_buffer(slot);
+
+		const VkCommandBufferSubmitInfo cmd_buffer_submit_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+			.commandBuffer = slot.command_buffer,
+		};
+
+		const VkSemaphoreSubmitInfo signal_semaphore_submit_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.semaphore = semaphore,
+			.value = slot.timeline_value,
+			.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		};
+
+		const VkSubmitInfo2 submit_info{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &cmd_buffer_submit_info,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &signal_semaphore_submit_info,
+		};
+
+		slot.state.store(SlotState::COPYING, std::memory_order_relaxed);
+		if (vkQueueSubmit2(engine->graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit export command buffer to graphic queue!");
+		}
+		return true;
+	}
+
+	void TextureExporter::record_copy_cmd_buffer(const StagingSlot& slot) const {
+		auto const& texture = slot.request.texture;
+		auto const cmd = slot.command_buffer;
+
+		vkResetCommandBuffer(cmd, 0);
+		constexpr VkCommandBufferBeginInfo begin_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		};
+
+		if (vkBeginCommandBuffer(cmd, &begin_info) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+
+		record_copy(cmd, *texture, slot.request.src_region, slot.buffer->buffer);
+
+		if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+	}
+
+	void TextureExporter::record_copy(const VkCommandBuffer cmd, const Texture& texture, const VkRect2D src_region, const VkBuffer buffer) {
+		//earlier node evaluations on this queue are covered by the ALL_COMMANDS source scope
+		texture.insert_memory_barrier(cmd,
+			VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_MEMORY_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_COPY_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+		const VkBufferImageCopy region{
+			.bufferOffset = 0,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = 0,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+			.imageOffset = { src_region.offset.x, src_region.offset.y, 0 },
+			.imageExtent = {
+				src_region.extent.width,
+				src_region.extent.height,
+				1
+			}
+		};
+		vkCmdCopyImageToBuffer(cmd, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+		texture.insert_memory_barrier(cmd,
+			VK_PIPELINE_STAGE_2_COPY_BIT,
+			VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_ACCESS_2_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		const VkBufferMemoryBarrier2 buffer_memory_barrier{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+			.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+			.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+			.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = buffer,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE,
+		};
+
+		const VkDependencyInfo dependency_info{
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.bufferMemoryBarrierCount = 1,
+			.pBufferMemoryBarriers = &buffer_memory_barrier,
+		};
+
+		vkCmdPipelineBarrier2(cmd, &dependency_info);
+	}
+
+	std::vector<std::byte> TextureExporter::read_pixels(const TexturePtr& texture) const {
+		const Buffer buffer(
+			engine->vma_allocator,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			PreferredMemoryType::RAM_FOR_DOWNLOAD,
+			static_cast<VkDeviceSize>(texture->width) * texture->height * texel_size(texture->format));
+
+		immediate_submit(engine, [&](VkCommandBuffer cmd) {
+			record_copy(cmd, *texture, { { 0, 0 }, { texture->width, texture->height } }, buffer.buffer);
+			});
+
+		vmaInvalidateAllocation(buffer.vma_allocator, buffer.allocation, 0, VK_WHOLE_SIZE);
+		auto const data = static_cast<const std::byte*>(buffer.mapped_buffer);
+		return { data, data + buffer.size };
+	}
+
+	uint32_t TextureExporter::texel_size(const VkFormat format) {
+		return format_texel_layout_map.at(format).texel_size();
+	}
+
+	void TextureExporter::update() {
+		uint64_t completed_value;
+		vkGetSemaphoreCounterValue(engine->device, semaphore, &completed_value);
+
+		for (auto& slot : slots) {
+			if (slot.state.load(std::memory_order_acquire) == SlotState::COPYING && slot.timeline_value <= completed_value) {
+				slot.request.texture.reset(); //the GPU no longer references the image
+				slot.state.store(SlotState::ENCODING, std::memory_order_relaxed);
+				encode_workers.submit([this, &slot] {
+					try {
+						encode(slot);
+					}
+					catch (const std::exception& e) {  //the slot must be freed whatever the encoder throws
+						std::cerr << "failed to export texture to " << slot.request.file_path.string() << ": " << e.what() << std::endl;
+					}
+					slot.state.store(SlotState::FREE, std::memory_order_release);
+					});
+			}
+		}
+
+		while (!pending_requests.empty() && try_submit(pending_requests.front())) {
+			pending_requests.pop_front();
+		}
+	}
+
+	size_t TextureExporter::in_flight_count() const noexcept {
+		return pending_requests.size() + std::ranges::count_if(slots, [](const StagingSlot& slot) {
+			return slot.state.load(std::memory_order_relaxed) != SlotState::FREE;
+			});
+	}
+
+	void TextureExporter::encode(StagingSlot& slot) {
+		auto const& buffer = *slot.buffer;
+		vmaInvalidateAllocation(buffer.vma_allocator, buffer.allocation, 0, VK_WHOLE_SIZE);
+
+		if (slot.request.canvas) {
+			copy_to_canvas(slot);
+			return;
+		}
+
+		//the texture itself is already released, its shape is cached in the slot
+		encode_pixels(static_cast<const std::byte*>(buffer.mapped_buffer), slot.width, slot.height, slot.format, slot.request.file_path, slot.request.file_format);
+	}
+
+	void TextureExporter::copy_to_canvas(const StagingSlot& slot) {
+		auto& canvas = *slot.request.canvas;
+		auto const texel_size = format_texel_layout_map.at(canvas.format).texel_size();
+		auto const src = static_cast<const std::byte*>(slot.buffer->mapped_buffer);
+		auto const src_row_size = static_cast<size_t>(slot.width) * texel_size;
+		auto const [dst_x, dst_y] = slot.request.dst_offset;
+
+		for (uint32_t y = 0; y < slot.height; ++y) {  //tiles cover disjoint canvas regions, rows are written without locking
+			auto const dst_texel_index = (static_cast<size_t>(dst_y) + y) * canvas.width + static_cast<size_t>(dst_x);
+			std::memcpy(canvas.pixels.data() + dst_texel_index * texel_size, src + y * src_row_size, src_row_size);
+		}
+
+		if (canvas.remaining_tile_num.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			encode_pixels(canvas.pixels.data(), canvas.width, canvas.height, canvas.format, canvas.file_path, canvas.file_format);
+			canvas.pixels = {};
+		}
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_image.h"
+#include "vk_buffer.h"
+#include "util/thread_pool.h"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <vector>
+
+class VulkanEngine;
+
+enum class ExportFileFormat {
+	PNG,
+	EXR,
+	TGA,
+};
+
+namespace engine {
+	//Downloads textures through a ring of persistently mapped RAM_FOR_DOWNLOAD buffers.
+	//Copies are submitted to the graphics queue and signal a timeline semaphore; update() polls the semaphore
+	//once per frame and hands finished slots to a worker pool that encodes PNG/EXR/TGA, so the UI never waits.
+	class TextureExporter {
+	public:
+		constexpr static inline uint32_t staging_slot_num = 4;
+		constexpr static inline uint32_t encode_worker_num = 2;
+
+		//Host image that tiles of a tiled evaluation are assembled into, the worker writing the last tile encodes it
+		struct TiledCanvas {
+			std::filesystem::path file_path;
+			ExportFileFormat file_format;
+			uint32_t width;
+			uint32_t height;
+			VkFormat format;
+			std::vector<std::byte> pixels;
+			std::atomic<uint32_t> remaining_tile_num;
+		};
+
+		explicit TextureExporter(VulkanEngine* engine);
+
+		~TextureExporter();
+
+		TextureExporter(const TextureExporter&) = delete;
+		TextureExporter& operator=(const TextureExporter&) = delete;
+
+		//texture must be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and have been created with VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+		void export_texture(const TexturePtr& texture, std::filesystem::path file_path, ExportFileFormat file_format);
+
+		std::shared_ptr<TiledCanvas> begin_tiled_export(std::filesystem::path file_path, ExportFileFormat file_format, VkFormat format, uint32_t width, uint32_t height, uint32_t tile_num);
+
+		//copies src_region of texture to dst_offset of the canvas. Tiles bypass the pending queue since the caller
+		//overwrites the texture with the next tile, false is returned when no staging slot is free
+		bool export_tile(const std::shared_ptr<TiledCanvas>& canvas, const TexturePtr& texture, VkRect2D src_region, VkOffset2D dst_offset);
+
+		//copies the whole texture into host memory and waits for it, for callers that need the texels right away.
+		//Same requirements as export_texture()
+		[[nodiscard]] std::vector<std::byte> read_pixels(const TexturePtr& texture) const;
+
+		[[nodiscard]] bool has_free_slot() const noexcept;
+
+		void update();
+
+		[[nodiscard]] size_t in_flight_count() const noexcept;
+
+		static ExportFileFormat file_format_from_extension(const std::filesystem::path& file_path);
+
+		static bool is_format_supported(VkFormat format) noexcept;
+
+		//bytes of one tightly packed texel, format must be supported
+		static uint32_t texel_size(VkFormat format);
+
+		//writes tightly packed texels of format to file_path, also used by the CPU backend which has no staging buffers
+		static void encode_pixels(const std::byte* data, uint32_t width, uint32_t height, VkFormat format,
+			const std::filesystem::path& file_path, ExportFileFormat file_format);
+
+	private:
+		struct ExportRequest {
+			TexturePtr texture;
+			std::filesystem::path file_path;
+			ExportFileFormat file_format;
+			VkRect2D src_region;
+			std::shared_ptr<TiledCanvas> canvas;
+			VkOffset2D dst_offset{ 0, 0 };
+		};
+
+		enum class SlotState : uint32_t {
+			FREE,
+			COPYING,
+			ENCODING,
+		};
+
+		struct StagingSlot {
+			std::unique_ptr<Buffer> buffer;
+			VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+			uint64_t timeline_value = 0;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			ExportRequest request;
+			std::atomic<SlotState> state = SlotState::FREE;
+		};
+
+		VulkanEngine* engine;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		uint64_t timeline_value = 0;
+		std::array<StagingSlot, staging_slot_num> slots;
+		std::deque<ExportRequest> pending_requests;
+
+		ThreadPool encode_workers{ encode_worker_num };
+
+		void flush();
+
+		void create_semaphore();
+
+		void create_command_buffers();
+
+		bool try_submit(ExportRequest& request);
+
+		//barriers around a copy of src_region to the start of buffer, the texture is back in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL after it
+		static void record_copy(VkCommandBuffer cmd, const Texture& texture, VkRect2D src_region, VkBuffer buffer);
+
+		void record_copy_cmd_buffer(const StagingSlot& slot) const;
+
+		void encode(StagingSlot& slot);
+
+		static void copy_to_canvas(const StagingSlot& slot);
+	};
+}
@@ -0,0 +1,192 @@
+#include "vk_texture_pool.h"
+#include "vk_engine.h"
+
+#include <ranges>
+#include <stdexcept>
+
+namespace engine {
+	size_t TexturePool::KeyHash::operator()(const Key& key) const noexcept {
+		size_t seed = std::hash<uint32_t>{}(key.width);
+		for (auto const value : {
+			static_cast<uint32_t>(key.height),
+			static_cast<uint32_t>(key.format),
+			static_cast<uint32_t>(key.aspect_flags),
+			static_cast<uint32_t>(key.usage),
+			static_cast<uint32_t>(key.greyscale),
+			static_cast<uint32_t>(key.category) }) {
+			seed ^= std::hash<uint32_t>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}
+		return seed;
+	}
+
+	TexturePool::TexturePool(VulkanEngine* engine) : engine(engine), state(std::make_shared<State>()) {
+		constexpr VkSemaphoreTypeCreateInfo timeline_semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.pNext = nullptr,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+
+		const VkSemaphoreCreateInfo semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &timeline_semaphore_create_info,
+			.flags = 0,
+		};
+
+		for (auto& semaphore : semaphores) {
+			if (vkCreateSemaphore(engine->device, &semaphore_create_info, nullptr, &semaphore) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create texture pool timeline semaphore!");
+			}
+		}
+	}
+
+	TexturePool::~TexturePool() {
+		{
+			std::lock_guard lock(state->mutex);
+			state->idle_textures.clear();
+			state->retiring_textures.clear();
+		}
+		for (auto const semaphore : semaphores) {
+			vkDestroySemaphore(engine->device, semaphore, nullptr);
+		}
+	}
+
+	bool TexturePool::is_retired(const IdleTexture& idle_texture) const {
+		if (idle_texture.release_frame + retire_frame_num > state->frame) {
+			return false;
+		}
+		for (uint32_t i = 0; i < QUEUE_NUM; ++i) {
+			if (idle_texture.release_values[i] > state->completed_values[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	TexturePtr TexturePool::acquire(const uint32_t width, const uint32_t height, const VkFormat format, const VkImageAspectFlags aspect_flags, const VkImageUsageFlags usage, const bool greyscale) {
+		const Key key{
+			.width = width,
+			.height = height,
+			.format = format,
+			.aspect_flags = aspect_flags,
+			.usage = usage,
+			.greyscale = greyscale,
+			.category = MemoryCategoryScope::current(),
+		};
+
+		std::unique_ptr<Texture> texture;
+		{
+			std::lock_guard lock(state->mutex);
+			if (auto const iter = state->idle_textures.find(key); iter != state->idle_textures.end()) {
+				auto& idle = iter->second;
+				//idle textures are appended in release order, so the oldest one is the first to retire
+				if (!idle.empty() && is_retired(idle.front())) {
+					texture = std::move(idle.front().texture);
+					idle.erase(idle.begin());
+				}
+			}
+		}
+		if (!texture) {
+			texture = Texture::create_device_texture_unique(engine, width, height, format, aspect_flags, usage, greyscale);
+		}
+
+		return TexturePtr(texture.release(), [weak_state = std::weak_ptr(state), key](Texture* released_texture) {
+			release(weak_state, key, released_texture);
+			});
+	}
+
+	void TexturePool::release(const std::weak_ptr<State>& weak_state, const Key& key, Texture* texture) {
+		std::unique_ptr<Texture> owned_texture(texture);
+		auto const shared_state = weak_state.lock();
+		if (!shared_state) {
+			return;
+		}
+		std::lock_guard lock(shared_state->mutex);
+		auto& idle = shared_state->idle_textures[key];
+		//past the limit the texture is not reused, but frames and evaluations in flight may still use it
+		auto& parked = idle.size() < idle_limit_per_key ? idle : shared_state->retiring_textures;
+		parked.emplace_back(IdleTexture{
+			.texture = std::move(owned_texture),
+			.release_frame = shared_state->frame,
+			.release_values = shared_state->submitted_values,
+			});
+	}
+
+	void TexturePool::signal_submissions(const VkQueue graphics_queue, const VkQueue compute_queue) {
+		std::lock_guard lock(state->mutex);
+		const std::array<VkQueue, QUEUE_NUM> queues{ graphics_queue, compute_queue };
+		for (uint32_t i = 0; i < QUEUE_NUM; ++i) {
+			const VkSemaphoreSubmitInfo signal_semaphore_submit_info{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.semaphore = semaphores[i],
+				.value = state->submitted_values[i] + 1,
+				.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			};
+
+			//an empty batch, its signal waits for everything submitted to the queue before it
+			const VkSubmitInfo2 submit_info{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+				.signalSemaphoreInfoCount = 1,
+				.pSignalSemaphoreInfos = &signal_semaphore_submit_info,
+			};
+
+			if (vkQueueSubmit2(queues[i], 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+				throw std::runtime_error("failed to submit texture pool timeline signal!");
+			}
+			++state->submitted_values[i];
+		}
+	}
+
+	void TexturePool::update() {
+		std::lock_guard lock(state->mutex);
+		++state->frame;
+		for (uint32_t i = 0; i < QUEUE_NUM; ++i) {
+			vkGetSemaphoreCounterValue(engine->device, semaphores[i], &state->completed_values[i]);
+		}
+		std::erase_if(state->retiring_textures, [&](const IdleTexture& idle_texture) {
+			return is_retired(idle_texture);
+			});
+		if (state->frame % 64 != 0) {
+			return;
+		}
+		for (auto& idle : state->idle_textures | std::views::values) {
+			std::erase_if(idle, [&](const IdleTexture& idle_texture) {
+				return idle_texture.release_frame + idle_frame_limit <= state->frame && is_retired(idle_texture);
+				});
+		}
+	}
+
+	void TexturePool::trim(const MemoryCategory category) {
+		std::lock_guard lock(state->mutex);
+		for (auto& [key, idle] : state->idle_textures) {
+			if (key.category == category) {
+				std::erase_if(idle, [&](const IdleTexture& idle_texture) {
+					return is_retired(idle_texture);
+					});
+			}
+		}
+	}
+
+	size_t TexturePool::idle_count() const {
+		std::lock_guard lock(state->mutex);
+		size_t count = state->retiring_textures.size();
+		for (auto const& idle : state->idle_textures | std::views::values) {
+			count += idle.size();
+		}
+		return count;
+	}
+
+	VkDeviceSize TexturePool::idle_bytes() const {
+		std::lock_guard lock(state->mutex);
+		VkDeviceSize bytes = 0;
+		for (auto const& idle_texture : state->retiring_textures) {
+			bytes += idle_texture.texture->allocation_size;
+		}
+		for (auto const& idle : state->idle_textures | std::views::values) {
+			for (auto const& idle_texture : idle) {
+				bytes += idle_texture.texture->allocation_size;
+			}
+		}
+		return bytes;
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_image.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class VulkanEngine;
+
+namespace engine {
+	//Recycles TEMP_BIT device textures (node outputs, previews, UDF ping-pong images) by shape, format and usage.
+	//Releasing the last TexturePtr parks the image here instead of freeing it. It is handed out again once the frames
+	//that may still sample it have retired and the node evaluations submitted before the release have finished, which
+	//run on both queues outside the frame fences. Every release is tagged with the last value signal_submissions()
+	//submitted on each queue; textures idle for idle_frame_limit frames are freed to return the memory. Releases beyond
+	//idle_limit_per_key are not kept for reuse, they are freed as soon as they retire.
+	class TexturePool {
+	public:
+		constexpr static inline uint64_t retire_frame_num = 3;  //frames in flight plus the frame that released it
+		constexpr static inline uint64_t idle_frame_limit = 1024;
+		constexpr static inline size_t idle_limit_per_key = 16;
+
+		explicit TexturePool(VulkanEngine* engine);
+
+		~TexturePool();
+
+		TexturePool(const TexturePool&) = delete;
+		TexturePool& operator=(const TexturePool&) = delete;
+
+		//the returned texture is in an unknown layout, callers transition it from VK_IMAGE_LAYOUT_UNDEFINED
+		TexturePtr acquire(uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspect_flags, VkImageUsageFlags usage, bool greyscale);
+
+		//submits a batch to each queue that signals the next value of its timeline once all work submitted before it has
+		//finished, call after submitting work that may use pooled textures
+		void signal_submissions(VkQueue graphics_queue, VkQueue compute_queue);
+
+		//advances the frame counter, reads the completed timeline values and frees textures that stayed idle too long,
+		//call once per frame
+		void update();
+
+		//frees the retired idle textures of one category right away, for callers that release memory on purpose
+		void trim(MemoryCategory category);
+
+		[[nodiscard]] size_t idle_count() const;
+
+		[[nodiscard]] VkDeviceSize idle_bytes() const;
+
+	private:
+		struct Key {
+			uint32_t width;
+			uint32_t height;
+			VkFormat format;
+			VkImageAspectFlags aspect_flags;
+			VkImageUsageFlags usage;
+			bool greyscale;
+			MemoryCategory category;
+
+			bool operator==(const Key&) const = default;
+		};
+
+		struct KeyHash {
+			size_t operator()(const Key& key) const noexcept;
+		};
+
+		enum QueueIndex : uint32_t {
+			GRAPHICS_QUEUE,
+			COMPUTE_QUEUE,
+			QUEUE_NUM,
+		};
+
+		using TimelineValues = std::array<uint64_t, QUEUE_NUM>;
+
+		struct IdleTexture {
+			std::unique_ptr<Texture> texture;
+			uint64_t release_frame;
+			TimelineValues release_values;  //submitted timeline values at release, reused once all of them completed
+		};
+
+		//shared with the deleters of handed out textures, which free the texture directly once the pool is gone
+		struct State {
+			std::mutex mutex;
+			uint64_t frame = 0;
+			TimelineValues submitted_values{};
+			TimelineValues completed_values{};
+			std::unordered_map<Key, std::vector<IdleTexture>, KeyHash> idle_textures;
+			std::vector<IdleTexture> retiring_textures;  //released beyond idle_limit_per_key, freed once retired
+		};
+
+		VulkanEngine* engine;
+		std::shared_ptr<State> state;
+		std::array<VkSemaphore, QUEUE_NUM> semaphores{};
+
+		//the caller holds the state mutex
+		[[nodiscard]] bool is_retired(const IdleTexture& idle_texture) const;
+
+		static void release(const std::weak_ptr<State>& weak_state, const Key& key, Texture* texture);
+	};
+}
@@ -0,0 +1,79 @@
+#include "vk_uniform_arena.h"
+#include "vk_engine.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+	void UniformSlot::copy_from_host(void const* host_data, const size_t data_size, const size_t data_offset) const {
+		memcpy(mapped_data + data_offset, host_data, data_size);
+	}
+
+	UniformSlotPtr UniformSlot::view(const BufferPtr& buffer) {
+		return UniformSlotPtr(new UniformSlot{
+			.buffer = buffer->buffer,
+			.offset = 0,
+			.size = buffer->size,
+			.mapped_data = static_cast<std::byte*>(buffer->mapped_buffer),
+			}, [buffer](const UniformSlot* slot) {
+				delete slot;
+			});
+	}
+
+	UniformArena::UniformArena(VulkanEngine* engine) : state(std::make_shared<State>()) {
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(engine->physical_device, &properties);
+		state->alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 16);
+		state->buffer = std::make_unique<Buffer>(
+			engine->vma_allocator,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,  //node parameters arrive through the parameter ring
+			PreferredMemoryType::VRAM_MAPPABLE,
+			arena_size);
+	}
+
+	UniformSlotPtr UniformArena::allocate(const VkDeviceSize size) {
+		std::lock_guard lock(state->mutex);
+		const VkDeviceSize slot_size = (size + state->alignment - 1) / state->alignment * state->alignment;
+
+		VkDeviceSize offset;
+		if (auto& free_offsets = state->free_offsets[slot_size]; !free_offsets.empty()) {
+			offset = free_offsets.back();
+			free_offsets.pop_back();
+		}
+		else if (state->next_offset + slot_size <= arena_size) {
+			offset = state->next_offset;
+			state->next_offset += slot_size;
+		}
+		else {
+			throw std::runtime_error("failed to allocate uniform slot, the parameter arena is full!");
+		}
+		state->used_bytes += slot_size;
+
+		return UniformSlotPtr(new UniformSlot{
+			.buffer = state->buffer->buffer,
+			.offset = offset,
+			.size = size,
+			.mapped_data = static_cast<std::byte*>(state->buffer->mapped_buffer) + offset,
+			}, [weak_state = std::weak_ptr(state), slot_size](const UniformSlot* slot) {
+				if (auto const shared_state = weak_state.lock()) {
+					std::lock_guard lock(shared_state->mutex);
+					shared_state->free_offsets[slot_size].emplace_back(slot->offset);
+					shared_state->used_bytes -= slot_size;
+				}
+				delete slot;
+			});
+	}
+
+	VkBuffer UniformArena::buffer() const noexcept {
+		return state->buffer->buffer;
+	}
+
+	VkDeviceSize UniformArena::alignment() const noexcept {
+		return state->alignment;
+	}
+
+	VkDeviceSize UniformArena::used_bytes() const {
+		std::lock_guard lock(state->mutex);
+		return state->used_bytes;
+	}
+}
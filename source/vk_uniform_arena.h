@@ -0,0 +1,62 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_buffer.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class VulkanEngine;
+
+namespace engine {
+	//A persistently mapped range of a uniform buffer: a slot of the parameter arena or a whole shared buffer
+	struct UniformSlot {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		std::byte* mapped_data = nullptr;
+
+		void copy_from_host(void const* host_data, size_t data_size, size_t data_offset = 0) const;
+
+		//views all of buffer and keeps it alive, for nodes writing into a uniform buffer owned by the engine
+		static std::shared_ptr<UniformSlot> view(const BufferPtr& buffer);
+	};
+	using UniformSlotPtr = std::shared_ptr<UniformSlot>;
+
+	//One VRAM_MAPPABLE uniform buffer that node parameters are suballocated from, so creating or deleting a node
+	//never touches the allocator and all parameters are contiguous. Slots are rounded up to
+	//minUniformBufferOffsetAlignment and recycled through per-size free lists; node types share a few sizes.
+	//Nodes whose descriptor set only holds their parameters bind one shared set with a dynamic offset.
+	class UniformArena {
+	public:
+		constexpr static inline VkDeviceSize arena_size = 4ull << 20;
+
+		explicit UniformArena(VulkanEngine* engine);
+
+		UniformArena(const UniformArena&) = delete;
+		UniformArena& operator=(const UniformArena&) = delete;
+
+		//the slot returns to the arena when the last reference is dropped
+		UniformSlotPtr allocate(VkDeviceSize size);
+
+		[[nodiscard]] VkBuffer buffer() const noexcept;
+
+		[[nodiscard]] VkDeviceSize alignment() const noexcept;
+
+		[[nodiscard]] VkDeviceSize used_bytes() const;
+
+	private:
+		//shared with the deleters of handed out slots, which outlive the arena during shutdown
+		struct State {
+			std::mutex mutex;
+			std::unique_ptr<Buffer> buffer;
+			VkDeviceSize alignment;
+			VkDeviceSize next_offset = 0;
+			VkDeviceSize used_bytes = 0;
+			std::unordered_map<VkDeviceSize, std::vector<VkDeviceSize>> free_offsets;  //keyed by aligned slot size
+		};
+
+		std::shared_ptr<State> state;
+	};
+}
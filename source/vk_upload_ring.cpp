@@ -0,0 +1,210 @@
+#include "vk_upload_ring.h"
+#include "vk_engine.h"
+#include "vk_initializers.h"
+
+#include <stdexcept>
+
+namespace engine {
+	UploadRing::UploadRing(VulkanEngine* engine) :
+		engine(engine),
+		transfer_family(engine->queue_family_indices.transfer_family.value()),
+		graphics_family(engine->queue_family_indices.graphics_family.value()) {
+		ring_buffer = std::make_unique<Buffer>(
+			engine->vma_allocator,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			PreferredMemoryType::RAM_FOR_UPLOAD,
+			ring_size);
+		create_command_pools();
+		create_semaphores();
+	}
+
+	UploadRing::~UploadRing() {
+		wait(graphics_value);
+		reclaim(graphics_value);
+		vkDestroyCommandPool(engine->device, transfer_command_pool, nullptr);
+		vkDestroyCommandPool(engine->device, graphics_command_pool, nullptr);
+		vkDestroySemaphore(engine->device, transfer_semaphore, nullptr);
+		vkDestroySemaphore(engine->device, graphics_semaphore, nullptr);
+	}
+
+	void UploadRing::create_command_pools() {
+		const VkCommandPoolCreateInfo transfer_pool_info = vkinit::command_pool_create_info(transfer_family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		if (vkCreateCommandPool(engine->device, &transfer_pool_info, nullptr, &transfer_command_pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create transfer command pool!");
+		}
+
+		const VkCommandPoolCreateInfo graphics_pool_info = vkinit::command_pool_create_info(graphics_family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		if (vkCreateCommandPool(engine->device, &graphics_pool_info, nullptr, &graphics_command_pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create graphics command pool!");
+		}
+	}
+
+	void UploadRing::create_semaphores() {
+		constexpr VkSemaphoreTypeCreateInfo timeline_semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.pNext = nullptr,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+
+		const VkSemaphoreCreateInfo semaphore_create_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &timeline_semaphore_create_info,
+			.flags = 0,
+		};
+
+		//each queue signals its own semaphore, a shared one could see values signaled out of order
+		if (vkCreateSemaphore(engine->device, &semaphore_create_info, nullptr, &transfer_semaphore) != VK_SUCCESS ||
+			vkCreateSemaphore(engine->device, &semaphore_create_info, nullptr, &graphics_semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload timeline semaphore!");
+		}
+	}
+
+	void UploadRing::reclaim(const uint64_t completed_value) {
+		ring_allocator.release(completed_value);
+		while (!in_flight_uploads.empty() && in_flight_uploads.front().value <= completed_value) {
+			auto& upload = in_flight_uploads.front();
+			vkFreeCommandBuffers(engine->device, transfer_command_pool, 1, &upload.transfer_command_buffer);
+			vkFreeCommandBuffers(engine->device, graphics_command_pool, 1, &upload.graphics_command_buffer);
+			in_flight_uploads.pop_front();
+		}
+	}
+
+	VkCommandBuffer UploadRing::begin_command_buffer(const VkCommandPool command_pool) const {
+		const VkCommandBufferAllocateInfo cmd_allocate_info = vkinit::command_buffer_allocate_info(command_pool, 1);
+		VkCommandBuffer command_buffer;
+		if (vkAllocateCommandBuffers(engine->device, &cmd_allocate_info, &command_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffers!");
+		}
+
+		constexpr VkCommandBufferBeginInfo begin_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		};
+		if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		return command_buffer;
+	}
+
+	void UploadRing::submit(const VkQueue queue, const VkCommandBuffer command_buffer, const VkSemaphore wait_semaphore, const uint64_t wait_value,
+		const VkSemaphore signal_semaphore, const uint64_t signal_value) const {
+		if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+
+		const VkCommandBufferSubmitInfo cmd_buffer_submit_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+			.commandBuffer = command_buffer,
+		};
+
+		const VkSemaphoreSubmitInfo wait_semaphore_submit_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.semaphore = wait_semaphore,
+			.value = wait_value,
+			.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		};
+
+		const VkSemaphoreSubmitInfo signal_semaphore_submit_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.semaphore = signal_semaphore,
+			.value = signal_value,
+			.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		};
+
+		const VkSubmitInfo2 submit_info{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+			.waitSemaphoreInfoCount = wait_semaphore == VK_NULL_HANDLE ? 0u : 1u,
+			.pWaitSemaphoreInfos = &wait_semaphore_submit_info,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &cmd_buffer_submit_info,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &signal_semaphore_submit_info,
+		};
+
+		if (vkQueueSubmit2(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit upload command buffer!");
+		}
+	}
+
+	uint64_t UploadRing::upload(const VkDeviceSize size, const FillFunc& fill, const TransferRecordFunc& record_transfer,
+		const GraphicsRecordFunc& record_graphics, const VkDeviceSize alignment) {
+		std::lock_guard lock(mutex);
+
+		InFlightUpload upload{
+			.value = graphics_value + 1,
+		};
+		const Buffer* staging_buffer = ring_buffer.get();
+		VkDeviceSize staging_offset = 0;
+		if (size <= ring_size) {
+			std::optional<VkDeviceSize> offset;
+			while (!(offset = ring_allocator.allocate(size, alignment, upload.value))) {
+				//the ring is full, the oldest upload is the first to free its range
+				auto const value = ring_allocator.oldest_value().value();
+				wait(value);
+				reclaim(value);
+			}
+			staging_offset = *offset;
+		}
+		else {
+			upload.dedicated_buffer = std::make_unique<Buffer>(
+				engine->vma_allocator,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				PreferredMemoryType::RAM_FOR_UPLOAD,
+				size);
+			staging_buffer = upload.dedicated_buffer.get();
+		}
+
+		fill(static_cast<std::byte*>(staging_buffer->mapped_buffer) + staging_offset);
+		vmaFlushAllocation(engine->vma_allocator, staging_buffer->allocation, staging_offset, size);
+
+		upload.transfer_command_buffer = begin_command_buffer(transfer_command_pool);
+		record_transfer(upload.transfer_command_buffer, staging_buffer->buffer, staging_offset);
+		submit(engine->transfer_queue, upload.transfer_command_buffer, VK_NULL_HANDLE, 0, transfer_semaphore, ++transfer_value);
+
+		upload.graphics_command_buffer = begin_command_buffer(graphics_command_pool);
+		record_graphics(upload.graphics_command_buffer);
+		submit(engine->graphics_queue, upload.graphics_command_buffer, transfer_semaphore, transfer_value, graphics_semaphore, ++graphics_value);
+
+		in_flight_uploads.emplace_back(std::move(upload));
+		return graphics_value;
+	}
+
+	bool UploadRing::is_complete(const uint64_t value) const {
+		uint64_t completed_value;
+		vkGetSemaphoreCounterValue(engine->device, graphics_semaphore, &completed_value);
+		return value <= completed_value;
+	}
+
+	void UploadRing::wait(const uint64_t value) const {
+		const VkSemaphoreWaitInfo wait_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.semaphoreCount = 1,
+			.pSemaphores = &graphics_semaphore,
+			.pValues = &value,
+		};
+		if (vkWaitSemaphores(engine->device, &wait_info, VULKAN_WAIT_TIMEOUT) != VK_SUCCESS) {
+			throw std::runtime_error("failed to wait for upload to complete!");
+		}
+	}
+
+	void UploadRing::update() {
+		std::lock_guard lock(mutex);
+		uint64_t completed_value;
+		vkGetSemaphoreCounterValue(engine->device, graphics_semaphore, &completed_value);
+		reclaim(completed_value);
+	}
+
+	uint32_t UploadRing::src_queue_family() const noexcept {
+		return transfer_family == graphics_family ? VK_QUEUE_FAMILY_IGNORED : transfer_family;
+	}
+
+	uint32_t UploadRing::dst_queue_family() const noexcept {
+		return transfer_family == graphics_family ? VK_QUEUE_FAMILY_IGNORED : graphics_family;
+	}
+
+	size_t UploadRing::in_flight_count() const {
+		std::lock_guard lock(mutex);
+		return in_flight_uploads.size();
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "vk_types.h"
+#include "vk_buffer.h"
+#include "util/ring_allocator.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+class VulkanEngine;
+
+namespace engine {
+	//Stages uploads in one persistently mapped RAM_FOR_UPLOAD ring and copies them on the dedicated transfer queue.
+	//Every upload is two submissions: the copy signals transfer_semaphore, then a graphics submission waits on it,
+	//acquires queue ownership, finishes the resource (layouts, mipmaps) and signals graphics_semaphore.
+	//The CPU only waits when the ring is full; update() reclaims the ranges of finished uploads once per frame.
+	//Uploads larger than the ring get a dedicated staging buffer that lives until the upload completes.
+	class UploadRing {
+	public:
+		constexpr static inline VkDeviceSize ring_size = 64ull << 20;
+		constexpr static inline VkDeviceSize default_alignment = 16;  //covers the texel sizes of every uploaded format
+
+		using FillFunc = std::function<void(std::byte* staging_data)>;
+		using TransferRecordFunc = std::function<void(VkCommandBuffer command_buffer, VkBuffer staging_buffer, VkDeviceSize staging_offset)>;
+		using GraphicsRecordFunc = std::function<void(VkCommandBuffer command_buffer)>;
+
+		explicit UploadRing(VulkanEngine* engine);
+
+		~UploadRing();
+
+		UploadRing(const UploadRing&) = delete;
+		UploadRing& operator=(const UploadRing&) = delete;
+
+		//fill writes size bytes of staging memory, record_transfer copies them and releases ownership to the graphics family,
+		//record_graphics acquires ownership. Returns the graphics_semaphore value that marks the upload as complete.
+		//Later graphics submissions are ordered after the upload by the barriers record_graphics ends with.
+		uint64_t upload(VkDeviceSize size, const FillFunc& fill, const TransferRecordFunc& record_transfer,
+			const GraphicsRecordFunc& record_graphics, VkDeviceSize alignment = default_alignment);
+
+		[[nodiscard]] bool is_complete(uint64_t value) const;
+
+		void wait(uint64_t value) const;
+
+		//reclaims staging ranges and command buffers of finished uploads, call once per frame
+		void update();
+
+		//queue family indices of ownership transfer barriers, VK_QUEUE_FAMILY_IGNORED when both queues share a family
+		[[nodiscard]] uint32_t src_queue_family() const noexcept;
+
+		[[nodiscard]] uint32_t dst_queue_family() const noexcept;
+
+		[[nodiscard]] size_t in_flight_count() const;
+
+	private:
+		struct InFlightUpload {
+			uint64_t value;
+			VkCommandBuffer transfer_command_buffer;
+			VkCommandBuffer graphics_command_buffer;
+			std::unique_ptr<Buffer> dedicated_buffer;
+		};
+
+		VulkanEngine* engine;
+		uint32_t transfer_family;
+		uint32_t graphics_family;
+		std::unique_ptr<Buffer> ring_buffer;
+		RingAllocator ring_allocator{ ring_size };
+		std::deque<InFlightUpload> in_flight_uploads;
+
+		VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
+		VkCommandPool graphics_command_pool = VK_NULL_HANDLE;
+		VkSemaphore transfer_semaphore = VK_NULL_HANDLE;
+		VkSemaphore graphics_semaphore = VK_NULL_HANDLE;
+		uint64_t transfer_value = 0;
+		uint64_t graphics_value = 0;
+
+		mutable std::mutex mutex;
+
+		void create_command_pools();
+
+		void create_semaphores();
+
+		void reclaim(uint64_t completed_value);
+
+		VkCommandBuffer begin_command_buffer(VkCommandPool command_pool) const;
+
+		void submit(VkQueue queue, VkCommandBuffer command_buffer, VkSemaphore wait_semaphore, uint64_t wait_value,
+			VkSemaphore signal_semaphore, uint64_t signal_value) const;
+	};
+}